@@ -0,0 +1,303 @@
+/*
+ * A program that folds one target sequence in a duplex with every query sequence in a FASTA file.
+ * The target and the thermodynamic parameters are read only once.
+ * The strands of nucleic acids can be composed of either DNA or RNA.
+ *
+ * (c) 2026 Mathews Lab, University of Rochester Medical Center.
+ */
+
+#include "BatchDuplexFold.h"
+#include "../src/bimol.h"
+
+// The number of records read from the FASTA file at a time, and folded together.
+#define BATCH_SIZE 1024
+
+///////////////////////////////////////////////////////////////////////////////
+// Constructor.
+///////////////////////////////////////////////////////////////////////////////
+BatchDuplexFold::BatchDuplexFold() {
+
+	// Initialize the calculation type description.
+	calcType = "Batch duplex folding";
+
+	// Initialize the nucleic acid type.
+	isRNA = true;
+
+	// Initialize the output format to ct.
+	isBracket = false;
+
+	// Initialize the maximum internal bulge loop size.
+	maxLoop = 6;
+
+	// Initialize the maximum number of structures, which is only the best duplex.
+	maxStructures = 1;
+
+	// Initialize the maximum percent energy difference.
+	percent = 40;
+
+	// Initialize the calculation temperature.
+	temperature = 310.15;
+
+	// Initialize the folding window size.
+	windowSize = 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Parse the command line arguments.
+///////////////////////////////////////////////////////////////////////////////
+bool BatchDuplexFold::parse( int argc, char** argv ) {
+
+	// Create the command line parser and build in its required parameters.
+	ParseCommandLine* parser = new ParseCommandLine( "BatchDuplexFold" );
+	parser->addParameterDescription( "target seq file", "The name of a file containing the target sequence, which is folded with every query sequence." );
+	parser->addParameterDescription( "FASTA file", "The name of a FASTA file holding any number of query sequences. Each record is a line starting with \">\" and the sequence label, followed by one or more lines of sequence." );
+	parser->addParameterDescription( "output file", "The name of the output file. The duplexes of the target with all the queries are written to this one file, in the order of the input." );
+
+	// Add the DNA option.
+	vector<string> dnaOptions;
+	dnaOptions.push_back( "-d" );
+	dnaOptions.push_back( "-D" );
+	dnaOptions.push_back( "--DNA" );
+	parser->addOptionFlagsNoParameters( dnaOptions, "Specify that the sequences are DNA, and DNA parameters are to be used. Default is to use RNA parameters." );
+
+	// Add the dot-bracket option.
+	vector<string> bracketOptions;
+	bracketOptions.push_back( "-k" );
+	bracketOptions.push_back( "-K" );
+	bracketOptions.push_back( "--bracket" );
+	parser->addOptionFlagsNoParameters( bracketOptions, "Write the structures in dot-bracket format. Default is to write a ct file." );
+
+	// Add the maximum loop size option.
+	vector<string> loopOptions;
+	loopOptions.push_back( "-l" );
+	loopOptions.push_back( "-L" );
+	loopOptions.push_back( "--loop" );
+	parser->addOptionFlagsWithParameters( loopOptions, "Specify a maximum internal/bulge loop size. Default is 6 unpaired numcleotides." );
+
+	// Add the maximum number of structures option.
+	vector<string> maxStructuresOptions;
+	maxStructuresOptions.push_back( "-m" );
+	maxStructuresOptions.push_back( "-M" );
+	maxStructuresOptions.push_back( "--maximum" );
+	parser->addOptionFlagsWithParameters( maxStructuresOptions, "Specify a maximum number of structures for each query. Default is 1 structure, the lowest free energy duplex." );
+
+	// Add the percent energy difference option.
+	vector<string> percentOptions;
+	percentOptions.push_back( "-p" );
+	percentOptions.push_back( "-P" );
+	percentOptions.push_back( "--percent" );
+	parser->addOptionFlagsWithParameters( percentOptions, "Specify a maximum percent energy difference. Default is 40 percent (specified as 40, not 0.4)." );
+
+	// Add the temperature option.
+	vector<string> tempOptions;
+	tempOptions.push_back( "-t" );
+	tempOptions.push_back( "-T" );
+	tempOptions.push_back( "--temperature" );
+	parser->addOptionFlagsWithParameters( tempOptions, "Specify the temperature at which calculation takes place in Kelvin. Default is 310.15 K, which is 37 degrees C." );
+
+	// Add the window size option.
+	vector<string> windowOptions;
+	windowOptions.push_back( "-w" );
+	windowOptions.push_back( "-W" );
+	windowOptions.push_back( "--window" );
+	parser->addOptionFlagsWithParameters( windowOptions, "Specify a window size. Default is 0 nucleotides." );
+
+	// Parse the command line into pieces.
+	parser->parseLine( argc, argv );
+
+	// Get required parameters from the parser.
+	if( !parser->isError() ) {
+		targetFile = parser->getParameter( 1 );
+		fastaFile = parser->getParameter( 2 );
+		outFile = parser->getParameter( 3 );
+	}
+
+	// Get the DNA option.
+	if( !parser->isError() ) { isRNA = !parser->contains( dnaOptions ); }
+
+	// Get the dot-bracket option.
+	if( !parser->isError() ) { isBracket = parser->contains( bracketOptions ); }
+
+	// Get the maximum loop size option.
+	if( !parser->isError() ) {
+		parser->setOptionInteger( loopOptions, maxLoop );
+		if( maxLoop < 0 ) { parser->setError( "maximum loop size" ); }
+	}
+
+	// Get the maximum number of structures option.
+	if( !parser->isError() ) {
+		parser->setOptionInteger( maxStructuresOptions, maxStructures );
+		if( maxStructures <= 0 ) { parser->setError( "maximum number of structures" ); }
+	}
+
+	// Get the percent energy difference option.
+	if( !parser->isError() ) {
+		parser->setOptionDouble( percentOptions, percent );
+		if( percent < 0 ) { parser->setError( "percent energy difference" ); }
+	}
+
+	// Get the temperature option.
+	if( !parser->isError() ) {
+		parser->setOptionDouble( tempOptions, temperature );
+		if( temperature < 0 ) { parser->setError( "temperature" ); }
+	}
+
+	// Get the window size option.
+	if( !parser->isError() ) {
+		parser->setOptionInteger( windowOptions, windowSize );
+		if( windowSize < 0 ) { parser->setError( "window size" ); }
+	}
+
+	// Delete the parser and return whether the parser encountered an error.
+	bool noError = ( parser->isError() == false );
+	delete parser;
+	return noError;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Run calculations.
+///////////////////////////////////////////////////////////////////////////////
+void BatchDuplexFold::run() {
+
+	// Create a variable that handles errors.
+	int error = 0;
+
+	/*
+	 * Read the thermodynamic parameters once, into an instance without a sequence that every duplex uses.
+	 * Set the temperature first, because the parameters are read at that temperature.
+	 */
+	cout << "Reading thermodynamic parameters..." << flush;
+	RNA* thermo = new RNA( isRNA );
+	ErrorChecker<RNA>* checker = new ErrorChecker<RNA>( thermo );
+	error = checker->isErrorStatus( thermo->SetTemperature( temperature ) );
+	if( error == 0 ) { error = checker->isErrorStatus( thermo->ReadThermodynamic() ); }
+	if( error == 0 ) { cout << "done." << endl; }
+
+	/*
+	 * Read the target once, from a sequence file (type = 2).
+	 */
+	RNA* target = NULL;
+	ErrorChecker<RNA>* targetChecker = NULL;
+	if( error == 0 ) {
+		cout << "Initializing target..." << flush;
+		target = new RNA( targetFile.c_str(), 2, isRNA );
+		targetChecker = new ErrorChecker<RNA>( target );
+		error = targetChecker->isErrorStatus();
+		if( error == 0 ) { cout << "done." << endl; }
+	}
+
+	/*
+	 * Open the FASTA file and the output file.
+	 * All the duplexes are written through the output stream, which stays open until every record is done.
+	 */
+	FastaReader* in = NULL;
+	ofstream out;
+	if( error == 0 ) {
+		in = new FastaReader( fastaFile );
+		if( !in->isOpen() ) {
+			cerr << "Error: cannot open FASTA file " << fastaFile << "." << endl;
+			error = 1;
+		}
+	}
+	if( error == 0 ) {
+		out.open( outFile.c_str() );
+		if( !out ) {
+			cerr << "Error: cannot open output file " << outFile << "." << endl;
+			error = 1;
+		}
+	}
+
+	/*
+	 * Fold the target with the queries, a batch of records at a time.
+	 * bimolbatch folds the queries of a batch (in parallel, in the SMP build), and then the duplexes are written in the order of the input.
+	 * A query that the RNA constructor reports as not a valid sequence, or that has no duplex with the target, is reported and skipped.
+	 */
+	int folded = 0;
+	int failed = 0;
+	if( error == 0 ) {
+		cout << "Folding duplexes..." << flush;
+
+		vector<string> labels;
+		vector<string> sequences;
+		while( in->readRecords( BATCH_SIZE, labels, sequences ) > 0 ) {
+
+			int records = (int) labels.size();
+
+			// Make the query and the duplex of each valid record.
+			vector<RNA*> queries( records, (RNA*) NULL );
+			vector<RNA*> duplexes( records, (RNA*) NULL );
+			vector<structure*> queryStructures;
+			vector<structure*> duplexStructures;
+			vector<int> queryErrors( records, 0 );
+			for( int i = 0; i < records; i++ ) {
+				queries[i] = new RNA( sequences[i].c_str(), isRNA );
+				queryErrors[i] = queries[i]->GetErrorCode();
+				if( queryErrors[i] != 0 ) { continue; }
+
+				queries[i]->GetStructure()->SetSequenceLabel( labels[i] );
+				duplexes[i] = new RNA( isRNA );
+				queryStructures.push_back( queries[i]->GetStructure() );
+				duplexStructures.push_back( duplexes[i]->GetStructure() );
+			}
+
+			if( !queryStructures.empty() ) {
+				bimolbatch( target->GetStructure(), &queryStructures[0], &duplexStructures[0], (int) queryStructures.size(),
+					maxLoop, maxStructures, (int) percent, windowSize, thermo->GetDatatable() );
+			}
+
+			for( int i = 0; i < records; i++ ) {
+				if( queryErrors[i] != 0 ) {
+					cerr << endl << "Error in sequence " << labels[i] << ": " << queries[i]->GetErrorMessage( queryErrors[i] );
+					failed++;
+					delete queries[i];
+					continue;
+				}
+
+				int writeError = isBracket ? duplexes[i]->WriteDotBracket( out ) : duplexes[i]->WriteCt( out );
+				if( writeError != 0 ) {
+					cerr << endl << "Error in sequence " << labels[i] << ": " << duplexes[i]->GetErrorMessage( writeError );
+					failed++;
+				}
+				else { folded++; }
+
+				delete queries[i];
+				delete duplexes[i];
+			}
+		}
+
+		// Closing the file writes anything still buffered, which can also fail.
+		out.close();
+		if( !out ) {
+			cerr << endl << "Error: cannot write output file " << outFile << "." << endl;
+			error = 1;
+		}
+
+		cout << "done." << endl;
+		cout << "Folded " << folded << " duplexes";
+		if( failed > 0 ) { cout << "; " << failed << " sequences had errors"; }
+		cout << "." << endl;
+	}
+
+	// Delete the FASTA reader, the error checkers, the target, and the parameters.
+	delete in;
+	delete targetChecker;
+	delete target;
+	delete checker;
+	delete thermo;
+
+	// Print confirmation of run finishing.
+	if( error == 0 && failed == 0 ) { cout << calcType << " complete." << endl; }
+	else { cerr << calcType << " complete with errors." << endl; }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Main method to run the program.
+///////////////////////////////////////////////////////////////////////////////
+int main( int argc, char* argv[] ) {
+
+	BatchDuplexFold* runner = new BatchDuplexFold();
+	bool parseable = runner->parse( argc, argv );
+	if( parseable == true ) { runner->run(); }
+	delete runner;
+	return 0;
+}
@@ -0,0 +1,77 @@
+/*
+ * A program that folds one target sequence in a duplex with every query sequence in a FASTA file.
+ * The target and the thermodynamic parameters are read only once.
+ * The strands of nucleic acids can be composed of either DNA or RNA.
+ *
+ * (c) 2026 Mathews Lab, University of Rochester Medical Center.
+ */
+
+#ifndef BATCHDUPLEXFOLD_H
+#define BATCHDUPLEXFOLD_H
+
+#include "../RNA_class/RNA.h"
+#include "../src/ErrorChecker.h"
+#include "../src/FastaReader.h"
+#include "../src/ParseCommandLine.h"
+
+class BatchDuplexFold {
+ public:
+	// Public constructor and methods.
+
+	/*
+	 * Name:        Constructor.
+	 * Description: Initializes all private variables.
+	 */
+	BatchDuplexFold();
+
+	/*
+	 * Name:        parse
+	 * Description: Parses command line arguments to determine what options are required for a particular calculation.
+	 * Arguments:
+	 *     1.   The number of command line arguments.
+	 *     2.   The command line arguments themselves.
+	 * Returns:
+	 *     True if parsing completed without errors, false if not.
+	 */
+	bool parse( int argc, char** argv );
+
+	/*
+	 * Name:        run
+	 * Description: Run calculations.
+	 */
+	void run();
+
+ private:
+	// Private variables.
+
+	// Description of the calculation type.
+	string calcType;
+
+	// Input and output file names.
+	string targetFile;       // The target sequence file.
+	string fastaFile;        // The FASTA file of query sequences.
+	string outFile;          // The output file.
+
+	// Flag signifying if calculation handles RNA (true) or DNA (false).
+	bool isRNA;
+
+	// Flag signifying whether structures are written in dot-bracket format (true) or ct format (false).
+	bool isBracket;
+
+	// The maximum internal/bulge loop size.
+	int maxLoop;
+
+	// The maximum number of structures for each query.
+	int maxStructures;
+
+	// The maximum percent energy difference.
+	double percent;
+
+	// The temperature at which calculation occurs.
+	double temperature;
+
+	// The window size for suboptimal structures.
+	int windowSize;
+};
+
+#endif /* BATCHDUPLEXFOLD_H */
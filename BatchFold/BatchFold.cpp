@@ -0,0 +1,367 @@
+/*
+ * A program that folds every sequence in a FASTA file, reading the thermodynamic parameters only once.
+ * The sequences can be composed of either DNA or RNA.
+ *
+ * (c) 2026 Mathews Lab, University of Rochester Medical Center.
+ */
+
+#include "BatchFold.h"
+#include "../src/pfunction.h"
+#include <cctype>
+
+#ifdef SMP
+#include <omp.h>
+#endif
+
+// The number of records read from the FASTA file at a time, and shared among the threads.
+#define BATCH_SIZE 1024
+
+///////////////////////////////////////////////////////////////////////////////
+// Constructor.
+///////////////////////////////////////////////////////////////////////////////
+BatchFold::BatchFold() {
+
+	// Initialize the calculation type description.
+	calcType = "Batch folding";
+
+	// Initialize the calculation done for each sequence.
+	mode = "MFE";
+
+	// Initialize the MEA gamma.
+	gamma = 1.0;
+
+	// Initialize the nucleic acid type.
+	isRNA = true;
+
+	// Initialize the output format to ct.
+	isBracket = false;
+
+	// Initialize the maximum internal bulge loop size.
+	maxLoop = 30;
+
+	// Initialize the maximum pairing distance between nucleotides.
+	maxDistance = -1;
+
+	// Initialize the calculation temperature.
+	temperature = 310.15;
+
+	// The parameters are read in run().
+	thermo = NULL;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Parse the command line arguments.
+///////////////////////////////////////////////////////////////////////////////
+bool BatchFold::parse( int argc, char** argv ) {
+
+	// Create the command line parser and build in its required parameters.
+	ParseCommandLine* parser = new ParseCommandLine( "BatchFold" );
+	parser->addParameterDescription( "FASTA file", "The name of a FASTA file holding any number of sequences. Each record is a line starting with \">\" and the sequence label, followed by one or more lines of sequence." );
+	parser->addParameterDescription( "output file", "The name of the output file. The structures of all the sequences are written to this one file, in the order of the input. With the --ensemble option, this is a text file with one line per sequence." );
+
+	// Add the DNA option.
+	vector<string> dnaOptions;
+	dnaOptions.push_back( "-d" );
+	dnaOptions.push_back( "-D" );
+	dnaOptions.push_back( "--DNA" );
+	parser->addOptionFlagsNoParameters( dnaOptions, "Specify that the sequences are DNA, and DNA parameters are to be used. Default is to use RNA parameters." );
+
+	// Add the ensemble energy option.
+	vector<string> ensembleOptions;
+	ensembleOptions.push_back( "-e" );
+	ensembleOptions.push_back( "-E" );
+	ensembleOptions.push_back( "--ensemble" );
+	parser->addOptionFlagsNoParameters( ensembleOptions, "Calculate the partition function of each sequence, and write the label and ensemble folding free energy change (in kcal/mol) of each sequence, separated by a tab, instead of a structure." );
+
+	// Add the MEA gamma option.
+	vector<string> gammaOptions;
+	gammaOptions.push_back( "-g" );
+	gammaOptions.push_back( "-G" );
+	gammaOptions.push_back( "--gamma" );
+	parser->addOptionFlagsWithParameters( gammaOptions, "Specify the gamma (the weight on pairs) for maximum expected accuracy structures. Default is 1.0." );
+
+	// Add the dot-bracket option.
+	vector<string> bracketOptions;
+	bracketOptions.push_back( "-k" );
+	bracketOptions.push_back( "-K" );
+	bracketOptions.push_back( "--bracket" );
+	parser->addOptionFlagsNoParameters( bracketOptions, "Write the structures in dot-bracket format. Default is to write a ct file." );
+
+	// Add the maximum loop size option.
+	vector<string> loopOptions;
+	loopOptions.push_back( "-l" );
+	loopOptions.push_back( "-L" );
+	loopOptions.push_back( "--loop" );
+	parser->addOptionFlagsWithParameters( loopOptions, "Specify a maximum internal/bulge loop size for minimum free energy structures. Default is 30 unpaired nucleotides." );
+
+	// Add the maximum pairing distance option.
+	vector<string> distanceOptions;
+	distanceOptions.push_back( "-md" );
+	distanceOptions.push_back( "-MD" );
+	distanceOptions.push_back( "--maxdistance" );
+	parser->addOptionFlagsWithParameters( distanceOptions, "Specify a maximum pairing distance between nucleotides. Default is no restriction on distance between pairs." );
+
+	// Add the MEA option.
+	vector<string> meaOptions;
+	meaOptions.push_back( "-mea" );
+	meaOptions.push_back( "-MEA" );
+	meaOptions.push_back( "--MEA" );
+	parser->addOptionFlagsNoParameters( meaOptions, "Calculate the partition function of each sequence, and write its maximum expected accuracy structure. Default is to write the minimum free energy structure." );
+
+	// Add the temperature option.
+	vector<string> tempOptions;
+	tempOptions.push_back( "-t" );
+	tempOptions.push_back( "-T" );
+	tempOptions.push_back( "--temperature" );
+	parser->addOptionFlagsWithParameters( tempOptions, "Specify the temperature at which calculation takes place in Kelvin. Default is 310.15 K, which is 37 degrees C." );
+
+	// Parse the command line into pieces.
+	parser->parseLine( argc, argv );
+
+	// Get required parameters from the parser.
+	if( !parser->isError() ) {
+		fastaFile = parser->getParameter( 1 );
+		outFile = parser->getParameter( 2 );
+	}
+
+	// Get the DNA option.
+	if( !parser->isError() ) { isRNA = !parser->contains( dnaOptions ); }
+
+	// Get the calculation mode.
+	if( !parser->isError() ) {
+		if( parser->contains( meaOptions ) && parser->contains( ensembleOptions ) ) { parser->setErrorSpecialized( "The --MEA and --ensemble options cannot be used together." ); }
+		else if( parser->contains( meaOptions ) ) { mode = "MEA"; }
+		else if( parser->contains( ensembleOptions ) ) { mode = "ensemble"; }
+	}
+
+	// Get the gamma option.
+	if( !parser->isError() ) {
+		parser->setOptionDouble( gammaOptions, gamma );
+		if( gamma <= 0 ) { parser->setError( "gamma" ); }
+	}
+
+	// Get the dot-bracket option.
+	if( !parser->isError() ) { isBracket = parser->contains( bracketOptions ); }
+
+	// Get the maximum loop size option.
+	if( !parser->isError() ) {
+		parser->setOptionInteger( loopOptions, maxLoop );
+		if( maxLoop < 0 ) { parser->setError( "maximum loop size" ); }
+	}
+
+	// Get the maximum distance option.
+	if( !parser->isError() ) {
+		parser->setOptionInteger( distanceOptions, maxDistance );
+		bool badDistance =
+		  ( maxDistance < 0 ) &&
+		  ( maxDistance != -1 );
+		if( badDistance ) { parser->setError( "maximum pairing distance" ); }
+	}
+
+	// Get the temperature option.
+	if( !parser->isError() ) {
+		parser->setOptionDouble( tempOptions, temperature );
+		if( temperature < 0 ) { parser->setError( "temperature" ); }
+	}
+
+	// Delete the parser and return whether the parser encountered an error.
+	bool noError = ( parser->isError() == false );
+	delete parser;
+	return noError;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Fold one record.
+///////////////////////////////////////////////////////////////////////////////
+int BatchFold::foldRecord( const string& label, const string& sequence, pfdatatable* table, pfdatatable* master, RNA*& strand, double& energy ) {
+
+	// The constructor reports a sequence that is empty or has a character that is not a nucleotide.
+	strand = new RNA( sequence.c_str(), isRNA );
+	int error = strand->GetErrorCode();
+	if( error != 0 ) { return error; }
+
+	strand->CopyThermodynamic( thermo );
+	strand->GetStructure()->SetSequenceLabel( label );
+
+	// As in a sequence file, lower case nucleotides are forced single stranded.
+	for( int j = 0; j < (int) sequence.size() && error == 0; j++ ) {
+		if( islower( sequence[j] ) && sequence[j] != 'x' && sequence[j] != 'n' ) { error = strand->ForceSingleStranded( j + 1 ); }
+	}
+
+	if( error == 0 && maxDistance != -1 ) { error = strand->ForceMaximumPairingDistance( maxDistance ); }
+	if( error != 0 ) { return error; }
+
+	if( mode == "MFE" ) { return strand->FoldSingleStrand( 0, 1, 0, "", maxLoop, true ); }
+
+	strand->SetPartitionFunctionDatatable( table );
+	error = strand->PartitionFunction();
+
+	// Find the result while the table still has the scaling of this calculation.
+	if( error == 0 ) {
+		if( mode == "MEA" ) { error = strand->MaximizeExpectedAccuracy( 50, 1, 5, gamma ); }
+		else {
+			energy = strand->GetEnsembleEnergy();
+			error = strand->GetErrorCode();
+		}
+	}
+
+	// Put back the table if the calculation rescaled it.
+	if( !( table->scaling == master->scaling ) ) { *table = *master; }
+
+	return error;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Run calculations.
+///////////////////////////////////////////////////////////////////////////////
+void BatchFold::run() {
+
+	// Create a variable that handles errors.
+	int error = 0;
+
+	/*
+	 * Read the thermodynamic parameters once, into an instance without a sequence that every sequence copies.
+	 * Set the temperature first, because the parameters are read at that temperature.
+	 */
+	cout << "Reading thermodynamic parameters..." << flush;
+	thermo = new RNA( isRNA );
+	ErrorChecker<RNA>* checker = new ErrorChecker<RNA>( thermo );
+	error = checker->isErrorStatus( thermo->SetTemperature( temperature ) );
+	if( error == 0 ) { error = checker->isErrorStatus( thermo->ReadThermodynamic() ); }
+	if( error == 0 ) { cout << "done." << endl; }
+
+	/*
+	 * For the partition function, use the equilibrium constants cached with the parameters, which are made once.
+	 * A calculation may rescale its table, so each thread works on its own copy, which is restored from the cached table when that happens.
+	 */
+	int threads = 1;
+#ifdef SMP
+	threads = omp_get_max_threads();
+#endif
+	pfdatatable* pfmaster = NULL;
+	vector<pfdatatable*> pftables;
+	if( error == 0 && mode != "MFE" ) {
+		pfmaster = thermo->GetPfdatatable( thermo->GetTemperature() );
+		for( int t = 0; t < threads; t++ ) { pftables.push_back( new pfdatatable( *pfmaster ) ); }
+	}
+
+	/*
+	 * Open the FASTA file and the output file.
+	 * All the results are written through the output stream, which stays open until every record is done.
+	 */
+	FastaReader* in = NULL;
+	ofstream out;
+	if( error == 0 ) {
+		in = new FastaReader( fastaFile );
+		if( !in->isOpen() ) {
+			cerr << "Error: cannot open FASTA file " << fastaFile << "." << endl;
+			error = 1;
+		}
+	}
+	if( error == 0 ) {
+		out.open( outFile.c_str() );
+		if( !out ) {
+			cerr << "Error: cannot open output file " << outFile << "." << endl;
+			error = 1;
+		}
+	}
+
+	/*
+	 * Fold the sequences, a batch of records at a time.
+	 * The sequences of a batch are folded in parallel (in the SMP build), each into its own result slot, so no thread waits for another.
+	 * The results of the batch are then written in the order of the input.
+	 * An error in one sequence is reported, and the sequence is skipped.
+	 */
+	int folded = 0;
+	int failed = 0;
+	if( error == 0 ) {
+		cout << "Folding sequences..." << flush;
+
+		vector<string> labels;
+		vector<string> sequences;
+		while( in->readRecords( BATCH_SIZE, labels, sequences ) > 0 ) {
+
+			int records = (int) labels.size();
+			vector<RNA*> strands( records, (RNA*) NULL );
+			vector<int> foldErrors( records, 0 );
+			vector<double> energies( records, 0.0 );
+
+#ifdef SMP
+			#pragma omp parallel for schedule(dynamic)
+#endif
+			for( int i = 0; i < records; i++ ) {
+
+				// The partition function uses this thread's copy of the equilibrium constants.
+				int thread = 0;
+#ifdef SMP
+				thread = omp_get_thread_num();
+#endif
+				foldErrors[i] = foldRecord( labels[i], sequences[i], ( mode == "MFE" ) ? NULL : pftables[thread], pfmaster, strands[i], energies[i] );
+
+				// The ensemble energy is all that is written, so the strand is not kept.
+				if( mode == "ensemble" && foldErrors[i] == 0 ) {
+					delete strands[i];
+					strands[i] = NULL;
+				}
+			}
+
+			for( int i = 0; i < records; i++ ) {
+				if( foldErrors[i] != 0 ) {
+					cerr << endl << "Error in sequence " << labels[i] << ": " << strands[i]->GetErrorMessage( foldErrors[i] );
+					failed++;
+				}
+				else {
+					int writeError = 0;
+					if( mode == "ensemble" ) {
+						out << labels[i] << "\t" << energies[i] << "\n";
+						if( !out ) { writeError = 28; }
+					}
+					else { writeError = isBracket ? strands[i]->WriteDotBracket( out ) : strands[i]->WriteCt( out ); }
+
+					if( writeError != 0 ) {
+						cerr << endl << "Error in sequence " << labels[i] << ": " << thermo->GetErrorMessage( writeError );
+						failed++;
+					}
+					else { folded++; }
+				}
+
+				delete strands[i];
+			}
+		}
+
+		// Closing the file writes anything still buffered, which can also fail.
+		out.close();
+		if( !out ) {
+			cerr << endl << "Error: cannot write output file " << outFile << "." << endl;
+			error = 1;
+		}
+
+		cout << "done." << endl;
+		cout << "Folded " << folded << " sequences";
+		if( failed > 0 ) { cout << "; " << failed << " sequences had errors"; }
+		cout << "." << endl;
+	}
+
+	// Delete the FASTA reader, the copies of the equilibrium constants, the error checker, and the parameters.
+	// The cached table is deleted with the parameters.
+	delete in;
+	for( int t = 0; t < (int) pftables.size(); t++ ) { delete pftables[t]; }
+	delete checker;
+	delete thermo;
+
+	// Print confirmation of run finishing.
+	if( error == 0 && failed == 0 ) { cout << calcType << " complete." << endl; }
+	else { cerr << calcType << " complete with errors." << endl; }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Main method to run the program.
+///////////////////////////////////////////////////////////////////////////////
+int main( int argc, char* argv[] ) {
+
+	BatchFold* runner = new BatchFold();
+	bool parseable = runner->parse( argc, argv );
+	if( parseable == true ) { runner->run(); }
+	delete runner;
+	return 0;
+}
@@ -0,0 +1,96 @@
+/*
+ * A program that folds every sequence in a FASTA file, reading the thermodynamic parameters only once.
+ * The sequences can be composed of either DNA or RNA.
+ *
+ * (c) 2026 Mathews Lab, University of Rochester Medical Center.
+ */
+
+#ifndef BATCHFOLD_H
+#define BATCHFOLD_H
+
+#include "../RNA_class/RNA.h"
+#include "../src/ErrorChecker.h"
+#include "../src/FastaReader.h"
+#include "../src/ParseCommandLine.h"
+
+class BatchFold {
+ public:
+	// Public constructor and methods.
+
+	/*
+	 * Name:        Constructor.
+	 * Description: Initializes all private variables.
+	 */
+	BatchFold();
+
+	/*
+	 * Name:        parse
+	 * Description: Parses command line arguments to determine what options are required for a particular calculation.
+	 * Arguments:
+	 *     1.   The number of command line arguments.
+	 *     2.   The command line arguments themselves.
+	 * Returns:
+	 *     True if parsing completed without errors, false if not.
+	 */
+	bool parse( int argc, char** argv );
+
+	/*
+	 * Name:        run
+	 * Description: Run calculations.
+	 */
+	void run();
+
+ private:
+	// Private methods.
+
+	/*
+	 * Name:        foldRecord
+	 * Description: Fold one sequence with the parameters in thermo.
+	 * Arguments:
+	 *     1.   The sequence label.
+	 *     2.   The sequence.
+	 *     3.   The equilibrium constants for the partition function, which are restored from the fourth argument if the calculation rescales them.
+	 *          This is NULL for minimum free energy structures.
+	 *     4.   The equilibrium constants as made from the parameters.
+	 *     5.   The pointer that receives the new RNA. The caller deletes it.
+	 *     6.   The variable that receives the ensemble energy, for the ensemble energy calculation.
+	 * Returns:
+	 *     0 if there was no error, or an RNA error code.
+	 */
+	int foldRecord( const string& label, const string& sequence, pfdatatable* table, pfdatatable* master, RNA*& strand, double& energy );
+
+	// Private variables.
+
+	// Description of the calculation type.
+	string calcType;
+
+	// Input and output file names.
+	string fastaFile;        // The input FASTA file.
+	string outFile;          // The output file.
+
+	// The calculation done for each sequence: "MFE", "MEA", or "ensemble".
+	string mode;
+
+	// The gamma (weight of pairs) for MEA structures.
+	double gamma;
+
+	// Flag signifying if calculation handles RNA (true) or DNA (false).
+	bool isRNA;
+
+	// Flag signifying whether structures are written in dot-bracket format (true) or ct format (false).
+	bool isBracket;
+
+	// The maximum internal/bulge loop size.
+	int maxLoop;
+
+	// The maximum pairing distance.
+	int maxDistance;
+
+	// The temperature at which calculation occurs.
+	double temperature;
+
+	// The thermodynamic parameters, read once and shared with each sequence.
+	RNA* thermo;
+};
+
+#endif /* BATCHFOLD_H */
@@ -0,0 +1,142 @@
+/*
+ * A program that compiles the thermodynamic parameters into one binary file, which is mapped into memory
+ * in place of reading the text files.
+ *
+ * (c) 2026 Mathews Lab, University of Rochester Medical Center.
+ */
+
+#include "CompileParameters.h"
+#include <cstdlib>
+#include <sstream>
+
+///////////////////////////////////////////////////////////////////////////////
+// Constructor.
+///////////////////////////////////////////////////////////////////////////////
+CompileParameters::CompileParameters() {
+
+	// Initialize the calculation type description.
+	calcType = "Parameter compilation";
+
+	// Initialize the nucleic acid type.
+	isRNA = true;
+
+	// Initialize the file to be written, not checked.
+	check = false;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Parse the command line arguments.
+///////////////////////////////////////////////////////////////////////////////
+bool CompileParameters::parse( int argc, char** argv ) {
+
+	// Create the command line parser and build in its required parameters.
+	ParseCommandLine* parser = new ParseCommandLine( "CompileParameters" );
+	parser->addParameterDescription( "output file", "The name of the binary parameter file to write (or, with --check, to check). To be used in place of the text files, the file must be placed with them (in $DATAPATH), named parameters.bin for RNA or dnaparameters.bin for DNA. The file is specific to the build of RNAstructure that wrote it, and it must be written again after the text files are edited." );
+
+	// Add the DNA option.
+	vector<string> dnaOptions;
+	dnaOptions.push_back( "-d" );
+	dnaOptions.push_back( "-D" );
+	dnaOptions.push_back( "--DNA" );
+	parser->addOptionFlagsNoParameters( dnaOptions, "Compile the DNA parameters. Default is to compile the RNA parameters." );
+
+	// Add the temperatures option.
+	vector<string> tempOptions;
+	tempOptions.push_back( "-t" );
+	tempOptions.push_back( "-T" );
+	tempOptions.push_back( "--temperatures" );
+	parser->addOptionFlagsWithParameters( tempOptions, "Specify a comma-separated list of temperatures, in Kelvin, at which to store free energy changes in addition to 310.15 K. Parameters at these temperatures are loaded without any processing; parameters at other temperatures are calculated from those at 310.15 K and the enthalpy changes, which are also stored. Default is to store only 310.15 K." );
+
+	// Add the check option.
+	vector<string> checkOptions;
+	checkOptions.push_back( "-c" );
+	checkOptions.push_back( "-C" );
+	checkOptions.push_back( "--check" );
+	parser->addOptionFlagsNoParameters( checkOptions, "Check an existing binary parameter file, including the checksums of all its tables, instead of writing one. When the file is loaded, only the checksum of the table that is used is checked." );
+
+	// Parse the command line into pieces.
+	parser->parseLine( argc, argv );
+
+	// Get required parameters from the parser.
+	if( !parser->isError() ) { outFile = parser->getParameter( 1 ); }
+
+	// Get the DNA option.
+	if( !parser->isError() ) { isRNA = !parser->contains( dnaOptions ); }
+
+	// Get the check option.
+	if( !parser->isError() ) { check = parser->contains( checkOptions ); }
+
+	// Get the temperatures option.
+	if( !parser->isError() && parser->contains( tempOptions ) ) {
+		stringstream list( parser->getOptionString( tempOptions, false ) );
+		string item;
+		while( getline( list, item, ',' ) ) {
+			char* end;
+			double temperature = strtod( item.c_str(), &end );
+			if( item.empty() || *end != '\0' || temperature <= 0 ) {
+				parser->setError( "temperatures" );
+				break;
+			}
+			temperatures.push_back( temperature );
+		}
+	}
+
+	// Delete the parser and return whether the parser encountered an error.
+	bool noError = ( parser->isError() == false );
+	delete parser;
+	return noError;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Run calculations.
+///////////////////////////////////////////////////////////////////////////////
+void CompileParameters::run() {
+
+	RNA* thermo = new RNA( isRNA );
+
+	// Check an existing file.
+	if( check ) {
+		cout << "Checking the " << ( isRNA ? "RNA" : "DNA" ) << " parameter file..." << flush;
+		if( thermo->VerifyParameterFile( outFile.c_str() ) ) {
+			cout << "done." << endl;
+			cout << "The parameter file is valid." << endl;
+		}
+		else {
+			cout << endl;
+			cerr << "The parameter file is missing, was written by another build or for the other backbone type, or is corrupt." << endl;
+		}
+		delete thermo;
+		return;
+	}
+
+	// Show a message saying that the compilation has started.
+	cout << "Compiling the " << ( isRNA ? "RNA" : "DNA" ) << " parameters..." << flush;
+
+	// Read the text files and write the binary file.
+	int error = thermo->WriteParameterFile( outFile.c_str(), temperatures );
+
+	// Print confirmation of run finishing, or the error.
+	if( error == 0 ) {
+		cout << "done." << endl;
+		cout << calcType << " complete." << endl;
+	}
+	else {
+		cout << endl;
+		cerr << thermo->GetErrorMessage( error );
+		cerr << calcType << " complete with errors." << endl;
+	}
+
+	delete thermo;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Main method to run the program.
+///////////////////////////////////////////////////////////////////////////////
+int main( int argc, char* argv[] ) {
+
+	CompileParameters* runner = new CompileParameters();
+	bool parseable = runner->parse( argc, argv );
+	if( parseable == true ) { runner->run(); }
+	delete runner;
+	return 0;
+}
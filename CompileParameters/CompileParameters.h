@@ -0,0 +1,60 @@
+/*
+ * A program that compiles the thermodynamic parameters into one binary file, which is mapped into memory
+ * in place of reading the text files.
+ *
+ * (c) 2026 Mathews Lab, University of Rochester Medical Center.
+ */
+
+#ifndef COMPILEPARAMETERS_H
+#define COMPILEPARAMETERS_H
+
+#include "../RNA_class/RNA.h"
+#include "../src/ParseCommandLine.h"
+
+class CompileParameters {
+ public:
+	// Public constructor and methods.
+
+	/*
+	 * Name:        Constructor.
+	 * Description: Initializes all private variables.
+	 */
+	CompileParameters();
+
+	/*
+	 * Name:        parse
+	 * Description: Parses command line arguments to determine what options are required for a particular calculation.
+	 * Arguments:
+	 *     1.   The number of command line arguments.
+	 *     2.   The command line arguments themselves.
+	 * Returns:
+	 *     True if parsing completed without errors, false if not.
+	 */
+	bool parse( int argc, char** argv );
+
+	/*
+	 * Name:        run
+	 * Description: Run calculations.
+	 */
+	void run();
+
+ private:
+	// Private variables.
+
+	// Description of the calculation type.
+	string calcType;
+
+	// The output file name.
+	string outFile;
+
+	// Flag signifying if the parameters are for RNA (true) or DNA (false).
+	bool isRNA;
+
+	// Flag signifying if the file is checked (true) instead of written (false).
+	bool check;
+
+	// The temperatures, other than 310.15 K, at which free energy changes are stored.
+	vector<double> temperatures;
+};
+
+#endif /* COMPILEPARAMETERS_H */
@@ -9,7 +9,8 @@ int main( int argc, char* argv[] ) {
   // Do error checking on the command line, make sure its usage is correct.
   if( argc != 2 ) {
     cerr << "Incorrect number of command line arguments given." << endl
-         << "USAGE: PARTS <configuration file>" << endl << endl
+         << "USAGE: PARTS <configuration file>" << endl
+	 << "OR:    PARTS-smp <configuration file>" << endl << endl
 	 << "Configuration file format:" << endl
 	 << "<flag> <value> <new line> ..." << endl << endl
 	 << "Configuration file flags:" << endl
@@ -55,6 +56,10 @@ int main( int argc, char* argv[] ) {
          << "    Pseudo-random number generator seed." << endl
          << "    (stochastic sampling mode only)"
          << endl << endl
+	 << "threads" << endl
+	 << "    Number of threads used by PARTS-smp." << endl
+	 << "    (0, the default, uses the OpenMP default)"
+	 << endl << endl
 	 << "Flags 'seq1,' 'seq2', and 'mode' are required to run PARTS."
 	 << endl
 	 << "The other flags are optional." << endl << endl
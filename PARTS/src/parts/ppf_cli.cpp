@@ -776,6 +776,12 @@ if(_DUMP_PPF_CLI_MESSAGES_)
 				printf("Read maximum separation: %d\n", this->max_n_separation_between_nucs);
 				p_cnt++;
 			}
+			else if(strcmp(argv[p_cnt], "-threads") == 0)
+			{
+				p_cnt++;
+				this->n_threads = atoi(argv[p_cnt]);
+				p_cnt++;
+			}
 			else if(strcmp(argv[p_cnt], "-fold_env_prob_treshold") == 0)
 			{
 				p_cnt++;
@@ -853,6 +859,7 @@ void t_ppf_cli::init_paths_vars()
 	this->stoch_sampling_seed = 0xfffff;
 
 	this->max_n_separation_between_nucs = 0x1fffffff;
+	this->n_threads = 0;
 	this->phmm_band_constraint_size = 0x1fffffff;
 
 	this->seq1_path = NULL;
@@ -954,7 +961,8 @@ void t_ppf_cli::print_usage_msg()
 				-fold_env_prob_treshold [minimum probability threshold for allocation of single pairing arrays] {ENTOR}\n\
 				-array_mem_limit_in_megs [soft limit on memory to be allocated to arrays in Megabytes.\n\
 				-phmm_band_constraint_size [Size of band constraint on all of HMM computations]\n\
-				-str_coinc_env_prob_treshold [minimum probability threshold for allocation of co-incident positions]\n\n\
+				-str_coinc_env_prob_treshold [minimum probability threshold for allocation of co-incident positions]\n\
+				-threads [number of threads for PARTS-smp, 0 for the OpenMP default]\n\n\
 			Example of a configuration file: \n\
 				seq1 RD0260.seq \n\
 				seq2 RE2140.seq \n\
@@ -1111,6 +1119,10 @@ if(_DUMP_PPF_CLI_MESSAGES_)
                         this->stoch_sampling_seed = atoi(cur_val);
 			//printf("Set stoch sampling seed to %d\n", this->stoch_sampling_seed);
                 }
+		else if(strcmp(cur_option, "threads") == 0)
+		{
+			this->n_threads = atoi(cur_val);
+		}
 	}
 
 	fclose(f_conf);
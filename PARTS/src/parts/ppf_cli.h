@@ -156,6 +156,10 @@ class t_ppf_cli
 
 	int max_n_separation_between_nucs;
 
+	// Number of threads for the loop computations of PARTS-smp, 0 for the OpenMP default.
+	// Input by -threads flag or threads option.
+	int n_threads;
+
 	double fold_env_prob_treshold;
 	double str_coinc_env_prob_treshold;
 
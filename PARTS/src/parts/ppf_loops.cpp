@@ -52,6 +52,10 @@
 
 #include "array_file_manager.h"
 
+#ifdef SMP
+#include <omp.h>
+#endif
+
 // Stochastic traceback code.
 #include "stoch_tb/stoch_sampled_str_aln_sample_set.h"
 #include "stoch_tb/stoch_sampling_math.h"
@@ -831,136 +835,173 @@ if(_DUMP_PPF_LOOPS_MESSAGES_)
 
 void t_ppf_loops::compute_internal_pseudo_free_energy_loops()
 {
-	int r_i = 0;
-	int r_j = 0;
-	int r_k = 0;
-	int r_l = 0;
-
 	int N1 = seq_man->get_l_seq1();
-	int N2 = seq_man->get_l_seq2();
 
-	int low_k, high_k, low_l, high_l;
+#ifdef SMP
+	// Each cell depends only on the cells of its own (i, j) band and on cells whose seq1 interval is inside [i, j],
+	// so the bands with the same j-i do not depend on each other and are computed in parallel.
+	// A band that needs rescaling stops at that cell, and continues from it after the arrays are rescaled.
+	if(ppf_cli->n_threads > 0)
+	{
+		omp_set_num_threads(ppf_cli->n_threads);
+	}
+
+	int max_span = MIN(N1 - 1, ppf_cli->max_n_separation_between_nucs);
 
 	// progress bar to print a nice progress bar.
-	t_ppf_progress_bar* ppf_progress_bar = new t_ppf_progress_bar(ppf_cli, '=', true, this->seq_man->get_l_seq1());
+	t_ppf_progress_bar* ppf_progress_bar = new t_ppf_progress_bar(ppf_cli, '=', true, max_span);
 
-	// Main loop calculation:
-	for(int j = 1; j <= N1; j++)
+	// The cell each band continues from, and whether the band is done; indexed by i.
+	int* band_l = new int[N1 + 1];
+	int* band_k = new int[N1 + 1];
+	bool* band_done = new bool[N1 + 1];
+
+	for(int span = 1; span <= max_span; span++)
 	{
-		ppf_progress_bar->update_bar(j);
+		ppf_progress_bar->update_bar(span);
 
-		for( int i = j-1; i >= MAX(j - ppf_cli->max_n_separation_between_nucs, 1); i--)
+		for(int i = 1; i <= N1 - span; i++)
 		{
-			bool ij_coinc = true;
-			if(seq1_spf->folding_constraints->coinc_pointer_relocation_map != NULL && seq1_spf->folding_constraints->coinc_pointer_relocation_map[i][j] == POS_MEM_NOT_EXIST)
-			{
-				ij_coinc = false;
-			}
-
-			low_l = MAX( t_template_pf_array::low_limits[j], 1 );
-			high_l = MIN( t_template_pf_array::high_limits[j], N2 );
+			band_l[i] = 0;
+			band_done[i] = false;
+		}
 
-			for ( int l = low_l; ij_coinc && l <= high_l; l++ )
+		bool bands_left = true;
+		while(bands_left)
+		{
+			#pragma omp parallel for schedule(dynamic)
+			for(int i = 1; i <= N1 - span; i++)
 			{
-				low_k = MAX(MAX(l - ppf_cli->max_n_separation_between_nucs, 1), t_template_pf_array::low_limits[i-1] + 1);
-				high_k = MIN(l - 1, t_template_pf_array::high_limits[i - 1]+1);
-
-				for ( int k = high_k; k >= low_k; k-- )
+				if(!band_done[i])
 				{
-					bool kl_coinc = true;
-					if(seq2_spf->folding_constraints->coinc_pointer_relocation_map != NULL && seq2_spf->folding_constraints->coinc_pointer_relocation_map[k][l] == POS_MEM_NOT_EXIST)
-					{
-						kl_coinc = false;
-					}
-
-					// Make sure that there is at least MIN_LOOP of distance between i-j and k-l.
-					if(kl_coinc)
-					{
-
-if(_DUMP_PPF_LOOPS_MESSAGES_)
-{
-						printf("----------------------------------------------\n");
-						printf("Calculating (%d, %d, %d, %d):\n", i, j, k, l);
-}
+					band_done[i] = this->compute_internal_pseudo_free_energy_band(i, i + span, band_l[i], band_k[i]);
+				}
+			} // i loop
 
-#ifdef _LINEAR_COMPUTATIONS_
-						do 
-						{
-#endif		
-							if( ( (j > N1 || (j-i) > MIN_LOOP) &&  (l>N2 || (l-k) > MIN_LOOP) ) 
-								&& ( (l <= N2 || k - (l - N2) > MIN_LOOP) && (j <= N1 || i - (j - N1) > MIN_LOOP) ) // To impose constraint on the length of interior loop when exterior loop is calculated.
-								)
-							{
+			// Rescale once for the bands that stopped; each of them recomputes its cell and checks it again.
+			bands_left = false;
+			for(int i = 1; !bands_left && i <= N1 - span; i++)
+			{
+				if(!band_done[i])
+				{
+					ppf_scaler->rescale_pp_ppf_arrays(i, i + span, band_k[i], band_l[i]);
+					bands_left = true;
+				}
+			} // i loop
+		}
+	} // span loop
 
-								V_mhe->calculate_V_mhe(i, j, k, l); // Arrays to use.
-							}
+	delete [] band_l;
+	delete [] band_k;
+	delete [] band_done;
+#else
+	// progress bar to print a nice progress bar.
+	t_ppf_progress_bar* ppf_progress_bar = new t_ppf_progress_bar(ppf_cli, '=', true, N1);
 
-							W_mhi->calculate_ij_W_mhi(i, j, k, l); // Arrays to use. 
-							W_mhi->calculate_kl_W_mhi(i, j, k, l); // Arrays to use. 
-							WL->calculate_WL(i, j, k, l); // Arrays to use.
-							W->calculate_W(i, j, k, l); // Arrays to use.
-							WMBL->calculate_WMBL(i, j, k, l); // Arrays to use.
-							WMB->calculate_WMB(i, j, k, l); // Arrays to use.
+	// Main loop calculation:
+	for(int j = 1; j <= N1; j++)
+	{
+		ppf_progress_bar->update_bar(j);
 
-#ifdef _LINEAR_COMPUTATIONS_
-						}
-						while(ppf_scaler->check_pp_ppf_array_rescale(i, j, k, l));
+		for( int i = j-1; i >= MAX(j - ppf_cli->max_n_separation_between_nucs, 1); i--)
+		{
+			// Rescale and recompute the cell until it does not need rescaling.
+			int l = 0;
+			int k = 0;
+			while(!this->compute_internal_pseudo_free_energy_band(i, j, l, k))
+			{
+				ppf_scaler->rescale_pp_ppf_arrays(i, j, k, l);
+			}
+		} // i loop
+	} // j loop
 #endif
 
-extern bool _DUMP_PPF_V_MHE_MESSAGES_;
+	delete(ppf_progress_bar);
 
-						//if(i == 1 && j == 73 && k == 1 && l == 72)
-						//{
-						//	printf("Vmhe(2, 72, 2, 71) = %lf\n", this->ppf_scaler->get_unscaled_log_value_by_indices(2,72,2,71,this->V_mhe->x(2,72,2,71)));
-						//}
+	//this->dump_internal_arrays();
+
+	//exit(0);
+}
 
-						//if(i == 1 && k == 1 && j >= 73 && l >= 72)
-						//if(i == 1 && j == 73 && k == 1 && l == 72)						
-						//{
-						//	_DUMP_PPF_V_MHE_MESSAGES_ = true;
+// Compute the cells of seq1 interval (i, j), with l increasing and k decreasing, starting from the cell (k, l);
+// l is 0 to start from the first cell.
+// Returns false, with l and k set to the cell, if a cell needs rescaling; the arrays are not rescaled.
+bool t_ppf_loops::compute_internal_pseudo_free_energy_band(int i, int j, int& l, int& k)
+{
+	int N1 = seq_man->get_l_seq1();
+	int N2 = seq_man->get_l_seq2();
 
-						//	//this->ppf_loops->V_mhe->calculate_V_mhe(i,j,k,l, false);
+	int low_k, high_k, low_l, high_l;
 
-						//	//printf("V_mhe(%d, %d, %d, %d) = %.15f\n", i,j,k,l,this->ppf_loops->V_mhe->x(i,j,k,l));							
+	if(seq1_spf->folding_constraints->coinc_pointer_relocation_map != NULL && seq1_spf->folding_constraints->coinc_pointer_relocation_map[i][j] == POS_MEM_NOT_EXIST)
+	{
+		return(true);
+	}
 
-						//	//printf("Doing spurious Vmhe backtrack.\n");
-						//	//printf("Vmhe(2, 72, 2, 71) = %lf\n", this->ppf_scaler->get_unscaled_log_value_by_indices(2,72,2,71,this->V_mhe->x(2,72,2,71)));
+	low_l = MAX( t_template_pf_array::low_limits[j], 1 );
+	high_l = MIN( t_template_pf_array::high_limits[j], N2 );
 
-						//	// Allocate map structure objects for traceback.
-						//	this->map_strs = new t_MAP_structures(seq_man, ppf_cli);
+	int start_k = 0;
+	if(l == 0)
+	{
+		l = low_l;
+	}
+	else
+	{
+		start_k = k;
+	}
 
-						//	// Alignment information.
-						//	this->map_alignment = new t_MAP_alignment(seq_man, ppf_cli);
+	for ( ; l <= high_l; l++ )
+	{
+		low_k = MAX(MAX(l - ppf_cli->max_n_separation_between_nucs, 1), t_template_pf_array::low_limits[i-1] + 1);
+		high_k = MIN(l - 1, t_template_pf_array::high_limits[i - 1]+1);
 
-						//	this->tb_stack = new t_ppf_tb_stack();
+		for ( k = (start_k != 0)?(start_k):(high_k); k >= low_k; k-- )
+		{
+			bool kl_coinc = true;
+			if(seq2_spf->folding_constraints->coinc_pointer_relocation_map != NULL && seq2_spf->folding_constraints->coinc_pointer_relocation_map[k][l] == POS_MEM_NOT_EXIST)
+			{
+				kl_coinc = false;
+			}
 
-						//	//this->ppf_loops->V_mhe->calculate_V_mhe(1, 73, 1, 72, true);
-						//	this->V_mhe->calculate_V_mhe(2,72,2,71, true);
-						//	printf("V_mhe(%d, %d, %d, %d) = %.15f\n", 2,72,2,71,this->V_mhe->x(2,72,2,71));	
+			// Make sure that there is at least MIN_LOOP of distance between i-j and k-l.
+			if(kl_coinc)
+			{
 
-						//	delete(this->map_strs);
-						//	delete(this->map_alignment);
-						//	delete(this->tb_stack);
+if(_DUMP_PPF_LOOPS_MESSAGES_)
+{
+				printf("----------------------------------------------\n");
+				printf("Calculating (%d, %d, %d, %d):\n", i, j, k, l);
+}
 
-						//	this->map_strs = NULL;
-						//	this->map_alignment = NULL;
-						//	this->tb_stack = NULL;
-						//	exit(0);
+				if( ( (j > N1 || (j-i) > MIN_LOOP) &&  (l>N2 || (l-k) > MIN_LOOP) ) 
+					&& ( (l <= N2 || k - (l - N2) > MIN_LOOP) && (j <= N1 || i - (j - N1) > MIN_LOOP) ) // To impose constraint on the length of interior loop when exterior loop is calculated.
+					)
+				{
 
-						//	//_DUMP_PPF_V_MHE_MESSAGES_ = false;
-						//}
+					V_mhe->calculate_V_mhe(i, j, k, l); // Arrays to use.
+				}
 
-					} // Loop limit if for internal and external checks on i-j and k-l.				
-				} // k loop
-			} // l loop
-		} // i loop
-	} // j loop
+				W_mhi->calculate_ij_W_mhi(i, j, k, l); // Arrays to use. 
+				W_mhi->calculate_kl_W_mhi(i, j, k, l); // Arrays to use. 
+				WL->calculate_WL(i, j, k, l); // Arrays to use.
+				W->calculate_W(i, j, k, l); // Arrays to use.
+				WMBL->calculate_WMBL(i, j, k, l); // Arrays to use.
+				WMB->calculate_WMB(i, j, k, l); // Arrays to use.
 
-	delete(ppf_progress_bar);
+#ifdef _LINEAR_COMPUTATIONS_
+				if(ppf_scaler->check_pp_ppf_array_overflow(i, j, k, l))
+				{
+					return(false);
+				}
+#endif
+			} // Loop limit if for internal and external checks on i-j and k-l.				
+		} // k loop
 
-	//this->dump_internal_arrays();
+		start_k = 0;
+	} // l loop
 
-	//exit(0);
+	return(true);
 }
 
 void t_ppf_loops::load_internal_arrays(char* arrays_dir)
@@ -95,6 +95,7 @@ public:
 	//int compute_pseudo_free_energy_loops();
 	int compute_pseudo_free_energy_loops();
 	void compute_internal_pseudo_free_energy_loops();
+	bool compute_internal_pseudo_free_energy_band(int i, int j, int& l, int& k);
 	void compute_external_pseudo_free_energy_loops();
 
 	int mallocate_arrays();
@@ -251,28 +251,11 @@ void t_ppf_scale::copy_scales_to_spf_by_id(int id, double* spf_scales)
 // This function interrupts main loop calculations in pp mode.
 bool t_ppf_scale::check_pp_ppf_array_rescale(int i, int j, int k, int l)
 {
-	// Check all array values against MAX_ARRAY_VALUE_LIMIT,
-	// if there is no possible overflow yet, return false and return.
+	// If there is no possible overflow yet, return false and return.
 	// otherwise rescale all arrays over again with rescale_factor.
-	if(this->ppf_loops->WL->x(i,j,k,l) > MAX_ARRAY_VALUE_LIMIT ||
-		this->ppf_loops->W->x(i,j,k,l) > MAX_ARRAY_VALUE_LIMIT ||
-		this->ppf_loops->WMBL->x(i,j,k,l) > MAX_ARRAY_VALUE_LIMIT ||
-        this->ppf_loops->WMB->x(i,j,k,l) > MAX_ARRAY_VALUE_LIMIT ||
-		this->ppf_loops->W_mhi->x_ij(i,j,k,l) > MAX_ARRAY_VALUE_LIMIT ||
-		this->ppf_loops->W_mhi->x_kl(i,j,k,l) > MAX_ARRAY_VALUE_LIMIT ||
-		this->ppf_loops->V_mhe->x(i,j,k,l) > MAX_ARRAY_VALUE_LIMIT ||
-		this->ppf_loops->W_ext->x(j,l) > MAX_ARRAY_VALUE_LIMIT)
+	if(this->check_pp_ppf_array_overflow(i,j,k,l))
 	{
-		char panic_msg[500];
-		sprintf(panic_msg, "One of the PPF arrays of indices (%d, %d, %d, %d) need down scaling @ %s(%d)", i,j,k,l, __FILE__, __LINE__);
-		//ppf_panic(panic_msg, this->ppf_cli);
-
-		// Update all scaling factors.
-		// This is done for once and the rescaling 
-		this->increment_scales_by_rescale(false);
-
-		// Need a rescaling update and rescaling here.
-		this->ppf_loops->rescale_all_ppf_arrays_by_indices(i, j, k, l, false);
+		this->rescale_pp_ppf_arrays(i,j,k,l);
 
 		return(true);
 	}
@@ -282,6 +265,35 @@ bool t_ppf_scale::check_pp_ppf_array_rescale(int i, int j, int k, int l)
 	}
 }
 
+// Check all array values of indices (i, j, k, l) against MAX_ARRAY_VALUE_LIMIT.
+// This only reads the arrays, so it can be called for different cells at the same time.
+bool t_ppf_scale::check_pp_ppf_array_overflow(int i, int j, int k, int l)
+{
+	return(this->ppf_loops->WL->x(i,j,k,l) > MAX_ARRAY_VALUE_LIMIT ||
+		this->ppf_loops->W->x(i,j,k,l) > MAX_ARRAY_VALUE_LIMIT ||
+		this->ppf_loops->WMBL->x(i,j,k,l) > MAX_ARRAY_VALUE_LIMIT ||
+		this->ppf_loops->WMB->x(i,j,k,l) > MAX_ARRAY_VALUE_LIMIT ||
+		this->ppf_loops->W_mhi->x_ij(i,j,k,l) > MAX_ARRAY_VALUE_LIMIT ||
+		this->ppf_loops->W_mhi->x_kl(i,j,k,l) > MAX_ARRAY_VALUE_LIMIT ||
+		this->ppf_loops->V_mhe->x(i,j,k,l) > MAX_ARRAY_VALUE_LIMIT ||
+		this->ppf_loops->W_ext->x(j,l) > MAX_ARRAY_VALUE_LIMIT);
+}
+
+// Down scale all internal arrays after one of the arrays of indices (i, j, k, l) went over MAX_ARRAY_VALUE_LIMIT.
+void t_ppf_scale::rescale_pp_ppf_arrays(int i, int j, int k, int l)
+{
+	char panic_msg[500];
+	sprintf(panic_msg, "One of the PPF arrays of indices (%d, %d, %d, %d) need down scaling @ %s(%d)", i,j,k,l, __FILE__, __LINE__);
+	//ppf_panic(panic_msg, this->ppf_cli);
+
+	// Update all scaling factors.
+	// This is done for once and the rescaling 
+	this->increment_scales_by_rescale(false);
+
+	// Need a rescaling update and rescaling here.
+	this->ppf_loops->rescale_all_ppf_arrays_by_indices(i, j, k, l, false);
+}
+
 bool t_ppf_scale::check_pp_ppf_external_array_rescale(int i, int j, int k, int l)
 {
 	bool need_rescaling = false;
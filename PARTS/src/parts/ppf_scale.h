@@ -47,6 +47,8 @@ public:
 	// Rescale check function, calls each array to rescale if going out of precision for
 	// one of the arrays.
 	bool check_pp_ppf_array_rescale(int i, int j, int k, int l);
+	bool check_pp_ppf_array_overflow(int i, int j, int k, int l);
+	void rescale_pp_ppf_arrays(int i, int j, int k, int l);
 	bool check_pp_ppf_external_array_rescale(int i, int j, int k, int l);
 
 	bool check_back_frag_array_rescale(int i, int j, int k, int l,
@@ -237,12 +237,12 @@ Dynalign_object::Dynalign_object(const char* filename, const short maxtrace, con
 int Dynalign_object::Dynalign(const short int maxtrace, 
                               const short int bpwin, const short int awin, const short int percent, const short int imaxseparation, const float slope, const float intercept, const float gap, const int max_elongation, const char savefile[], const bool optimalonly, const short int singlefold_subopt_percent, const bool local, 
 	const short int numProcessors,
-      const int maxpairs)
+      const int maxpairs, const double maxmemory)
 #else
 int Dynalign_object::Dynalign(const short int maxtrace, 
 	const short int bpwin, const short int awin, const short int percent, const short int imaxseparation, const float gap, const bool singleinsert, const char savefile[], const bool optimalonly, const short int singlefold_subopt_percent, const bool local, 
 	const short int numProcessors,
-      const int maxpairs)
+      const int maxpairs, const double maxmemory)
 #endif
 
  {
@@ -335,12 +335,12 @@ int Dynalign_object::Dynalign(const short int maxtrace,
 	errormessage = dynalign(GetRNA1()->GetStructure(), GetRNA2()->GetStructure(), align, imaxseparation, islope, iintercept, igapincrease, GetRNA1()->GetDatatable(),
                                  maxtrace, bpwin, awin, percent, forcealign, max_elongation, allowed_alignments, GetRNA1()->GetProgress(),
            savefile, optimalonly, local,
-           /*force =*/ constraints, numProcessors); 
+           /*force =*/ constraints, numProcessors, maxmemory, &plannedmemory); 
 #else	
 	errormessage = dynalign(GetRNA1()->GetStructure(), GetRNA2()->GetStructure(), align, imaxseparation, igapincrease, GetRNA1()->GetDatatable(),
            singleinsert, maxtrace, bpwin, awin, percent, forcealign, allowed_alignments, GetRNA1()->GetProgress(),
            savefile, optimalonly, local,
-           /*force =*/ constraints, numProcessors); 
+           /*force =*/ constraints, numProcessors, maxmemory, &plannedmemory); 
 #endif
 	
 
@@ -624,6 +624,12 @@ double Dynalign_object::GetLowestEnergy() {
 
 }
 
+//Report the memory planned for the arrays kept in memory by the last Dynalign calculation.
+double Dynalign_object::GetPlannedMemory() {
+
+	return plannedmemory;
+}
+
 
 //Return error messages based on code from GetErrorCode and other error codes.		
 
@@ -749,6 +755,9 @@ void Dynalign_object::CommonConstructor() {
 	//By default, pair energies are not needed
 	array = NULL;
 
+	//No Dynalign calculation has been planned
+	plannedmemory = 0;
+
 
 }
 
@@ -111,17 +111,19 @@ class Dynalign_object:  public TwoRNA {
 		//! \param local is whether Dynalign is being run in local (true) or global mode (false).
 		//! \param numProcessors is the number of processors to use for the calculation.  This requires a compilation for SMP.
 		//! \param maxpairs is under development for multiple sequence folding.  Use -1 (default) for now.
+		//! \param maxmemory is the most memory, in megabytes, for the arrays that are filled.  Arrays beyond this are put in temporary spill files
+		//!	that are paged to disk as needed, which is slower but gives the same result.  0 (default) is no limit.  GetPlannedMemory() reports the plan.
 		//! \return An int that indicates an error code (0 = no error, non-zero = error occurred).
 #ifdef DYNALIGN_II
 	int Dynalign(const short int maxtrace, 
                      const short int bpwin, const short int awin, const short int percent, const short int imaxseparation=-99, const float slope = 0.1, const float intercept = 0.5, const float gap=0.4, const int max_elongation = 5, 
 			const char savefile[]=NULL, const bool optimalonly=false, const short int singlefold_subopt_percent=30, const bool local=false, 
-			const short int numProcessors=1, const int maxpairs=-1);
+			const short int numProcessors=1, const int maxpairs=-1, const double maxmemory=0);
 #else
 		int Dynalign(const short int maxtrace, 
 			const short int bpwin, const short int awin, const short int percent, const short int imaxseparation=-99, const float gap=0.4, const bool singleinsert=true, 
 			const char savefile[]=NULL, const bool optimalonly=false, const short int singlefold_subopt_percent=30, const bool local=false, 
-			const short int numProcessors=1, const int maxpairs=-1);
+			const short int numProcessors=1, const int maxpairs=-1, const double maxmemory=0);
 #endif
 
 		//******************************************************
@@ -218,6 +220,13 @@ class Dynalign_object:  public TwoRNA {
 		//!The errorcode can be resolved to a c string using GetErrorMessage.
 		//!\return a double that gives an energy in kcal/mol.
 		double GetLowestEnergy();
+
+
+		//!Report the memory planned for the arrays kept in memory by the last call to Dynalign().
+
+		//!This is the peak memory of the arrays, apart from any that were put in spill files because of the maxmemory parameter of Dynalign().
+		//!\return a double that gives the memory in megabytes, or 0 if Dynalign() has not been called.
+		double GetPlannedMemory();
 	
 
 		//******************************************************
@@ -310,6 +319,8 @@ class Dynalign_object:  public TwoRNA {
 		bool savefileread;//a bool to indicate that a savefile was read.
 
 		double ***array;//a 3-D array to hold to store pair energies
+
+		double plannedmemory;//the memory in megabytes planned by the last Dynalign calculation
 	
 
 
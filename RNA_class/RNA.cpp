@@ -79,14 +79,21 @@ RNA::RNA(const char sequence[], const bool IsRNA):Thermodynamics(IsRNA) {
 	//Indicate that the partition function calculation has not been performed.
 	partitionfunctionallocated = false;
 
+	//PartitionFunction() makes its own equilibrium constants unless SetPartitionFunctionDatatable() is called.
+	sharedpfdata = NULL;
+	pfdatashared = false;
+	pfsmapping = NULL;
+
 	//Indicate that the energy data is not read.
 	energyallocated = false;
 
 	//Drawing coordinates have not been determined.
 	drawallocated = false;
 
-	//set error status to zero
+	//set error status to zero, unless the sequence is empty or has a character that a sequence file does not allow
 	ErrorCode=0;
+	if (ct->GetSequenceLength()==0) ErrorCode=20;
+	else if (strspn(sequence,"ACGTUXNacgtuxn")<strlen(sequence)) ErrorCode=27;
 
 	//Do not report progress by default:
 	progress=NULL;
@@ -110,6 +117,11 @@ RNA::RNA(const char filename[], const int type, const bool IsRNA ):Thermodynamic
 	//Indicate that the partition function calculation has not been performed.
 	partitionfunctionallocated = false;
 
+	//PartitionFunction() makes its own equilibrium constants unless SetPartitionFunctionDatatable() is called.
+	sharedpfdata = NULL;
+	pfdatashared = false;
+	pfsmapping = NULL;
+
 	//Indicate that the energy data is not (yet) read.
 	energyallocated = false;
 
@@ -144,6 +156,11 @@ RNA::RNA(const bool IsRNA):Thermodynamics(IsRNA) {
 	//Indicate that the partition function calculation has not been performed.
 	partitionfunctionallocated = false;
 
+	//PartitionFunction() makes its own equilibrium constants unless SetPartitionFunctionDatatable() is called.
+	sharedpfdata = NULL;
+	pfdatashared = false;
+	pfsmapping = NULL;
+
 	//Indicate that the energy data is not (yet) read.
 	energyallocated = false;
 
@@ -196,6 +213,8 @@ char* RNA::GetErrorMessage(const int error) {
 	else if (error==24) return "Too few iterations.  There must be at least one iteration.\n";
 	else if (error==25) return "Index is not a multiple of 10.\n";
 	else if (error==26) return "k, the equilibrium constant, needs to be greater than or equal to 0.\n";
+	else if (error==27) return "The sequence has a character that is not a nucleotide.\n";
+	else if (error==28) return "Error writing to file.\n";
 	else return "Unknown Error\n";
 
 
@@ -598,6 +617,13 @@ int RNA::PredictProbablePairs(const float probability) {
 
 
 
+}
+
+//Provide the equilibrium constants for subsequent partition function calculations.
+void RNA::SetPartitionFunctionDatatable(pfdatatable *table) {
+
+	sharedpfdata = table;
+
 }
 
 //Calculate the partition function for the current sequence.
@@ -632,7 +658,9 @@ int RNA::PartitionFunction(const char savefile[], double temperature) {
 		delete[] mod;
 		delete[] w3;
 		delete[] w5;
-		delete pfdata;
+		if (!pfdatashared) delete pfdata;
+		delete pfsmapping;
+		pfsmapping = NULL;
 	}
 	//Allocate the memory needed (only if this is the first call to pfunction):
 	//indicate that the memory has been allocated so that the destructor will delete it.
@@ -688,10 +716,19 @@ int RNA::PartitionFunction(const char savefile[], double temperature) {
 	}
 
 	//Initialize the partition function datatable:
+		//Use the table from SetPartitionFunctionDatatable(), if there is one.
 		//Ignore the setting of parameter temperature if it is less than zero.
 		//Generally, this parameter should be left at the default.
-	if (temperature<0) pfdata=new pfdatatable(data,scalingdefinition,temp);
-	else pfdata=new pfdatatable(data,scalingdefinition,temperature);
+		//Otherwise copy the table cached with the parameters, because the calculation can rescale it.
+	pfdatashared = (sharedpfdata!=NULL);
+	if (pfdatashared) pfdata=sharedpfdata;
+	else {
+		pfdatatable *cachedpfdata = GetPfdatatable(temperature<0?temp:temperature);
+
+		if (cachedpfdata!=NULL) pfdata=new pfdatatable(*cachedpfdata);
+		else if (temperature<0) pfdata=new pfdatatable(data,scalingdefinition,temp);
+		else pfdata=new pfdatatable(data,scalingdefinition,temperature);
+	}
 
 	//This code converts the SHAPE array of data to equilibrium constants.  This is
 	//needed for the partition function.  NOTE, however, there is no going back so a structure
@@ -848,6 +885,24 @@ int RNA::Stochastic(const int structures, const int seed) {
 }
 
 
+//Sample structures from the Boltzman ensemble, and count the pairs in them.
+int RNA::Stochastic(const int structures, const int seed, stochasticcounts *counts) {
+
+	if (!partitionfunctionallocated) {
+		//There is no partition function data available.
+		return 15;
+	}
+
+
+	//Past error trapping, call the stochastic traceback function
+	return stochastictraceback(w,wmb,wmbl,wcoax,wl,v,
+		fce, w3,w5,pfdata->scaling, lfce, mod, pfdata, structures,
+		ct, seed, progress, counts);
+
+
+}
+
+
 //Force a nucleotide to be double stranded (base paired).
 //Return an integer that indicates an error code (0 = no error, 4 = nucleotide out of range, 8 = too many restraints specified, 9 = same nucleotide in conflicting restraint).
 int RNA::ForceDoubleStranded(const int i) {
@@ -1469,10 +1524,34 @@ int RNA::WriteCt(const char filename[], bool append) {
 
 }
 
-//Write a ct file of the structures
-int RNA::WriteDotBracket(const char filename[]) {
+//Write a ct file of the structures to a stream
+int RNA::WriteCt(ostream &out) {
 	if (ct->GetNumberofStructures()>0) {
-		ct->writedotbracket(filename);
+		ct->ctout(out);
+		if (!out) return 28;
+		return 0;
+	}
+	else return 10; //an error code
+
+
+}
+
+//Write a dot-bracket file of the structures
+int RNA::WriteDotBracket(const char filename[], bool append) {
+	if (ct->GetNumberofStructures()>0) {
+		ct->writedotbracket(filename,append);
+		return 0;
+	}
+	else return 10; //an error code
+
+
+}
+
+//Write the structures in dot-bracket format to a stream
+int RNA::WriteDotBracket(ostream &out) {
+	if (ct->GetNumberofStructures()>0) {
+		ct->writedotbracket(out);
+		if (!out) return 28;
 		return 0;
 	}
 	else return 10; //an error code
@@ -1631,27 +1710,16 @@ int RNA::BreakPseudoknot(const bool minimum_energy, const int structurenumber) {
 
 
 			//allocate main arrays and initialize the Arrays to defaults
-			bpProbArray = new double *[ct->GetSequenceLength()+1];
+			bpProbArray = allocateMEATriangle(ct->GetSequenceLength(),0);
 			bpSSProbArray = new double [ct->GetSequenceLength()+1];
-			vwArray = new double *[ct->GetSequenceLength()+1];
-			vwPArray = new double *[ct->GetSequenceLength()+1];
-
+			vwArray = allocateMEAArray(ct->GetSequenceLength(),-0);
+			vwPArray = allocateMEAArray(ct->GetSequenceLength(),-0);
 
 			sumPij = 0;
 
 			for (i=0;i<=ct->GetSequenceLength();i++) {
-				bpProbArray[i] = new double [ct->GetSequenceLength()+1];
-				vwArray[i] = new double [ct->GetSequenceLength()+1];
-				vwPArray[i] = new double [ct->GetSequenceLength()+1];
-
 				//tempct->basepr[1][i] = 0;
 				bpSSProbArray[i] = 0;
-
-				for (j=0;j<=ct->GetSequenceLength();j++) {
-					bpProbArray[i][j]=0;
-					vwArray[i][j]=-0;
-					vwPArray[i][j]=-0;
-				}
 			}
 
 
@@ -1718,19 +1786,12 @@ int RNA::BreakPseudoknot(const bool minimum_energy, const int structurenumber) {
 
 			// Deallocate memory for the MaxExpect calculation
 			//Arrays with functionality in the fill step
-			for (i=0;i<=ct->GetSequenceLength();i++) {
-				delete[] bpProbArray[i];
-			}
-			delete[] bpProbArray;
+			deleteMEAArray(bpProbArray);
 
 			delete[] bpSSProbArray;
 
-			for (i=0; i<=ct->GetSequenceLength(); i++) {
-				delete[] vwArray[i];
-				delete[] vwPArray[i];
-			}
-			delete[] vwArray;
-			delete[] vwPArray;
+			deleteMEAArray(vwArray);
+			deleteMEAArray(vwPArray);
 
 
 
@@ -2182,7 +2243,8 @@ RNA::~RNA() {
 		delete wmbl;
 		delete wcoax;
 		delete fce;
-		delete pfdata;
+		if (!pfdatashared) delete pfdata;
+		delete pfsmapping;
 
 	}
 
@@ -2268,7 +2330,8 @@ int RNA::FileReader(const char filename[], const int type) {
 
 			read(&sav,&(vers));//read the version of the save file
 
-			if (vers!=pfsaveversion) {
+			//Version 4 files are read into memory; the current version is mapped.
+			if (vers!=pfsaveversion&&vers!=4) {
 				//Wrong version!
 				sav.close();
 				return 16;
@@ -2282,12 +2345,6 @@ int RNA::FileReader(const char filename[], const int type) {
 			//allocate everything
 			ct->allocate(sequencelength);
 
-			w = new pfunctionclass(ct->GetSequenceLength());
-			v = new pfunctionclass(ct->GetSequenceLength());
-			wmb = new pfunctionclass(ct->GetSequenceLength());
-			wmbl = new pfunctionclass(ct->GetSequenceLength());
-			wcoax = new pfunctionclass(ct->GetSequenceLength());
-			wl = new pfunctionclass(ct->GetSequenceLength());
 			fce = new forceclass(ct->GetSequenceLength());
 
 			w5 = new PFPRECISION [ct->GetSequenceLength()+1];
@@ -2297,12 +2354,50 @@ int RNA::FileReader(const char filename[], const int type) {
 			mod = new bool [2*ct->GetSequenceLength()+1];
 
 			pfdata = new pfdatatable();
+			pfdatashared = false;
+
+			if (vers==pfsaveversion) {
+				//load the data from the pfsavefile, using the arrays in place:
+				pfsmapping = mappfsave(filename, ct, w5, w3, &v, &w, &wmb, &wl, &wmbl, &wcoax, fce, &pfdata->scaling, mod, lfce, pfdata);
+				if (pfsmapping==NULL) {
+					delete fce;
+					delete[] w5;
+					delete[] w3;
+					delete[] lfce;
+					delete[] mod;
+					delete pfdata;
+					return 16;
+				}
+			}
+			else {
+				w = new pfunctionclass(ct->GetSequenceLength());
+				v = new pfunctionclass(ct->GetSequenceLength());
+				wmb = new pfunctionclass(ct->GetSequenceLength());
+				wmbl = new pfunctionclass(ct->GetSequenceLength());
+				wcoax = new pfunctionclass(ct->GetSequenceLength());
+				wl = new pfunctionclass(ct->GetSequenceLength());
+
+				//load all the data from the pfsavefile:
+				if (!readpfsave(filename, ct, w5, w3,v, w, wmb,wl, wmbl, wcoax, fce,&pfdata->scaling,mod,lfce,pfdata)) {
+					delete w;
+					delete v;
+					delete wmb;
+					delete wmbl;
+					delete wcoax;
+					delete wl;
+					delete fce;
+					delete[] w5;
+					delete[] w3;
+					delete[] lfce;
+					delete[] mod;
+					delete pfdata;
+					return 16;
+				}
+			}
 
 			//indicate that the memory has been allocated so that the destructor will delete it.
 			partitionfunctionallocated = true;
 
-			//load all the data from the pfsavefile:
-			readpfsave(filename, ct, w5, w3,v, w, wmb,wl, wmbl, wcoax, fce,&pfdata->scaling,mod,lfce,pfdata);
 			return 0;
 
 		}
@@ -2361,6 +2456,7 @@ int RNA::FileReader(const char filename[], const int type) {
 			//indicate that the thermodynamic parameters are read and available (and need to be deleted).
 			energyread = true;
 			data = new datatable();
+			cache = NULL;//the parameters from the save file belong to this instance alone
 
 			//now read the file.
 			readsav(filename, ct, ew2, ewmb2, ew5, ew3, lfce, mod, data,
@@ -27,6 +27,8 @@
 
 #endif //_WINDOWS_GUI
 
+class stochasticcounts;
+
 
 //! RNA Class.
 /*!
@@ -51,8 +53,8 @@ class RNA: public Thermodynamics {
 		//!	Input sequence should contain A,C,G,T,U,a,c,g,t,u,x,X.
 		//!	Capitalization makes no difference.
 		//!	T=t=u=U.  If IsRNA is true, the backbone is RNA, so U is assumed.  If IsRNA is false, the backbone is DNA, so T is assumed.
-		//!	x=X= nucleotide that neither stacks nor pairs.
-		//!	For now, any unknown nuc is considered 'X'.
+		//!	x=X=n=N= nucleotide that neither stacks nor pairs.
+		//!	Any other character is also considered 'X', but it sets error 27, and an empty sequence sets error 20; GetErrorCode() returns these after the constructor is called.
 		//! Note that sequences will subsequently be indexed starting at 1 (like a biologist), so that the 0th position in the sequence array will be nucleotide 1.
 		//!	\param sequence is a NULL terminated c string.
 		//!	\param IsRNA is a bool that indicates whether this sequence is RNA or DNA.  true=RNA.  false=DNA.  Default is true.
@@ -120,6 +122,9 @@ class RNA: public Thermodynamics {
 		//!		23 = no structures present
 		//!		24 = too few iterations
 		//!		25 = index (for drawing) is not a multiple of 10
+		//!		26 = equilibrium constant is negative
+		//!		27 = sequence has a character that is not a nucleotide
+		//!		28 = error writing to file
 		//!\param error is the integer error code provided by GetErrorCode() or from other functions that return integer error codes.
 		//!\return A pointer to a c string that provides an error message.
 		char* GetErrorMessage(const int error);
@@ -272,6 +277,17 @@ class RNA: public Thermodynamics {
 		//! \param temperature is a double that indicates a pseudo-temperature for calculating equilibrium constants from  free energies at fixed temperature previously specified.
 		//! \return An int that indicates an error code (0 = no error, 5 = error reading thermodynamic parameter files).
 		int PartitionFunction(const char savefile[]="",double temperature=-10.0); 
+
+		//!Provide the equilibrium constants for PartitionFunction(), so that they are not recalculated from the free energy parameters for each sequence.
+
+		//!This is for programs that calculate partition functions for many sequences, where converting every parameter to an equilibrium
+		//!		constant can take longer than the calculation itself.  The table must have been made from the same free energy parameters and temperature.
+		//!	The table is not copied or deleted, so it must exist for as long as this instance uses it.  Note that PartitionFunction() rescales the table
+		//!		in place if the calculation heads out of the range of PFPRECISION, so a table cannot be used by two calculations at the same time, and
+		//!		a caller that reuses a table should restore it if its scaling has changed.
+		//!	This must be called before PartitionFunction().  Passing NULL returns to the default, where PartitionFunction() makes its own table.
+		//! \param table is a pointer to pfdatatable with the equilibrium constants.
+		void SetPartitionFunctionDatatable(pfdatatable *table);
 		
 		//! Predict structures containing highly probable pairs.
 
@@ -325,6 +341,18 @@ class RNA: public Thermodynamics {
 		//!	\param seed is an integer that seeds the random number generator that is required for sampling, which defaults to 1.
 		//! \return An int that indicates an error code (0 = no error, non-zero = error).
 		int Stochastic(const int structures, const int seed=1);
+
+		//! Sample structures from the Boltzman ensemble, and count their base pairs instead of storing them.
+
+		//! This is the same sample as Stochastic(structures, seed), but the structures are not added to this RNA.
+		//!		Instead, the base pairs and unpaired nucleotides of each structure are added to counts, so the memory
+		//!		needed does not grow with the number of structures.
+		//!	In case of error, the function returns a non-zero that can be parsed by GetErrorMessage() or GetErrorMessageString().
+		//!	\param structures is the number of structures to be sampled.
+		//!	\param seed is an integer that seeds the random number generator that is required for sampling.
+		//!	\param counts is the stochasticcounts (see stochasticcounts.h), made for the length of this sequence, that receives the counts.
+		//! \return An int that indicates an error code (0 = no error, non-zero = error).
+		int Stochastic(const int structures, const int seed, stochasticcounts *counts);
 		
 
 		//********************************************************************************
@@ -600,12 +628,27 @@ class RNA: public Thermodynamics {
 		//!	\return An integer that provides an error code.  0 = no error, 10 = no structure to write.
 		int WriteCt(const char filename[], bool append=false);
 
+		//!Write a ct file of the structures to a stream.
+
+		//!	This lets a caller write the structures of many sequences through one open file.
+		//! \param out is the stream to which the ct data is written.
+		//!	\return An integer that provides an error code.  0 = no error, 10 = no structure to write, 28 = the stream failed.
+		int WriteCt(ostream &out);
+
 		//!Write dot-bracket file of structures.
 
 		//!	Return 0 if no error and non-zero errors can be parsed by GetErrorMessage() or GetErrorMessageString().
 		//!\param filename is a NULL terminated c string that specified the name of the file to be written.
+		//! \param append is a bool that indicates whether the structures should be appended to an existing file.  If true, data will be appended if the file exists, or a new file created if the file does not exist.  If false, any existing file is overwritten.  This is false by default.
 		//!\return An integer that provides an error code.  0 = no error.
-		int WriteDotBracket(const char filename[]);
+		int WriteDotBracket(const char filename[], bool append=false);
+
+		//!Write the structures in dot-bracket format to a stream.
+
+		//!	This lets a caller write the structures of many sequences through one open file.
+		//! \param out is the stream to which the structures are written.
+		//!\return An integer that provides an error code.  0 = no error, 10 = no structure to write, 28 = the stream failed.
+		int WriteDotBracket(ostream &out);
 
 		//*******************************************************
 		//Functions that return information about structures:
@@ -880,6 +923,16 @@ class RNA: public Thermodynamics {
 		//The following bool is used to indicate whether the partion function arrays have been allocated and therefore need to be deleted.
 		bool partitionfunctionallocated;
 
+		//The equilibrium constants provided by SetPartitionFunctionDatatable(), or NULL.
+		pfdatatable *sharedpfdata;
+
+		//The following bool indicates that pfdata is sharedpfdata, and therefore is not deleted with the partition function arrays.
+		bool pfdatashared;
+
+		//The mapping of a partition function save file that v, w, wmb, wl, wmbl, and wcoax use in place, or NULL.
+		//It is deleted after those arrays.
+		mappedfile *pfsmapping;
+
 		
 
 		//The following bool is used to indicate whether the folding free energy arrays are allocated and therefore need to be deleted.
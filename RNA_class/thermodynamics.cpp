@@ -1,6 +1,120 @@
 #include <cstdlib>
 #include <cstring>
+#include <string>
+#include <vector>
 #include "thermodynamics.h"
+#include "../src/pfunction.h"
+#include "../src/mappedfile.h"
+
+#ifndef _WIN32
+	#include <pthread.h>
+#endif
+
+
+//The cache of thermodynamic parameters.
+//Each entry holds the parameters read from one path for one backbone type and temperature, and the number of instances of
+//	Thermodynamics that use them.  The entry is deleted with the last of those instances.
+//The entry also keeps the equilibrium constants made from the parameters for the partition function, one table for each temperature asked for.
+struct thermodynamiccache {
+	std::string path;
+	bool isrna;
+	double temperature;
+	datatable *data;
+	mappedfile *mapping;//the precompiled parameter file that holds data, or NULL if data was allocated
+	int references;
+	std::vector<double> pftemperatures;
+	std::vector<pfdatatable*> pftables;
+};
+
+//The entries, and the lock that protects them; instances in different threads share the cache.
+static std::vector<thermodynamiccache*> cacheentries;
+
+#ifdef _WIN32
+class cachelock {
+	public:
+		cachelock() {InitializeCriticalSection(&section);}
+		void lock() {EnterCriticalSection(&section);}
+		void unlock() {LeaveCriticalSection(&section);}
+	private:
+		CRITICAL_SECTION section;
+};
+#else
+class cachelock {
+	public:
+		cachelock() {pthread_mutex_init(&mutex,NULL);}
+		void lock() {pthread_mutex_lock(&mutex);}
+		void unlock() {pthread_mutex_unlock(&mutex);}
+	private:
+		pthread_mutex_t mutex;
+};
+#endif
+static cachelock cachemutex;
+
+
+//The precompiled parameter file, written by WriteParameterFile() and mapped into memory by ReadThermodynamic().
+//The file is the header, then one entry for each table, then the tables.  Each table is a datatable, exactly as it is laid out
+//	in memory, so the file can only be used by a build with the same layout; the header records enough to check that.
+//Table 0 is the free energy changes at 310.15 K, table 1 is the enthalpy changes, and the rest are the free energy changes at
+//	other temperatures.  The header holds a checksum of the entries, and each entry holds a checksum of its table.
+#define PARAMETERFILEMAGIC "RNApars\0"
+#define PARAMETERFILEVERSION 1
+#define PARAMETERFILEALIGN 64 //the tables start at multiples of this many bytes from the start of the file
+
+struct parameterfileheader {
+	char magic[8];
+	int version;
+	int byteorder;//1, which reads as another number on a machine with the other byte order
+	int tablesize;//sizeof(datatable)
+	int isrna;
+	int tables;
+	int reserved;
+	unsigned long long checksum;
+};
+
+struct parameterfileentry {
+	double temperature;//in K, or 0 for the enthalpy changes
+	unsigned long long checksum;
+};
+
+//The offset of table number table in a file with tables tables.
+static size_t parameterfileoffset(int tables, int table) {
+	size_t start = sizeof(parameterfileheader)+tables*sizeof(parameterfileentry);
+	size_t size = sizeof(datatable);
+
+	start = (start+PARAMETERFILEALIGN-1)/PARAMETERFILEALIGN*PARAMETERFILEALIGN;
+	size = (size+PARAMETERFILEALIGN-1)/PARAMETERFILEALIGN*PARAMETERFILEALIGN;
+	return start+table*size;
+}
+
+//A 64-bit FNV-1a hash of block, taken a word at a time in four independent streams so that it is not limited by the latency of the multiply.
+static unsigned long long parameterchecksum(const char *block, size_t size) {
+	unsigned long long stream[4] = {14695981039346656037ULL,14695981039346656037ULL,14695981039346656037ULL,14695981039346656037ULL};
+	unsigned long long word,sum;
+	size_t i;
+
+	for (i=0;i+32<=size;i+=32) {
+		for (int l=0;l<4;++l) {
+			memcpy(&word,block+i+8*l,8);
+			stream[l] = (stream[l]^word)*1099511628211ULL;
+		}
+	}
+	sum = 14695981039346656037ULL;
+	for (int l=0;l<4;++l) sum = (sum^stream[l])*1099511628211ULL;
+	for (;i<size;++i) sum = (sum^(unsigned char) block[i])*1099511628211ULL;
+	return sum;
+}
+
+//Check that the parameter file in mapping was written by this build for this backbone, and that it is complete.
+//The checksums of the tables are checked separately, because they require reading the tables.
+static bool checkparameterfile(const char *mapping, size_t size, bool isrna) {
+	const parameterfileheader *header = (const parameterfileheader *) mapping;
+
+	if (size<sizeof(parameterfileheader)) return false;
+	if (strncmp(header->magic,PARAMETERFILEMAGIC,8)!=0||header->version!=PARAMETERFILEVERSION||header->byteorder!=1) return false;
+	if (header->tablesize!=(int) sizeof(datatable)||header->isrna!=(isrna?1:0)||header->tables<2) return false;
+	if (size<parameterfileoffset(header->tables,header->tables)) return false;
+	return parameterchecksum(mapping+sizeof(parameterfileheader),header->tables*sizeof(parameterfileentry))==header->checksum;
+}
 
 //Constructor:
 Thermodynamics::Thermodynamics(const bool ISRNA) {
@@ -17,6 +131,8 @@ Thermodynamics::Thermodynamics(const bool ISRNA) {
 	//set the enthalpy parameters to an unread status
 	enthalpy = NULL;
 
+	//no parameters are shared yet
+	cache = NULL;
 
 }
 
@@ -28,8 +144,8 @@ int Thermodynamics::SetTemperature(double temperature) {
 	//set the folding temperature
 	temp = temperature;
 
-	//If the thermodynamic parameter files were read at some point, delete them now:
-	if (energyread) delete data;
+	//If the thermodynamic parameter files were read at some point, give them up now:
+	if (energyread) ReleaseDatatable();
 
 	//Setting energyread to false will ensure that the parameters will be re-read from disk
 		//and set for the correct temperature at ay point they are needed.
@@ -58,8 +174,8 @@ double Thermodynamics::GetTemperature() {
 //Destructor:
 Thermodynamics::~Thermodynamics() {
 
-	//If the thermodynamic parameter files were read at some point, delete them now:
-	if (energyread) delete data;
+	//If the thermodynamic parameter files were read at some point, give them up now:
+	if (energyread) ReleaseDatatable();
 
 	//If the enthalpy parameters were read from disk, they must be deleted now:
 	if (enthalpy!=NULL) delete enthalpy;
@@ -209,16 +325,93 @@ datatable *Thermodynamics::GetDatatable() {
 
 //read the thermodynamic parameters from disk at location $DATAPATH or pwd
 int Thermodynamics::ReadThermodynamic(const char *pathname) {
-	char loop[maxfil],stackf[maxfil],tstackh[maxfil],tstacki[maxfil],
-		tloop[maxfil],miscloop[maxfil],danglef[maxfil],int22[maxfil],
-		int21[maxfil],coax[maxfil],tstackcoax[maxfil],
-		coaxstack[maxfil],tstack[maxfil],tstackm[maxfil],triloop[maxfil],int11[maxfil],hexaloop[maxfil],
-		tstacki23[maxfil], tstacki1n[maxfil],datapath[maxfil],*pointer;
+	char datapath[maxfil];
+	mappedfile *mapping;
 
-	//only allocate the datatable if energyread is false, meaning that no parameters are loaded
-	//	This is important because the user might alter the temperature with SetTemperature(), triggering a re-read of the parameters.
-	if (!energyread) data = new datatable();
+	//If parameters are already loaded, give them up, because they will be replaced.
+	if (energyread) {
+		ReleaseDatatable();
+		energyread = false;
+	}
 	
+	GetDataPath(pathname,datapath);
+
+	//Use the parameters from the cache if another instance has read them.
+	//The lock is held while the parameters are read, so that two threads do not both read the same parameters.
+	cachemutex.lock();
+	for (int entry=0;entry<(int) cacheentries.size();++entry) {
+		if (cacheentries[entry]->path==datapath&&cacheentries[entry]->isrna==isrna&&cacheentries[entry]->temperature==temp) {
+			cache = cacheentries[entry];
+			cache->references++;
+			data = cache->data;
+			energyread = true;
+			cachemutex.unlock();
+			return 0;
+		}
+	}
+
+	//Use the precompiled parameter file, if there is one, and otherwise read the text files.
+	if (!ReadParameterFile(datapath,temp,data,mapping)) {
+		
+		mapping = NULL;
+		data = new datatable();
+
+		//now check to see if the temperature is other than 310.15 K:
+		if (temp>(310.15+TOLERANCE)||temp<(310.15-TOLERANCE)) {
+
+			//temperature is altered, so the enthalpy tables need to be read:
+			datatable *localenthalpy;
+
+			//allocate a table to storte enthalpy parameters
+			localenthalpy = new datatable();
+
+			if (ReadParameterText(datapath,data,localenthalpy)!=0) {
+	
+				delete localenthalpy;
+				delete data;
+				energyread = false;//energy files have not been correctly read
+				cachemutex.unlock();
+				return 5;//an error has occured
+
+			}
+
+			//using the enthalpy parameters and the folding free energy changes at 37 degrees C,
+			//	calculate folding free energy changes at temp, the current temperature, and overwrite the 
+			//	folding free energy changes at 37 degrees C
+			dG_T((float)temp,*data,*localenthalpy,*data);
+
+			//remove the enthalpy parameters, there is no need to keep them
+			delete localenthalpy;
+
+		}
+		else if (ReadParameterText(datapath,data,NULL)!=0) {
+
+			delete data;
+			energyread = false;//energy files have not been correctly read
+			cachemutex.unlock();
+			return 5;//an error code
+
+		}
+	}
+
+	//Add the parameters to the cache.
+	cache = new thermodynamiccache();
+	cache->path = datapath;
+	cache->isrna = isrna;
+	cache->temperature = temp;
+	cache->data = data;
+	cache->mapping = mapping;
+	cache->references = 1;
+	cacheentries.push_back(cache);
+	cachemutex.unlock();
+
+	energyread=true;//energy files have been correctly read
+	return 0;
+}
+
+//Put the path to the thermodynamic parameters, with a trailing slash, in datapath.
+void Thermodynamics::GetDataPath(const char *pathname, char *datapath) {
+	char *pointer;
 
 	//Set the path to the thermodynamic parameters:
 	if (pathname!=NULL) {
@@ -237,65 +430,264 @@ int Thermodynamics::ReadThermodynamic(const char *pathname) {
 		else strcpy(datapath,"");
 
 	}
-	
+}
+
+//Read the free energy changes at 310.15 K, and the enthalpy changes if enthalpytable is not NULL, from the text files in datapath.
+int Thermodynamics::ReadParameterText(char *datapath, datatable *freeenergy, datatable *enthalpytable) {
+	char loop[maxfil],stackf[maxfil],tstackh[maxfil],tstacki[maxfil],
+		tloop[maxfil],miscloop[maxfil],danglef[maxfil],int22[maxfil],
+		int21[maxfil],coax[maxfil],tstackcoax[maxfil],
+		coaxstack[maxfil],tstack[maxfil],tstackm[maxfil],triloop[maxfil],int11[maxfil],hexaloop[maxfil],
+		tstacki23[maxfil], tstacki1n[maxfil];
+
 	//open the data files -- must reside in pwd or $DATAPATH.
 	//open the thermodynamic data tables
 	GetDat (loop, stackf, tstackh, tstacki,tloop, miscloop, danglef, int22,
           int21,coax, tstackcoax,coaxstack, tstack, tstackm, triloop,
           int11, hexaloop, tstacki23, tstacki1n, datapath, isrna);//the true indicates RNA parameters
 	if (opendat (loop,stackf,tstackh,tstacki,tloop,miscloop,danglef,int22,int21,
-   		coax,tstackcoax,coaxstack,tstack,tstackm,triloop,int11,hexaloop,tstacki23, tstacki1n,data)==0) {
+   		coax,tstackcoax,coaxstack,tstack,tstackm,triloop,int11,hexaloop,tstacki23, tstacki1n,freeenergy)==0) {
       	
-
-		delete data;
-		energyread = false;//energy files have not been correctly read
 		return 5;//an error code
 		
 	}
-	else {
-		
-		//now check to see if the temperature is other than 310.15 K:
-		if (temp>(310.15+TOLERANCE)||temp<(310.15-TOLERANCE)) {
 
-			//temperature is altered, so the enthalpy tables need to be read:
-			datatable *localenthalpy;
+	if (enthalpytable!=NULL) {
+
+		//get the names of the enthalpy files
+		GetDat(loop, stackf, tstackh, tstacki,
+			tloop, miscloop, danglef, int22,
+			int21,coax, tstackcoax,
+			coaxstack, tstack, tstackm, triloop,
+			int11, hexaloop, tstacki23, tstacki1n, datapath, isrna,true);//rtue means this is enthalpy files
 
-			//get the names of the enthalpy files
-			GetDat(loop, stackf, tstackh, tstacki,
-				tloop, miscloop, danglef, int22,
-				int21,coax, tstackcoax,
-				coaxstack, tstack, tstackm, triloop,
-				int11, hexaloop, tstacki23, tstacki1n, datapath, isrna,true);//rtue means this is enthalpy files
+		//open the enthlpy parameters and check for errors
+		if (opendat(loop, stackf, tstackh, tstacki,
+			tloop, miscloop, danglef, int22,
+			int21,coax, tstackcoax,
+			coaxstack, tstack, tstackm, triloop,
+			int11,hexaloop,tstacki23, tstacki1n, enthalpytable)==0) {
 
-			//allocate a table to storte enthalpy parameters
-			localenthalpy = new datatable();
+			return 5;//an error has occured
 
-			//open the enthlpy parameters and check for errors
-			if (opendat(loop, stackf, tstackh, tstacki,
-				tloop, miscloop, danglef, int22,
-				int21,coax, tstackcoax,
-				coaxstack, tstack, tstackm, triloop,
-				int11,hexaloop,tstacki23, tstacki1n, localenthalpy)==0) {
-	
-				delete localenthalpy;
-				return 5;//an error has occured
+		}
+	}
 
-			}
+	return 0;
+}
 
-			//using the enthalpy parameters and the folding free energy changes at 37 degrees C,
-			//	calculate folding free energy changes at temp, the current temperature, and overwrite the 
-			//	folding free energy changes at 37 degrees C
-			dG_T((float)temp,*data,*localenthalpy,*data);
+//Get the name of the precompiled parameter file in datapath.
+void Thermodynamics::GetParameterFileName(const char *datapath, char *filename) {
 
-			//remove the enthalpy parameters, there is no need to keep them
-			delete localenthalpy;
+	strcpy(filename,datapath);
+
+	//DNA parameters start with "dna", like the text files
+	if (!isrna) strcat(filename,"dna");
+	strcat(filename,"parameters.bin");
+}
+
+//Find the free energy changes at temperature in the precompiled parameter file in datapath.
+bool Thermodynamics::ReadParameterFile(char *datapath, double temperature, datatable *&table, mappedfile *&mapping) {
+	char filename[maxfil];
+	const parameterfileheader *header;
+	const parameterfileentry *entries;
+	const char *start;
+	int found;
+
+	GetParameterFileName(datapath,filename);
+	//The mapping is copy on write, because the table is used through a datatable * that the code may write;
+	//	a write changes only this process's copy of the page, never the file.
+	mapping = new mappedfile(filename,true);
+
+	//A file that fails a check is ignored, and the text files are read instead.
+	if (!mapping->good()||!checkparameterfile(mapping->data(),mapping->size(),isrna)) {
+		delete mapping;
+		return false;
+	}
+	start = mapping->data();
+	header = (const parameterfileheader *) start;
+	entries = (const parameterfileentry *) (start+sizeof(parameterfileheader));
+
+	//Look for a table at this temperature.  Entry 1 is the enthalpy changes, which has temperature 0.
+	found = -1;
+	for (int entry=0;entry<header->tables;++entry) {
+		if (entry!=1&&temperature<=(entries[entry].temperature+TOLERANCE)&&temperature>=(entries[entry].temperature-TOLERANCE)) found = entry;
+	}
+
+	if (found>=0) {
+		//Use the table in place, if its checksum matches.  This reads the table once, which costs far less than parsing the text files;
+		//	the tables at the other temperatures are not read.
+		if (parameterchecksum(start+parameterfileoffset(header->tables,found),sizeof(datatable))!=entries[found].checksum) {
+			delete mapping;
+			return false;
+		}
+		table = (datatable *) (mapping->data()+parameterfileoffset(header->tables,found));
+		return true;
+	}
+
+	//Otherwise calculate the table from the free energy changes at 310.15 K and the enthalpy changes, as for the text files.
+	if (parameterchecksum(start+parameterfileoffset(header->tables,0),sizeof(datatable))!=entries[0].checksum||
+		parameterchecksum(start+parameterfileoffset(header->tables,1),sizeof(datatable))!=entries[1].checksum) {
+		delete mapping;
+		return false;
+	}
+	table = new datatable();
+	*table = *((const datatable *) (start+parameterfileoffset(header->tables,0)));
+	dG_T((float) temperature,*table,*((datatable *) (start+parameterfileoffset(header->tables,1))),*table);
+
+	delete mapping;
+	mapping = NULL;
+	return true;
+}
+
+//Check a precompiled parameter file, including the checksums of all its tables.
+bool Thermodynamics::VerifyParameterFile(const char *filename) {
+	mappedfile mapping(filename);
+	const parameterfileheader *header;
+	const parameterfileentry *entries;
+
+	if (!mapping.good()||!checkparameterfile(mapping.data(),mapping.size(),isrna)) return false;
+
+	header = (const parameterfileheader *) mapping.data();
+	entries = (const parameterfileentry *) (mapping.data()+sizeof(parameterfileheader));
+	for (int entry=0;entry<header->tables;++entry) {
+		if (parameterchecksum(mapping.data()+parameterfileoffset(header->tables,entry),sizeof(datatable))!=entries[entry].checksum) return false;
+	}
+	return true;
+}
+
+//Write the precompiled parameter file.
+int Thermodynamics::WriteParameterFile(const char *filename, const vector<double> &temperatures, const char *pathname) {
+	char datapath[maxfil];
+	parameterfileheader header;
+	vector<parameterfileentry> entries;
+	datatable *freeenergy,*enthalpytable,*table;
+	char padding[PARAMETERFILEALIGN];
+
+	GetDataPath(pathname,datapath);
+
+	//Read the free energy changes at 310.15 K and the enthalpy changes from the text files.
+	freeenergy = new datatable();
+	enthalpytable = new datatable();
+	if (ReadParameterText(datapath,freeenergy,enthalpytable)!=0) {
+		delete freeenergy;
+		delete enthalpytable;
+		return 5;
+	}
+
+	//The first two tables are the free energy changes at 310.15 K and the enthalpy changes; the rest are the free energy changes
+	//	at the other temperatures.
+	entries.resize(2);
+	entries[0].temperature = 310.15;
+	entries[1].temperature = 0;
+	for (int i=0;i<(int) temperatures.size();++i) {
+		bool repeated = false;
 
+		for (int entry=0;entry<(int) entries.size();++entry) {
+			if (entry!=1&&temperatures[i]<=(entries[entry].temperature+TOLERANCE)&&temperatures[i]>=(entries[entry].temperature-TOLERANCE)) repeated = true;
 		}
+		if (!repeated) {
+			entries.push_back(parameterfileentry());
+			entries.back().temperature = temperatures[i];
+		}
+	}
 
+	memset(&header,0,sizeof(parameterfileheader));
+	memcpy(header.magic,PARAMETERFILEMAGIC,8);
+	header.version = PARAMETERFILEVERSION;
+	header.byteorder = 1;
+	header.tablesize = (int) sizeof(datatable);
+	header.isrna = isrna?1:0;
+	header.tables = (int) entries.size();
+
+	ofstream out(filename,ios::binary);
+	if (!out.good()) {
+		delete freeenergy;
+		delete enthalpytable;
+		return 2;
+	}
+
+	//Write the tables, then go back and write the header and the entries, which hold the checksums of the tables.
+	memset(padding,0,PARAMETERFILEALIGN);
+	table = new datatable();
+	for (int entry=0;entry<(int) entries.size();++entry) {
+		if (entry==0) memcpy(table,freeenergy,sizeof(datatable));
+		else if (entry==1) memcpy(table,enthalpytable,sizeof(datatable));
+		else {
+			memcpy(table,freeenergy,sizeof(datatable));
+			dG_T((float) entries[entry].temperature,*table,*enthalpytable,*table);
+		}
+		entries[entry].checksum = parameterchecksum((const char *) table,sizeof(datatable));
 
-		energyread=true;//energy files have been correctly read
-		return 0;
+		out.seekp(parameterfileoffset(header.tables,entry));
+		out.write((const char *) table,sizeof(datatable));
 	}
+	out.write(padding,parameterfileoffset(header.tables,header.tables)-parameterfileoffset(header.tables,header.tables-1)-sizeof(datatable));
+
+	header.checksum = parameterchecksum((const char *) &entries[0],entries.size()*sizeof(parameterfileentry));
+	out.seekp(0);
+	out.write((const char *) &header,sizeof(parameterfileheader));
+	out.write((const char *) &entries[0],entries.size()*sizeof(parameterfileentry));
+
+	bool written = out.good();
+	out.close();
+
+	delete table;
+	delete freeenergy;
+	delete enthalpytable;
+
+	if (!written) return 2;
+	return 0;
+}
+
+//Give up data, either by releasing this instance's reference to the cache entry or by deleting it.
+void Thermodynamics::ReleaseDatatable() {
+
+	if (cache==NULL) {
+		//data belongs to this instance alone
+		delete data;
+		return;
+	}
+
+	cachemutex.lock();
+	cache->references--;
+	if (cache->references==0) {
+		//This was the last instance using the entry, so delete it.
+		for (int entry=0;entry<(int) cacheentries.size();++entry) {
+			if (cacheentries[entry]==cache) {
+				cacheentries.erase(cacheentries.begin()+entry);
+				break;
+			}
+		}
+		for (int table=0;table<(int) cache->pftables.size();++table) delete cache->pftables[table];
+		if (cache->mapping!=NULL) delete cache->mapping;
+		else delete cache->data;
+		delete cache;
+	}
+	cachemutex.unlock();
+	cache = NULL;
+
+}
+
+//Provide the equilibrium constants for the partition function, made from the free energy change parameters.
+pfdatatable *Thermodynamics::GetPfdatatable(double temperature) {
+	pfdatatable *table = NULL;
+
+	if (cache==NULL) return NULL;
+
+	cachemutex.lock();
+	for (int entry=0;entry<(int) cache->pftables.size();++entry) {
+		if (cache->pftemperatures[entry]==temperature) table = cache->pftables[entry];
+	}
+	if (table==NULL) {
+		table = new pfdatatable(data,scalingdefinition,temperature);
+		cache->pftemperatures.push_back(temperature);
+		cache->pftables.push_back(table);
+	}
+	cachemutex.unlock();
+
+	return table;
+
 }
 
 
@@ -360,11 +752,20 @@ void Thermodynamics::CopyThermodynamic(Thermodynamics *thermo) {
 
 	if (thermo->GetEnergyRead()) {
 		SetTemperature(thermo->GetTemperature());
-		data = new datatable();
 		energyread = true;
-		
 
-		*data = *thermo->GetDatatable(); 
+		if (thermo->cache!=NULL) {
+			//Share the cached parameters.
+			cachemutex.lock();
+			cache = thermo->cache;
+			cache->references++;
+			data = cache->data;
+			cachemutex.unlock();
+		}
+		else {
+			data = new datatable();
+			*data = *thermo->GetDatatable(); 
+		}
 	}
 
 	return;
@@ -7,11 +7,23 @@
 //Import the definition of struct datatable.
 #include "../src/rna_library.h"
 
+#include <vector>
+
 
 //TOLERANCE is the maximum deviation from 310.15 K before which the enthalpy parameters are read from disk to adjust the free energyy changes from 310.15 K.
 #define TOLERANCE 0.01 
 
 
+//The equilibrium constants for the partition function, defined in pfunction.h.
+class pfdatatable;
+
+//An entry in the cache of parameters shared by instances of Thermodynamics, defined in thermodynamics.cpp.
+struct thermodynamiccache;
+
+//A file mapped into memory, defined in mappedfile.h.
+class mappedfile;
+
+
 //! Thermodynamics Class.
 /*!
 	The RNA class provides an encapsulation of the functions and struct for reading and storing thermodynamic parameters.
@@ -63,12 +75,37 @@ class Thermodynamics {
 		//!	in files for 310.15 K.
 		//!	Return of zero => no error and a return of non-zero indicates error.
 		//! Public functions that need the thermodynamic parameters call this function automatically. 
+		//! The parameters are read from disk only once per process for each path, backbone type, and temperature.  Every instance that reads the same
+		//!	parameters shares one copy of them, which is deleted when the last of those instances is deleted.
 		//! By default, the path to the thermodynamic paramaters is fetched from the $DATAPATH environment variable.
 		//! If a specific path is needed, $DATAPATH is overridden by specifying the pathname explicitly here as a parameter.
+		//! If the path holds a precompiled parameter file (see WriteParameterFile()), it is mapped into memory and used in place of the text files.
 		//! \return An int that indicates whether an error occured.
 		//! \param pathname is a pointer to cstring that indicates the pathname to the thermodynamnic parameters.  By default, this is NULL and the environment variable $DATAPATH is consulted to get this path. 
 		int ReadThermodynamic(const char *pathname = NULL);
 
+		//! Write a precompiled parameter file, which ReadThermodynamic() uses in place of the text files.
+
+		//! The file holds the free energy changes at 310.15 K, the enthalpy changes, and the free energy changes at each of a set of other temperatures,
+		//!	all read from the text files.  Parameters at a temperature in the file are used without any processing; parameters at other temperatures are
+		//!	calculated from the free energy changes at 310.15 K and the enthalpy changes.
+		//! The file is binary and specific to the build that wrote it.  A file written by another build is ignored, and so is a file that is incomplete.
+		//!	When the file is loaded, only the checksum of the table that is used is checked; VerifyParameterFile() checks all of them.
+		//!	A file with a table that fails its checksum is ignored.
+		//! The file is not updated when the text files change, so it must be written again after they are edited.
+		//! For ReadThermodynamic() to find the file, it must be in the path with the text files, named parameters.bin for RNA or dnaparameters.bin for DNA.
+		//! \param filename is a cstring that gives the name of the file to write.
+		//! \param temperatures is a vector of the temperatures, in K, at which to store free energy changes in addition to 310.15 K.
+		//! \param pathname is a pointer to cstring that indicates the pathname to the text files, as for ReadThermodynamic().
+		//! \return An int that indicates an error code: 0 = no error, 2 = error writing the file, 5 = error reading the text files.
+		int WriteParameterFile(const char *filename, const vector<double> &temperatures, const char *pathname = NULL);
+
+		//! Check a precompiled parameter file written by WriteParameterFile(), including the checksums of all its tables.
+
+		//! \param filename is a cstring that gives the name of the file.
+		//! \return A bool that is true if the file can be used by this build for this backbone type and all the checksums match.
+		bool VerifyParameterFile(const char *filename);
+
 		//**********************************************
 		//Functions that provide accessibility of the underlying tables:
 		//**********************************************
@@ -76,9 +113,19 @@ class Thermodynamics {
 
 		//! This function is used during inheritance o provide access to the free energy change parameters.
 		//! This function generates no error codes.  (Error checking was done for this during construction).
+		//! The table can be shared with other instances (see ReadThermodynamic()), so it must not be modified.
 		//!\return A pointer to datatable with free energy change parameters.
 		datatable *GetDatatable();
 
+		//! Provide the equilibrium constants for the partition function, made from the free energy change parameters.
+
+		//! The table is made once for the parameters shared by a set of instances (see ReadThermodynamic()) and the temperature, and it is shared
+		//!		by those instances, so it must not be modified.  A partition function calculation can rescale its table, so it needs a copy.
+		//!	The parameters must have been read.
+		//! \param temperature is a double that gives the temperature, in K, of the equilibrium constants.
+		//!	\return A pointer to pfdatatable, or NULL if the parameters were not read from disk (they came from a save file) and are therefore not shared.
+		pfdatatable *GetPfdatatable(double temperature);
+
 		//! This function is used to provide an enthalpy table.
 		//! This function will return a NULL pointer if there is an error reading the tables from disk.
 		//! It is important that programs check the status of the pointer before using it, i.e. make sure it is not NULL.
@@ -91,6 +138,7 @@ class Thermodynamics {
 		//!the parameters from disk.  It is helpful, however, when a large number
 		//!of calculations with be performed because the parameters can then
 		//!be read from disk only once.
+		//!Parameters that were read from disk are shared with thermo, not copied.
 		//!Note that the source Thermodynamics class must have been initialized with the "correct" ISRNA value and correct temperature.
 		//!Return 0 if no error and non-zero errors can be parsed by GetErrorMessage() or GetErrorMessageString().
 		//!\param thermo is a pointer to Thermodynamics class.  That must have already called the ReadThermodynamics() function.  
@@ -123,6 +171,22 @@ class Thermodynamics {
 			char *coaxstack, char *tstack, char *tstackm, char *triloop,
 			char *int11, char *hexaloop, char *tstacki23, char *tstacki1n,
 			char *datapath, bool isRNA, bool isEnthalpy=false);
+
+		//Put the path to the thermodynamic parameters, with a trailing slash, in datapath.
+		//pathname is the path given to ReadThermodynamic(); if it is NULL, $DATAPATH is used.
+		void GetDataPath(const char *pathname, char *datapath);
+
+		//Read the free energy changes at 310.15 K, and the enthalpy changes if enthalpytable is not NULL, from the text files in datapath.
+		//Return 0 if no error or 5 if the files could not be read.
+		int ReadParameterText(char *datapath, datatable *freeenergy, datatable *enthalpytable);
+
+		//Get the name of the precompiled parameter file in datapath.
+		void GetParameterFileName(const char *datapath, char *filename);
+
+		//Find the free energy changes at temperature in the precompiled parameter file in datapath.
+		//Return false if there is no usable file.  Otherwise, table points to the free energy changes and mapping is the mapping of the file
+		//	that holds them, or NULL if they had to be calculated for the temperature, in which case table was allocated with new.
+		bool ReadParameterFile(char *datapath, double temperature, datatable *&table, mappedfile *&mapping);
 		
 		//!Access the thermodynamic parameter class an instance of datatable.
 		
@@ -136,6 +200,12 @@ class Thermodynamics {
 		//Class to store thermodynamic parameters.
 		datatable *data;
 
+		//The cache entry that holds data, if data was read from disk and is shared with other instances, or NULL if data belongs to this instance alone.
+		thermodynamiccache *cache;
+
+		//Give up data, either by releasing this instance's reference to the cache entry or by deleting it.
+		void ReleaseDatatable();
+
 		//Class to store enthalpy parameters.
 		datatable *enthalpy;
 
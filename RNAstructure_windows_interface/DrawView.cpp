@@ -855,7 +855,8 @@ void CDrawView::OnDrawAddcolorannotation()
 		ifstream sav(filedialog->GetPathName().GetBuffer(10),ios::binary);
 
 		read(&sav,&vers);
-		if (vers!=pfsaveversion) {
+		//version 4 files can still be read
+		if (vers!=pfsaveversion&&vers!=4) {
 			//the file version doesn't match the current version
 			AfxMessageBox( "Error: This save file was created with a different version of RNAstructure.", 
 			MB_OK|MB_ICONEXCLAMATION);
@@ -905,15 +906,21 @@ void CDrawView::OnDrawAddcolorannotation()
 		mod = new bool [2*ct.GetSequenceLength()+1];
 
 		//load all the data from the pfsavefile:
-		readpfsave(filedialog->GetPathName().GetBuffer(10), &ct, w5, w3,v, w, wmb,wl, wmbl, wcoax, fce,&scaling,mod,lfce,data);
+		if (readpfsave(filedialog->GetPathName().GetBuffer(10), &ct, w5, w3,v, w, wmb,wl, wmbl, wcoax, fce,&scaling,mod,lfce,data)) {
 
-		//fill array with the values for the plot:
-		pDoc->colorannotate();
-		pDoc->iscolorannotated=true;
+			//fill array with the values for the plot:
+			pDoc->colorannotate();
+			pDoc->iscolorannotated=true;
 
-		DetermineColor();
+			DetermineColor();
 
-		SetColors();
+			SetColors();
+		}
+		else {
+			//the file was written with a different precision or is incomplete
+			AfxMessageBox( "Error: This save file was created with a different version of RNAstructure.", 
+			MB_OK|MB_ICONEXCLAMATION);
+		}
 
 
 		
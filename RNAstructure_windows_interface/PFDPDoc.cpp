@@ -26,7 +26,8 @@ PFDPDoc::PFDPDoc(CString Filename, CRNAstructureApp *app):PlotDoc(app)
 	read(&sav,&(vers));//read the version of the save file
 		
 	//If the version is not correct, bail out and set v to NULL to indicate the bailout
-	if (vers!=pfsaveversion) {
+	//Version 4 files can still be read.
+	if (vers!=pfsaveversion&&vers!=4) {
 		arrayvalues = NULL;	
 		return;
 	}
@@ -69,7 +70,27 @@ PFDPDoc::PFDPDoc(CString Filename, CRNAstructureApp *app):PlotDoc(app)
 	data = new pfdatatable();
 
 	//load all the data from the pfsavefile:
-	readpfsave(filename.GetBuffer(10), &ct, w5, w3,v, w, wmb,wl, wmbl, wcoax, fce,&scaling,mod,lfce,data);
+	//If the file was written with a different precision or is incomplete, bail out as for the wrong version.
+	if (!readpfsave(filename.GetBuffer(10), &ct, w5, w3,v, w, wmb,wl, wmbl, wcoax, fce,&scaling,mod,lfce,data)) {
+		delete w;
+		delete v;
+		delete wmb;
+		delete fce;
+		delete[] w5;
+		delete[] w3;
+		for (i=1;i<=ct.GetSequenceLength();i++) {
+			delete[] arrayvalues[i];
+		}
+		delete[] arrayvalues;
+		delete[] lfce;
+		delete[] mod;
+		delete data;
+		delete wmbl;
+		delete wl;
+		delete wcoax;
+		arrayvalues = NULL;
+		return;
+	}
 
 	//fill array with the values for the plot:
 	for (i=1;i<ct.GetSequenceLength();i++) {
@@ -61,14 +61,15 @@ UINT PKProc( LPVOID pParam ){
 	
 
 	//load all the data from the pfsavefile:
-	readpfsave(pObject->savefile, &ct, w5, w3,v, w, wmb,wl, wmbl, wcoax, fce,&data->scaling,mod,lfce,data);
+	//The file was checked for its version when it was selected, so a failure here means it is incomplete or has another precision.
+	if (readpfsave(pObject->savefile, &ct, w5, w3,v, w, wmb,wl, wmbl, wcoax, fce,&data->scaling,mod,lfce,data)) {
 
-
-	//Call the maximum expected accuracy algorithm
+		//Call the maximum expected accuracy algorithm
 	
-	ProbKnotAssemble(v, w5, &ct, data, lfce, mod, data->scaling, fce, pObject->iterations, pObject->minlength );
+		ProbKnotAssemble(v, w5, &ct, data, lfce, mod, data->scaling, fce, pObject->iterations, pObject->minlength );
 
-	ct.ctout(pObject->ctoutfile);
+		ct.ctout(pObject->ctoutfile);
+	}
 		   
 	::PostMessage(pView->m_hWnd,ID_FOLDDONE,0,0);
 
@@ -177,7 +178,8 @@ void CProbKnotView::OnBnClickedOpensavebutton()
 		ifstream sav((filedialog->GetPathName()).GetBuffer(30),ios::binary);	
 		read(&sav,&(vers));//read the version of the save file
 		sav.close();
-		if (vers!=pfsaveversion) {
+		//version 4 files can still be read
+		if (vers!=pfsaveversion&&vers!=4) {
 			//the file version doesn't match the current version
 			AfxMessageBox( "Error: This save file was created with a different version of RNAstructure.  \nPlease select another file.", 
 			MB_OK|MB_ICONEXCLAMATION);
@@ -41,6 +41,9 @@ TurboFold_Interface::TurboFold_Interface() {
 
 		// Initialize the TurboFold iterations.
 		turboIterations = 3;
+
+		// Initialize the convergence threshold to 0, which indicates that every iteration is done in full.
+		convergence = 0;
 	}
 
 	// Initialize maximum expected accuracy mode parameters.
@@ -309,6 +312,14 @@ bool TurboFold_Interface::parse( int argc, char** argv ) {
 			}
 		}
 
+		// Get the convergence threshold.
+		if( !parser->isError() ) {
+			if( file.contains( "Convergence" ) ) {
+				convergence = file.getOption<double>( "Convergence" );
+				if( convergence < 0.0 || convergence > 1.0 ) { parser->setError( "convergence threshold" ); }
+			}
+		}
+
 		// Get the maximum pairing distance.
 		if( !parser->isError() ) {
 			if( file.contains( "MaximumPairingDistance" ) ) {
@@ -512,15 +523,21 @@ void TurboFold_Interface::run() {
 		object->SetProgress( *progress );
 
 		// Run the TurboFold algorithm and check for errors.
-		int mainCalcError = object->fold( turboGamma, turboIterations, processors );
+		int mainCalcError = object->fold( turboGamma, turboIterations, processors, convergence );
 		error = checker->isErrorStatus( mainCalcError );
 
 		// Delete the progress monitor.
 		object->StopProgress();
 		delete progress;
 
-		// If no error occurred, print message that main calculation is done.
-		if( error == 0 ) { cout << "done." << endl; }
+		// If no error occurred, print message that main calculation is done, and how the pair probabilities converged.
+		if( error == 0 ) {
+			cout << "done." << endl;
+			for( int i = 1; i <= object->GetIterations(); i++ ) {
+				cout << "Iteration " << i << ": " << object->GetRefoldedSequences( i ) << " of " << object->GetNumberSequences()
+				     << " sequences refolded, largest change in pair probability " << object->GetProbabilityChange( i ) << "." << endl;
+			}
+		}
 	}
 
 	/*
@@ -632,6 +649,8 @@ void TurboFold_Interface::usage( ParseCommandLine* parser ) {
 	parser->wrapString( "The TurboFold gamma. Default is 0.3." );
 	cout << "Iterations" << endl;
 	parser->wrapString( "The number of iterations TurboFold goes through. Default is 3 iterations." );
+	cout << "Convergence" << endl;
+	parser->wrapString( "The convergence threshold. A sequence whose pair probabilities change by no more than this in an iteration is not refolded in later iterations, and the iterations stop early when every sequence has converged. Default is 0, which means that every sequence is refolded in every iteration." );
 	cout << "MaximumPairingDistance" << endl;
 	parser->wrapString( "The maximum distance between nucleotides that can pair. For nucleotide i to pair with j, [i - j| < MaximumPairingDistance. This applies to each sequence. Default is no limit." );
 #ifdef COMPILE_SMP
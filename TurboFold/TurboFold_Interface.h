@@ -114,6 +114,9 @@ class TurboFold_Interface {
 	// The iterations value for TurboFold.
 	double turboIterations;
 
+	// The change in pair probabilities below which a sequence is considered converged, or 0 to refold every sequence in every iteration.
+	double convergence;
+
 	// The MEA mode window size.
 	int windowSize;
 };
@@ -1,9 +1,11 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <math.h>
 #include "TurboFold_object.h"
 #include "../RNA_class/RNA.h"
 #include <string>
 #include "../src/phmm/phmm_aln.h"
+#include "../src/phmm/phmm_array.h"
 #include "../src/phmm/structure/structure_object.h"
 #include "../src/phmm/utils/xmath/matrix/matrix.h"
 
@@ -23,6 +25,10 @@ TurboFold::TurboFold(const char fasta_fp[])
 {
 	this->err_code = 0;
 
+	// The alignment information is set up at the end of the constructor; the pairs are aligned by fold(), so that it can use the threads.
+	this->similarities = NULL;
+	this->i_next_alignment_pair = 0;
+
 	this->saves = NULL;
 
 	progress=NULL;
@@ -79,6 +85,10 @@ TurboFold::TurboFold(vector<string>* _sequences, vector<string>* _saves)
 {
 	this->err_code = 0;
 
+	// The alignment information is set up at the end of the constructor; the pairs are aligned by fold(), so that it can use the threads.
+	this->similarities = NULL;
+	this->i_next_alignment_pair = 0;
+
 	// Do a simple sanity check.
 	if(_sequences->size() !=  _saves->size())
 	{
@@ -167,51 +177,58 @@ TurboFold::~TurboFold()
 	this->extrinsic_info_list->clear();
 	delete(this->folders);
 	delete(this->extrinsic_info_list);
-	
-	// Free the alignment information.
-        for(int i_seq1 = 0; i_seq1 < n_seq; i_seq1++)
-        {
-                free(this->similarities[i_seq1]);
-        } // i_seq1 loop
-	free(this->similarities);
-
-        for(unsigned int i_seq1 = 0; i_seq1 < n_seq; i_seq1++)
-        {
-                for(unsigned int i_seq2 = i_seq1+1; i_seq2 < n_seq; i_seq2++)
-                {
-                        if(i_seq1 != i_seq2)
-                        {
-                                t_phmm_aln* phmm_aln = new t_phmm_aln(sequences->at(i_seq1), sequences->at(i_seq2));
-
-                                // Free alignment mapping probabilities.
-                                //this->aln_mapping_probs[i_seq1][i_seq2] = (double**)malloc(sizeof(double*) * (this->sequences->at(i_seq1)->numofbases + 2));                          
-                                for(int i = 1; i <= this->sequences->at(i_seq1)->numofbases; i++)
-                                {
-                                        int min_k = aln_env_results[i_seq1][i_seq2]->low_limits[i];
-                                        int max_k = aln_env_results[i_seq1][i_seq2]->high_limits[i];
-                                        ///this->aln_mapping_probs[i_seq1][i_seq2][i] = (double*)malloc(sizeof(double) * (max_k - min_k + 2));
-                                        //this->aln_mapping_probs[i_seq1][i_seq2][i] -= min_k;
-                                        this->aln_mapping_probs[i_seq1][i_seq2][i] += min_k;
-                                        free(this->aln_mapping_probs[i_seq1][i_seq2][i]);
-                                } // i loop
-                                free(this->aln_mapping_probs[i_seq1][i_seq2]);
-
-                                // Free alignment envelope result.
-                                phmm_aln->free_aln_env_result(this->aln_env_results[i_seq1][i_seq2]);
-                                delete(phmm_aln);
-                        }
-                        else
-                        {
-                        }
-                } // i_seq2 loop.
-
-                aln_env_results[i_seq1] += i_seq1;
-                free(aln_env_results[i_seq1]);
 
-                aln_mapping_probs[i_seq1] += i_seq1;
-                free(this->aln_mapping_probs[i_seq1]);
-        } // i_seq1 loop.
+	for(int i_seq = 0; i_seq < this->previous_probabilities.size(); i_seq++)
+	{
+		delete(this->previous_probabilities[i_seq]);
+	} // i_seq
 	
+	// Free the alignment information, if the constructor set it up; only the pairs that fold() aligned have results.
+	if(this->similarities != NULL)
+	{
+	        for(int i_seq1 = 0; i_seq1 < n_seq; i_seq1++)
+	        {
+	                free(this->similarities[i_seq1]);
+	        } // i_seq1 loop
+		free(this->similarities);
+
+	        for(unsigned int i_seq1 = 0; i_seq1 < n_seq; i_seq1++)
+	        {
+	                for(unsigned int i_seq2 = i_seq1+1; i_seq2 < n_seq; i_seq2++)
+	                {
+	                        if(this->aln_env_results[i_seq1][i_seq2] != NULL)
+	                        {
+	                                t_phmm_aln* phmm_aln = new t_phmm_aln(sequences->at(i_seq1), sequences->at(i_seq2));
+
+	                                // Free alignment mapping probabilities.
+	                                //this->aln_mapping_probs[i_seq1][i_seq2] = (double**)malloc(sizeof(double*) * (this->sequences->at(i_seq1)->numofbases + 2));                          
+	                                for(int i = 1; i <= this->sequences->at(i_seq1)->numofbases; i++)
+	                                {
+	                                        int min_k = aln_env_results[i_seq1][i_seq2]->low_limits[i];
+	                                        int max_k = aln_env_results[i_seq1][i_seq2]->high_limits[i];
+	                                        ///this->aln_mapping_probs[i_seq1][i_seq2][i] = (double*)malloc(sizeof(double) * (max_k - min_k + 2));
+	                                        //this->aln_mapping_probs[i_seq1][i_seq2][i] -= min_k;
+	                                        this->aln_mapping_probs[i_seq1][i_seq2][i] += min_k;
+	                                        free(this->aln_mapping_probs[i_seq1][i_seq2][i]);
+	                                } // i loop
+	                                free(this->aln_mapping_probs[i_seq1][i_seq2]);
+
+	                                // Free alignment envelope result.
+	                                phmm_aln->free_aln_env_result(this->aln_env_results[i_seq1][i_seq2]);
+	                                delete(phmm_aln);
+	                        }
+	                        else
+	                        {
+	                        }
+	                } // i_seq2 loop.
+
+	                aln_env_results[i_seq1] += i_seq1;
+	                free(aln_env_results[i_seq1]);
+
+	                aln_mapping_probs[i_seq1] += i_seq1;
+	                free(this->aln_mapping_probs[i_seq1]);
+	        } // i_seq1 loop.
+	}
 
 	// sequences are used in memory free'ing. Must make sure it is free'ed at the very last step.
         for(int i_seq = 0; i_seq < n_seq; i_seq++)
@@ -246,7 +263,7 @@ int TurboFold::SetMaxPairingDistance(int distance) {
 
 
 
-int TurboFold::fold(double gamma, int _n_iterations, int _n_parallel_pfunctions)
+int TurboFold::fold(double gamma, int _n_iterations, int _n_parallel_pfunctions, double convergence)
 {
 #ifdef COMPILE_SMP
 	// Allocate the mutex.
@@ -259,9 +276,32 @@ int TurboFold::fold(double gamma, int _n_iterations, int _n_parallel_pfunctions)
 
 
 
-	// Generate the alignment information.
-	//
+	// Align the pairs of sequences, the first time fold() is called.
+	if(this->i_next_alignment_pair < this->alignment_pairs.size() && this->align_sequence_pairs() != 0)
+	{
+		this->err_code = ALIGNMENT_INFO_COMPUTATION_ERROR;
+		return(this->err_code);
+	}
+
 	this->n_iterations = _n_iterations;
+
+	// Whether each sequence was refolded in the previous iteration, and whether it has converged.
+	vector<bool> refolded(this->sequences->size(), true);
+	vector<bool> converged(this->sequences->size(), false);
+
+	// Whether each sequence has a save file, which is written by the fold in the last iteration.
+	vector<bool> saved(this->sequences->size(), false);
+	bool any_saved = false;
+	for(int i_seq = 0; i_seq < this->sequences->size(); i_seq++)
+	{
+		saved[i_seq] = (this->saves != NULL && strlen(this->saves->at(i_seq)) > 0);
+		any_saved = any_saved || saved[i_seq];
+	} // i_seq loop
+
+	this->refold_sequence.assign(this->sequences->size(), true);
+	this->previous_probabilities.resize(this->sequences->size(), NULL);
+	this->n_refolded.clear();
+	this->probability_changes.clear();
 	
 	// Initialize the loops.
 	for(int i_iter = 0; i_iter <= n_iterations; i_iter++)
@@ -273,6 +313,80 @@ int TurboFold::fold(double gamma, int _n_iterations, int _n_parallel_pfunctions)
 			progress->update((int)((100.0*((double) i_iter))/((double) n_iterations+1)));
 		}
 
+		if(i_iter > 0)
+		{
+			// The extrinsic information of a sequence comes from the pairing probabilities of the other sequences,
+			// so it is unchanged unless another sequence was refolded in the previous iteration.
+			int n_refolded_last = 0;
+			for(int i_seq = 0; i_seq < this->sequences->size(); i_seq++)
+			{
+				if(refolded[i_seq])
+				{
+					n_refolded_last++;
+				}
+			} // i_seq loop
+
+			int n_to_refold = 0;
+			for(int i_seq = 0; i_seq < this->sequences->size(); i_seq++)
+			{
+				bool others_refolded = (n_refolded_last > (refolded[i_seq]?1:0));
+				this->refold_sequence[i_seq] = !converged[i_seq] && (i_iter == 1 || others_refolded);
+
+				if(this->refold_sequence[i_seq])
+				{
+					n_to_refold++;
+				}
+			} // i_seq loop
+
+			// When nothing is left to refold, the remaining iterations would not change anything.
+			// If save files are requested, go to the last iteration, which refolds the sequences to write them.
+			if(n_to_refold == 0)
+			{
+				if(!any_saved)
+				{
+					break;
+				}
+
+				for(; i_iter < n_iterations; i_iter++)
+				{
+					this->n_refolded.push_back(0);
+					this->probability_changes.push_back(0.0);
+				} // i_iter loop
+			}
+
+			// The last fold writes the save files.
+			if(i_iter == n_iterations)
+			{
+				for(int i_seq = 0; i_seq < this->sequences->size(); i_seq++)
+				{
+					if(saved[i_seq])
+					{
+						this->refold_sequence[i_seq] = true;
+					}
+				} // i_seq loop
+			}
+
+			// Keep the probabilities from before this iteration, to measure the change.
+			for(int i_seq = 0; i_seq < this->sequences->size(); i_seq++)
+			{
+				if(this->refold_sequence[i_seq])
+				{
+					if(this->previous_probabilities[i_seq] == NULL)
+					{
+						this->previous_probabilities[i_seq] = new t_matrix(this->sequences->at(i_seq)->numofbases, this->sequences->at(i_seq)->numofbases, true);
+					}
+
+					for(int i = 1; i <= this->sequences->at(i_seq)->numofbases; i++)
+					{
+						for(int j = i+1; j <= this->sequences->at(i_seq)->numofbases; j++)
+						{
+							this->previous_probabilities[i_seq]->x(i, j) = this->folders->at(i_seq)->GetPairProbability(i, j);
+						} // j loop
+					} // i loop
+				}
+			} // i_seq loop
+		}
+
 		// Set the extrinsic information for each sequence.
 		if(i_iter == 0)
 		{
@@ -297,9 +411,14 @@ int TurboFold::fold(double gamma, int _n_iterations, int _n_parallel_pfunctions)
 				return(this->err_code);
 			}	 	
 		
-			// Set ExtrinsicInformation(onst int i, const int j, double ext_info), for each base pair in each sequence.	
+			// Set ExtrinsicInformation(onst int i, const int j, double ext_info), for each base pair in each sequence that is refolded.
                         for(int i_seq = 0; i_seq < this->sequences->size(); i_seq++)
                         {
+				if(!this->refold_sequence[i_seq])
+				{
+					continue;
+				}
+
                                 for(int i = 1; i <= this->sequences->at(i_seq)->numofbases; i++)
                                 {
                                         for(int j = i+1; j <= this->sequences->at(i_seq)->numofbases; j++)
@@ -319,6 +438,12 @@ int TurboFold::fold(double gamma, int _n_iterations, int _n_parallel_pfunctions)
 		for(int _i_seq = 0; _i_seq < this->sequences->size(); _i_seq++)
 		{
 			refolding_threads[_i_seq] = NULL; // NULL refers to a thread not being assigned to this sequence, yet.
+
+			// A sequence that is not refolded is assigned a thread that never runs, so that it is not picked.
+			if(!this->refold_sequence[_i_seq])
+			{
+				refolding_threads[_i_seq] = new t_turbofold_thread(this, _i_seq, i_iter);
+			}
 		} // _i_seq loop for initing folding thread pointers.
 
 #ifdef COMPILE_SMP
@@ -428,6 +553,33 @@ int TurboFold::fold(double gamma, int _n_iterations, int _n_parallel_pfunctions)
 
 		// The list of refolding thread pointers is reallocated above, should be freed here.
 		free(this->refolding_threads);
+
+		// Measure how much the refolded sequences changed.
+		if(i_iter > 0)
+		{
+			int n_refolded_now = 0;
+			double largest_change = 0.0;
+			for(int i_seq = 0; i_seq < this->sequences->size(); i_seq++)
+			{
+				refolded[i_seq] = this->refold_sequence[i_seq];
+				if(!refolded[i_seq])
+				{
+					continue;
+				}
+
+				double change = this->get_probability_change(i_seq, this->previous_probabilities[i_seq]);
+				if(convergence > 0.0 && change <= convergence)
+				{
+					converged[i_seq] = true;
+				}
+
+				n_refolded_now++;
+				largest_change = max(largest_change, change);
+			} // i_seq loop
+
+			this->n_refolded.push_back(n_refolded_now);
+			this->probability_changes.push_back(largest_change);
+		}
 	} // i_iter loop.
 
 	//Add a coarse update of progress:
@@ -441,9 +593,14 @@ int TurboFold::fold(double gamma, int _n_iterations, int _n_parallel_pfunctions)
 
 int TurboFold::generate_extrinsic_information(int i_iter, const double gamma)
 {
-	// Reset the extrinsic information.
+	// Reset the extrinsic information of the sequences that are refolded; the others keep theirs.
 	for(unsigned int i_seq = 0; i_seq < this->sequences->size(); i_seq++)
 	{
+		if(!this->refold_sequence[i_seq])
+		{
+			continue;
+		}
+
 		for(int i = 1; i <= this->sequences->at(i_seq)->numofbases; i++)
 		{
 			for(int j = i+1; j <= this->sequences->at(i_seq)->numofbases; j++)
@@ -463,6 +620,13 @@ int TurboFold::generate_extrinsic_information(int i_iter, const double gamma)
                 {       
                         //t_energy_loops* seq2_energy_loops = energy_loops->at(i_seq2);
 			RNA* RNA2 = this->folders->at(i_seq2);
+
+			bool refold_seq1 = this->refold_sequence[i_seq1];
+			bool refold_seq2 = this->refold_sequence[i_seq2];
+			if(!refold_seq1 && !refold_seq2)
+			{
+				continue;
+			}
                  
                         for(int i = 1; i <= this->sequences->at(i_seq1)->numofbases; i++)
                         {
@@ -485,9 +649,15 @@ int TurboFold::generate_extrinsic_information(int i_iter, const double gamma)
 
 							//printf("%d, %d: %lf\n", k, l, this->extrinsic_info_list->at(i_seq2)->x(k,l));
 
-                                                        this->extrinsic_info_list->at(i_seq2)->x(k,l) += seq1_seq2_seq_similarity_weight * seq1_seq2_mapping_probability * RNA1->GetPairProbability(i,j);
+							if(refold_seq2)
+							{
+                                                        	this->extrinsic_info_list->at(i_seq2)->x(k,l) += seq1_seq2_seq_similarity_weight * seq1_seq2_mapping_probability * RNA1->GetPairProbability(i,j);
+							}
 
-							this->extrinsic_info_list->at(i_seq1)->x(i,j) += seq1_seq2_seq_similarity_weight * seq1_seq2_mapping_probability * RNA2->GetPairProbability(k,l);
+							if(refold_seq1)
+							{
+								this->extrinsic_info_list->at(i_seq1)->x(i,j) += seq1_seq2_seq_similarity_weight * seq1_seq2_mapping_probability * RNA2->GetPairProbability(k,l);
+							}
 
                                                         if(RNA1->GetErrorCode() != 0)
                                                         {
@@ -516,6 +686,11 @@ int TurboFold::generate_extrinsic_information(int i_iter, const double gamma)
         // Post process. For normalization and powerizing.
         for(unsigned int i_seq = 0; i_seq < this->sequences->size(); i_seq++)
         {
+		if(!this->refold_sequence[i_seq])
+		{
+			continue;
+		}
+
                 //char cur_ext_info_fp[1000];
                 //sprintf(cur_ext_info_fp, "ext_info_%d_iter_%d.txt", i_seq, i_iter);
                 //this->extrinsic_info_list->at(i_seq)->dump_matrix(cur_ext_info_fp);
@@ -529,10 +704,31 @@ int TurboFold::generate_extrinsic_information(int i_iter, const double gamma)
 	return(0);
 }
 
+double TurboFold::get_probability_change(int i_seq, t_matrix* probabilities)
+{
+	double largest_change = 0.0;
+
+	for(int i = 1; i <= this->sequences->at(i_seq)->numofbases; i++)
+	{
+		for(int j = i+1; j <= this->sequences->at(i_seq)->numofbases; j++)
+		{
+			double change = fabs(this->folders->at(i_seq)->GetPairProbability(i, j) - probabilities->x(i, j));
+			largest_change = max(largest_change, change);
+		} // j loop
+	} // i loop
+
+	return(largest_change);
+}
+
 int TurboFold::initialize_alignment_information()
 {
         // Allocate similarities.
         this->similarities = (double**)malloc(sizeof(double*) * (this->sequences->size() + 2));
+        if(this->similarities == NULL)
+        {
+                return(1);
+        }
+
         for(int i_seq1 = 0; i_seq1 < this->sequences->size(); i_seq1++)
         {
                 this->similarities[i_seq1] = (double*)malloc(sizeof(double) * (this->sequences->size() + 2));
@@ -544,66 +740,150 @@ int TurboFold::initialize_alignment_information()
         } // i_seq1 loop
 
         // Compute the alignment probabilities.
-        //this->pp_results = (t_pp_result***)malloc(sizeof(t_pp_result**) * (sequences->size() + 1));
         this->aln_env_results = (t_aln_env_result***)malloc(sizeof(t_aln_env_result**) * (sequences->size() + 1));
         this->aln_mapping_probs = (double****)malloc(sizeof(double***) * (sequences->size() + 1));
 
-        double alignment_info_mem_size = 0.0f;
-
+        this->alignment_pairs.clear();
         for(unsigned int i_seq1 = 0; i_seq1 < sequences->size(); i_seq1++)
         {
                 aln_env_results[i_seq1] = (t_aln_env_result**)malloc((sequences->size() + 2) * sizeof(t_aln_env_result*));
-
                 this->aln_mapping_probs[i_seq1] = (double***)malloc((sequences->size() + 2) * sizeof(double**));
-                alignment_info_mem_size += ((sequences->size() + 2) * sizeof(double**));
 
                 // Move the pointers.
                 this->aln_env_results[i_seq1] -= i_seq1;
                 this->aln_mapping_probs[i_seq1] -= i_seq1;
 
-                //pp_results[i_seq1] = (t_pp_result**)malloc((sequences->size() + 2) * sizeof(t_pp_result*));
                 for(unsigned int i_seq2 = i_seq1+1; i_seq2 < sequences->size(); i_seq2++)
                 {
-                        if(i_seq1 != i_seq2)
-                        {
-                                t_phmm_aln* phmm_aln = new t_phmm_aln(sequences->at(i_seq1), sequences->at(i_seq2));
+                        // The results are set by align_sequence_pairs().
+                        this->aln_env_results[i_seq1][i_seq2] = NULL;
+                        this->alignment_pairs.push_back(pair<int, int>(i_seq1, i_seq2));
+                } // i_seq2 loop.
+        } // i_seq1 loop.
+
+        this->i_next_alignment_pair = 0;
+
+	return(0);
+}
+
+int TurboFold::align_sequence_pairs()
+{
+        // The pairs are independent, and each pair writes only its own entries of the arrays above.
+        // Each thread aligns one pair at a time in its own workspace, so there are at most n_parallel_pfunctions sets of phmm arrays, each kept at the size of the largest pair its thread has aligned.
+
+#ifdef COMPILE_SMP
+        vector<t_ansi_thread*> alignment_threads;
+        for(int i_thread = 1; i_thread < this->n_parallel_pfunctions && i_thread < this->alignment_pairs.size(); i_thread++)
+        {
+                t_ansi_thread* alignment_thread = new t_ansi_thread(TurboFold::align_pairs, this);
+
+                // If the thread cannot be started, the pairs are left for the threads that are running.
+                if(!alignment_thread->run_thread())
+                {
+                        delete(alignment_thread);
+                        break;
+                }
+
+                alignment_threads.push_back(alignment_thread);
+        } // i_thread loop.
+#endif // COMPILE_SMP
+
+        // The main thread aligns pairs too.
+        t_phmm_workspace* workspace = new t_phmm_workspace();
+        for(int i_pair = this->next_alignment_pair(); i_pair < this->alignment_pairs.size(); i_pair = this->next_alignment_pair())
+        {
+                this->compute_alignment_information(i_pair, workspace);
+        } // i_pair loop.
+        delete(workspace);
+
+#ifdef COMPILE_SMP
+        for(int i_thread = 0; i_thread < alignment_threads.size(); i_thread++)
+        {
+                alignment_threads[i_thread]->wait_thread();
+                delete(alignment_threads[i_thread]);
+        } // i_thread loop.
+#endif // COMPILE_SMP
+
+	return(0);
+}
+
+int TurboFold::next_alignment_pair()
+{
+#ifdef COMPILE_SMP
+        this->turbofold_threads_mutex->lock_mutex();
+#endif // COMPILE_SMP
+
+        int i_pair = this->i_next_alignment_pair;
+        if(i_pair < this->alignment_pairs.size())
+        {
+                this->i_next_alignment_pair++;
+        }
 
-                                t_pp_result* cur_pp_results = phmm_aln->compute_posterior_probs();
-                                //pp_results[i_seq1][i_seq2] = cur_pp_results;
+#ifdef COMPILE_SMP
+        this->turbofold_threads_mutex->release_mutex();
+#endif // COMPILE_SMP
+
+        return(i_pair);
+}
+
+#ifdef COMPILE_SMP
+void* TurboFold::align_pairs(void* _turbofold_obj)
+{
+        TurboFold* turbofold_obj = (TurboFold*)_turbofold_obj;
+
+        t_phmm_workspace* workspace = new t_phmm_workspace();
+        for(int i_pair = turbofold_obj->next_alignment_pair(); i_pair < turbofold_obj->alignment_pairs.size(); i_pair = turbofold_obj->next_alignment_pair())
+        {
+                turbofold_obj->compute_alignment_information(i_pair, workspace);
+        } // i_pair loop.
+        delete(workspace);
 
-                                t_aln_env_result* cur_aln_env_result = phmm_aln->compute_alignment_envelope(PROB_ALN_ENV, cur_pp_results, cur_pp_results->fam_threshold, 7);
+        return(NULL);
+}
+#endif // COMPILE_SMP
 
-                                // Copy the ML similarity.
-                                this->similarities[i_seq1][i_seq2] = cur_pp_results->ml_similarity;
+void TurboFold::compute_alignment_information(int i_pair, t_phmm_workspace* workspace)
+{
+        int i_seq1 = this->alignment_pairs[i_pair].first;
+        int i_seq2 = this->alignment_pairs[i_pair].second;
+
+        t_phmm_aln* phmm_aln = new t_phmm_aln(sequences->at(i_seq1), sequences->at(i_seq2));
+        phmm_aln->set_workspace(workspace);
+
+        t_pp_result* cur_pp_results = phmm_aln->compute_posterior_probs();
+        //pp_results[i_seq1][i_seq2] = cur_pp_results;
+
+        t_aln_env_result* cur_aln_env_result = phmm_aln->compute_alignment_envelope(PROB_ALN_ENV, cur_pp_results, cur_pp_results->fam_threshold, 7);
+
+        // Copy the ML similarity.
+        this->similarities[i_seq1][i_seq2] = cur_pp_results->ml_similarity;
 
 				//printf("%d-%d similarity: %lf\n", i_seq1, i_seq2, cur_pp_results->ml_similarity);
 
-                                aln_env_results[i_seq1][i_seq2] = cur_aln_env_result;
+        aln_env_results[i_seq1][i_seq2] = cur_aln_env_result;
 
-                                // Allocate the alignment mapping probability matrix for current sequences. Note that these are 1 based.
-                                this->aln_mapping_probs[i_seq1][i_seq2] = (double**)malloc(sizeof(double*) * (this->sequences->at(i_seq1)->numofbases + 2));  
-                                alignment_info_mem_size += (sizeof(double*) * (this->sequences->at(i_seq1)->numofbases + 2));
+        // Allocate the alignment mapping probability matrix for current sequences. Note that these are 1 based.
+        this->aln_mapping_probs[i_seq1][i_seq2] = (double**)malloc(sizeof(double*) * (this->sequences->at(i_seq1)->numofbases + 2));  
 
-                                for(int i = 1; i <= this->sequences->at(i_seq1)->numofbases; i++)
-                                {
-                                        int min_k = cur_aln_env_result->low_limits[i];
-                                        int max_k = cur_aln_env_result->high_limits[i];
-                                        this->aln_mapping_probs[i_seq1][i_seq2][i] = (double*)malloc(sizeof(double) * (max_k - min_k + 2));
-                                        alignment_info_mem_size += (sizeof(double) * (max_k - min_k + 2));
+        for(int i = 1; i <= this->sequences->at(i_seq1)->numofbases; i++)
+        {
+                int min_k = cur_aln_env_result->low_limits[i];
+                int max_k = cur_aln_env_result->high_limits[i];
+                this->aln_mapping_probs[i_seq1][i_seq2][i] = (double*)malloc(sizeof(double) * (max_k - min_k + 2));
 
-                                        this->aln_mapping_probs[i_seq1][i_seq2][i] -= min_k;
-                                        for(int k = min_k; k <= max_k; k++)
-                                        {
-                                                // Mapping probability is coincidence probability of the nucleotides.
-                                                double aln_prob = exp(cur_pp_results->aln_probs[i][k]);
-                                                double ins1_prob = exp(cur_pp_results->ins1_probs[i][k]);
-                                                double ins2_prob = exp(cur_pp_results->ins2_probs[i][k]);
+                this->aln_mapping_probs[i_seq1][i_seq2][i] -= min_k;
+                for(int k = min_k; k <= max_k; k++)
+                {
+                        // Mapping probability is coincidence probability of the nucleotides.
+                        double aln_prob = exp(cur_pp_results->aln_probs[i][k]);
+                        double ins1_prob = exp(cur_pp_results->ins1_probs[i][k]);
+                        double ins2_prob = exp(cur_pp_results->ins2_probs[i][k]);
 
-                                                double mapping_probability = (aln_prob + ins1_prob + ins2_prob);
+                        double mapping_probability = (aln_prob + ins1_prob + ins2_prob);
 
-                                                this->aln_mapping_probs[i_seq1][i_seq2][i][k] = mapping_probability;
-                                        } // k loop
-                                } // i loop
+                        this->aln_mapping_probs[i_seq1][i_seq2][i][k] = mapping_probability;
+                } // k loop
+        } // i loop
 
 /*
 				char cur_map_fp[1000];
@@ -628,19 +908,9 @@ int TurboFold::initialize_alignment_information()
 				fclose(f_aln_map_prob);
 */
 
-                                // Free current pp result.
-                                phmm_aln->free_pp_result(cur_pp_results);
-                                delete(phmm_aln);
-                        }
-                        else
-                        {
-                                //pp_results[i_seq1][i_seq2] = NULL;
-                                aln_env_results[i_seq1][i_seq2] = NULL;
-                        }
-                } // i_seq2 loop.
-        } // i_seq1 loop.
-
-	return(0);
+        // Free current pp result.
+        phmm_aln->free_pp_result(cur_pp_results);
+        delete(phmm_aln);
 }
 
 int TurboFold::ProbKnot(const int i_seq, const int n_iterations, const int min_helix_length)
@@ -818,6 +1088,35 @@ int TurboFold::GetNumberSequences()
 	return(this->sequences->size());
 }
 
+int TurboFold::GetIterations()
+{
+	return(this->n_refolded.size());
+}
+
+int TurboFold::GetRefoldedSequences(const int i_iter)
+{
+	if(i_iter < 1 || i_iter > this->n_refolded.size())
+	{
+		this->err_code = ITERATION_ARGUMENT_OVERFLOW_ERROR;
+		return(0);
+	}
+
+	this->err_code = 0;
+	return(this->n_refolded[i_iter-1]);
+}
+
+double TurboFold::GetProbabilityChange(const int i_iter)
+{
+	if(i_iter < 1 || i_iter > this->probability_changes.size())
+	{
+		this->err_code = ITERATION_ARGUMENT_OVERFLOW_ERROR;
+		return(0.0);
+	}
+
+	this->err_code = 0;
+	return(this->probability_changes[i_iter-1]);
+}
+
 int TurboFold::SetTemperature(const double temp)
 {
 	this->err_code = 0;
@@ -3,6 +3,7 @@
 
 #include <vector>
 #include <string>
+#include <utility>
 using namespace std;
 
 //Include the correct flavor of TProgressDialog.h
@@ -20,6 +21,7 @@ using namespace std;
 class RNA;
 class t_matrix;
 struct t_aln_env_result;
+struct t_phmm_workspace;
 class t_structure;
 class t_ansi_mutex;
 class t_turbofold_thread;
@@ -42,6 +44,7 @@ RNALIB_READSHAPE_ERROR,
 RNALIB_SETTEMPERATURE_ERROR,
 RNA_LIB_RNA_CONSTRUCTOR_ERROR,
 RNALIB_SETDISTANCE_ERROR,
+ITERATION_ARGUMENT_OVERFLOW_ERROR,
 N_TF_ERRORS};
 
 static char err_strings[N_TF_ERRORS+1][100] = { "No error (Cross fingers).",//NO_ERRORS,
@@ -60,8 +63,9 @@ static char err_strings[N_TF_ERRORS+1][100] = { "No error (Cross fingers).",//NO
 "GetPairProbability error.", //RNALIB_GETPAIRPROBABILITY_ERROR,
 "ReadSHAPE error.", //RNALIB_READSHAPE_ERROR,
 "SetTemperature error.", //RNALIB_SETTEMPERATURE_ERROR,
-"RNA class constructor failed." //RNA_LIB_RNA_CONSTRUCTOR_ERROR,
-"Error in setting maximum distance at level of an RNA class."//RNALIB_SETDISTANCE_ERROR
+"RNA class constructor failed.", //RNA_LIB_RNA_CONSTRUCTOR_ERROR,
+"Error in setting maximum distance at level of an RNA class.",//RNALIB_SETDISTANCE_ERROR
+"Iteration index argument error." //ITERATION_ARGUMENT_OVERFLOW_ERROR
 }; //N_TF_ERRORS
 
 
@@ -175,11 +179,34 @@ public:
 
 	//! This function accomplishes the task of determining the pair probabilities.
 	//! This function must be called before any of the structure prediction methods can be used.
+	//! The first call also computes the alignment probabilities for each pair of sequences, with up to _n_parallel_pfunctions pairs aligned at once.
+	//! A sequence is not refolded in an iteration when its extrinsic information cannot have changed, i.e. when no other sequence was refolded in the previous iteration.
+	//! With a convergence threshold, a sequence whose pairing probabilities changed by no more than the threshold in an iteration is not refolded again,
+	//! and the iterations stop when no sequence is left to refold.  Partition function save files are still written by a refold in the last iteration.
 	//! \param gamma is the weight of the extrinsic information.  Larger gamma will result in more consistent structures.  The default is 0.3 and this provided a good structure prediction accuracy in benchmarks.
 	//! \param n_iterations is the number of iterations that should be performed to converge the base pairing probabilities.  The default is 3 because benchmarks showed only marginal improvement with further iterations.
 	//! \param _n_parallel_pfunctions is the number of threads to use.  For code compiled in serial, this must be 1, which is the default.  Define COMPILE_SMP to build for multithreading.
+	//! \param convergence is the largest change in any pairing probability of a sequence for the sequence to be considered converged.  The default of 0 refolds every sequence in every iteration.
 	//!	\return An integer error code that can be resolved to an error message using GetErrorMessage() or GetErrorString().  0 is no error. 
-	int fold(double gamma = 0.3, int n_iterations = 3, int _n_parallel_pfunctions = 1); 
+	int fold(double gamma = 0.3, int n_iterations = 3, int _n_parallel_pfunctions = 1, double convergence = 0.0); 
+
+	//! Provide the number of iterations performed by fold().
+
+	//! This is less than n_iterations if the iterations stopped because every sequence converged.
+	//! \return The number of iterations after the initial fold, or 0 if fold() has not been called.
+	int GetIterations();
+
+	//! Provide the number of sequences refolded in an iteration of fold().
+
+	//! \param i_iter is the iteration, from 1 to GetIterations().
+	//! \return The number of sequences refolded.
+	int GetRefoldedSequences(const int i_iter);
+
+	//! Provide the largest change in pairing probability in an iteration of fold().
+
+	//! \param i_iter is the iteration, from 1 to GetIterations().
+	//! \return The largest change in the probability of any pair in a sequence refolded in the iteration, from the probability before the iteration.
+	double GetProbabilityChange(const int i_iter);
 	
 	//******************************
 	// Functions that predict structures:
@@ -297,8 +324,27 @@ public:
 private:
 
 	int generate_extrinsic_information(int i_iter, const double gamma); 
+
+	// Return the largest difference between the pairing probabilities of sequence i_seq and those in probabilities.
+	double get_probability_change(int i_seq, t_matrix* probabilities);
+	// Allocate the alignment information and list the pairs of sequences to align.  The constructors call this, and report a failure in their error code.
 	int initialize_alignment_information();
 
+	// Compute the alignment information for every pair in alignment_pairs, using up to n_parallel_pfunctions threads.  fold() calls this the first time it runs.
+	int align_sequence_pairs();
+
+	// Compute the alignment information for the pair of sequences at alignment_pairs[i_pair].
+	// The phmm arrays are kept in workspace, which each thread reuses for the pairs it aligns.
+	void compute_alignment_information(int i_pair, t_phmm_workspace* workspace);
+
+	// Return the index of the next pair in alignment_pairs whose alignment information is not computed or being computed, or the number of pairs if there is none.
+	int next_alignment_pair();
+
+#ifdef COMPILE_SMP
+	// Threading function: Compute the alignment information for pairs of sequences until no pair is left.
+	static void* align_pairs(void* _turbofold_obj);
+#endif // COMPILE_SMP
+
 
 	int err_code;//Internal error code
 
@@ -310,7 +356,16 @@ private:
 	double**** aln_mapping_probs; // Basically, the co-incidence probabilities. 
 	vector<t_matrix*>* extrinsic_info_list; // Current set of extrinsic for each sequence.
 
+	vector<bool> refold_sequence; // Whether each sequence is refolded in the current iteration; extrinsic information is only computed for these.
+	vector<t_matrix*> previous_probabilities; // The pairing probabilities of each sequence before the current iteration.
+	vector<int> n_refolded; // The number of sequences refolded in each iteration.
+	vector<double> probability_changes; // The largest change in pairing probability in each iteration.
+
 	t_aln_env_result*** aln_env_results;
+
+	// The pairs of sequences (i_seq1 < i_seq2) that are aligned, and the index of the next pair to align.
+	vector<pair<int, int> > alignment_pairs;
+	int i_next_alignment_pair;
 };
 
 #endif // _TURBOFOLD_OBJECT_
@@ -18,24 +18,34 @@ CXX = g++
 JXX = javac 
 JXXFLAGS = -source 1.6
 
+###############################################################################
+## The partition function is calculated in double precision unless one of the flags below is set.
+## extended_double and log_double extend the range for long sequences (see src/defines.h).
+## All objects must be rebuilt ("make clean") after a change, e.g. "make clean; make partition PFPRECISIONFLAG=-DLOG_DOUBLE".
+###############################################################################
+
+PFPRECISIONFLAG =
+#PFPRECISIONFLAG = -D EXTENDED_DOUBLE
+#PFPRECISIONFLAG = -D LOG_DOUBLE
+
 ###############################################################################
 ## For compilation of the C++ component of RNAstructure, the exact flags depend on the operating system.
 ## There are flags for compiling into object files and for linking into a shared library, defined below for the three major systems.
 ###############################################################################
 
 # Linux
-CXXFLAGS = -O3 -fsched-spec-load -fPIC -D NDEBUG
+CXXFLAGS = -O3 -fsched-spec-load -fPIC -D NDEBUG ${PFPRECISIONFLAG}
 MULTIFINDFLAG = -DMULTIFIND
 LIBFLAGS = -shared
 OPSYSTEM = Linux
 
 # Mac
-#CXXFLAGS = -O3 -fPIC -arch x86_64
+#CXXFLAGS = -O3 -fPIC -arch x86_64 ${PFPRECISIONFLAG}
 #LIBFLAGS = -dynamiclib -arch x86_64 -framework JavaVM
 #OPSYSTEM = Mac
 
 # Cygwin (running on Windows)
-#CXXFLAGS = -O3 -fsched-spec-load -mno-cygwin
+#CXXFLAGS = -O3 -fsched-spec-load -mno-cygwin ${PFPRECISIONFLAG}
 #LIBFLAGS = -Wl,--add-stdcall-alias -mno-cygwin
 #OPSYSTEM = Windows
 
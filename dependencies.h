@@ -32,6 +32,10 @@ CMD_LINE_PARSER = \
 CONFIG_FILE_PARSER = \
 	${ROOTPATH}/src/configfile.o
 
+# The FASTA file reader, which reads the records a batch at a time.
+FASTA_READER = \
+	${ROOTPATH}/src/FastaReader.o
+
 # The dot plot handler.
 PLOT_HANDLER = \
 	${ROOTPATH}/src/DotPlotHandler.o
@@ -88,6 +92,42 @@ PARTS_FILES = \
 	${ROOTPATH}/src/phmm/utils/rng/rng.o \
 	${ROOTPATH}/src/phmm/utils/rng/seed_manager.o
 
+# Files unique to PARTS, for use with OPENMP SMP.
+PARTS_FILES_SMP = \
+	${ROOTPATH}/PARTS/src/parts/alignment_priors.o \
+	${ROOTPATH}/PARTS/src/parts/array_file_manager.o \
+	${ROOTPATH}/PARTS/src/parts/array_mem_manager.o \
+	${ROOTPATH}/PARTS/src/parts/map_alignment.o \
+	${ROOTPATH}/PARTS/src/parts/map_mhr_info.o \
+	${ROOTPATH}/PARTS/src/parts/map_results.o \
+	${ROOTPATH}/PARTS/src/parts/map_structures.o \
+	${ROOTPATH}/PARTS/src/parts/pf_alignment.o \
+	${ROOTPATH}/PARTS/src/parts/pp_results.o \
+	${ROOTPATH}/PARTS/src/parts/ppf_cli.o \
+	${ROOTPATH}/PARTS/src/parts/ppf_loops-smp.o \
+	${ROOTPATH}/PARTS/src/parts/ppf_operators.o \
+	${ROOTPATH}/PARTS/src/parts/ppf_progress_bar.o \
+	${ROOTPATH}/PARTS/src/parts/ppf_scale.o \
+	${ROOTPATH}/PARTS/src/parts/ppf_ss.o \
+	${ROOTPATH}/PARTS/src/parts/ppf_tb_stack.o \
+	${ROOTPATH}/PARTS/src/parts/ppf_timer.o \
+	${ROOTPATH}/PARTS/src/parts/ppf_v_mhe.o \
+	${ROOTPATH}/PARTS/src/parts/ppf_w_ext.o \
+	${ROOTPATH}/PARTS/src/parts/ppf_w.o \
+	${ROOTPATH}/PARTS/src/parts/ppf_w_l.o \
+	${ROOTPATH}/PARTS/src/parts/ppf_w_mb.o \
+	${ROOTPATH}/PARTS/src/parts/ppf_w_mbl.o \
+	${ROOTPATH}/PARTS/src/parts/ppf_w_mhi.o \
+	${ROOTPATH}/PARTS/src/parts/process_sequences.o \
+	${ROOTPATH}/PARTS/src/parts/single_pf_array.o \
+	${ROOTPATH}/PARTS/src/parts/template_pf_array.o \
+	${ROOTPATH}/PARTS/src/parts/stoch_tb/stoch_sampled_alignment.o \
+	${ROOTPATH}/PARTS/src/parts/stoch_tb/stoch_sampling_math.o \
+	${ROOTPATH}/PARTS/src/parts/stoch_tb/stoch_sampled_str_aln_sample_set.o \
+	${ROOTPATH}/PARTS/src/parts/stoch_tb/stoch_sampled_structures.o \
+	${ROOTPATH}/src/phmm/utils/rng/rng.o \
+	${ROOTPATH}/src/phmm/utils/rng/seed_manager.o
+
 # Files for the PHMM calculation group used with both PARTS and TurboFold.
 PHMM_FILES = \
 	${ROOTPATH}/src/phmm/aln_env_utils.o \
@@ -170,7 +210,7 @@ RNA_FILES_SMP = \
 	${ROOTPATH}/src/draw.o \
 	${ROOTPATH}/src/extended_double.o \
 	${ROOTPATH}/src/forceclass.o \
-	${ROOTPATH}/src/MaxExpect.o \
+	${ROOTPATH}/src/MaxExpect-smp.o \
 	${ROOTPATH}/src/MaxExpectStack.o \
 	${ROOTPATH}/src/outputconstraints.o \
 	${ROOTPATH}/src/pfunction-smp.o \
@@ -311,7 +351,7 @@ HYBRID_FILES_SMP = \
 	${RNA_FILES_SMP} \
 	${ROOTPATH}/RNA_class/HybridRNA.o \
 	${ROOTPATH}/RNA_class/TwoRNA.o \
-	${ROOTPATH}/src/bimol.o
+	${ROOTPATH}/src/bimol-smp.o
 
 
 # Common files for the Oligo library.
@@ -330,7 +370,7 @@ OLIGO_FILES_SMP = \
 	${RNA_FILES} \
 	${ROOTPATH}/RNA_class/Oligowalk_object.o \
 	${ROOTPATH}/src/alltrace_intermolecular.o \
-	${ROOTPATH}/src/intermolecular.o \
+	${ROOTPATH}/src/intermolecular-smp.o \
 	${ROOTPATH}/src/OligoScreenCalc-smp.o \
 	${ROOTPATH}/src/pclass.o \
 	${ROOTPATH}/src/siRNAfilter.o \
@@ -425,32 +465,73 @@ JAVA_LIBRARY_FILES = \
 ##########
 
 ${ROOTPATH}/AllSub/AllSub.o: \
+	${ROOTPATH}/src/arrayclass.h \
+	${ROOTPATH}/src/pfunction.h \
 	${ROOTPATH}/AllSub/AllSub.cpp ${ROOTPATH}/AllSub/AllSub.h
 
+${ROOTPATH}/BatchDuplexFold/BatchDuplexFold.o: \
+	${ROOTPATH}/src/arrayclass.h \
+	${ROOTPATH}/src/FastaReader.h \
+	${ROOTPATH}/src/pfunction.h \
+	${ROOTPATH}/BatchDuplexFold/BatchDuplexFold.cpp ${ROOTPATH}/BatchDuplexFold/BatchDuplexFold.h
+
+${ROOTPATH}/BatchFold/BatchFold.o: \
+	${ROOTPATH}/src/arrayclass.h \
+	${ROOTPATH}/src/FastaReader.h \
+	${ROOTPATH}/src/pfunction.h \
+	${ROOTPATH}/BatchFold/BatchFold.cpp ${ROOTPATH}/BatchFold/BatchFold.h
+
+${ROOTPATH}/BatchFold/BatchFold-smp.o: \
+	${ROOTPATH}/src/arrayclass.h \
+	${ROOTPATH}/src/FastaReader.h \
+	${ROOTPATH}/src/pfunction.h \
+	${ROOTPATH}/BatchFold/BatchFold.cpp ${ROOTPATH}/BatchFold/BatchFold.h
+	${CXX} -c ${CXXOPENMPFLAGS} \
+	-o ${ROOTPATH}/BatchFold/BatchFold-smp.o ${ROOTPATH}/BatchFold/BatchFold.cpp
+
 ${ROOTPATH}/bifold/bifold.o: \
+	${ROOTPATH}/src/arrayclass.h \
+	${ROOTPATH}/src/pfunction.h \
 	${ROOTPATH}/bifold/bifold.cpp ${ROOTPATH}/bifold/bifold.h
 
 ${ROOTPATH}/CircleCompare/CircleCompare_Interface.o: \
+	${ROOTPATH}/src/arrayclass.h \
+	${ROOTPATH}/src/pfunction.h \
 	${ROOTPATH}/CircleCompare/CircleCompare_Interface.cpp ${ROOTPATH}/CircleCompare/CircleCompare_Interface.h \
 	${ROOTPATH}/src/StructureComparedImageHandler.cpp ${ROOTPATH}/src/StructureComparedImageHandler.h \
 	${ROOTPATH}/src/StructureImageHandler.cpp ${ROOTPATH}/src/StructureImageHandler.h
 
+${ROOTPATH}/CompileParameters/CompileParameters.o: \
+	${ROOTPATH}/src/arrayclass.h \
+	${ROOTPATH}/src/pfunction.h \
+	${ROOTPATH}/CompileParameters/CompileParameters.cpp ${ROOTPATH}/CompileParameters/CompileParameters.h
+
 ${ROOTPATH}/dot2ct/dot2ct.o: \
+	${ROOTPATH}/src/arrayclass.h \
+	${ROOTPATH}/src/pfunction.h \
 	${ROOTPATH}/dot2ct/dot2ct.cpp ${ROOTPATH}/dot2ct/dot2ct.h
 
 ${ROOTPATH}/draw/DrawStructure.o: \
+	${ROOTPATH}/src/arrayclass.h \
+	${ROOTPATH}/src/pfunction.h \
 	${ROOTPATH}/draw/DrawStructure.cpp ${ROOTPATH}/draw/DrawStructure.h \
 	${ROOTPATH}/src/StructureImageHandler.cpp ${ROOTPATH}/src/StructureImageHandler.h
 
 ${ROOTPATH}/DuplexFold/DuplexFold.o: \
+	${ROOTPATH}/src/arrayclass.h \
+	${ROOTPATH}/src/pfunction.h \
 	${ROOTPATH}/DuplexFold/DuplexFold.cpp ${ROOTPATH}/DuplexFold/DuplexFold.h
 
 ${ROOTPATH}/DynalignDotPlot/DynalignDotPlot.o: \
+	${ROOTPATH}/src/arrayclass.h \
+	${ROOTPATH}/src/pfunction.h \
 	${ROOTPATH}/DynalignDotPlot/DynalignDotPlot.cpp ${ROOTPATH}/DynalignDotPlot/DynalignDotPlot.h
 
-${ROOTPATH}/dynalign/dynaligninterface.o: ${ROOTPATH}/dynalign/dynaligninterface.cpp
+${ROOTPATH}/dynalign/dynaligninterface.o: ${ROOTPATH}/dynalign/dynaligninterface.cpp \
+	${ROOTPATH}/src/arrayclass.h
 
-${ROOTPATH}/dynalign/dynaligninterface-smp.o: ${ROOTPATH}/dynalign/dynaligninterface.cpp
+${ROOTPATH}/dynalign/dynaligninterface-smp.o: ${ROOTPATH}/dynalign/dynaligninterface.cpp \
+	${ROOTPATH}/src/arrayclass.h
 	${COMPILE_SMP} ${ROOTPATH}/dynalign/dynaligninterface.cpp
 
 ${ROOTPATH}/dynalign/dynaligninterface_ii.o: ${ROOTPATH}/dynalign/dynaligninterface.cpp
@@ -460,43 +541,64 @@ ${ROOTPATH}/dynalign/dynaligninterface_ii-smp.o: ${ROOTPATH}/dynalign/dynalignin
 	${COMPILE_DYNALIGN_II_SMP} ${ROOTPATH}/dynalign/dynaligninterface.cpp
 
 ${ROOTPATH}/efn2/efn2.o: \
+	${ROOTPATH}/src/arrayclass.h \
+	${ROOTPATH}/src/pfunction.h \
 	${ROOTPATH}/efn2/efn2.cpp ${ROOTPATH}/efn2/efn2.h
 
 ${ROOTPATH}/efn2/efn2-smp.o: \
+	${ROOTPATH}/src/arrayclass.h \
+	${ROOTPATH}/src/pfunction.h \
 	${ROOTPATH}/efn2/efn2.cpp ${ROOTPATH}/efn2/efn2.h
 	${CXX} -c ${CXXOPENMPFLAGS} \
 	-o ${ROOTPATH}/efn2/efn2-smp.o ${ROOTPATH}/efn2/efn2.cpp
 	
 
 ${ROOTPATH}/EnergyPlot/EnergyPlot.o: \
+	${ROOTPATH}/src/arrayclass.h \
+	${ROOTPATH}/src/pfunction.h \
 	${ROOTPATH}/EnergyPlot/EnergyPlot.cpp ${ROOTPATH}/EnergyPlot/EnergyPlot.h
 
 ${ROOTPATH}/EnsembleEnergy/EnsembleEnergy_Interface.o: \
+	${ROOTPATH}/src/arrayclass.h \
+	${ROOTPATH}/src/pfunction.h \
 	${ROOTPATH}/EnsembleEnergy/EnsembleEnergy_Interface.cpp ${ROOTPATH}/EnsembleEnergy/EnsembleEnergy_Interface.h
 
 ${ROOTPATH}/fold/Fold.o: \
+	${ROOTPATH}/src/arrayclass.h \
+	${ROOTPATH}/src/pfunction.h \
 	${ROOTPATH}/fold/Fold.cpp ${ROOTPATH}/fold/Fold.h
 
 ${ROOTPATH}/MaxExpect/MaxExpectInterface.o: \
+	${ROOTPATH}/src/arrayclass.h \
+	${ROOTPATH}/src/pfunction.h \
 	${ROOTPATH}/MaxExpect/MaxExpectInterface.cpp 	${ROOTPATH}/MaxExpect/MaxExpect.h
 
 ${ROOTPATH}/multilign/Multilign_Interface.o: \
+	${ROOTPATH}/src/arrayclass.h \
+	${ROOTPATH}/src/pfunction.h \
 	${ROOTPATH}/multilign/Multilign_Interface.cpp ${ROOTPATH}/multilign/Multilign_Interface.h
 
 ${ROOTPATH}/multilign/Multilign_Interface-smp.o: \
+	${ROOTPATH}/src/arrayclass.h \
+	${ROOTPATH}/src/pfunction.h \
 	${ROOTPATH}/multilign/Multilign_Interface.cpp ${ROOTPATH}/multilign/Multilign_Interface.h
 	${COMPILE_SMP} ${ROOTPATH}/multilign/Multilign_Interface.cpp
 
 ${ROOTPATH}/Multifind/Multifind_Interface.o: \
+	${ROOTPATH}/src/arrayclass.h \
+	${ROOTPATH}/src/pfunction.h \
 	${ROOTPATH}/Multifind/Multifind_Interface.cpp ${ROOTPATH}/Multifind/Multifind_Interface.h
 	${COMPILE_SVM} ${ROOTPATH}/Multifind/Multifind_Interface.cpp
 
 ${ROOTPATH}/Multifind/Multifind_Interface-smp.o: \
+	${ROOTPATH}/src/arrayclass.h \
+	${ROOTPATH}/src/pfunction.h \
 	${ROOTPATH}/Multifind/Multifind_Interface.cpp ${ROOTPATH}/Multifind/Multifind_Interface.h
 	${COMPILE_SVM_SMP} ${ROOTPATH}/Multifind/Multifind_Interface.cpp
 
 
 ${ROOTPATH}/napss/napss.o: \
+	${ROOTPATH}/src/pfunction.h \
 	${ROOTPATH}/napss/napss.cpp \
 	${ROOTPATH}/src/algorithm.h \
 	${ROOTPATH}/src/arrayclass.h \
@@ -512,12 +614,16 @@ ${ROOTPATH}/napss/napss.o: \
 	${ROOTPATH}/src/TProgressDialog.h
 
 ${ROOTPATH}/oligoscreen/oligoscreen.o: \
+	${ROOTPATH}/src/arrayclass.h \
+	${ROOTPATH}/src/pfunction.h \
 	${ROOTPATH}/oligoscreen/oligoscreen.cpp ${ROOTPATH}/oligoscreen/oligoscreen.h
 
 ${ROOTPATH}/oligowalk/src/globals.o: \
 	${ROOTPATH}/oligowalk/src/globals.cpp ${ROOTPATH}/oligowalk/src/globals.h
 
 ${ROOTPATH}/oligowalk/src/oligowalk.o: \
+	${ROOTPATH}/src/arrayclass.h \
+	${ROOTPATH}/src/pfunction.h \
 	${ROOTPATH}/oligowalk/src/globals.h \
 	${ROOTPATH}/oligowalk/src/oligowalk.cpp \
 	${ROOTPATH}/src/algorithm.h \
@@ -533,37 +639,61 @@ ${ROOTPATH}/oligowalk/src/oligowalk.o: \
 	${ROOTPATH}/src/thermo.h \
 	${ROOTPATH}/src/TProgressDialog.h
 
+${ROOTPATH}/PARTS/src/parts/ppf_loops-smp.o: \
+	${ROOTPATH}/PARTS/src/parts/ppf_loops.cpp ${ROOTPATH}/PARTS/src/parts/ppf_loops.h \
+	${ROOTPATH}/PARTS/src/parts/ppf_cli.h ${ROOTPATH}/PARTS/src/parts/ppf_scale.h
+	${CXX} -c ${CXXOPENMPFLAGS} \
+	-o ${ROOTPATH}/PARTS/src/parts/ppf_loops-smp.o ${ROOTPATH}/PARTS/src/parts/ppf_loops.cpp
+
 ${ROOTPATH}/pfunction/partition.o: \
+	${ROOTPATH}/src/arrayclass.h \
+	${ROOTPATH}/src/pfunction.h \
 	${ROOTPATH}/pfunction/partition.cpp ${ROOTPATH}/pfunction/partition.h
 
 ${ROOTPATH}/ProbablePair/ProbablePair.o: \
+	${ROOTPATH}/src/arrayclass.h \
+	${ROOTPATH}/src/pfunction.h \
 	${ROOTPATH}/ProbablePair/ProbablePair.cpp ${ROOTPATH}/ProbablePair/ProbablePair.h
 
 ${ROOTPATH}/ProbabilityPlot/ProbabilityPlot.o: \
+	${ROOTPATH}/src/arrayclass.h \
+	${ROOTPATH}/src/pfunction.h \
 	${ROOTPATH}/ProbabilityPlot/ProbabilityPlot.cpp ${ROOTPATH}/ProbabilityPlot/ProbabilityPlot.h
 
 ${ROOTPATH}/ProbKnot/ProbKnot_Interface.o: \
+	${ROOTPATH}/src/arrayclass.h \
+	${ROOTPATH}/src/pfunction.h \
 	${ROOTPATH}/ProbKnot/ProbKnot_Interface.cpp ${ROOTPATH}/ProbKnot/ProbKnot_Interface.h
 
 ${ROOTPATH}/ProbKnot/ProbScan_Interface.o: \
         ${ROOTPATH}/ProbScan/ProbScan_Interface.cpp ${ROOTPATH}/ProbKnot/ProbScan_Interface.h
 
 ${ROOTPATH}/refold/refold.o: \
+	${ROOTPATH}/src/arrayclass.h \
+	${ROOTPATH}/src/pfunction.h \
 	${ROOTPATH}/refold/refold.cpp ${ROOTPATH}/refold/refold.h
 
 ${ROOTPATH}/RemovePseudoknots/RemovePseudoknots.o: \
+	${ROOTPATH}/src/arrayclass.h \
+	${ROOTPATH}/src/pfunction.h \
 	${ROOTPATH}/RemovePseudoknots/RemovePseudoknots.cpp ${ROOTPATH}/RemovePseudoknots/RemovePseudoknots.h
 
-${ROOTPATH}/RNA_class/Dynalign_class.o: RNA_class/Dynalign_class.cpp
+${ROOTPATH}/RNA_class/Dynalign_class.o: RNA_class/Dynalign_class.cpp \
+	${ROOTPATH}/src/arrayclass.h \
+	${ROOTPATH}/src/pfunction.h
 
 ${ROOTPATH}/RNA_class/Dynalign_object.o: \
+	${ROOTPATH}/src/arrayclass.h \
+	${ROOTPATH}/src/pfunction.h \
 	${ROOTPATH}/RNA_class/Dynalign_object.cpp ${ROOTPATH}/RNA_class/Dynalign_object.h \
-	${ROOTPATH}/src/platform.h
+	${ROOTPATH}/src/dynalignarray.h ${ROOTPATH}/src/platform.h \
+	${ROOTPATH}/src/varray.h ${ROOTPATH}/src/wendarray.h
 
 
 ${ROOTPATH}/RNA_class/Dynalign_ii_object.o: \
 	${ROOTPATH}/RNA_class/Dynalign_object.cpp ${ROOTPATH}/RNA_class/Dynalign_object.h \
-	${ROOTPATH}/src/platform.h
+	${ROOTPATH}/src/dynalignarray.h ${ROOTPATH}/src/platform.h \
+	${ROOTPATH}/src/varray.h ${ROOTPATH}/src/wendarray.h
 	${COMPILE_DYNALIGN_II} ${ROOTPATH}/RNA_class/Dynalign_object.cpp
 
 ${ROOTPATH}/RNA_class/HybridRNA.o: \
@@ -572,7 +702,7 @@ ${ROOTPATH}/RNA_class/HybridRNA.o: \
 	${ROOTPATH}/RNA_class/thermodynamics.cpp ${ROOTPATH}/RNA_class/thermodynamics.h \
 	${ROOTPATH}/RNA_class/TwoRNA.cpp ${ROOTPATH}/RNA_class/TwoRNA.h \
 	${ROOTPATH}/src/algorithm.cpp ${ROOTPATH}/src/algorithm.h \
-	${ROOTPATH}/src/arrayclass.h \
+	${ROOTPATH}/src/arrayclass.h ${ROOTPATH}/src/bifurcation.h \
 	${ROOTPATH}/src/bimol.h \
 	${ROOTPATH}/src/defines.h \
 	${ROOTPATH}/src/dotarray.h \
@@ -590,6 +720,8 @@ ${ROOTPATH}/RNA_class/HybridRNA_class.o: \
 	${ROOTPATH}/src/structure.h
 
 ${ROOTPATH}/RNA_class/Multifind_object.o: \
+	${ROOTPATH}/src/arrayclass.h \
+	${ROOTPATH}/src/pfunction.h \
 	${ROOTPATH}/RNA_class/Multifind_object.cpp ${ROOTPATH}/RNA_class/Multifind_object.h
 	${COMPILE_SVM_SMP} ${ROOTPATH}/RNA_class/Multifind_object.cpp
 
@@ -649,11 +781,17 @@ ${ROOTPATH}/RNA_class/Multilign_object-Multifind.o: \
 
 
 ${ROOTPATH}/phmm/phmm_interface.o: ${ROOTPATH}/phmm/phmm_interface.cpp \
+	${ROOTPATH}/src/arrayclass.h \
+	${ROOTPATH}/src/pfunction.h \
     ${ROOTPATH}/phmm/phmm_interface.h
 
-${ROOTPATH}/RNA_class/OligoWalk_class.o: ${ROOTPATH}/RNA_class/OligoWalk_class.cpp
+${ROOTPATH}/RNA_class/OligoWalk_class.o: ${ROOTPATH}/RNA_class/OligoWalk_class.cpp \
+	${ROOTPATH}/src/arrayclass.h \
+	${ROOTPATH}/src/pfunction.h
 
 ${ROOTPATH}/RNA_class/Oligowalk_object.o: \
+	${ROOTPATH}/src/arrayclass.h \
+	${ROOTPATH}/src/pfunction.h \
 	${ROOTPATH}/RNA_class/Oligowalk_object.cpp ${ROOTPATH}/RNA_class/Oligowalk_object.h
 
 ${ROOTPATH}/RNA_class/RNA.o: \
@@ -667,6 +805,7 @@ ${ROOTPATH}/RNA_class/RNA.o: \
 	${ROOTPATH}/src/dotarray.h \
 	${ROOTPATH}/src/draw.h \
 	${ROOTPATH}/src/forceclass.h \
+	${ROOTPATH}/src/mappedfile.h \
 	${ROOTPATH}/src/MaxExpect.h \
 	${ROOTPATH}/src/pfunction.h \
 	${ROOTPATH}/src/probknot.h \
@@ -704,18 +843,22 @@ ${ROOTPATH}/RNA_class/RNA_dynalign_ii.o: \
 	${COMPILE_DYNALIGN_II} ${ROOTPATH}/RNA_class/RNA.cpp
 
 ${ROOTPATH}/RNA_class/RNA_class.o: \
+	${ROOTPATH}/src/arrayclass.h \
+	${ROOTPATH}/src/pfunction.h \
 	${ROOTPATH}/RNA_class/RNA_class.cpp \
 	${ROOTPATH}/src/structure.h
 
 ${ROOTPATH}/RNA_class/thermodynamics.o: \
-	${ROOTPATH}/RNA_class/thermodynamics.cpp ${ROOTPATH}/RNA_class/thermodynamics.h
+	${ROOTPATH}/src/arrayclass.h \
+	${ROOTPATH}/RNA_class/thermodynamics.cpp ${ROOTPATH}/RNA_class/thermodynamics.h \
+	${ROOTPATH}/src/defines.h ${ROOTPATH}/src/mappedfile.h ${ROOTPATH}/src/pfunction.h
 
 ${ROOTPATH}/RNA_class/TwoRNA.o: \
 	${ROOTPATH}/RNA_class/RNA.cpp ${ROOTPATH}/RNA_class/RNA.h \
 	${ROOTPATH}/RNA_class/thermodynamics.cpp ${ROOTPATH}/RNA_class/thermodynamics.h \
 	${ROOTPATH}/RNA_class/TwoRNA.cpp ${ROOTPATH}/RNA_class/TwoRNA.h \
 	${ROOTPATH}/src/algorithm.cpp ${ROOTPATH}/src/algorithm.h \
-	${ROOTPATH}/src/arrayclass.h \
+	${ROOTPATH}/src/arrayclass.h ${ROOTPATH}/src/bifurcation.h \
 	${ROOTPATH}/src/bimol.h \
 	${ROOTPATH}/src/defines.h \
 	${ROOTPATH}/src/dotarray.h \
@@ -731,18 +874,22 @@ ${ROOTPATH}/RNA_class/TwoRNA.o: \
 ${ROOTPATH}/RNAstructure_java_interface/SWIG/ProgressMonitor.o: \
 	${ROOTPATH}/RNAstructure_java_interface/SWIG/ProgressMonitor.cpp ${ROOTPATH}/RNAstructure_java_interface/SWIG/ProgressMonitor.h
 
-${ROOTPATH}/RNAstructure_java_interface/SWIG/RNAstructureBackendCalculator.o: ${ROOTPATH}/RNAstructure_java_interface/SWIG/RNAstructureBackendCalculator.cpp
+${ROOTPATH}/RNAstructure_java_interface/SWIG/RNAstructureBackendCalculator.o: ${ROOTPATH}/RNAstructure_java_interface/SWIG/RNAstructureBackendCalculator.cpp \
+	${ROOTPATH}/src/arrayclass.h \
+	${ROOTPATH}/src/pfunction.h
 	${COMPILE_PROXY_FOR_JAVA}
 
 ${ROOTPATH}/RNAstructure_java_interface/SWIG/TProgressDialog.o: \
 	${ROOTPATH}/RNAstructure_java_interface/SWIG/TProgressDialog.cpp ${ROOTPATH}/RNAstructure_java_interface/SWIG/TProgressDialog.h
 
 ${ROOTPATH}/scorer/Scorer_Interface.o: \
+	${ROOTPATH}/src/arrayclass.h \
+	${ROOTPATH}/src/pfunction.h \
 	${ROOTPATH}/scorer/Scorer_Interface.cpp ${ROOTPATH}/scorer/Scorer_Interface.h
 
 ${ROOTPATH}/src/algorithm.o: \
 	${ROOTPATH}/src/algorithm.cpp ${ROOTPATH}/src/algorithm.h \
-	${ROOTPATH}/src/arrayclass.h \
+	${ROOTPATH}/src/arrayclass.h ${ROOTPATH}/src/bifurcation.h \
 	${ROOTPATH}/src/defines.h \
 	${ROOTPATH}/src/dotarray.h \
 	${ROOTPATH}/src/forceclass.h \
@@ -755,7 +902,7 @@ ${ROOTPATH}/src/algorithm.o: \
 
 ${ROOTPATH}/src/algorithm-smp.o: \
 	${ROOTPATH}/src/algorithm.cpp ${ROOTPATH}/src/algorithm.h \
-	${ROOTPATH}/src/arrayclass.h \
+	${ROOTPATH}/src/arrayclass.h ${ROOTPATH}/src/bifurcation.h \
 	${ROOTPATH}/src/defines.h \
 	${ROOTPATH}/src/dotarray.h \
 	${ROOTPATH}/src/forceclass.h \
@@ -771,7 +918,7 @@ ${ROOTPATH}/src/algorithm-smp.o: \
 
 ${ROOTPATH}/src/algorithm_dynalign_ii.o: \
 	${ROOTPATH}/src/algorithm.cpp ${ROOTPATH}/src/algorithm.h \
-	${ROOTPATH}/src/arrayclass.h \
+	${ROOTPATH}/src/arrayclass.h ${ROOTPATH}/src/bifurcation.h \
 	${ROOTPATH}/src/defines.h \
 	${ROOTPATH}/src/dotarray.h \
 	${ROOTPATH}/src/forceclass.h \
@@ -785,7 +932,7 @@ ${ROOTPATH}/src/algorithm_dynalign_ii.o: \
 
 ${ROOTPATH}/src/algorithm_instrumented.o: \
 	${ROOTPATH}/src/algorithm.cpp ${ROOTPATH}/src/algorithm.h \
-	${ROOTPATH}/src/arrayclass.h \
+	${ROOTPATH}/src/arrayclass.h ${ROOTPATH}/src/bifurcation.h \
 	${ROOTPATH}/src/defines.h \
 	${ROOTPATH}/src/dotarray.h \
 	${ROOTPATH}/src/forceclass.h \
@@ -798,11 +945,14 @@ ${ROOTPATH}/src/algorithm_instrumented.o: \
 	${COMPILE_INSTRUMENTED} ${ROOTPATH}/src/algorithm.cpp
 
 ${ROOTPATH}/src/alltrace.o: \
+	${ROOTPATH}/src/arrayclass.h \
 	${ROOTPATH}/src/alltrace.cpp ${ROOTPATH}/src/alltrace.h \
 	${ROOTPATH}/src/defines.h \
 	${ROOTPATH}/src/structure.h
 
 ${ROOTPATH}/src/alltrace_intermolecular.o: \
+	${ROOTPATH}/src/arrayclass.h \
+	${ROOTPATH}/src/pfunction.h \
 	${ROOTPATH}/src/alltrace_intermolecular.cpp ${ROOTPATH}/src/alltrace_intermolecular.h
 
 ${ROOTPATH}/src/arrayclass.o: \
@@ -810,8 +960,17 @@ ${ROOTPATH}/src/arrayclass.o: \
 	${ROOTPATH}/src/defines.h
 
 ${ROOTPATH}/src/bimol.o: \
+	${ROOTPATH}/src/arrayclass.h \
+	${ROOTPATH}/src/pfunction.h \
 	${ROOTPATH}/src/bimol.cpp ${ROOTPATH}/src/bimol.h
 
+${ROOTPATH}/src/bimol-smp.o: \
+	${ROOTPATH}/src/arrayclass.h \
+	${ROOTPATH}/src/pfunction.h \
+	${ROOTPATH}/src/bimol.cpp ${ROOTPATH}/src/bimol.h
+	${CXX} -c ${CXXOPENMPFLAGS} \
+	-o ${ROOTPATH}/src/bimol-smp.o ${ROOTPATH}/src/bimol.cpp
+
 ${ROOTPATH}/src/configfile.o: \
 	${ROOTPATH}/src/configfile.cpp ${ROOTPATH}/src/configfile.h
 
@@ -901,9 +1060,11 @@ ${ROOTPATH}/src/dynalign_ii-smp.o: \
 	${COMPILE_DYNALIGN_II_SMP} ${ROOTPATH}/src/dynalign.cpp
 
 ${ROOTPATH}/src/dynalignarray.o: \
+	${ROOTPATH}/src/arrayclass.h \
 	${ROOTPATH}/src/defines.h \
 	${ROOTPATH}/src/dynalign.h \
-	${ROOTPATH}/src/dynalignarray.cpp ${ROOTPATH}/src/dynalignarray.h
+	${ROOTPATH}/src/dynalignarray.cpp ${ROOTPATH}/src/dynalignarray.h \
+	${ROOTPATH}/src/mappedfile.h
 
 ${ROOTPATH}/src/dynalignheap.o: \
 	${ROOTPATH}/src/defines.h \
@@ -922,17 +1083,40 @@ ${ROOTPATH}/src/dynalignstackclass_ii.o: \
 ${ROOTPATH}/src/extended_double.o: \
 	${ROOTPATH}/src/extended_double.cpp ${ROOTPATH}/src/extended_double.h
 
+${ROOTPATH}/src/FastaReader.o: \
+	${ROOTPATH}/src/FastaReader.cpp ${ROOTPATH}/src/FastaReader.h
+
 ${ROOTPATH}/src/forceclass.o: \
 	${ROOTPATH}/src/forceclass.cpp ${ROOTPATH}/src/forceclass.h
 
 ${ROOTPATH}/src/intermolecular.o: \
+	${ROOTPATH}/src/arrayclass.h \
+	${ROOTPATH}/src/pfunction.h \
+	${ROOTPATH}/src/intermolecular.cpp ${ROOTPATH}/src/intermolecular.h \
+	${ROOTPATH}/src/siRNAfilter.cpp ${ROOTPATH}/src/siRNAfilter.h
+
+${ROOTPATH}/src/intermolecular-smp.o: \
+	${ROOTPATH}/src/arrayclass.h \
+	${ROOTPATH}/src/pfunction.h \
 	${ROOTPATH}/src/intermolecular.cpp ${ROOTPATH}/src/intermolecular.h \
 	${ROOTPATH}/src/siRNAfilter.cpp ${ROOTPATH}/src/siRNAfilter.h
+	${CXX} -c ${CXXOPENMPFLAGS} \
+	-o ${ROOTPATH}/src/intermolecular-smp.o ${ROOTPATH}/src/intermolecular.cpp
 
 ${ROOTPATH}/src/MaxExpect.o: \
+	${ROOTPATH}/src/arrayclass.h \
+	${ROOTPATH}/src/pfunction.h \
 	${ROOTPATH}/src/defines.h \
 	${ROOTPATH}/src/MaxExpect.cpp ${ROOTPATH}/src/MaxExpect.h
 
+${ROOTPATH}/src/MaxExpect-smp.o: \
+	${ROOTPATH}/src/arrayclass.h \
+	${ROOTPATH}/src/pfunction.h \
+	${ROOTPATH}/src/defines.h \
+	${ROOTPATH}/src/MaxExpect.cpp ${ROOTPATH}/src/MaxExpect.h
+	${CXX} -c ${CXXOPENMPFLAGS} \
+	-o ${ROOTPATH}/src/MaxExpect-smp.o ${ROOTPATH}/src/MaxExpect.cpp
+
 ${ROOTPATH}/src/MaxExpectStack.o: \
 	${ROOTPATH}/src/MaxExpectStack.cpp ${ROOTPATH}/src/MaxExpectStack.h
 
@@ -948,9 +1132,13 @@ ${ROOTPATH}/src/observingtextprogressbar.o: \
 	${ROOTPATH}/src/TProgressDialog.h
 
 ${ROOTPATH}/src/OligoScreenCalc.o: \
+	${ROOTPATH}/src/arrayclass.h \
+	${ROOTPATH}/src/pfunction.h \
 	${ROOTPATH}/src/OligoScreenCalc.cpp ${ROOTPATH}/src/OligoScreenCalc.h
 
 ${ROOTPATH}/src/OligoScreenCalc-smp.o: \
+	${ROOTPATH}/src/arrayclass.h \
+	${ROOTPATH}/src/pfunction.h \
 	${ROOTPATH}/src/OligoScreenCalc.cpp ${ROOTPATH}/src/OligoScreenCalc.h
 	${CXX} -c ${CXXOPENMPFLAGS} \
 	-o ${ROOTPATH}/src/OligoScreenCalc-smp.o ${ROOTPATH}/src/OligoScreenCalc.cpp 
@@ -963,18 +1151,24 @@ ${ROOTPATH}/src/ParseCommandLine.o: \
 	${ROOTPATH}/src/ParseCommandLine.cpp ${ROOTPATH}/src/ParseCommandLine.h
 
 ${ROOTPATH}/src/pclass.o: \
+	${ROOTPATH}/src/arrayclass.h \
+	${ROOTPATH}/src/pfunction.h \
 	${ROOTPATH}/src/pclass.cpp ${ROOTPATH}/src/pclass.h
 
 ${ROOTPATH}/src/probknot.o: \
+	${ROOTPATH}/src/arrayclass.h \
+	${ROOTPATH}/src/pfunction.h \
 	${ROOTPATH}/src/probknot.cpp ${ROOTPATH}/src/probknot.h
 
 ${ROOTPATH}/src/pfunction.o: \
+	${ROOTPATH}/src/arrayclass.h \
 	${ROOTPATH}/src/pfunction.cpp ${ROOTPATH}/src/pfunction.h ${ROOTPATH}/src/boltzmann.h \
-	${ROOTPATH}/src/algorithm.h ${ROOTPATH}/src/structure.h  
+	${ROOTPATH}/src/algorithm.h ${ROOTPATH}/src/structure.h ${ROOTPATH}/src/bifurcation.h ${ROOTPATH}/src/log_double.h ${ROOTPATH}/src/mappedfile.h
 
 ${ROOTPATH}/src/pfunction-smp.o: \
+	${ROOTPATH}/src/arrayclass.h \
 	${ROOTPATH}/src/pfunction.cpp ${ROOTPATH}/src/pfunction.h ${ROOTPATH}/src/boltzmann.h \
-	${ROOTPATH}/src/algorithm.h ${ROOTPATH}/src/structure.h  
+	${ROOTPATH}/src/algorithm.h ${ROOTPATH}/src/structure.h ${ROOTPATH}/src/bifurcation.h ${ROOTPATH}/src/log_double.h ${ROOTPATH}/src/mappedfile.h
 	${CXX} -c ${CXXOPENMPFLAGS} \
 	-o ${ROOTPATH}/src/pfunction-smp.o ${ROOTPATH}/src/pfunction.cpp
 
@@ -990,6 +1184,7 @@ ${ROOTPATH}/src/rank.o: \
 	${ROOTPATH}/src/workunit.h
 
 ${ROOTPATH}/src/rankconsumer.o: \
+	${ROOTPATH}/src/arrayclass.h \
 	${ROOTPATH}/src/dynalign.h \
 	${ROOTPATH}/src/dynalignarray.h \
 	${ROOTPATH}/src/rankconsumer.cpp ${ROOTPATH}/src/rankconsumer.h \
@@ -1032,6 +1227,8 @@ ${ROOTPATH}/src/rna_library.o: \
 	${ROOTPATH}/src/structure.h
 
 ${ROOTPATH}/src/pkHelix.o: \
+	${ROOTPATH}/src/arrayclass.h \
+	${ROOTPATH}/src/pfunction.h \
 	${ROOTPATH}/src/pkHelix.cpp ${ROOTPATH}/src/pkHelix.h
 
 ${ROOTPATH}/src/basepair.o: \
@@ -1041,12 +1238,15 @@ ${ROOTPATH}/src/Pseudoknot.o: \
 	${ROOTPATH}/src/Pseudoknot.cpp ${ROOTPATH}/src/Pseudoknot.h
 
 ${ROOTPATH}/src/PseudoParser.o: \
+	${ROOTPATH}/src/arrayclass.h \
+	${ROOTPATH}/src/pfunction.h \
 	${ROOTPATH}/src/PseudoParser.cpp ${ROOTPATH}/src/PseudoParser.h
 
 ${ROOTPATH}/src/score.o: \
 	${ROOTPATH}/src/score.cpp ${ROOTPATH}/src/score.h
 
 ${ROOTPATH}/src/siRNAfilter.o: \
+	${ROOTPATH}/src/arrayclass.h \
 	${ROOTPATH}/src/siRNAfilter.cpp ${ROOTPATH}/src/siRNAfilter.h
 
 ${ROOTPATH}/src/stackclass.o: \
@@ -1057,10 +1257,14 @@ ${ROOTPATH}/src/stackstruct.o: \
 	${ROOTPATH}/src/stackstruct.cpp ${ROOTPATH}/src/stackstruct.h
 
 ${ROOTPATH}/src/stochastic.o: \
-	${ROOTPATH}/src/stochastic.cpp ${ROOTPATH}/src/stochastic.h
+	${ROOTPATH}/src/arrayclass.h \
+	${ROOTPATH}/src/pfunction.h \
+	${ROOTPATH}/src/stochastic.cpp ${ROOTPATH}/src/stochastic.h ${ROOTPATH}/src/stochasticcounts.h
 
 ${ROOTPATH}/src/stochastic-smp.o: \
-	${ROOTPATH}/src/stochastic.cpp ${ROOTPATH}/src/stochastic.h
+	${ROOTPATH}/src/arrayclass.h \
+	${ROOTPATH}/src/pfunction.h \
+	${ROOTPATH}/src/stochastic.cpp ${ROOTPATH}/src/stochastic.h ${ROOTPATH}/src/stochasticcounts.h
 	${CXX} -c ${CXXOPENMPFLAGS} \
 	-o ${ROOTPATH}/src/stochastic-smp.o ${ROOTPATH}/src/stochastic.cpp 
 
@@ -1070,21 +1274,28 @@ ${ROOTPATH}/src/structure.o: \
 	${ROOTPATH}/src/structure.cpp ${ROOTPATH}/src/structure.h
 
 ${ROOTPATH}/src/StructureComparedImageHandler.o: \
+	${ROOTPATH}/src/arrayclass.h \
+	${ROOTPATH}/src/pfunction.h \
 	${ROOTPATH}/src/StructureComparedImageHandler.cpp ${ROOTPATH}/src/StructureComparedImageHandler.h \
 	${ROOTPATH}/src/StructureImageHandler.cpp ${ROOTPATH}/src/StructureImageHandler.h
 
 ${ROOTPATH}/src/StructureImageHandler.o: \
+	${ROOTPATH}/src/arrayclass.h \
+	${ROOTPATH}/src/pfunction.h \
 	${ROOTPATH}/src/StructureImageHandler.cpp ${ROOTPATH}/src/StructureImageHandler.h
 
 ${ROOTPATH}/src/thermo.o: \
+	${ROOTPATH}/src/arrayclass.h \
 	${ROOTPATH}/src/thermo.cpp ${ROOTPATH}/src/thermo.h
 
 ${ROOTPATH}/src/TProgressDialog.o: \
 	${ROOTPATH}/src/TProgressDialog.cpp ${ROOTPATH}/src/TProgressDialog.h
 
 ${ROOTPATH}/src/varray.o: \
+	${ROOTPATH}/src/arrayclass.h \
 	${ROOTPATH}/src/defines.h \
 	${ROOTPATH}/src/dynalign.h \
+	${ROOTPATH}/src/mappedfile.h \
 	${ROOTPATH}/src/varray.cpp ${ROOTPATH}/src/varray.h
 
 ${ROOTPATH}/src/wendarray.o: \
@@ -1092,13 +1303,19 @@ ${ROOTPATH}/src/wendarray.o: \
 	${ROOTPATH}/src/wendarray.cpp ${ROOTPATH}/src/wendarray.h
 
 ${ROOTPATH}/stochastic/stochastic.o: \
-	${ROOTPATH}/stochastic/stochastic.cpp ${ROOTPATH}/stochastic/stochastic.h
+	${ROOTPATH}/src/arrayclass.h \
+	${ROOTPATH}/src/pfunction.h \
+	${ROOTPATH}/stochastic/stochastic.cpp ${ROOTPATH}/stochastic/stochastic.h ${ROOTPATH}/src/stochasticcounts.h
 
 ${ROOTPATH}/ShapeKnots/ShapeKnots_Interface.o: \
+	${ROOTPATH}/src/arrayclass.h \
+	${ROOTPATH}/src/pfunction.h \
     ${ROOTPATH}/ShapeKnots/ShapeKnots_Interface.cpp ${ROOTPATH}/ShapeKnots/ShapeKnots_Interface.h \
     ${ROOTPATH}/src/ShapeKnots.h 
 
 ${ROOTPATH}/src/ShapeKnots.o: \
+	${ROOTPATH}/src/arrayclass.h \
+	${ROOTPATH}/src/pfunction.h \
     ${ROOTPATH}/src/ShapeKnots.cpp ${ROOTPATH}/src/ShapeKnots.h \
 	${ROOTPATH}/src/pkHelix.h \
 	${ROOTPATH}/src/PseudoParser.h \
@@ -1111,9 +1328,36 @@ ${ROOTPATH}/src/ShapeKnots.o: \
 ${ROOTPATH}/TurboFold/TurboFold_Interface-smp.o:
 	${COMPILE_SMP} ${ROOTPATH}/TurboFold/TurboFold_Interface.cpp
 
-${ROOTPATH}/TurboFold/TurboFold_object-smp.o:
+${ROOTPATH}/TurboFold/TurboFold_object-smp.o: \
+	${ROOTPATH}/src/arrayclass.h \
+	${ROOTPATH}/src/pfunction.h
 	${COMPILE_SMP} ${ROOTPATH}/TurboFold/TurboFold_object.cpp
 
-${ROOTPATH}/TurboFold/TurboFold_thread-smp.o:
+${ROOTPATH}/TurboFold/TurboFold_thread-smp.o: \
+	${ROOTPATH}/src/arrayclass.h \
+	${ROOTPATH}/src/pfunction.h
 	${COMPILE_SMP} ${ROOTPATH}/TurboFold/TurboFold_thread.cpp
 
+${ROOTPATH}/PARTS/src/parts/single_pf_array.o: \
+	${ROOTPATH}/src/arrayclass.h \
+	${ROOTPATH}/src/pfunction.h
+
+${ROOTPATH}/RNA_class/ProbScan.o: \
+	${ROOTPATH}/src/arrayclass.h \
+	${ROOTPATH}/src/pfunction.h
+
+${ROOTPATH}/RNAstructure_java_drawing/SWIG/DotPlotBackend.o: \
+	${ROOTPATH}/src/arrayclass.h \
+	${ROOTPATH}/src/pfunction.h
+
+${ROOTPATH}/RNAstructure_java_drawing/SWIG/StructureBackend.o: \
+	${ROOTPATH}/src/arrayclass.h \
+	${ROOTPATH}/src/pfunction.h
+
+${ROOTPATH}/TurboFold/TurboFold_object.o: \
+	${ROOTPATH}/src/arrayclass.h \
+	${ROOTPATH}/src/pfunction.h
+
+${ROOTPATH}/TurboFold/TurboFold_thread.o: \
+	${ROOTPATH}/src/arrayclass.h \
+	${ROOTPATH}/src/pfunction.h
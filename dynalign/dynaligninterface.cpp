@@ -258,6 +258,7 @@ int main(int argc, char* argv[]) {
 
 	double Temperature;
 	bool DNA;
+	double maxmemory = 0,plannedmemory;//the memory limit for the fill arrays and the memory planned, in megabytes
 
 
 	TProgressDialog *progress = NULL;
@@ -407,6 +408,8 @@ int main(int argc, char* argv[]) {
 	  else Temperature = 310.15;
 	  if (config.contains("DNA")) DNA = config.getOption<bool>("DNA");
 	  else DNA = false;
+	  if (config.contains("max_memory")) maxmemory = config.getOption<double>("max_memory");
+	  else maxmemory = 0;
 
     }
 
@@ -822,12 +825,12 @@ int main(int argc, char* argv[]) {
 if (dynalign(&ct1, &ct2, align, imaxseparation, islope, iintercept, igapincrease, &data,
                  maxtrace, bpwin, awin, percent, forcealign, max_elongation, allowed_alignments, progress,
            (savefile != "") ? savefile.c_str() : NULL, optimalonly, local,
-		   /*force =*/ constrained, numProcessors)==14)
+		   /*force =*/ constrained, numProcessors, maxmemory, &plannedmemory)==14)
 #else
     if (dynalign(&ct1, &ct2, align, imaxseparation, igapincrease, &data,
            insert, maxtrace, bpwin, awin, percent, forcealign, allowed_alignments, progress,
            (savefile != "") ? savefile.c_str() : NULL, optimalonly, local,
-		   /*force =*/ constrained, numProcessors)==14)
+		   /*force =*/ constrained, numProcessors, maxmemory, &plannedmemory)==14)
 #endif
 
  {
@@ -839,6 +842,8 @@ if (dynalign(&ct1, &ct2, align, imaxseparation, islope, iintercept, igapincrease
 
 	}
   
+	if (maxmemory>0) cout << "Memory planned for the arrays: " << plannedmemory << " MB\n";
+
 	//output the structures
 	ct1.ctout(outct.c_str());
 	ct2.ctout(outct2.c_str());
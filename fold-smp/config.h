@@ -1,5 +1,6 @@
 CC = gcc
 CFLAGS = -DSHORT -O3 -Wall -D disablecoax
+OPENMP_CFLAGS = -fopenmp
 CUDA_CC = nvcc
 CUDA_CFLAGS = -DSHORT -O3 -use_fast_math -D disablecoax 
 DAT = ../data_tables
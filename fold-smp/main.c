@@ -5,6 +5,10 @@
 #include <time.h>
 #include <sys/stat.h>
 #include <dirent.h>
+#include <getopt.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 #include "prna.h"
 #include "util.h"
@@ -22,6 +26,8 @@ static const char Usage[] =
   "-p <file>: write ProbKnot structure in ct format to <file>\n"
   "-m <length>: set minimum helix length for ProbKnot\n"
   "             (default: 3 base pairs)\n"
+  "-n, --threads <count>: number of threads for the fill\n"
+  "             (default: all processors; OpenMP build only)\n"
   "-v:        show arrays\n\n"
   "If none of -t, -l, -p, or -v is chosen,\n"
   "writes ProbKnot structure in ct format to stdout\n";
@@ -35,8 +41,13 @@ int main(int argc, char **argv)
   const char *probknot_filename = 0; 
   const char *binary_parameter_filename = 0;
   /* process command-line arguments */
+  static const struct option long_options[] = {
+    {"threads", required_argument, 0, 'n'},
+    {0, 0, 0, 0}
+  };
+  int num_threads = 0;
   int c;
-  while ((c = getopt(argc, argv, "hb:dt:l:p:m:v")) != EOF)
+  while ((c = getopt_long(argc, argv, "hb:dt:l:p:m:n:v", long_options, 0)) != EOF)
     if (c == 'h')
       die(Usage,cmd);
     else if (c == 'b')
@@ -51,6 +62,10 @@ int main(int argc, char **argv)
       probknot_filename = optarg;
     else if (c == 'm')
       min_helix_length = atoi(optarg);
+    else if (c == 'n') {
+      if (!isdigits(optarg) || (num_threads = atoi(optarg)) < 1)
+	die("%s: number of threads must be a positive integer", cmd);
+    }
     else if (c == 'v')
       verbose = 1;
     else
@@ -77,6 +92,13 @@ int main(int argc, char **argv)
     param_read_from_text(path, use_dna_params, &par);
   }
 // param_show(par); 
+#ifdef _OPENMP
+  if (num_threads)
+    omp_set_num_threads(num_threads);
+#else
+  if (num_threads > 1)
+    fprintf(stderr, "%s: built without OpenMP, ignoring --threads\n", cmd);
+#endif
   /* calculate partition function */
   prna_t p = prna_new(seq, &par);
   printf("RT is %f\n",RT);
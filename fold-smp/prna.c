@@ -349,6 +349,16 @@ DEV HOST static int_t *array_val(int_t *a, int i, int j, int n, const base_t *s)
 #define IINC 1
 #endif
 
+/* In the OpenMP build, prna_new opens one team of threads for the whole fill
+   and each kernel below shares its loop over i among that team. The cells of
+   one diagonal only read cells of shorter diagonals, so they are independent,
+   and the implicit barrier at the end of each loop orders the kernels. */
+#if defined(_OPENMP) && !defined(__CUDACC__)
+#define OMP_FOR_I _Pragma("omp for schedule(dynamic)")
+#else
+#define OMP_FOR_I
+#endif
+
 //MFE recursions begin
 //TODO
 //figure out source of differences in arrays
@@ -361,6 +371,7 @@ GLOBAL static void calc_V_hairpin_and_V_stack//_multibranch//calculate V(i,j)=Vh
 (int d, int n, base_t *s, int_t *v, int_t *w, int_t *wm, int_t *w5, int_t *w3, param_t p)
 {
   int i;
+  OMP_FOR_I
   for (i = ISTART; i < n; i += IINC) { //for(i=blockId.x;i<numberofbases;i+=gridDim.x) so each thread will handle 0+blockId.x,256+blockId.x.. 
     const int jtmp = i+d+1;
     const int j = wrap(jtmp,n);
@@ -425,6 +436,7 @@ GLOBAL static void calc_V_bulge_internal (int d, int n, base_t *s, int_t *v, int
 {
 //	Vbi(i,j) = min[V(k,l)+ Ebulge/int(i,j,k,l)] where i<k<l<j, i!=i+1, and j!=j-1
   int i;
+  OMP_FOR_I
   for (i = ISTART; i < n; i += IINC) {
     const int jtmp = i+d+1;
     const int j = wrap(jtmp,n);
@@ -489,6 +501,7 @@ GLOBAL static void calc_V_multibranch (int d, int n, base_t *s, int_t *v, int_t
 	//V(i,j) = min(V(i,j), Vmb(i,j))
 
   int i;
+  OMP_FOR_I
   for (i = ISTART; i < n; i += IINC) { //for(i=blockId.x;i<numberofbases;i+=gridDim.x) so each thread will handle 0+blockId.x,256+blockId.x.. 
     const int jtmp = i+d+1;
     const int j = wrap(jtmp,n);
@@ -543,6 +556,7 @@ GLOBAL static void calc_V_exterior (int d, int n, base_t *s, int_t *v, int_t *w,
 //		min_over_k[ V(k,j-2-N) + W3(i+2) + W5(k-1) + E ] ]
 
   int i;
+  OMP_FOR_I
   for (i = ISTART; i < n; i += IINC) { //for(i=blockId.x;i<numberofbases;i+=gridDim.x) so each thread will handle 0+blockId.x,256+blockId.x.. 
     const int jtmp = i+d+1;
     const int j = wrap(jtmp,n);
@@ -587,6 +601,7 @@ GLOBAL static void calc_W (int d, int n, base_t *s, int_t *v, int_t *w, int_t *w
 //			V(i+1,j+1)+Edangleboth]
 
   int i;
+  OMP_FOR_I
   for (i = ISTART; i < n; i += IINC) { //for(i=blockId.x;i<numberofbases;i+=gridDim.x) so each thread will handle 0+blockId.x,256+blockId.x.. 
     const int jtmp = i+d+1;
     const int j = wrap(jtmp,n);
@@ -676,6 +691,7 @@ GLOBAL static void calc_WM (int d, int n, base_t *s, int_t *v, int_t *w, int_t *
 //			V(i+1,k)+V(k+2,j)+2c+Ecoax3'mismatch]
 
   int i;
+  OMP_FOR_I
   for (i = ISTART; i < n; i += IINC) { //for(i=blockId.x;i<numberofbases;i+=gridDim.x) so each thread will handle 0+blockId.x,256+blockId.x.. 
     const int jtmp = i+d+1;
     const int j = wrap(jtmp,n);
@@ -732,6 +748,7 @@ GLOBAL static void calc_WM (int d, int n, base_t *s, int_t *v, int_t *w, int_t *
 GLOBAL static void calc_coaxial (int d, int n, base_t *s, int_t *v, int_t *w, int_t *wm, int_t *w5, int_t *w3, param_t p)
 {
   int i;
+  OMP_FOR_I
   for (i = ISTART; i < n; i += IINC) {
     const int jtmp = i+d+1;
     const int j = wrap(jtmp,n);
@@ -832,6 +849,7 @@ GLOBAL static void calc_coaxial (int d, int n, base_t *s, int_t *v, int_t *w, in
 GLOBAL static void calc_wl_coax(int d, int n, base_t *s, int_t *v, int_t *w, int_t *wm, int_t *w5, int_t *w3, param_t p)
 {
   int i;
+  OMP_FOR_I
   for (i = ISTART; i < n; i += IINC) {
     const int jtmp = i+d+1;
     const int j = wrap(jtmp,n);
@@ -1158,6 +1176,10 @@ prna_t prna_new(const char *s, param_t par)
   init_w5_and_w3(n,p->w5,p->w3);
   init_w(n,p->w);
  
+#ifdef _OPENMP /* every thread walks the diagonals; the kernels split each one */
+#pragma omp parallel
+#endif
+  {
   int d;
 
   for (d = 0; d < n-1; d++) {
@@ -1177,10 +1199,14 @@ prna_t prna_new(const char *s, param_t par)
     calc_WM(ARGS);
 #ifndef disablecoax
     calc_wl_coax(ARGS);
+#endif
+#ifdef _OPENMP /* w5 and w3 gain one element per diagonal; O(d) work for a single thread */
+#pragma omp single
 #endif
     calc_w5_and_w3(ARGS);
 
   }
+  } /* end parallel fill */
 printf("done with array fill\n");
   /* 
   free(v);    
@@ -1421,6 +1447,7 @@ void prna_write_save_file(const prna_t p, const param_t par)
   }
 
   short numseq[2*p->n+1];//numseq array contains the sequnece in a different format
+  numseq[0] = 0;//unused, but written to the file
   for(i=1;i<=p->n;i++){
     numseq[i] = numseq[i+p->n] = base_as_num(p->seq[i-1]);
   }
@@ -1615,7 +1642,7 @@ int vmin = (int) vmintmp;
   int_t nhexaloop = (int_t) par->nhexaloop;//we have them as ints, they need to be shorts
   int hexaloop[par->nhexaloop+1][2];//has to be an int because the numbers to represent sequence get big
   for(i=0;i<=par->nhexaloop;i++){
-    hexaloop[i][0]=triloop[i][1]=0;
+    hexaloop[i][0]=hexaloop[i][1]=0;
     for(j=0;j<8;j++){//5nt in a triloop
 #ifdef SHORT//if int_t is int, then we use the int_t_pow function instead of int_pow (there's probably a better way to do this)
       if (i!=0) hexaloop[i][0] += (base_as_num(par->hexaloop[i-1].seq[j]) * int_pow(5,j));
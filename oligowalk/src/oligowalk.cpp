@@ -197,6 +197,8 @@ test 3 2 5 8   testing 3 sites 2,5 and 8 without prefilter score -- do not type
 		//open the sequence into ct 
 		ct=new structure;	
 		openseq_frac(ct,seqfilename, start, end);
+		//olig() keeps the pairs of the target in structure 1, so there must be one
+		ct->AddStructure();
 		
 		if (TESTnum==-1)	scoreit=true;
 		else				scoreit=false;
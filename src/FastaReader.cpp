@@ -0,0 +1,67 @@
+/*
+ * An implementation file for a class that reads the records of a FASTA file a batch at a time.
+ *
+ * (c) 2026 Mathews Lab, University of Rochester Medical Center.
+ */
+
+#include "FastaReader.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// Constructor.
+///////////////////////////////////////////////////////////////////////////////
+FastaReader::FastaReader( const string& file ) {
+
+	in.open( file.c_str() );
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Check whether the FASTA file was opened.
+///////////////////////////////////////////////////////////////////////////////
+bool FastaReader::isOpen() {
+
+	return in.is_open();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Read the next records from the FASTA file.
+///////////////////////////////////////////////////////////////////////////////
+int FastaReader::readRecords( int maxRecords, vector<string>& labels, vector<string>& sequences ) {
+
+	labels.clear();
+	sequences.clear();
+
+	// Read lines until the next record would be one too many.
+	// A record header that was read but not used is put back with seekg.
+	string line;
+	streampos start = in.tellg();
+	while( getline( in, line ) ) {
+
+		// Remove a carriage return left by a file with DOS line endings.
+		if( !line.empty() && line[line.size()-1] == '\r' ) { line.erase( line.size()-1 ); }
+
+		if( !line.empty() && line[0] == '>' ) {
+			if( (int) labels.size() == maxRecords ) {
+				in.clear();
+				in.seekg( start );
+				break;
+			}
+
+			// The label is the rest of the header line, without leading spaces.
+			size_t begin = line.find_first_not_of( " \t", 1 );
+			labels.push_back( ( begin == string::npos ) ? "" : line.substr( begin ) );
+			sequences.push_back( "" );
+		}
+
+		// Sequence lines are added to the current record without any whitespace.
+		// Anything before the first header is ignored.
+		else if( !labels.empty() ) {
+			for( size_t i = 0; i < line.size(); i++ ) {
+				if( line[i] != ' ' && line[i] != '\t' ) { sequences.back() += line[i]; }
+			}
+		}
+
+		start = in.tellg();
+	}
+
+	return (int) labels.size();
+}
@@ -0,0 +1,58 @@
+/*
+ * A header file for a class that reads the records of a FASTA file a batch at a time,
+ * so a file with any number of sequences can be handled without holding all of it in memory.
+ *
+ * (c) 2026 Mathews Lab, University of Rochester Medical Center.
+ */
+
+#ifndef FASTA_READER_H
+#define FASTA_READER_H
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+class FastaReader {
+ public:
+	// Public constructor and methods.
+
+	/*
+	 * Name:        Constructor.
+	 * Description: Opens the FASTA file.
+	 * Arguments:
+	 *     1.   The name of the FASTA file.
+	 */
+	FastaReader( const string& file );
+
+	/*
+	 * Name:        isOpen
+	 * Description: Check whether the FASTA file was opened.
+	 * Returns:
+	 *     True if the file is open, false if not.
+	 */
+	bool isOpen();
+
+	/*
+	 * Name:        readRecords
+	 * Description: Read the next records from the FASTA file.
+	 *              Each record is a line starting with ">" and the label, followed by one or more lines of sequence.
+	 *              Whitespace in the sequence is removed, and anything before the first record is ignored.
+	 * Arguments:
+	 *     1.   The maximum number of records to read.
+	 *     2.   The vector that receives the labels.
+	 *     3.   The vector that receives the sequences.
+	 * Returns:
+	 *     The number of records read, which is zero at the end of the file.
+	 */
+	int readRecords( int maxRecords, vector<string>& labels, vector<string>& sequences );
+
+ private:
+	// Private variables.
+
+	// The open FASTA file.
+	ifstream in;
+};
+
+#endif /* FASTA_READER_H */
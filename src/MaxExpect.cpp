@@ -17,6 +17,11 @@
 
 #include <cstring>
 #include <iostream>
+
+#ifdef SMP
+	#include <omp.h>
+#endif
+
 using namespace std;
 
 #define maxsort 90000 //Starting point for the maximum number of basepairs within %cntrl8
@@ -33,11 +38,53 @@ using namespace std;
 const double DOUBLE_DELTA = 1e-13; //the amount the doubles can differ - an estimate of precision for this calculation
 
 
+//Allocate a square array of doubles, [0..size][0..size], as one block, with every element set to value.
+double **allocateMEAArray(int size, double value) {
+	double **array;
+	double *block;
+	long elements;
+	int i;
+
+	elements = ((long) size+1)*(size+1);
+	block = new double [elements];
+	for (long e=0;e<elements;e++) block[e] = value;
+
+	array = new double *[size+1];
+	for (i=0;i<=size;i++) array[i] = block + (long) i*(size+1);
+
+	return array;
+}
+
+//Allocate the lower triangle of a square array of doubles, [j][i] for 0<=i<=j<=size, as one block,
+//	with every element set to value.
+double **allocateMEATriangle(int size, double value) {
+	double **array;
+	double *block;
+	long elements;
+	int j;
+
+	elements = ((long) size+1)*(size+2)/2;
+	block = new double [elements];
+	for (long e=0;e<elements;e++) block[e] = value;
+
+	array = new double *[size+1];
+	for (j=0;j<=size;j++) array[j] = block + (long) j*(j+1)/2;
+
+	return array;
+}
+
+//Delete an array made by allocateMEAArray or allocateMEATriangle.
+void deleteMEAArray(double **array) {
+	delete[] array[0];
+	delete[] array;
+}
+
+
 /*
  * Method for executing the traceback through v and w to find
  * the optimal structure with the highest bp probability 
  */
-void traceBack(structure *ct, double **vwArray, double **bpProbArray, double gamma, int ip, int jp) {
+void traceBack(structure *ct, double **vwArray, double **bpProbArray, double gamma, int ip, int jp, int *pairs) {
 	int i, j;
 	int branchPt;
 	bool foundTrace = false; // used to determine if the traceback value was found
@@ -72,7 +119,8 @@ void traceBack(structure *ct, double **vwArray, double **bpProbArray, double gam
 		else if (doubleEqual(vwArray[j][i], vwArray[i][j]))
 		{
 			// add to the bp list set to each other
-			ct->SetPair(i,j,ct->GetNumberofStructures());
+			pairs[i] = j;
+			pairs[j] = i;
 
 			
 
@@ -144,7 +192,7 @@ void traceBack(structure *ct, double **vwArray, double **bpProbArray, double gam
  * Method for executing the traceback through v and w to find
  * the optimal structure with the highest bp probability 
  */
-void traceBackExternal(structure *ct, double **vwArray, double **vwPArray, double **bpProbArray, double gamma, int ip, int jp) {
+void traceBackExternal(structure *ct, double **vwArray, double **vwPArray, double **bpProbArray, double gamma, int ip, int jp, int *pairs) {
 	int i, j, k;
 	//int branchPt;
 	bool foundTrace = false; // used to determine if the traceback value was found
@@ -161,8 +209,8 @@ void traceBackExternal(structure *ct, double **vwArray, double **vwPArray, doubl
 	
 
 	if (ip>1&&jp<ct->GetSequenceLength()) expectMxStk->push(ip-1, jp+1);
-	else if (ip>1) traceBack(ct,vwArray,bpProbArray,gamma,1,ip-1);
-	else if (jp<ct->GetSequenceLength()) traceBack(ct,vwArray,bpProbArray,gamma,jp+1,ct->GetSequenceLength());
+	else if (ip>1) traceBack(ct,vwArray,bpProbArray,gamma,1,ip-1,pairs);
+	else if (jp<ct->GetSequenceLength()) traceBack(ct,vwArray,bpProbArray,gamma,jp+1,ct->GetSequenceLength(),pairs);
 	
 
 	// continue processing while the stack has values
@@ -181,7 +229,8 @@ void traceBackExternal(structure *ct, double **vwArray, double **vwPArray, doubl
 		if (doubleEqual(vwPArray[j][i], vwPArray[i][j]))
 		{
 			// add to the bp list set to each other
-			ct->SetPair(i,j,ct->GetNumberofStructures());
+			pairs[i] = j;
+			pairs[j] = i;
 			
 
 			#if defined DEBUG
@@ -190,8 +239,8 @@ void traceBackExternal(structure *ct, double **vwArray, double **vwPArray, doubl
 			#endif
 
 			if (i>1&&j<ct->GetSequenceLength()) expectMxStk->push(i-1, j+1);
-			else if (i>1) traceBack(ct,vwArray,bpProbArray,gamma,1,i-1);
-			else if (j<ct->GetSequenceLength()) traceBack(ct,vwArray,bpProbArray,gamma,j+1,ct->GetSequenceLength());
+			else if (i>1) traceBack(ct,vwArray,bpProbArray,gamma,1,i-1,pairs);
+			else if (j<ct->GetSequenceLength()) traceBack(ct,vwArray,bpProbArray,gamma,j+1,ct->GetSequenceLength(),pairs);
 			
 
 		} // end if vwPArray = bp probability total, then bp was found
@@ -239,7 +288,7 @@ void traceBackExternal(structure *ct, double **vwArray, double **vwPArray, doubl
 				for (k=2;k< i&&!foundTrace; k++) {
 					if (doubleEqual(vwPArray[i][j] ,vwArray[k][i]+vwPArray[k-1][j])) {
 						foundTrace = true;
-						traceBack(ct,vwArray,bpProbArray,gamma,k,i);
+						traceBack(ct,vwArray,bpProbArray,gamma,k,i,pairs);
 						expectMxStk->push(k-1,j);
 
 					}
@@ -253,7 +302,7 @@ void traceBackExternal(structure *ct, double **vwArray, double **vwPArray, doubl
 
 
 						foundTrace=true;
-						traceBack(ct,vwArray,bpProbArray,gamma,j,k);
+						traceBack(ct,vwArray,bpProbArray,gamma,j,k,pairs);
 						expectMxStk->push(i,k+1);
 				
 
@@ -286,7 +335,7 @@ void trace(structure *ct, double **vwArray, double **vwPArray, double **bpProbAr
 	register int number;
 	int sort;
 	int i;
-	int iret,jret,numbp,count,count2,k1,k2,num;
+	int numbp,count,count2,k1,k2,num;
 	int *heapi,*heapj;
 	int cur,c,k,j,cntr;
 	double crit;
@@ -413,6 +462,26 @@ void trace(structure *ct, double **vwArray, double **vwPArray, double **bpProbAr
 
 
 
+	//The traceback for a pair depends only on the arrays, but whether a pair is traced depends on the pairs
+	//	marked by the structures before it.  So the next unmarked pairs on the heap are traced together, in
+	//	parallel in the SMP version, and then used in order.  A pair that the structures before it have marked
+	//	since is skipped, as it would have been if the pairs were traced one at a time, so the structures
+	//	do not depend on the number of threads.
+	int batchsize,batchcount,next,b;
+	int *batch;
+	int **batchpairs;
+
+#ifdef SMP
+	batchsize = 4*omp_get_max_threads();
+#else
+	batchsize = 1;
+#endif
+	batch = new int [batchsize];
+	batchpairs = new int *[batchsize];
+	for (b=0;b<batchsize;b++) batchpairs[b] = new int [number+1];
+	batchcount = 0;
+	next = 0;
+
 	//Use a bool to keep track if the last structure needed to be removed:
 	bool removestructure=false;
 
@@ -422,9 +491,32 @@ void trace(structure *ct, double **vwArray, double **vwPArray, double **bpProbAr
 	   //err=0;
 	   //Select the next valid unmarked basepair
 		if (!mark[heapi[cntr]][heapj[cntr]]) {
-   		
-		   iret = heapi[cntr];
-		   jret = heapj[cntr];
+
+		   //Find the traceback for this pair in the batch, tracing the next batch if it is not there.
+		   //The pairs in the batch that come before this one have been marked since the batch was traced.
+		   while (next<batchcount&&batch[next]>cntr) next++;
+		   if (next==batchcount) {
+				batchcount = 0;
+				for (c=cntr;c>0&&batchcount<batchsize;c--) {
+					if (!mark[heapi[c]][heapj[c]]) batch[batchcount++] = c;
+				}
+
+#ifdef SMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+				for (b=0;b<batchcount;b++) {
+					int *pairs = batchpairs[b];
+					int ib = heapi[batch[b]];
+					int jb = heapj[batch[b]];
+
+					for (int n=0;n<=number;n++) pairs[n] = 0;
+					pairs[ib] = jb;
+					pairs[jb] = ib;
+					traceBack(ct, vwArray, bpProbArray, gamma, ib+1, jb-1, pairs);//internal fragment
+					traceBackExternal(ct, vwArray, vwPArray, bpProbArray, gamma, ib, jb, pairs);//external fragment
+				}
+				next = 0;
+		   }
 		   
 		   if (!removestructure) ct->AddStructure();
 		   
@@ -434,17 +526,13 @@ void trace(structure *ct, double **vwArray, double **vwPArray, double **bpProbAr
 			//zero the BP array, if the previous structure needed to be removed:
 		   if(removestructure) ct->CleanStructure(ct->GetNumberofStructures()); 
 
-		   //perform the traceback
-
-		   
-		   ct->SetPair(iret,jret,ct->GetNumberofStructures());
-		   
-			traceBack(ct, vwArray, bpProbArray, gamma, iret+1, jret-1);//internal fragment
-		   //traceBackExternal(ct, vwArray, vwPArray, bpProbArray, gamma, 2, 72);
-			traceBackExternal(ct, vwArray, vwPArray, bpProbArray, gamma, iret, jret);//external fragment
+		   //copy the traceback
+		   for (k=1;k<=number;k++) {
+				if (k<batchpairs[next][k]) ct->SetPair(k,batchpairs[next][k],ct->GetNumberofStructures());
+		   }
 
        		ct->SetEnergy(ct->GetNumberofStructures(),energy[cntr]);
-				
+
 			//count the number of new base pairs not within window of existing
             		//base pairs
         	numbp = 0;
@@ -497,6 +585,9 @@ void trace(structure *ct, double **vwArray, double **vwPArray, double **bpProbAr
 	}
 
 	de_allocate (mark,number+1);
+	for (b=0;b<batchsize;b++) delete[] batchpairs[b];
+	delete[] batchpairs;
+	delete[] batch;
 	delete[] energy;
 	delete[] heapi;
 	delete[] heapj;
@@ -520,30 +611,21 @@ void MaxExpectFill(structure *ct, pfunctionclass *v, PFPRECISION *w5, pfdatatabl
 	
 
 	//allocate main arrays and initialize the Arrays to defaults
-	bpProbArray = new double *[ct->GetSequenceLength()+1];
+	//bpProbArray[j][i] is only used for i<j, so it is a triangle
+	bpProbArray = allocateMEATriangle(ct->GetSequenceLength(),0);
 	bpSSProbArray = new double [ct->GetSequenceLength()+1];
-	vwArray = new double *[ct->GetSequenceLength()+1];
-	vwPArray = new double *[ct->GetSequenceLength()+1];
+	vwArray = allocateMEAArray(ct->GetSequenceLength(),-0);
+	vwPArray = allocateMEAArray(ct->GetSequenceLength(),-0);
 
-	int i, j, iSmall, jBig, Length;
+	int i;
 	
 	
 	//double sumPij = 0; //holds the sum of probabilities for base pairs based on a specific i over js
 
 
 	for (i=0;i<=ct->GetSequenceLength();i++) {
-		bpProbArray[i] = new double [ct->GetSequenceLength()+1];
-		vwArray[i] = new double [ct->GetSequenceLength()+1];
-		vwPArray[i] = new double [ct->GetSequenceLength()+1];
-
 		//ct->basepr[1][i] = 0;
 		bpSSProbArray[i] = 0;
-
-		for (j=0;j<=ct->GetSequenceLength();j++) {
-			bpProbArray[i][j]=0;
-			vwArray[i][j]=-0;
-			vwPArray[i][j]=-0;
-		}
 	}
 
 	#if defined DEBUG
@@ -565,57 +647,35 @@ void MaxExpectFill(structure *ct, pfunctionclass *v, PFPRECISION *w5, pfdatatabl
 	//    4)  multibranching at 12 BPs (2 hairpins and a stack)
 	// Because of the rules for hairpin, the probabilities 
 	//    can be taken from the bpProbArray directly until j-i > 5
-	
+
+	//Calculate the base pair probabilities to start...
+	//Each probability is calculated once, and the rows are independent, so they are shared among the threads.
+	// JG 20071226 - modified to just check probability rather than canonical
+#ifdef SMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+	for (int j=2;j<=ct->GetSequenceLength();j++) {
+		for (int i=1;i<j;i++) {
+			bpProbArray[j][i] = calculateprobability(i, j, v, w5, ct, pfdata, lfce, mod, pfdata->scaling, fce);
+		}
+	}
+
 	// Calculate the single stranded probabilities for each base
 	// Pi = 1 - (for all j, sum(Pij)
 	// fill in w for the diagonal for the Pi,i
-	for (i=1; i<=ct->GetSequenceLength(); i++)
+#ifdef SMP
+#pragma omp parallel for
+#endif
+	for (int i=1; i<=ct->GetSequenceLength(); i++)
 	{
-
-		
-
 		bpSSProbArray[i] = 1;
 
-		for (j=1; j<=ct->GetSequenceLength(); j++)
-		{
-			if (i!=j)
-			{
-				if (i < j)
-				{
-					iSmall = i;
-					jBig = j;
-				}
-				else
-				{
-					iSmall = j;
-					jBig = i;
-				}
-					
-				//subtract the paired probability
-				bpSSProbArray[i] = bpSSProbArray[i] - calculateprobability(iSmall, jBig, v, w5, ct, pfdata, lfce, mod, pfdata->scaling, fce);
-
-			} //end if
-
-		} // end for each paired base
+		//subtract the paired probabilities
+		for (int j=1; j<i; j++) bpSSProbArray[i] = bpSSProbArray[i] - bpProbArray[i][j];
+		for (int j=i+1; j<=ct->GetSequenceLength(); j++) bpSSProbArray[i] = bpSSProbArray[i] - bpProbArray[j][i];
 
 		vwArray[i][i] = bpSSProbArray[i];
-	} // end loop over each base pair
-
-
-	//Calculate the base pair probabilities to start...
-	for (Length = MIN_HP_LENGTH; Length <=ct->GetSequenceLength(); Length++)
-	{
-
-		//begin populating v and w along the diagonal starting with the
-		//   shortest hairpin length
-		for (i=1, j=i+Length-1; j<=ct->GetSequenceLength(); i++, j++)
-		{
-			// check for canonical pair
-			// JG 20071226 - modified to just check probability rather than canonical
-			bpProbArray[j][i] = calculateprobability(i, j, v, w5, ct, pfdata, lfce, mod, pfdata->scaling, fce);
-
-		}
-	}
+	} // end loop over each base
 
 	
 	MEAFill(ct, bpProbArray, bpSSProbArray, vwArray, vwPArray, w5Array, w3Array, gamma, maxPercent,progress);
@@ -632,19 +692,12 @@ void MaxExpectFill(structure *ct, pfunctionclass *v, PFPRECISION *w5, pfdatatabl
 
 	// Deallocate memory for the MaxExpect calculation
 	//Arrays with functionality in the fill step
-	for (i=0;i<=ct->GetSequenceLength();i++) {
-		delete[] bpProbArray[i];
-	}
-	delete[] bpProbArray;
+	deleteMEAArray(bpProbArray);
 
 	delete[] bpSSProbArray;
 
-	for (i=0; i<=ct->GetSequenceLength(); i++) {
-		delete[] vwArray[i];
-		delete[] vwPArray[i];
-	}
-	delete[] vwArray;
-	delete[] vwPArray;
+	deleteMEAArray(vwArray);
+	deleteMEAArray(vwPArray);
 
 	#if defined DEBUG
 		delete[] w5Array;
@@ -989,7 +1042,7 @@ void MEAFill(structure *ct, double **bpProbArray, double *bpSSProbArray, double
  * Input:  The array cantaining the partition function probabilities
  *         The "structure" array
  */
-void bpMatch(structure *ct, char* pfsfile,
+int bpMatch(structure *ct, char* pfsfile,
 		      double gamma, double maxPercent, int maxStructures, int Window, TProgressDialog *progress) {
 	//int i, j;
 	short vers;
@@ -998,8 +1051,7 @@ void bpMatch(structure *ct, char* pfsfile,
 	// get the number of bases from the save file
 	ifstream sav(pfsfile,ios::binary);
 	read(&sav,&(vers));//read the version of the save file
-		//right now there is no infrastructure to indicate the wrong version is being read. 
-		//This should be changed in the future...
+		//a save file of the wrong version is detected by readpfsave
 	int sequencelength;
 	read(&sav,&(sequencelength));
 	sav.close();
@@ -1025,10 +1077,12 @@ void bpMatch(structure *ct, char* pfsfile,
 	
 
 	// read the pfs file
-	readpfsave(pfsfile,ct,w5,w3,v,w,wmb,wl,wmbl,wcoax,fce,&scaling,mod,lfce,pfdata);
-
-	//Run the fill routine
-	MaxExpectFill(ct, v, w5, pfdata, lfce, mod, fce, maxPercent, maxStructures, Window, gamma, progress);
+	int error = 0;
+	if (readpfsave(pfsfile,ct,w5,w3,v,w,wmb,wl,wmbl,wcoax,fce,&scaling,mod,lfce,pfdata)) {
+		//Run the fill routine
+		MaxExpectFill(ct, v, w5, pfdata, lfce, mod, fce, maxPercent, maxStructures, Window, gamma, progress);
+	}
+	else error = 16;
 
 
 	// Deallocate memory for partition function primitives
@@ -1047,8 +1101,7 @@ void bpMatch(structure *ct, char* pfsfile,
 	delete[] lfce;
 	delete[] mod;
 
-
-	
+	return error;
 
 } //end probrecursion
 
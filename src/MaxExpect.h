@@ -16,7 +16,8 @@ static double DOUBLE_INFINITY = 1e300;
 // core functionality methods
 
 // this function runs MaxExpect using data written to disk
-void bpMatch(structure *ct, char* pfsfile, double gamma, double maxPercent, int maxStructures, int Window, TProgressDialog *progress=NULL);
+// it returns 0 on success, or 16 if the save file cannot be read
+int bpMatch(structure *ct, char* pfsfile, double gamma, double maxPercent, int maxStructures, int Window, TProgressDialog *progress=NULL);
 
 //This function sets up the fill routine and runs the traceback routine
 void MaxExpectFill(structure *ct, pfunctionclass *v, PFPRECISION *w5, pfdatatable *pfdata, bool *lfce, bool *mod, forceclass *fce, double maxPercent, int maxStructures, int Window, double gamma=1.0, TProgressDialog *progress=NULL);
@@ -28,14 +29,25 @@ void MEAFill(structure *ct, double **bpProbArray, double *bpSSProbArray, double
 void bpProbRecursion(double **bpProbArray, double **vwArray, structure *ct, char* pfsfile);
 
 // execute the traceback utilizing the v and w Arrays - internal fragments ( nucs i to j, inclusive)
-void traceBack(structure *ct, double **vwArray, double **bpProbArray, double gamma, int ip, int jp);
+// the pairs found are recorded in pairs, which is indexed like basepr
+void traceBack(structure *ct, double **vwArray, double **bpProbArray, double gamma, int ip, int jp, int *pairs);
 
 // execute the traceback utilizing the v and w Arrays - external fragments ( nucs 1 to i and j to N)
-void traceBackExternal(structure *ct, double **vwArray, double **vwPArray, double **bpProbArray, double gamma, int ip, int jp);
+// the pairs found are recorded in pairs, which is indexed like basepr
+void traceBackExternal(structure *ct, double **vwArray, double **vwPArray, double **bpProbArray, double gamma, int ip, int jp, int *pairs);
 
 //Coordinates traceback of suboptimal structures
 void trace(structure *ct, double **vwArray, double **vwPArray, double **bpProbArray, double gamma, double maxPercent, int maxStructures, int Window);
 
+// allocate vwArray or vwPArray, [0..size][0..size], in one block with every element set to value
+double **allocateMEAArray(int size, double value);
+
+// allocate bpProbArray, [j][i] for i<=j, in one block with every element set to value
+double **allocateMEATriangle(int size, double value);
+
+// delete an array made by allocateMEAArray or allocateMEATriangle
+void deleteMEAArray(double **array);
+
 // compares 2 double values for equality
 bool doubleEqual(double double1, double double2);
 
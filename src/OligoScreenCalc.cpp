@@ -21,6 +21,9 @@ using namespace std;
 #define CNTR8 20 //percent sort
 #define CNTR9 0 //window size
 
+//The number of oligos read and calculated at a time.
+#define OLIGOBLOCK 1024
+
 
 int bimolecular(structure *ct,datatable *data) {
 	//Calculate the bimolecular folding free energy
@@ -64,284 +67,143 @@ int bimolecular(structure *ct,datatable *data) {
 
 }
 
-//Perform the OligoScreen calculation.
-int OligoScreenCalc(const char *infilename, const char *outfilename, datatable *data, rddata *hybriddata) {
-	ifstream in;
-	ofstream out;
-//<<<<<<< OligoScreenCalc.cpp
-//	char temp[500];
-//	int i,j,energy;
-//	structure *ct;
-
-
-//=======
-#ifdef SMP
-	int threads = omp_get_num_procs();
-#else
-	int threads = 1;
-#endif
-	string *oligo;
-	oligo = new string[threads];
-//>>>>>>> 1.7
-	in.open(infilename);
-	out.open(outfilename);
-	
-	out << "Sequence\tDGbimolecular\tDGunimolecular\tDGduplex\tDG2BPat5'\tDG2BPat3'\n";
+//Calculate the five energies reported for one oligo (see OligoScreenCalc()) and put them in energy[0..4].
+void screenoligo(const string &oligo, datatable *data, rddata *hybriddata, int *energy) {
+	int j,ii;
+	structure *ct;
 
+	//convert the oligo to a ct file
+	ii = oligo.length();
+	ct = new structure();
 
-	while (!in.eof()) {
-		for (int i=0;i<threads;i++){
-		getline(in, oligo[i]);
-		}
+	ct->allocate(ii);
 
-//<<<<<<< OligoScreenCalc.cpp
-///		out << temp << "\t";
-		//convert temp to a ct file
-//		i = strlen(temp);
-//		ct = new structure();
+	for (j=0;j<ii;j++) {
+		if (oligo[j]=='A'||oligo[j]=='a') ct->numseq[j+1] = 1;
+		else if (oligo[j]=='C'||oligo[j]=='c') ct->numseq[j+1] = 2;
+		else if (oligo[j]=='G'||oligo[j]=='g') ct->numseq[j+1] = 3;
+		else  ct->numseq[j+1] = 4;
+	}
 
-//		ct->allocate(i);
-		//ct->numofbases=i;
+	//First Calculate the Bimolecular folding DG:
+	energy[0] = bimolecular(ct,data);
 
-//		ct->SetSequenceLabel("");
-		//strcpy(ct->ctlabel[1],"");
-//		for (j=0;j<i;j++) {
+	//Now do the unimolecular folding:
+	dynamic(ct,data,CNTR6,CNTR8,CNTR9);
+	energy[1] = ct->GetEnergy(1);
+	//efn2 (&data,ct);--no efn2 needed with current parameters
 
-//			if (temp[j]=='A'||temp[j]=='a') ct->numseq[j+1] = 1;
-//			else if (temp[j]=='C'||temp[j]=='c') ct->numseq[j+1] = 2;
-//			else if (temp[j]=='G'||temp[j]=='g') ct->numseq[j+1] = 3;
-//			else  ct->numseq[j+1] = 4;
+	//now calculate the duplex free energy:
+	//if (!pObject->isRNA) {//oligo is DNA:
+	if (hybriddata!=NULL) {
+		energy[2] = hybriddata->init;//initiation
+		for (j=1;j<(ct->GetSequenceLength());j++) {
+			energy[2] = energy[2] + hybriddata->stack[complement(j+1,ct)][ct->numseq[j+1]][complement(j,ct)][ct->numseq[j]];
+		}
+	}
 
-//		}
-//=======
-#ifdef SMP
-#pragma omp parallel for ordered schedule(runtime)
-#endif
-		for (int i=0;i<threads;i++){	
-			if (!oligo[i].empty()){
-//>>>>>>> 1.7
-
-				int j,k,l,ii;
-				int energy[5];
-				structure *ct;
-
-				//convert temp to a ct file
-				ii = oligo[i].length();
-				ct = new structure();
-
-				ct->allocate(ii);
-				//ct->numofbases=ii;
-
-				//strcpy(ct->ctlabel[1],"");
-				for (j=0;j<ii;j++) {
-					if (oligo[i][j]=='A'||oligo[i][j]=='a') ct->numseq[j+1] = 1;
-					else if (oligo[i][j]=='C'||oligo[i][j]=='c') ct->numseq[j+1] = 2;
-					else if (oligo[i][j]=='G'||oligo[i][j]=='g') ct->numseq[j+1] = 3;
-					else  ct->numseq[j+1] = 4;
-				}
-
-				//First Calculate the Bimolecular folding DG:
-				energy[0] = bimolecular(ct,data);
-
-
-//<<<<<<< OligoScreenCalc.cpp
-		//gcvt((float (ct->energy[1]))/10,6,temp);
-//		if (conversionfactor==10) sprintf(temp,"%.1f",(float (ct->GetEnergy(1)))/conversionfactor);
-//		else sprintf(temp,"%.2f",(float (ct->GetEnergy(1)))/conversionfactor); //assume conversionfactor==100
-//=======
-//>>>>>>> 1.7
-
-				//Now do the unimolecular folding:
-				dynamic(ct,data,CNTR6,CNTR8,CNTR9);
-				energy[1] = ct->GetEnergy(1);
-				//efn2 (&data,ct);--no efn2 needed with current parameters
-				//sortstructures (ct);
-		
+	else {//oligo is RNA:
+		energy[2] = data->init;//initiation
+		for (j=1;j<(ct->GetSequenceLength());j++) {
+			energy[2] = energy[2] + data->stack[ct->numseq[j]]
+				[complement(j,ct)][ct->numseq[j+1]][complement(j+1,ct)];
+		}
 
-				//now calculate the duplex free energy:
-			
-//<<<<<<< OligoScreenCalc.cpp
-		//if (!pObject->isRNA) {//oligo is DNA:
-//		if (hybriddata!=NULL) {
-//      		energy = hybriddata->init;//initiation
-//			for (j=1;j<(ct->GetSequenceLength());j++) {
-//          		energy = energy + hybriddata->stack[complement(j+1,ct)][ct->numseq[j+1]][complement(j,ct)][ct->numseq[j]];
-//			}
-//=======
-				//if (!pObject->isRNA) {//oligo is DNA:
-				if (hybriddata!=NULL) {
-		      		energy[2] = hybriddata->init;//initiation
-					for (j=1;j<(ct->GetSequenceLength());j++) {
-			  		energy[2] = energy[2] + hybriddata->stack[complement(j+1,ct)][ct->numseq[j+1]][complement(j,ct)][ct->numseq[j]];
-					}
+		//add end correction for RNA-RNA duplexes
+		if (ct->numseq[1]==4||ct->numseq[1]==1) {
+			energy[2] = energy[2] + data->auend;
+		}
+		if (ct->numseq[ct->GetSequenceLength()]==4||ct->numseq[ct->GetSequenceLength()]==1) {
+			energy[2] = energy[2] + data->auend;
+		}
+	}
 
+	//Added 1/11/05
+	//Calculate the free energy cost of opening two base pairs at 5' end of duplex and 3' end of duplex
 
-				}
+	//start at 5' end of sequence submitted
+	energy[3] = 0;
+	for (j=1;j<(ct->GetSequenceLength())&&j<3;j++) {
+		energy[3] = energy[3] - data->stack[ct->numseq[j]][complement(j,ct)][ct->numseq[j+1]][complement(j+1,ct)];
+	}
+	//check for AU/GU ends
+	if (ct->numseq[1]==4||ct->numseq[1]==1) {
+		energy[3] = energy[3] - data->auend;
+	}
+	if (ct->numseq[3]==4||ct->numseq[3]==1) {
+		energy[3] = energy[3] + data->auend;
+	}
 
-				else {//oligo is RNA:
-		      		energy[2] = data->init;//initiation
-		      		for (j=1;j<(ct->GetSequenceLength());j++) {
-			  		energy[2] = energy[2] + data->stack[ct->numseq[j]]
-			    		[complement(j,ct)][ct->numseq[j+1]][complement(j+1,ct)];
-					}
+	//now do 3' end of sequence submitted
+	energy[4] = 0;
+	for (j=ct->GetSequenceLength();j>(0)&&j>ct->GetSequenceLength()-2;j--) {
+		energy[4] = energy[4] - data->stack[complement(j,ct)][ct->numseq[j]][complement(j-1,ct)][ct->numseq[j-1]];
+	}
+	//check for AU/GU ends
+	if (ct->numseq[ct->GetSequenceLength()]==4||ct->numseq[ct->GetSequenceLength()]==1) {
+		energy[4] = energy[4] - data->auend;
+	}
+	if (ct->GetSequenceLength()>2) {
+		if (ct->numseq[ct->GetSequenceLength()-2]==4||ct->numseq[ct->GetSequenceLength()-2]==1) {
+			energy[4] = energy[4] + data->auend;
+		}
+	}
 
+	delete ct;
+}
 
-					//add end correction for RNA-RNA duplexes
-					if (ct->numseq[1]==4||ct->numseq[1]==1) {
-						energy[2] = energy[2] + data->auend;
-					}
-					if (ct->numseq[ct->GetSequenceLength()]==4||ct->numseq[ct->GetSequenceLength()]==1) {
-						energy[2] = energy[2] + data->auend;
-					}
+//Perform the OligoScreen calculation.
+//The oligos are read, calculated, and written a block of OLIGOBLOCK at a time, so the list can be any length.
+//With SMP, the oligos of a block are calculated in parallel and the block is written in order afterwards,
+//	so that no thread waits for the oligos before its own to be written.
+int OligoScreenCalc(const char *infilename, const char *outfilename, datatable *data, rddata *hybriddata) {
+	ifstream in;
+	ofstream out;
+	string *oligo;
+	int (*energy)[5];
+	int i,ii,count;
 
-				}
+	oligo = new string[OLIGOBLOCK];
+	energy = new int[OLIGOBLOCK][5];
 
+	in.open(infilename);
+	out.open(outfilename);
 
+	out << "Sequence\tDGbimolecular\tDGunimolecular\tDGduplex\tDG2BPat5'\tDG2BPat3'\n";
+	if (conversionfactor==10) out.precision(1);
+	else out.precision(2); //assume conversionfactor==100
+	out << fixed;
 
-				//Added 1/11/05
-				//Calculate the free energy cost of opening two base pairs at 5' end of duplex and 3' end of duplex
-		
-				//start at 5' end of sequence submitted
-		
-		      		energy[3] = 0;
-				for (j=1;j<(ct->GetSequenceLength())&&j<3;j++) {
-			  	energy[3] = energy[3] - data->stack[ct->numseq[j]][complement(j,ct)][ct->numseq[j+1]][complement(j+1,ct)];
-				}
-				//check for AU/GU ends
-				if (ct->numseq[1]==4||ct->numseq[1]==1) {
-					energy[3] = energy[3] - data->auend;
-				}
-				if (ct->numseq[3]==4||ct->numseq[3]==1) {
-					energy[3] = energy[3] + data->auend;
-				}
-
-
-				//now do 3' end of sequence submitted
-				energy[4] = 0;
-				for (j=ct->GetSequenceLength();j>(0)&&j>ct->GetSequenceLength()-2;j--) {
-			  	energy[4] = energy[4] - data->stack[complement(j,ct)][ct->numseq[j]][complement(j-1,ct)][ct->numseq[j-1]];
-				}
-				//check for AU/GU ends
-				if (ct->numseq[ct->GetSequenceLength()]==4||ct->numseq[ct->GetSequenceLength()]==1) {
-					energy[4] = energy[4] - data->auend;
-				}
-				if (ct->GetSequenceLength()>2) {
-					if (ct->numseq[ct->GetSequenceLength()-2]==4||ct->numseq[ct->GetSequenceLength()-2]==1) {
-						energy[4] = energy[4] + data->auend;
-					}
-				}
-		
+	while (!in.eof()) {
+		//read the next block of oligos
+		for (count=0;count<OLIGOBLOCK&&!in.eof();count++) {
+			getline(in, oligo[count]);
+		}
 
-				//write to the output file
+		//the time for each oligo depends on its length, so hand them out one at a time
 #ifdef SMP
-#pragma omp ordered
+#pragma omp parallel for schedule(dynamic)
 #endif
-				for (int ii=0;ii<5;ii++){
-					if (conversionfactor==10) out.precision(1);
-					else out.precision(2); //assume conversionfactor==100
-					out << fixed;
-					if (ii == 0) out << oligo[i] << "\t";
-			 		out << (float (energy[ii]))/conversionfactor;
-					if (ii != 4) out << "\t";
-					else out << "\n";
-				}
-//>>>>>>> 1.7
-
-				delete ct;
-
-
-//<<<<<<< OligoScreenCalc.cpp
-//		else {//oligo is RNA:
-//      		energy = data->init;//initiation
-//      		for (j=1;j<(ct->GetSequenceLength());j++) {
-//          		energy = energy + data->stack[ct->numseq[j]]
- //           		[complement(j,ct)][ct->numseq[j+1]][complement(j+1,ct)];
-//=======
-//>>>>>>> 1.7
-			}
-//<<<<<<< OligoScreenCalc.cpp
-
-
-			//add end correction for RNA-RNA duplexes
-//			if (ct->numseq[1]==4||ct->numseq[1]==1) {
-//				energy = energy + data->auend;
-//			}
-//			if (ct->numseq[ct->GetSequenceLength()]==4||ct->numseq[ct->GetSequenceLength()]==1) {
-//				energy = energy + data->auend;
-//			}
-
-//=======
-//>>>>>>> 1.7
+		for (i=0;i<count;i++) {
+			if (!oligo[i].empty()) screenoligo(oligo[i],data,hybriddata,energy[i]);
 		}
-//<<<<<<< OligoScreenCalc.cpp
-
-		//gcvt((float (energy))/10,6,temp);
-//		if (conversionfactor==10) sprintf(temp,"%.1f",(float (energy))/conversionfactor);
-//		else sprintf(temp,"%.2f",(float (energy))/conversionfactor); //assume conversionfactor==100
-
-
-//		out << temp<<"\t";
 
-		//Added 1/11/05
-		//Calculate the free energy cost of opening two base pairs at 5' end of duplex and 3' end of duplex
-		
-		//start at 5' end of sequence submitted
-		
-//      	energy = 0;
-//		for (j=1;j<(ct->GetSequenceLength())&&j<3;j++) {
- //         	energy = energy - data->stack[ct->numseq[j]][complement(j,ct)][ct->numseq[j+1]][complement(j+1,ct)];
-//		}
-		//check for AU/GU ends
-//		if (ct->numseq[1]==4||ct->numseq[1]==1) {
-//			energy = energy - data->auend;
-//		}
-//		if (ct->numseq[3]==4||ct->numseq[3]==1) {
-//			energy = energy + data->auend;
-//		}
-		
-		//gcvt((float (energy))/10,6,temp);
-//		if (conversionfactor==10) sprintf(temp,"%.1f",(float (energy))/conversionfactor);
-///		else sprintf(temp,"%.2f",(float (energy))/conversionfactor); //assume conversionfactor==100
-
-
-//		out << temp<<"\t";
-
-		//now do 3' end of sequence submitted
-		
-//      	energy = 0;
-//		for (j=ct->GetSequenceLength();j>(0)&&j>ct->GetSequenceLength()-2;j--) {
-//          	energy = energy - data->stack[complement(j,ct)][ct->numseq[j]][complement(j-1,ct)][ct->numseq[j-1]];
-//		}
-		//check for AU/GU ends
-//		if (ct->numseq[ct->GetSequenceLength()]==4||ct->numseq[ct->GetSequenceLength()]==1) {
-//			energy = energy - data->auend;
-//		}
-//		if (ct->GetSequenceLength()>2) {
-//			if (ct->numseq[ct->GetSequenceLength()-2]==4||ct->numseq[ct->GetSequenceLength()-2]==1) {
-//				energy = energy + data->auend;
-//			}
-//		}
-		
-		//gcvt((float (energy))/10,6,temp);
-//		if (conversionfactor==10) sprintf(temp,"%.1f",(float (energy))/conversionfactor);
-//		else sprintf(temp,"%.2f",(float (energy))/conversionfactor); //assume conversionfactor==100
-
-
-//		out << temp<<"\n";
-
-
-//		delete ct;
-
-//		in >> temp;
-
-		
-//=======
-//>>>>>>> 1.7
+		//write to the output file
+		for (i=0;i<count;i++) {
+			if (oligo[i].empty()) continue;
+			out << oligo[i] << "\t";
+			for (ii=0;ii<5;ii++) {
+				out << (float (energy[i][ii]))/conversionfactor;
+				if (ii != 4) out << "\t";
+				else out << "\n";
+			}
+		}
 	}
 
 	in.close();
 	out.close();
 	delete[] oligo;
+	delete[] energy;
 
 	return 0;//no errors
 }
@@ -14,6 +14,7 @@
 
 #include "structure.h"
 #include "algorithm.h"
+#include "bifurcation.h"
 #ifdef _WINDOWS_GUI
 #include "../RNAstructure_windows_interface/platform.h"
 #else 
@@ -2855,8 +2856,13 @@ void force(structure *ct,forceclass *fce, bool *lfce){
 	}
 
 	for (i=0;i<ct->GetNumberofForbiddenPairs();i++) {
-		if(ct->GetForbiddenPair5(i)<=ct->GetSequenceLength()&ct->GetForbiddenPair3(i)<=ct->GetSequenceLength()) fce->f(ct->GetForbiddenPair5(i),ct->GetForbiddenPair3(i)) = fce->f(ct->GetForbiddenPair5(i),ct->GetForbiddenPair3(i))|NOPAIR;
-		if(ct->GetForbiddenPair5(i)<=ct->GetSequenceLength()&&ct->GetForbiddenPair3(i)<=ct->GetSequenceLength()) fce->f(ct->GetForbiddenPair3(i),ct->GetForbiddenPair5(i)+ct->GetSequenceLength())=fce->f(ct->GetForbiddenPair3(i),ct->GetForbiddenPair5(i)+ct->GetSequenceLength())|NOPAIR;
+		//A forbidden pair can be given in either order, but the second copy of the sequence must be indexed from the 5' nucleotide
+		int five = min(ct->GetForbiddenPair5(i),ct->GetForbiddenPair3(i));
+		int three = max(ct->GetForbiddenPair5(i),ct->GetForbiddenPair3(i));
+		if(three<=ct->GetSequenceLength()) {
+			fce->f(five,three) = fce->f(five,three)|NOPAIR;
+			fce->f(three,five+ct->GetSequenceLength())=fce->f(three,five+ct->GetSequenceLength())|NOPAIR;
+		}
 	}
 
 	//Double up the sequence
@@ -3355,103 +3361,25 @@ void force(structure *ct,forceclass *fce, bool *lfce){
 #else
 #endif
 
-	//The fill routine is encapsulated in function fill.
-	//This was separated from dynamic on 3/12/06 by DHM.  This provides greater flexibility
-	//for use of the arrays for other tasks than secondary structure prediction, e.g. dot plots.
-#if defined DYNALIGN_II
-void fill(structure *ct, arrayclass &v, arrayclass &w, arrayclass &wmb, forceclass &fce, int &vmin,bool *lfce, bool *mod,
-          integersize *w5, integersize *w3, bool quickenergy,
-          datatable *data, arrayclass *w2, arrayclass *wmb2, arrayclass *we,TProgressDialog* update, int maxinter, bool quickstructure)
-
-#elif !defined INSTRUMENTED//If pre-compiler flag INSTRUMENTED is not defined, compile the following code
-	void fill(structure *ct, arrayclass &v, arrayclass &w, arrayclass &wmb, forceclass &fce, int &vmin,bool *lfce, bool *mod,
-			integersize *w5, integersize *w3, bool quickenergy,
-			datatable *data, arrayclass *w2, arrayclass *wmb2, TProgressDialog* update, int maxinter,bool quickstructure)
-
-#else //IF DEFINED INSTRUMENTED
-		void fill(structure *ct, arrayclass &v, arrayclass &vmb, arrayclass &vext, arrayclass &w, arrayclass &wmb, forceclass &fce, int &vmin,bool *lfce, bool *mod,
-				integersize *w5, integersize *w3, bool quickenergy,
-				datatable *data, arrayclass *w2, arrayclass *wmb2, TProgressDialog* update, int maxinter,bool quickstructure)
-
-#endif //end !INTRUMENTED
-		{
-			//This is the fill routine:
-			register int number, h, maximum;
-			int d, maxj;
-			integersize **wca,**curE,**prevE,**tempE;
-
-
-			number = ct->GetSequenceLength();
-
-			if (!ct->intermolecular) {
-				//This code is needed for O(N^3) prediction of internal loops
-				wca = new integersize *[number+1];
-				curE= new integersize *[number+1];
-				prevE= new integersize *[number+1];
-
-				for (int locali=0;locali<=number;locali++) {
-					wca[locali] = new integersize [number+1];
-					curE[locali]= new integersize [number+1];
-					prevE[locali]= new integersize [number+1];
-					for (int localj=0;localj<=number;localj++){
-						wca[locali][localj] = INFINITE_ENERGY;
-						curE[locali][localj]=INFINITE_ENERGY;
-						prevE[locali][localj]=INFINITE_ENERGY;
-					}
-				}
-			}
-			else {//intermolecular folding
-				//initialize wca only
-				wca = new integersize *[number+1];
-				for (int locali=0;locali<=number;locali++) {
-					wca[locali] = new integersize [number+1];
-
-					for (int localj=0;localj<=number;localj++)	{
-						wca[locali][localj] = INFINITE_ENERGY;
-					}
-				}
-			}
-
-			if (quickenergy||quickstructure) maximum = number;
-			else maximum = (2*(number)-1);
-
-
-			vmin=INFINITE_ENERGY;
-			//h or (h-number+1) is the distance between i and j
-			for (h=0;h<=maximum-1;h++){
-
-				//d = j-i;
-				d=(h<=(number-1))?h:(h-number+1);
-				if (((h%10)==0)&&update) update->update((100*h)/(maximum+1));
-				if (h==number&&!ct->intermolecular) {
-					for(int locali=0;locali<=number;locali++) {
-						for(int localj=0;localj<=number;localj++) {
-							curE[locali][localj]=INFINITE_ENERGY;
-							prevE[locali][localj]=INFINITE_ENERGY;
-						}
-					}
-				}
-				
-
-				//These variables for start and end (as opposed the fancy syntax that was here before) are needed because of openmp.
-				int startme,endme;//start and end for loop over i
-				if (h<=(number-1)) {
-					startme=1;
-					endme=number-h;
-				}
-				else {
-					startme=2*number-h;
-					endme=number;
-
-				}
-#ifdef SMP
-#pragma omp parallel for
+	//Calculate v, w and wmb (and w2 and wmb2 for intermolecular folding) for the fragment i to j.
+	//For fragment 1 to j this also calculates w5[j], and for fragment i to N, w3[i].  vmin is lowered
+	//	by the exterior fragments.
+	//All shorter fragments inside i to j must already be filled.
+	//wcolumn is the copy of w by column for the bifurcation search, and this updates wcolumn[j][i].
+	//curE and prevE are the O(N^3) internal loop arrays of the serial code (NULL with SMP).
+	static void fillcell(int i, int j, structure *ct, arrayclass &v,
+#ifdef INSTRUMENTED
+			arrayclass &vmb, arrayclass &vext,
 #endif
-				
-				
+			arrayclass &w, arrayclass &wmb, forceclass &fce, int &vmin, bool *lfce, bool *mod,
+			integersize *w5, integersize *w3, datatable *data, arrayclass *w2, arrayclass *wmb2,
+#ifdef DYNALIGN_II
+			arrayclass *we,
+#endif
+			int maxinter, integersize **wca, integersize **wcolumn, integersize **curE, integersize **prevE) {
 
-				for (int i=startme;i<=endme;i++){
-					int j=i+d;
+	int number = ct->GetSequenceLength();
+	int d = j-i;
 					register int rarray;
 					int dp,ll,jpf,jf,bl,maxasym;
 					int before,after;
@@ -3463,9 +3391,6 @@ void fill(structure *ct, arrayclass &v, arrayclass &w, arrayclass &wmb, forcecla
 #ifndef disablecoax
 					register int castack; //variable for coaxial stacking, not needed if coaxial stacking is disabled
 #endif
-					int maxi=((h<=(number-1))?(number-h):number);
-					if (i==maxi)
-						maxj=j;
 
 
 					maxasym = maxinter;
@@ -4128,6 +4053,7 @@ sub1:
 					v.f(i,j) = min(rarray,v.f(i,j));//QUESTION: THIS IS DIFFERENT FROM THE MAIN algorithm.cpp (see #ifndef above)
 #endif//END INSTRUMENTED
 sub2:
+#ifndef SMP//The O(N^3) internal loop arrays are only used by the serial fill
 
 					/*prefill curE[i] and prev[i] for the first two diagonals as ll =4 and 5	
 					  As d =10, only fill curE (ll=4, d=10)
@@ -4214,6 +4140,7 @@ d = j - i;
 
 					//also block propagation of interior loops that contain nucleotides that need to be double-stranded:
 					if ((lfce[i]||lfce[j])&&!ct->intermolecular) for (dp=1;dp<=d;dp++) curE[dp][i] = INFINITE_ENERGY;//QUESTION: THIS WASN'T IN THE algirithm.napss.cpp
+#endif //ifndef SMP
 
 
 					//Compute w[i][j]: best energy between i and j where i,j does not have
@@ -4412,12 +4339,12 @@ d = j - i;
 						//search for an open bifurcation:
 						
 						//in this code, the w arrays are accessed directly, and not through the f function
+						//w.dg[i][k] for k from i to j-1 is row i, and w.f(k+1,j) is column j, or column
+						//	j-number for k>=number
 						int end=min(number,j);
-						for (k=i;k<end;++k) {
-							wmb.f(i,j) = min(wmb.f(i,j),w.dg[i][k]+w.dg[k+1][j]);
-						}		
-						for (k=number;k<j;++k) {
-							wmb.f(i,j) = min(wmb.f(i,j),w.dg[i][k]+w.dg[k+1-number][j-number]);
+						wmb.f(i,j) = minbifurcation(w.dg[i]+i,wcolumn[j]+i+1,end-i,wmb.f(i,j));
+						if (j>number) {
+							wmb.f(i,j) = minbifurcation(w.dg[i]+number,wcolumn[j-number]+1,j-number,wmb.f(i,j));
 						}
 
 
@@ -4972,10 +4899,250 @@ sub3:
 #else
 #endif
 			
+					wcolumn[j][i] = w.f(i,j);
+
+}
+
+#ifdef SMP
+#define FILLTILE 16 //edge length, in nucleotides, of the square tiles of fragments filled by one task
+
+	//Fill diagonals hfirst through hlast, which are either all interior fragments (h<=number-1) or all
+	//	exterior fragments, as a wavefront over square tiles of fragments.
+	//A tile is one OpenMP task that starts once the tile to its left (smaller j) and the tile below it
+	//	(larger i) are finished; inside a tile the fragments are filled from shortest to longest.
+	//	This replaces the barrier after each diagonal with a dependence between neighbouring tiles,
+	//	and lets the task scheduler balance tiles whose internal loop searches differ in cost.
+	//w5[j] and w3[i] are filled by the cells 1 to j and i to N, whose tiles follow those of the
+	//	shorter w5 and w3 entries.
+	static void tiledfill(int hfirst, int hlast, structure *ct, arrayclass &v,
+#ifdef INSTRUMENTED
+			arrayclass &vmb, arrayclass &vext,
+#endif
+			arrayclass &w, arrayclass &wmb, forceclass &fce, int &vmin, bool *lfce, bool *mod,
+			integersize *w5, integersize *w3, datatable *data, arrayclass *w2, arrayclass *wmb2,
+#ifdef DYNALIGN_II
+			arrayclass *we,
+#endif
+			int maxinter, integersize **wca, integersize **wcolumn) {
+
+	int number = ct->GetSequenceLength();
+	bool exterior = hfirst>(number-1);
+
+	//Exterior fragments i to j (j>number) are tiled by i and j-number, where j-number<i.
+	int offset = exterior?number:0;
+	int dfirst = exterior?(hfirst-number+1):hfirst;
+	int dlast = exterior?(hlast-number+1):hlast;
+	int tiles = (number+FILLTILE-1)/FILLTILE;
+
+	//One dependence token per tile, plus a last one that stands in for tiles outside the triangle.
+	char *token = new char [tiles*tiles+1];
+	int none = tiles*tiles;
+
+	#pragma omp parallel
+	#pragma omp single
+	{
+		//Create the tasks in order of tile diagonal, so that a tile's neighbours are created before it.
+		for (int tiled=(exterior?1-tiles:0);tiled<=(exterior?0:tiles-1);tiled++) {
+			for (int ti=0;ti<tiles;ti++) {
+				int tj = ti+tiled;
+				if (tj<0||tj>=tiles) continue;
+
+				int left,below;
+				if (exterior) {
+					left = (tj>0)?(ti*tiles+tj-1):none;
+					below = (ti<tiles-1)?((ti+1)*tiles+tj):none;
+				}
+				else {
+					left = (tj>ti)?(ti*tiles+tj-1):none;
+					below = (ti<tj)?((ti+1)*tiles+tj):none;
+				}
 
+				#pragma omp task firstprivate(ti,tj) depend(in:token[left],token[below]) depend(out:token[ti*tiles+tj])
+				{
+					int ilow = ti*FILLTILE+1;
+					int ihigh = min(ti*FILLTILE+FILLTILE,number);
+					int jlow = tj*FILLTILE+1+offset;
+					int jhigh = min(tj*FILLTILE+FILLTILE,exterior?(number-1):number)+offset;
+					int tilevmin = INFINITE_ENERGY;//vmin is shared, so each tile keeps its own minimum
+
+					for (int d=max(dfirst,jlow-ihigh);d<=min(dlast,jhigh-ilow);d++) {
+						for (int locali=max(ilow,jlow-d);locali<=min(ihigh,jhigh-d);locali++) {
+							fillcell(locali,locali+d,ct,v,
+#ifdef INSTRUMENTED
+								vmb,vext,
+#endif
+								w,wmb,fce,tilevmin,lfce,mod,w5,w3,data,w2,wmb2,
+#ifdef DYNALIGN_II
+								we,
+#endif
+								maxinter,wca,wcolumn,NULL,NULL);
+						}
+					}
 
+					if (tilevmin<INFINITE_ENERGY) {
+						#pragma omp critical (tiledfill)
+						vmin = min(vmin,tilevmin);
+					}
 				}
-#ifndef SMP
+			}
+		}
+	}
+
+	delete[] token;
+}
+#endif //SMP
+
+	//The fill routine is encapsulated in function fill.
+	//This was separated from dynamic on 3/12/06 by DHM.  This provides greater flexibility
+	//for use of the arrays for other tasks than secondary structure prediction, e.g. dot plots.
+#if defined DYNALIGN_II
+void fill(structure *ct, arrayclass &v, arrayclass &w, arrayclass &wmb, forceclass &fce, int &vmin,bool *lfce, bool *mod,
+          integersize *w5, integersize *w3, bool quickenergy,
+          datatable *data, arrayclass *w2, arrayclass *wmb2, arrayclass *we,TProgressDialog* update, int maxinter, bool quickstructure)
+
+#elif !defined INSTRUMENTED//If pre-compiler flag INSTRUMENTED is not defined, compile the following code
+	void fill(structure *ct, arrayclass &v, arrayclass &w, arrayclass &wmb, forceclass &fce, int &vmin,bool *lfce, bool *mod,
+			integersize *w5, integersize *w3, bool quickenergy,
+			datatable *data, arrayclass *w2, arrayclass *wmb2, TProgressDialog* update, int maxinter,bool quickstructure)
+
+#else //IF DEFINED INSTRUMENTED
+		void fill(structure *ct, arrayclass &v, arrayclass &vmb, arrayclass &vext, arrayclass &w, arrayclass &wmb, forceclass &fce, int &vmin,bool *lfce, bool *mod,
+				integersize *w5, integersize *w3, bool quickenergy,
+				datatable *data, arrayclass *w2, arrayclass *wmb2, TProgressDialog* update, int maxinter,bool quickstructure)
+
+#endif //end !INTRUMENTED
+		{
+			//This is the fill routine:
+			register int number, h, maximum;
+			int d, maxj;
+			integersize **wca,**curE,**prevE,**tempE;
+			integersize **wcolumn;
+			bool internalloops;//true if curE and prevE are allocated
+
+
+			number = ct->GetSequenceLength();
+
+#ifdef SMP
+			//The SMP fill uses the O(N^4) internal loop search, so curE and prevE are not needed.
+			internalloops = false;
+#else
+			internalloops = !ct->intermolecular;
+#endif
+
+			if (internalloops) {
+				//This code is needed for O(N^3) prediction of internal loops
+				wca = new integersize *[number+1];
+				curE= new integersize *[number+1];
+				prevE= new integersize *[number+1];
+
+				for (int locali=0;locali<=number;locali++) {
+					wca[locali] = new integersize [number+1];
+					curE[locali]= new integersize [number+1];
+					prevE[locali]= new integersize [number+1];
+					for (int localj=0;localj<=number;localj++){
+						wca[locali][localj] = INFINITE_ENERGY;
+						curE[locali][localj]=INFINITE_ENERGY;
+						prevE[locali][localj]=INFINITE_ENERGY;
+					}
+				}
+			}
+			else {//intermolecular folding or SMP
+				//initialize wca only
+				curE = NULL;
+				prevE = NULL;
+				wca = new integersize *[number+1];
+				for (int locali=0;locali<=number;locali++) {
+					wca[locali] = new integersize [number+1];
+
+					for (int localj=0;localj<=number;localj++)	{
+						wca[locali][localj] = INFINITE_ENERGY;
+					}
+				}
+			}
+
+			//wcolumn[j][i] is a copy of w.f(i,j), stored by column so that the bifurcation search is unit-stride.
+			//Column j holds i from max(0,j-number) to min(j,number).
+			wcolumn = new integersize *[2*number+1];
+			for (int localj=0;localj<=2*number;localj++) {
+				int lowi = max(0,localj-number);
+				int highi = min(localj,number);
+				wcolumn[localj] = new integersize [highi-lowi+1];
+				wcolumn[localj] -= lowi;
+				for (int locali=lowi;locali<=highi;locali++) {
+					wcolumn[localj][locali] = INFINITE_ENERGY;
+				}
+			}
+
+			if (quickenergy||quickstructure) maximum = number;
+			else maximum = (2*(number)-1);
+
+
+			vmin=INFINITE_ENERGY;
+#ifdef SMP
+			//Fill the interior fragments (j<=N), and then the exterior fragments, each as one tiled wavefront.
+			if (update) update->update(0);
+			tiledfill(0,number-1,ct,v,
+#ifdef INSTRUMENTED
+				vmb,vext,
+#endif
+				w,wmb,fce,vmin,lfce,mod,w5,w3,data,w2,wmb2,
+#ifdef DYNALIGN_II
+				we,
+#endif
+				maxinter,wca,wcolumn);
+			if (maximum>number) {
+				if (update) update->update((100*number)/(maximum+1));
+				tiledfill(number,maximum-1,ct,v,
+#ifdef INSTRUMENTED
+					vmb,vext,
+#endif
+					w,wmb,fce,vmin,lfce,mod,w5,w3,data,w2,wmb2,
+#ifdef DYNALIGN_II
+					we,
+#endif
+					maxinter,wca,wcolumn);
+			}
+#else //!SMP
+			//h or (h-number+1) is the distance between i and j
+			for (h=0;h<=maximum-1;h++){
+
+				//d = j-i;
+				d=(h<=(number-1))?h:(h-number+1);
+				if (((h%10)==0)&&update) update->update((100*h)/(maximum+1));
+				if (h==number&&!ct->intermolecular) {
+					for(int locali=0;locali<=number;locali++) {
+						for(int localj=0;localj<=number;localj++) {
+							curE[locali][localj]=INFINITE_ENERGY;
+							prevE[locali][localj]=INFINITE_ENERGY;
+						}
+					}
+				}
+				
+
+				int startme,endme;//start and end for loop over i
+				if (h<=(number-1)) {
+					startme=1;
+					endme=number-h;
+				}
+				else {
+					startme=2*number-h;
+					endme=number;
+
+				}
+
+				for (int i=startme;i<=endme;i++){
+					fillcell(i,i+d,ct,v,
+#ifdef INSTRUMENTED
+						vmb,vext,
+#endif
+						w,wmb,fce,vmin,lfce,mod,w5,w3,data,w2,wmb2,
+#ifdef DYNALIGN_II
+						we,
+#endif
+						maxinter,wca,wcolumn,curE,prevE);
+				}
+				maxj = endme+d;
+
 				if (!ct->intermolecular) {
 					if (d>(maxj>number?8:11))
 					{
@@ -4992,8 +5159,8 @@ sub3:
 							}
 						}
 				}
-#endif //ifndef SMP
 			}
+#endif //SMP
 
 
 
@@ -5025,7 +5192,14 @@ sub3:
 				delete[] wca[locali];
 			delete[] wca;
 
-			if (!ct->intermolecular) {
+			for (int localj=0;localj<=2*number;localj++) {
+				//move the pointer back before deleting
+				wcolumn[localj] += max(0,localj-number);
+				delete[] wcolumn[localj];
+			}
+			delete[] wcolumn;
+
+			if (internalloops) {
 				for (int locali=0;locali<=number;locali++) {
 					delete[] curE[locali];
 					delete[] prevE[locali];
@@ -15,21 +15,17 @@ arrayclass::arrayclass(int size, integersize energy) {
 	infinite = INFINITE_ENERGY;
 
   Size = size;
-  register int i,j;
-  dg = new integersize *[size+1];
-    
-	for (i=0;i<=(size);i++)  {
-    dg[i] = new integersize [size+1];
-  }
-  for (i=0;i<=size;i++) {
-    for (j=0;j<size+1;j++) {
-      dg[i][j] = INFINITE_ENERGY;
-    }
+  register int i;
+  long entries = (long) (size+1)*(size+1);
+  storage = new integersize [entries];
+  for (long l=0;l<entries;l++) {
+    storage[l] = INFINITE_ENERGY;
   }
 
-  //Now move pointers, to facilitate fast access:
+  //Point each row at its block of storage, moved back by i to facilitate fast access:
+  dg = new integersize *[size+1];
   for (i=0;i<=size;++i) {
-	  dg[i]-=i;
+	  dg[i] = storage + (long) i*size;
   }
 
 }
@@ -37,14 +33,6 @@ arrayclass::arrayclass(int size, integersize energy) {
 // the destructor deallocates the space used
 arrayclass::~arrayclass() {
 	
-	int i;
-       	
-    for (i=0;i<=Size;i++) {
-		//move pointers back before deleting
-		dg[i]+=i;
-
-		//now delete
-        delete[] dg[i];
-    }
+     delete[] storage;
      delete[] dg;
 }
@@ -12,8 +12,13 @@ class arrayclass {
 private:
   int Size;
 
+  // all of the array is a single allocation; row i holds the Size+1
+  // fragments i to i..i+Size, so fragment i,j is at storage[i*Size+j]
+  integersize *storage;
+
 public:
   int k;
+  // dg[i] points into storage so that dg[i][j] is fragment i,j
   integersize **dg;
   integersize infinite;
 
@@ -29,16 +34,18 @@ public:
 };
 
 inline integersize &arrayclass::f(int i, int j) {
-   if (i > Size) {
-     i -= Size;
-     j -= Size;
-   }
-
    if (i > j) {
         return infinite;
    }
-   
-   return dg[i][j];
+
+   // fragments with i > Size are stored as i-Size to j-Size
+   // the two tests are kept as branches: the recursions almost always
+   // predict them, and selecting with masks instead measured slower
+   int shift = (i > Size) ? Size : 0;
+   i -= shift;
+   j -= shift;
+
+   return storage[(long) i*Size + j];
 }
 
 #endif
@@ -0,0 +1,340 @@
+#if !defined(BIFURCATION_H)
+#define BIFURCATION_H
+
+//Kernels for the search over the bifurcation point k in the multibranch and exterior loop
+//	recursions: the minimum (fill) or sum (calculatepfunction) over k of a term from row i
+//	and a term from column j of the arrays.
+//The fill routines keep a copy of the arrays they scan by column, so that both operands
+//	of a kernel are unit-stride.
+//With GCC or Clang on x86, an AVX2 (or, for the minimum, AVX-512) version is chosen at run
+//	time from the features of the processor.  Everywhere else the scalar version is used.
+//With LOG_DOUBLE, the sum has its own scalar and AVX2 versions in log space.
+
+#include "defines.h"
+
+#ifdef EXTENDED_DOUBLE
+	#include "extended_double.h"
+#endif//defined EXTENDED_DOUBLE
+#ifdef LOG_DOUBLE
+	#include "log_double.h"
+#endif//defined LOG_DOUBLE
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+	#define BIFURCATION_X86
+	#include <immintrin.h>
+#endif
+
+
+//Return the lesser of current and the least left[t]+right[t], for t from 0 to n-1.
+//The sums are formed as int, so two large energies cannot overflow integersize.
+inline int minbifurcationscalar(const integersize *left, const integersize *right, int n, int current) {
+	for (int t=0;t<n;++t) {
+		int e = left[t]+right[t];
+		if (e<current) current = e;
+	}
+	return current;
+}
+
+
+//Return sum plus the sum over t from 0 to n-1 of (a[t]-b[t]*s1*s2+c[t])*(d[t]+e[t]),
+//	or of (a[t]+c[t])*(d[t]+e[t]) if b is NULL.
+//The terms are added to sum one at a time in order of t, as the loop over k they replace did, so the
+//	result is the same as that loop's.  The AVX2 version forms four terms at a time but adds them in the same order.
+inline PFPRECISION sumbifurcationscalar(PFPRECISION sum, const PFPRECISION *a, const PFPRECISION *b, const PFPRECISION *c,
+	const PFPRECISION *d, const PFPRECISION *e, PFPRECISION s1, PFPRECISION s2, int n) {
+
+	for (int t=0;t<n;++t) {
+		if (b!=NULL) sum+=(a[t]-b[t]*s1*s2+c[t])*(d[t]+e[t]);
+		else sum+=(a[t]+c[t])*(d[t]+e[t]);
+	}
+	return sum;
+}
+
+
+#ifdef LOG_DOUBLE
+//exp(x), for the log-space sum below.  x is reduced to r = x - n*ln(2), with |r| <= ln(2)/2, and exp(r) is
+//	a degree 13 polynomial, which is within about an ulp.  n is rounded with BIFURCATION_ROUND rather than floor(),
+//	which is a library call on x86 without SSE4.1.  Below -708, including for -HUGE_VAL, the result is 0.
+//The AVX2 version does the same arithmetic in the same order, so the result does not depend on the processor.
+#define BIFURCATION_LOG2E 1.44269504088896338700e+00
+#define BIFURCATION_LN2HI 6.93147180369123816490e-01 //the high bits of ln(2), so that n*BIFURCATION_LN2HI is exact
+#define BIFURCATION_LN2LO 1.90821492927058770002e-10
+#define BIFURCATION_EXPMIN -708.0
+#define BIFURCATION_ROUND 6755399441055744.0 //1.5*2^52: adding and then subtracting it rounds to the nearest integer
+static const double bifurcationexpterms[14] = {1.0/6227020800.0,1.0/479001600.0,1.0/39916800.0,1.0/3628800.0,
+	1.0/362880.0,1.0/40320.0,1.0/5040.0,1.0/720.0,1.0/120.0,1.0/24.0,1.0/6.0,1.0/2.0,1.0,1.0};
+
+inline double bifurcationexp(double x) {
+	if (!(x>=BIFURCATION_EXPMIN)) return 0;
+
+	double n = (x*BIFURCATION_LOG2E+BIFURCATION_ROUND)-BIFURCATION_ROUND;
+	double r = (x-n*BIFURCATION_LN2HI)-n*BIFURCATION_LN2LO;
+	double p = bifurcationexpterms[0];
+	p = p*r+bifurcationexpterms[1];
+	p = p*r+bifurcationexpterms[2];
+	p = p*r+bifurcationexpterms[3];
+	p = p*r+bifurcationexpterms[4];
+	p = p*r+bifurcationexpterms[5];
+	p = p*r+bifurcationexpterms[6];
+	p = p*r+bifurcationexpterms[7];
+	p = p*r+bifurcationexpterms[8];
+	p = p*r+bifurcationexpterms[9];
+	p = p*r+bifurcationexpterms[10];
+	p = p*r+bifurcationexpterms[11];
+	p = p*r+bifurcationexpterms[12];
+	p = p*r+bifurcationexpterms[13];
+
+	//2^n, built from its exponent bits
+	union {unsigned long long bits; double value;} scale;
+	scale.bits = ((unsigned long long) ((long long) n+1023))<<52;
+	return p*scale.value;
+}
+
+//One term of the log-space sum, (a-b*s+c)*(d+e) with s=s1*s2 and every value given by its log, relative to
+//	exp(largest).  The sum a-b*s+c is formed relative to the larger of a and c, and d+e relative to the larger
+//	of d and e, so that a term is only lost to underflow if it is below exp(largest-708).
+//	As in log_double, a difference a-b*s that would be negative is zero.
+inline double sumbifurcationlogterm(double a, double b, double c, double d, double e, double s, double largest) {
+	double left = (a>c)?a:c;
+	double right = (d>e)?d:e;
+	double scale = bifurcationexp(left+right-largest);
+	if (left==-HUGE_VAL) left = 0;
+	if (right==-HUGE_VAL) right = 0;
+
+	double row = bifurcationexp(a-left)-bifurcationexp(b+s-left);
+	if (row<0) row = 0;
+	row = row+bifurcationexp(c-left);
+	return scale*row*(bifurcationexp(d-right)+bifurcationexp(e-right));
+}
+
+//The same sum as sumbifurcationscalar, without the sum passed in, for log_double.
+//The terms are found relative to the largest of the bounds max(a,c)+max(d,e), so that the sum costs six exps
+//	per term and one log, with no log per term.  This cannot match a log_double sum term by term anyway, so
+//	the terms are added as doubles in four interleaved partial sums, t%4, added as (p0+p1)+(p2+p3), and then
+//	the last n%4 in order.  The AVX2 version adds in the same order.
+//b is passed as -HUGE_VAL terms if it is NULL.
+inline log_double sumbifurcationlogscalar(const log_double *a, const log_double *b, const log_double *c,
+	const log_double *d, const log_double *e, log_double s1, log_double s2, int n) {
+
+	double s = s1.lnvalue+s2.lnvalue;
+	double largest = -HUGE_VAL;
+	double p[4] = {0,0,0,0};
+	double sum;
+	int t;
+
+	for (t=0;t<n;++t) {
+		double left = (a[t].lnvalue>c[t].lnvalue)?a[t].lnvalue:c[t].lnvalue;
+		double right = (d[t].lnvalue>e[t].lnvalue)?d[t].lnvalue:e[t].lnvalue;
+		if (left+right>largest) largest = left+right;
+	}
+	if (largest==-HUGE_VAL) return log_double::fromlog(-HUGE_VAL);
+
+	for (t=0;t+4<=n;t+=4) {
+		for (int l=0;l<4;++l) {
+			p[l]+=sumbifurcationlogterm(a[t+l].lnvalue,(b!=NULL)?b[t+l].lnvalue:-HUGE_VAL,c[t+l].lnvalue,
+				d[t+l].lnvalue,e[t+l].lnvalue,s,largest);
+		}
+	}
+	sum = (p[0]+p[1])+(p[2]+p[3]);
+	for (;t<n;++t) {
+		sum+=sumbifurcationlogterm(a[t].lnvalue,(b!=NULL)?b[t].lnvalue:-HUGE_VAL,c[t].lnvalue,d[t].lnvalue,e[t].lnvalue,s,largest);
+	}
+
+	if (!(sum>0)) return log_double::fromlog(-HUGE_VAL);
+	return log_double::fromlog(largest+log(sum));
+}
+#endif //LOG_DOUBLE
+
+
+#ifdef BIFURCATION_X86
+
+//Load eight energies as 32-bit integers.
+__attribute__((target("avx2"))) inline __m256i loadbifurcation8(const short *p) {
+	return _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i *) p));
+}
+__attribute__((target("avx2"))) inline __m256i loadbifurcation8(const int *p) {
+	return _mm256_loadu_si256((const __m256i *) p);
+}
+
+//Load sixteen energies as 32-bit integers.
+__attribute__((target("avx512f"))) inline __m512i loadbifurcation16(const short *p) {
+	return _mm512_cvtepi16_epi32(_mm256_loadu_si256((const __m256i *) p));
+}
+__attribute__((target("avx512f"))) inline __m512i loadbifurcation16(const int *p) {
+	return _mm512_loadu_si512((const void *) p);
+}
+
+__attribute__((target("avx2"))) inline int minbifurcationavx2(const integersize *left, const integersize *right, int n, int current) {
+	__m256i best = _mm256_set1_epi32(current);
+	int t;
+	int lane[8];
+
+	for (t=0;t+8<=n;t+=8) {
+		best = _mm256_min_epi32(best,_mm256_add_epi32(loadbifurcation8(left+t),loadbifurcation8(right+t)));
+	}
+	_mm256_storeu_si256((__m256i *) lane,best);
+	for (int l=0;l<8;++l) if (lane[l]<current) current = lane[l];
+
+	return minbifurcationscalar(left+t,right+t,n-t,current);
+}
+
+__attribute__((target("avx512f"))) inline int minbifurcationavx512(const integersize *left, const integersize *right, int n, int current) {
+	__m512i best = _mm512_set1_epi32(current);
+	int t;
+
+	for (t=0;t+16<=n;t+=16) {
+		best = _mm512_min_epi32(best,_mm512_add_epi32(loadbifurcation16(left+t),loadbifurcation16(right+t)));
+	}
+	current = _mm512_reduce_min_epi32(best);
+
+	return minbifurcationscalar(left+t,right+t,n-t,current);
+}
+
+#if !defined(EXTENDED_DOUBLE) && !defined(LOG_DOUBLE)
+__attribute__((target("avx2"))) inline double sumbifurcationavx2(double sum, const double *a, const double *b, const double *c,
+	const double *d, const double *e, double s1, double s2, int n) {
+
+	__m256d vs1 = _mm256_set1_pd(s1);
+	__m256d vs2 = _mm256_set1_pd(s2);
+	double term[4];
+	int t;
+
+	for (t=0;t+4<=n;t+=4) {
+		__m256d row = _mm256_loadu_pd(a+t);
+		if (b!=NULL) row = _mm256_sub_pd(row,_mm256_mul_pd(_mm256_mul_pd(_mm256_loadu_pd(b+t),vs1),vs2));
+		row = _mm256_add_pd(row,_mm256_loadu_pd(c+t));
+		_mm256_storeu_pd(term,_mm256_mul_pd(row,_mm256_add_pd(_mm256_loadu_pd(d+t),_mm256_loadu_pd(e+t))));
+		sum+=term[0];
+		sum+=term[1];
+		sum+=term[2];
+		sum+=term[3];
+	}
+	return sumbifurcationscalar(sum,a+t,(b!=NULL)?(b+t):NULL,c+t,d+t,e+t,s1,s2,n-t);
+}
+#endif //!EXTENDED_DOUBLE && !LOG_DOUBLE
+
+#ifdef LOG_DOUBLE
+//bifurcationexp for four values.
+__attribute__((target("avx2"))) inline __m256d bifurcationexpavx2(__m256d x) {
+	__m256d n = _mm256_sub_pd(_mm256_add_pd(_mm256_mul_pd(x,_mm256_set1_pd(BIFURCATION_LOG2E)),_mm256_set1_pd(BIFURCATION_ROUND)),
+		_mm256_set1_pd(BIFURCATION_ROUND));
+	__m256d r = _mm256_sub_pd(_mm256_sub_pd(x,_mm256_mul_pd(n,_mm256_set1_pd(BIFURCATION_LN2HI))),
+		_mm256_mul_pd(n,_mm256_set1_pd(BIFURCATION_LN2LO)));
+	__m256d p = _mm256_set1_pd(bifurcationexpterms[0]);
+	for (int l=1;l<14;++l) p = _mm256_add_pd(_mm256_mul_pd(p,r),_mm256_set1_pd(bifurcationexpterms[l]));
+
+	//2^n, built from its exponent bits; lanes below the minimum (or -HUGE_VAL, for which n is not a number) are masked to 0
+	__m256i bits = _mm256_slli_epi64(_mm256_add_epi64(_mm256_cvtepi32_epi64(_mm256_cvtpd_epi32(n)),_mm256_set1_epi64x(1023)),52);
+	__m256d inrange = _mm256_cmp_pd(x,_mm256_set1_pd(BIFURCATION_EXPMIN),_CMP_GE_OQ);
+	return _mm256_and_pd(_mm256_mul_pd(p,_mm256_castsi256_pd(bits)),inrange);
+}
+
+//sumbifurcationlogterm for four terms.
+__attribute__((target("avx2"))) inline __m256d sumbifurcationlogtermavx2(__m256d a, __m256d b, __m256d c, __m256d d, __m256d e,
+	__m256d s, __m256d largest) {
+
+	__m256d minusinfinity = _mm256_set1_pd(-HUGE_VAL);
+	__m256d zero = _mm256_setzero_pd();
+	__m256d left = _mm256_max_pd(c,a);
+	__m256d right = _mm256_max_pd(e,d);
+	__m256d scale = bifurcationexpavx2(_mm256_sub_pd(_mm256_add_pd(left,right),largest));
+	left = _mm256_blendv_pd(left,zero,_mm256_cmp_pd(left,minusinfinity,_CMP_EQ_OQ));
+	right = _mm256_blendv_pd(right,zero,_mm256_cmp_pd(right,minusinfinity,_CMP_EQ_OQ));
+
+	__m256d row = _mm256_sub_pd(bifurcationexpavx2(_mm256_sub_pd(a,left)),bifurcationexpavx2(_mm256_sub_pd(_mm256_add_pd(b,s),left)));
+	row = _mm256_max_pd(row,zero);
+	row = _mm256_add_pd(row,bifurcationexpavx2(_mm256_sub_pd(c,left)));
+	__m256d column = _mm256_add_pd(bifurcationexpavx2(_mm256_sub_pd(d,right)),bifurcationexpavx2(_mm256_sub_pd(e,right)));
+	return _mm256_mul_pd(_mm256_mul_pd(scale,row),column);
+}
+
+//sumbifurcationlogscalar with AVX2.  A log_double is only its log, so the arrays are read as doubles.
+__attribute__((target("avx2"))) inline log_double sumbifurcationlogavx2(const log_double *a, const log_double *b, const log_double *c,
+	const log_double *d, const log_double *e, log_double s1, log_double s2, int n) {
+
+	const double *la = &a[0].lnvalue, *lc = &c[0].lnvalue, *ld = &d[0].lnvalue, *le = &e[0].lnvalue;
+	const double *lb = (b!=NULL)?&b[0].lnvalue:NULL;
+	double s = s1.lnvalue+s2.lnvalue;
+	__m256d vlargest = _mm256_set1_pd(-HUGE_VAL);
+	double lane[4];
+	double largest,sum;
+	int t;
+
+	for (t=0;t+4<=n;t+=4) {
+		__m256d bound = _mm256_add_pd(_mm256_max_pd(_mm256_loadu_pd(lc+t),_mm256_loadu_pd(la+t)),
+			_mm256_max_pd(_mm256_loadu_pd(le+t),_mm256_loadu_pd(ld+t)));
+		vlargest = _mm256_max_pd(vlargest,bound);
+	}
+	_mm256_storeu_pd(lane,vlargest);
+	largest = lane[0];
+	for (int l=1;l<4;++l) if (lane[l]>largest) largest = lane[l];
+	for (;t<n;++t) {
+		double left = (la[t]>lc[t])?la[t]:lc[t];
+		double right = (ld[t]>le[t])?ld[t]:le[t];
+		if (left+right>largest) largest = left+right;
+	}
+	if (largest==-HUGE_VAL) return log_double::fromlog(-HUGE_VAL);
+
+	__m256d p = _mm256_setzero_pd();
+	__m256d vs = _mm256_set1_pd(s);
+	__m256d nob = _mm256_set1_pd(-HUGE_VAL);
+	vlargest = _mm256_set1_pd(largest);
+	for (t=0;t+4<=n;t+=4) {
+		p = _mm256_add_pd(p,sumbifurcationlogtermavx2(_mm256_loadu_pd(la+t),(lb!=NULL)?_mm256_loadu_pd(lb+t):nob,_mm256_loadu_pd(lc+t),
+			_mm256_loadu_pd(ld+t),_mm256_loadu_pd(le+t),vs,vlargest));
+	}
+	_mm256_storeu_pd(lane,p);
+	sum = (lane[0]+lane[1])+(lane[2]+lane[3]);
+	for (;t<n;++t) {
+		sum+=sumbifurcationlogterm(la[t],(lb!=NULL)?lb[t]:-HUGE_VAL,lc[t],ld[t],le[t],s,largest);
+	}
+
+	if (!(sum>0)) return log_double::fromlog(-HUGE_VAL);
+	return log_double::fromlog(largest+log(sum));
+}
+#endif //LOG_DOUBLE
+
+//0 for the scalar kernels, 1 for AVX2, 2 for AVX2 and AVX-512.
+inline int bifurcationlevel() {
+	__builtin_cpu_init();
+	if (!__builtin_cpu_supports("avx2")) return 0;
+	if (!__builtin_cpu_supports("avx512f")) return 1;
+	return 2;
+}
+
+#endif //BIFURCATION_X86
+
+
+//Return the lesser of current and the least left[t]+right[t], for t from 0 to n-1.
+inline int minbifurcation(const integersize *left, const integersize *right, int n, int current) {
+#ifdef BIFURCATION_X86
+	static const int level = bifurcationlevel();
+
+	if (level==2) return minbifurcationavx512(left,right,n,current);
+	if (level==1) return minbifurcationavx2(left,right,n,current);
+#endif //BIFURCATION_X86
+	return minbifurcationscalar(left,right,n,current);
+}
+
+//Return sum plus the sum over t from 0 to n-1 of (a[t]-b[t]*s1*s2+c[t])*(d[t]+e[t]),
+//	or of (a[t]+c[t])*(d[t]+e[t]) if b is NULL.
+inline PFPRECISION sumbifurcation(PFPRECISION sum, const PFPRECISION *a, const PFPRECISION *b, const PFPRECISION *c,
+	const PFPRECISION *d, const PFPRECISION *e, PFPRECISION s1, PFPRECISION s2, int n) {
+#if defined(LOG_DOUBLE)
+#ifdef BIFURCATION_X86
+	static const int level = bifurcationlevel();
+
+	if (level>=1) return sum+sumbifurcationlogavx2(a,b,c,d,e,s1,s2,n);
+#endif
+	return sum+sumbifurcationlogscalar(a,b,c,d,e,s1,s2,n);
+#else
+#if defined(BIFURCATION_X86) && !defined(EXTENDED_DOUBLE)
+	static const int level = bifurcationlevel();
+
+	if (level>=1) return sumbifurcationavx2(sum,a,b,c,d,e,s1,s2,n);
+#endif
+	return sumbifurcationscalar(sum,a,b,c,d,e,s1,s2,n);
+#endif //LOG_DOUBLE
+}
+
+#endif //BIFURCATION_H
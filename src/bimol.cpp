@@ -12,13 +12,16 @@
 #include <iostream>
 #include <cstdlib>
 #include <cstring>
+#ifdef SMP
+#include <omp.h>
+#endif
 using namespace std;
 
-void bimoltracebackV(int i, int j, int jct3, int k, int N1, int N2, int maxloop, short **V, structure *ct3, datatable *data);
-void bimoltracebackVp(int i, int j, int jct3, int k, int N1, int N2, int maxloop, short **Vp, structure *ct3, datatable *data);
+void bimoltracebackV(int i, int j, int jct3, int *pairs, int N1, int N2, int maxloop, short **V, structure *ct3, datatable *data);
+void bimoltracebackVp(int i, int j, int jct3, int *pairs, int N1, int N2, int maxloop, short **Vp, structure *ct3, datatable *data);
 
-void accessfoldtracebackV(int i, int j, int jct3, int k, int N1, int N2, int maxloop, double **V, double *G, structure *ct3, datatable *data);
-void accessfoldtracebackVp(int i, int j, int jct3, int k, int N1, int N2, int maxloop, double **Vp, double *G, structure *ct3, datatable *data);
+void accessfoldtracebackV(int i, int j, int jct3, int *pairs, int N1, int N2, int maxloop, double **V, double *G, structure *ct3, datatable *data);
+void accessfoldtracebackVp(int i, int j, int jct3, int *pairs, int N1, int N2, int maxloop, double **Vp, double *G, structure *ct3, datatable *data);
 
 
 
@@ -26,6 +29,236 @@ bool inc[6][6]={{false,false,false,false,false,false}, {false,false,false,false,
                 {false,false,false,true,false,false}, {false,false,true,false,true,false}, {false,true,false,true,false,true}, {false,false,false,false,false,false}};
 
                 
+//Fill V[i][j] for bimol(), the lowest free energy from 1 to i in sequence 1 and j to N2 in sequence 2, where i is paired to j.
+//This needs the rows of V after i.
+void bimolfillV(int i, int j, int N1, int N2, int maxloop, short **V, structure *ct3, datatable *data) {
+  int jct3 = N1+3+j;
+  int ip, jp, jpct3;
+  int big, biggest, end;
+
+  //initialize V[i][j]
+  V[i][j] = INFINITE_ENERGY;
+  
+  //first, check if this is a valid pair
+  if (inc[ct3->numseq[i]][ct3->numseq[jct3]]) {
+    
+    //check case for a terminal mismatch on a starting pair
+    if (i < N1 && j > 1) {
+      V[i][j] = min(V[i][j], data->tstack[ct3->numseq[i]][ct3->numseq[jct3]][ct3->numseq[i+1]][ct3->numseq[jct3-1]] +   
+                    penalty(i, jct3, ct3, data));
+    } 
+    //i+1 dangles if nothing can stack on j
+    else if (i < N1 && j == 1) {
+      V[i][j] = min(V[i][j], erg4(i, jct3, i+1, 1, ct3, data, false) + penalty(i, jct3, ct3, data));
+    }  
+    //j-1 dangles if nothing can stack on i
+    else if (i == N1 && j > 1) {
+      V[i][j] = min(V[i][j], erg4(i, jct3, jct3-1, 2, ct3, data, false) + penalty(i, jct3, ct3, data));
+    }
+    //here nothing can stack because this pair involves terminal nucleotides
+    else (V[i][j] = min(V[i][j], penalty(i, jct3, ct3, data)));
+    
+    //now loop over all possible closing pairs at the far end of a base pair stack, bulge loop, or interior loop
+    biggest = N1-i+j-3; 
+    biggest = min(biggest, maxloop);
+    
+    for (int a = 0; a <= biggest; a++) {
+      end = i+a+1;
+      big = min(end, N1);
+      for (ip = max(i+1, i-j+a+3); ip <= big; ip++) {
+        jp = j+ip-i-a-2;
+        jpct3 = jp+N1+3;
+         
+        //make sure this pair at the far end is valid
+        if (inc[ct3->numseq[ip]][ct3->numseq[jpct3]]) {
+          
+          //base pair stack
+          if (a==0){//ip == i+1 && jp == j-1) {
+            V[i][j] = min(V[i][j], erg1(i, jct3, ip, jpct3, ct3, data)+V[ip][jp]);
+          }
+          
+          //either internal loop or bulge
+          else V[i][j] = min(V[i][j], erg2(i, jct3, ip, jpct3, ct3, data, 0, 0)+V[ip][jp]);
+          
+          
+        }
+      }//end loop over ip
+    
+    }//end loop over a
+  }//end check on valid pair
+}
+
+//Fill Vp[i][j] for bimol(), the lowest free energy from i to N1 in sequence 1 and 1 to j in sequence 2, where i is paired to j.
+//This needs the rows of Vp before i.
+void bimolfillVp(int i, int j, int N1, int N2, int maxloop, short **Vp, structure *ct3, datatable *data) {
+  int jct3 = N1+3+j;
+  int ip, jp, jpct3;
+  int big, biggest, end;
+
+  //initialize Vp
+  Vp[i][j] = INFINITE_ENERGY; 
+  
+  //Make sure this is a valid pair
+  if (inc[ct3->numseq[i]][ct3->numseq[jct3]]) {
+
+    //consider a terminal mm
+    if (i > 1 && j < N2) {
+      Vp[i][j] = min(Vp[i][j], data->tstack[ct3->numseq[jct3]][ct3->numseq[i]][ct3->numseq[jct3+1]][ct3->numseq[i-1]] + 
+                     penalty(jct3, i, ct3, data));
+    }   
+    //i-1 dangles if nothing can stack on j
+    else if (i > 1 && j == N2) {
+      Vp[i][j] = min(Vp[i][j], erg4(jct3, i, i-1, 2, ct3, data, false) + penalty(jct3, i, ct3, data));
+    }
+    //j+1 dangles if nothing can stack on i
+    else if (i == 1 && j < N2) {
+      Vp[i][j] = min(Vp[i][j], erg4(jct3, i, jct3+1, 1, ct3, data, false) + penalty(jct3, i, ct3, data));
+    }     
+    //terminal bp, so no stacks are allowed
+    else (Vp[i][j] = min(Vp[i][j], penalty(jct3, i, ct3, data)));
+    
+
+    //Consider an internal loop, bulge loop, or helical stack closed at the far end by another pair
+    biggest = N2-j+i-3;
+    biggest = min(biggest, maxloop);
+ 
+    for (int a = 0; a <= biggest; a++) {
+      end = j+a+1;
+      big = min(end, N2); 
+      for (jp = max(j+1, j-i+a+3), jpct3 = jp+N1+3; jp <= big; jp++, jpct3++) {
+        ip = i+jp-j-a-2;
+        
+        //check that the pair at the far end is valid
+        if (inc[ct3->numseq[ip]][ct3->numseq[jpct3]]) {
+        
+          //bp stack
+          if (a==0){//ip == i-1 && jp == j+1) {
+            Vp[i][j] = min(Vp[i][j], erg1(jct3, i, jpct3, ip, ct3, data)+Vp[ip][jp]);
+          }
+          
+          //internal loop or bulge
+          else Vp[i][j] = min(Vp[i][j], erg2(jct3, i, jpct3, ip, ct3, data, 0, 0)+Vp[ip][jp]);
+        }//end valid pair at far end
+    
+      }//end loop over ip
+    }//end loop over a
+  }//end valid pair
+}
+
+//Fill V[i][j] for accessfold(), as bimolfillV() does, with the pseudo-free energies Gp for pairing.
+void accessfoldfillV(int i, int j, int N1, int N2, int maxloop, double **V, double *Gp, structure *ct3, datatable *data) {
+  int jct3 = N1+3+j;
+  int ip, jp, jpct3;
+  int big, biggest, end;
+
+  //initialize V[i][j]
+  V[i][j] = INFINITE_ENERGY;
+  
+  //first, check if this is a valid pair
+  if (inc[ct3->numseq[i]][ct3->numseq[jct3]]) {
+    
+    //check case for a terminal mismatch on a starting pair
+    if (i < N1 && j > 1) {
+      V[i][j] = min(V[i][j], data->tstack[ct3->numseq[i]][ct3->numseq[jct3]][ct3->numseq[i+1]][ct3->numseq[jct3-1]] +   
+                    penalty(i, jct3, ct3, data) - Gp[i] - Gp[jct3]);
+    } 
+    //i+1 dangles if nothing can stack on j
+    else if (i < N1 && j == 1) {
+      V[i][j] = min(V[i][j], erg4(i, jct3, i+1, 1, ct3, data, false) + penalty(i, jct3, ct3, data) - Gp[i] - Gp[jct3]);
+    }  
+    //j-1 dangles if nothing can stack on i
+    else if (i == N1 && j > 1) {
+      V[i][j] = min(V[i][j], erg4(i, jct3, jct3-1, 2, ct3, data, false) + penalty(i, jct3, ct3, data) - Gp[i] - Gp[jct3]);
+    }
+    //here nothing can stack because this pair involves terminal nucleotides
+    else (V[i][j] = penalty(i, jct3, ct3, data) - Gp[i] - Gp[jct3]);
+    
+    //now loop over all possible closing pairs at the far end of a base pair stack, bulge loop, or interior loop
+    biggest = N1-i+j-3; 
+    biggest = min(biggest, maxloop);
+    
+    for (int a = 0; a <= biggest; a++) {
+      end = i+a+1;
+      big = min(end, N1);
+      for (ip = max(i+1, i-j+a+3); ip <= big; ip++) {
+        jp = j+ip-i-a-2;
+        jpct3 = jp+N1+3;
+         
+        //make sure this pair at the far end is valid
+        if (inc[ct3->numseq[ip]][ct3->numseq[jpct3]]) {
+          
+          //base pair stack
+          if (a==0){//ip == i+1 && jp == j-1) {
+            V[i][j] = min(V[i][j], erg1(i, jct3, ip, jpct3, ct3, data)+V[ip][jp] - Gp[i] - Gp[jct3]);
+          }
+          
+          //either internal loop or bulge
+          else V[i][j] = min(V[i][j], erg2(i, jct3, ip, jpct3, ct3, data, 0, 0)+V[ip][jp] - Gp[i] -Gp[jct3]);
+          
+          
+        }
+      }//end loop over ip
+    
+    }//end loop over a
+  }//end check on valid pair
+}
+
+//Fill Vp[i][j] for accessfold(), as bimolfillVp() does, with the pseudo-free energies Gp for pairing.
+void accessfoldfillVp(int i, int j, int N1, int N2, int maxloop, double **Vp, double *Gp, structure *ct3, datatable *data) {
+  int jct3 = N1+3+j;
+  int ip, jp, jpct3;
+  int big, biggest, end;
+
+  //initialize Vp
+  Vp[i][j] = INFINITE_ENERGY; 
+  
+  //Make sure this is a valid pair
+  if (inc[ct3->numseq[i]][ct3->numseq[jct3]]) {
+
+    //consider a terminal mm
+    if (i > 1 && j < N2) {
+      Vp[i][j] = min(Vp[i][j], data->tstack[ct3->numseq[jct3]][ct3->numseq[i]][ct3->numseq[jct3+1]][ct3->numseq[i-1]] + 
+                     penalty(jct3, i, ct3, data) - Gp[i] - Gp[jct3]);
+    }   
+    //i-1 dangles if nothing can stack on j
+    else if (i > 1 && j == N2) {
+      Vp[i][j] = min(Vp[i][j], erg4(jct3, i, i-1, 2, ct3, data, false) + penalty(jct3, i, ct3, data) - Gp[i] - Gp[jct3]);
+    }
+    //j+1 dangles if nothing can stack on i
+    else if (i == 1 && j < N2) {
+      Vp[i][j] = min(Vp[i][j], erg4(jct3, i, jct3+1, 1, ct3, data, false) + penalty(jct3, i, ct3, data) - Gp[i] - Gp[jct3]);
+    }     
+    //terminal bp, so no stacks are allowed
+    else (Vp[i][j] = min(Vp[i][j], penalty(jct3, i, ct3, data) - Gp[i] - Gp[jct3]));
+    
+
+    //Consider an internal loop, bulge loop, or helical stack closed at the far end by another pair
+    biggest = N2-j+i-3;
+    biggest = min(biggest, maxloop);
+ 
+    for (int a = 0; a <= biggest; a++) {
+      end = j+a+1;
+      big = min(end, N2); 
+      for (jp = max(j+1, j-i+a+3), jpct3 = jp+N1+3; jp <= big; jp++, jpct3++) {
+        ip = i+jp-j-a-2;
+        
+        //check that the pair at the far end is valid
+        if (inc[ct3->numseq[ip]][ct3->numseq[jpct3]]) {
+        
+          //bp stack
+          if (a==0){//ip == i-1 && jp == j+1) {
+            Vp[i][j] = min(Vp[i][j], erg1(jct3, i, jpct3, ip, ct3, data)+Vp[ip][jp] - Gp[i] - Gp[jct3]);
+          }
+          
+          //internal loop or bulge
+          else Vp[i][j] = erg2(jct3, i, jpct3, ip, ct3, data, 0, 0)+Vp[ip][jp] - Gp[i] - Gp[jct3];
+        }//end valid pair at far end
+    
+      }//end loop over ip
+    }//end loop over a
+  }//end valid pair
+}
+
 void bimol(structure *ct1, structure *ct2, structure *ct3, int maxloop, int maxtracebacks, int percent, int windowsize, 
            datatable *data) {
   
@@ -45,7 +278,7 @@ void bimol(structure *ct1, structure *ct2, structure *ct3, int maxloop, int maxt
   int a, b, k, k1, k2, k3;
   int vmin, crit, num, numbp;
   int q, up, ir, c, cur;
-  int iret, jret, sort;
+  int sort;
   int *energy, *heapi, *heapj; 
   
   ct3->allocate(maxseq);
@@ -90,142 +323,39 @@ void bimol(structure *ct1, structure *ct2, structure *ct3, int maxloop, int maxt
         
   //dynamic allocation of memory for V[i][j], the mfe from 1 to i in sequence 1 and j to N2 in sequence 2, where i is paired to j.
   short **V;
+  //The rows are in one block, so that the fill walks contiguous memory.
+  //All N1 rows are kept, even though a cell reads only the maxloop+2 rows next to it: every i,j is a possible
+  //	intermolecular pair, so the search for the lowest V[i][j]+Vp[i][j] and the tracebacks read every cell,
+  //	and V and Vp are filled from opposite ends of sequence 1, so their sums cannot be taken as the rows are filled.
   V = new short *[N1+1];
-  for (int k=0; k<=N1; k++) {
-    V[k] = new short [N2+1];
+  V[0] = new short [(N1+1)*(N2+1)];
+  for (int k=1; k<=N1; k++) {
+    V[k] = V[0]+k*(N2+1);
   }
    
   //dynamic allocation of memory for Vp[i][j], the mfe from i to N1 in sequence 1 and 1 to j in sequence 2, where i is paired to j.
   short **Vp;
   Vp = new short *[N1+1];
-  for (int k = 0; k <= N1; k++) {
-    Vp[k] = new short[N2+1];
+  Vp[0] = new short [(N1+1)*(N2+1)];
+  for (int k = 1; k <= N1; k++) {
+    Vp[k] = Vp[0]+k*(N2+1);
   }
   
-  //main loops over i and j to fill the V array
-  for (i=N1; i >= 1; i--) {
+  //main loops to fill the V and Vp arrays
+  //V[i][j] needs the rows of V after i, and Vp[i][j] needs the rows of Vp before i, so each pass fills a row of V, from i = N1 down,
+  //and a row of Vp, from i = 1 up.  With SMP, the 2*N2 cells of a pass are filled in parallel, in one parallel region for all of the passes.
 #ifdef SMP
-#pragma omp parallel for
+#pragma omp parallel
 #endif
-    for (j=1; j <= N2; j++) {
-      int jct3 = N1+3+j;
-      int ip, jp, jpct3;
-      int big, biggest, end;
-      //initialize V[i][j]
-      V[i][j] = INFINITE_ENERGY;
-      
-	  //first, check if this is a valid pair
-      if (inc[ct3->numseq[i]][ct3->numseq[jct3]]) {
-        
-        //check case for a terminal mismatch on a starting pair
-        if (i < N1 && j > 1) {
-          V[i][j] = min(V[i][j], data->tstack[ct3->numseq[i]][ct3->numseq[jct3]][ct3->numseq[i+1]][ct3->numseq[jct3-1]] +   
-                        penalty(i, jct3, ct3, data));
-        } 
-        //i+1 dangles if nothing can stack on j
-        else if (i < N1 && j == 1) {
-          V[i][j] = min(V[i][j], erg4(i, jct3, i+1, 1, ct3, data, false) + penalty(i, jct3, ct3, data));
-        }  
-        //j-1 dangles if nothing can stack on i
-        else if (i == N1 && j > 1) {
-          V[i][j] = min(V[i][j], erg4(i, jct3, jct3-1, 2, ct3, data, false) + penalty(i, jct3, ct3, data));
-        }
-		//here nothing can stack because this pair involves terminal nucleotides
-        else (V[i][j] = min(V[i][j], penalty(i, jct3, ct3, data)));
-        
-		//now loop over all possible closing pairs at the far end of a base pair stack, bulge loop, or interior loop
-        biggest = N1-i+j-3; 
-        biggest = min(biggest, maxloop);
-        
-        for (int a = 0; a <= biggest; a++) {
-          end = i+a+1;
-          big = min(end, N1);
-          for (ip = max(i+1, i-j+a+3); ip <= big; ip++) {
-            jp = j+ip-i-a-2;
-            jpct3 = jp+N1+3;
-             
-			//make sure this pair at the far end is valid
-            if (inc[ct3->numseq[ip]][ct3->numseq[jpct3]]) {
-              
-              //base pair stack
-			  if (a==0){//ip == i+1 && jp == j-1) {
-                V[i][j] = min(V[i][j], erg1(i, jct3, ip, jpct3, ct3, data)+V[ip][jp]);
-              }
-              
-              //either internal loop or bulge
-              else V[i][j] = min(V[i][j], erg2(i, jct3, ip, jpct3, ct3, data, 0, 0)+V[ip][jp]);
-              
-              
-            }
-          }//end loop over ip
-        
-        }//end loop over a
-      }//end check on valid pair
-    }//end loop over j
-  }//end loop over i
-    
-  
-  //main loops over i and j for Vp, V calculations in reverse direction 
-  for (i=1; i <= N1; i++) {
+  for (int pass = 0; pass < N1; pass++) {
 #ifdef SMP
-#pragma omp parallel for
+#pragma omp for schedule(dynamic,16)
 #endif
-    for (j = N2; j >= 1; j--) {
-      int jct3 = maxseq-N2+j;
-      int ip, jp, jpct3;
-      int big, biggest, end;
-	  //initialize Vp
-      Vp[i][j] = INFINITE_ENERGY; 
-      
-	  //Make sure this is a valid pair
-      if (inc[ct3->numseq[i]][ct3->numseq[jct3]]) {
-    
-        //consider a terminal mm
-        if (i > 1 && j < N2) {
-          Vp[i][j] = min(Vp[i][j], data->tstack[ct3->numseq[jct3]][ct3->numseq[i]][ct3->numseq[jct3+1]][ct3->numseq[i-1]] + 
-                         penalty(jct3, i, ct3, data));
-        }   
-        //i-1 dangles if nothing can stack on j
-        else if (i > 1 && j == N2) {
-          Vp[i][j] = min(Vp[i][j], erg4(jct3, i, i-1, 2, ct3, data, false) + penalty(jct3, i, ct3, data));
-        }
-        //j+1 dangles if nothing can stack on i
-        else if (i == 1 && j < N2) {
-          Vp[i][j] = min(Vp[i][j], erg4(jct3, i, jct3+1, 1, ct3, data, false) + penalty(jct3, i, ct3, data));
-        }     
-        //terminal bp, so no stacks are allowed
-        else (Vp[i][j] = min(Vp[i][j], penalty(jct3, i, ct3, data)));
-        
-
-		//Consider an internal loop, bulge loop, or helical stack closed at the far end by another pair
-        biggest = N2-j+i-3;
-        biggest = min(biggest, maxloop);
-     
-        for (int a = 0; a <= biggest; a++) {
-          end = j+a+1;
-          big = min(end, N2); 
-          for (jp = max(j+1, j-i+a+3), jpct3 = jp+N1+3; jp <= big; jp++, jpct3++) {
-            ip = i+jp-j-a-2;
-            
-			//check that the pair at the far end is valid
-            if (inc[ct3->numseq[ip]][ct3->numseq[jpct3]]) {
-            
-              //bp stack
-			  if (a==0){//ip == i-1 && jp == j+1) {
-                Vp[i][j] = min(Vp[i][j], erg1(jct3, i, jpct3, ip, ct3, data)+Vp[ip][jp]);
-              }
-              
-              //internal loop or bulge
-              else Vp[i][j] = min(Vp[i][j], erg2(jct3, i, jpct3, ip, ct3, data, 0, 0)+Vp[ip][jp]);
-            }//end valid pair at far end
-        
-          }//end loop over ip
-        }//end loop over a
-      }//end valid pair
-      
-    }//end loop over j
-      
-  }//end loop over i
+    for (int cell = 1; cell <= 2*N2; cell++) {
+      if (cell <= N2) bimolfillV(N1-pass, cell, N1, N2, maxloop, V, ct3, data);
+      else bimolfillVp(pass+1, 2*N2+1-cell, N1, N2, maxloop, Vp, ct3, data);
+    }
+  }
 
    
   //begin traceback
@@ -246,14 +376,15 @@ void bimol(structure *ct1, structure *ct2, structure *ct3, int maxloop, int maxt
     }
     
     //mark will keep track of bps that have been seen before
+    //Every pair is from i in sequence 1 to j in sequence 2, so mark only needs the rows for sequence 1.
     bool **mark;
-    mark = new bool *[maxseq+1];
-    for (i = 0; i <= maxseq; i++) {
+    mark = new bool *[N1+1];
+    for (i = 0; i <= N1; i++) {
       mark[i] = new bool [maxseq+1]; 
     }
     
     //initialize mark
-    for (int count = 1; count <= maxseq; count++) {
+    for (int count = 1; count <= N1; count++) {
       for (int count2 = 1; count2 <= maxseq; count2++) {
         mark[count][count2] = false;
       }
@@ -342,6 +473,26 @@ void bimol(structure *ct1, structure *ct2, structure *ct3, int maxloop, int maxt
       }
     }
     
+    //The traceback from a start depends only on the arrays, but whether a start is traced depends on the pairs
+    //	marked by the structures before it.  So, as in trace() in MaxExpect.cpp, the next unmarked starts on the
+    //	heap are traced together, in parallel in the SMP version, and then used in order.  A start that the
+    //	structures before it have marked since is skipped, as it would have been if the starts were traced one
+    //	at a time, so the structures do not depend on the number of threads.
+    int batchsize, batchcount, next;
+    int *batch;
+    int **batchpairs;
+
+#ifdef SMP
+    batchsize = 4*omp_get_max_threads();
+#else
+    batchsize = 1;
+#endif
+    batch = new int [batchsize];
+    batchpairs = new int *[batchsize];
+    for (b = 0; b < batchsize; b++) batchpairs[b] = new int [maxseq+1];
+    batchcount = 0;
+    next = 0;
+
 	//ct3->numofstructures = 0; //initialize the number of structures
 	bool failedprevious = false;//track whether a structure was traced, but not different enough from previous structures
 
@@ -351,14 +502,35 @@ void bimol(structure *ct1, structure *ct2, structure *ct3, int maxloop, int maxt
       //find next unmarked bp
       if (!mark[heapi[cntr]][N1+3+heapj[cntr]]) {
         
-        iret = heapi[cntr];
-        jret = heapj[cntr];
+        //find the traceback for this start in the batch, tracing the next batch if it is not there
+        //the starts in the batch that come before this one have been marked since the batch was traced
+        while (next < batchcount && batch[next] > cntr) next++;
+        if (next == batchcount) {
+          batchcount = 0;
+          for (c = cntr; c > 0 && batchcount < batchsize; c--) {
+            if (!mark[heapi[c]][N1+3+heapj[c]]) batch[batchcount++] = c;
+          }
+
+#ifdef SMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+          for (b = 0; b < batchcount; b++) {
+            int *pairs = batchpairs[b];
+            int ib = heapi[batch[b]];
+            int jb = heapj[batch[b]];
+
+            for (int n = 0; n <= maxseq; n++) pairs[n] = 0;
+            bimoltracebackV(ib, jb, jb+N1+3, pairs, N1, N2, maxloop, V, ct3, data);
+            bimoltracebackVp(ib, jb, jb+N1+3, pairs, N1, N2, maxloop, Vp, ct3, data);
+          }
+          next = 0;
+        }
+
 //<<<<<<< bimol.cpp
 		if (failedprevious) ct3->CleanStructure(ct3->GetNumberofStructures()); //last structure should not be kept, it should have pairs scrubbed
 		else ct3->AddStructure();//Need a new structure to contain this traceback
 		failedprevious=false;
                 
-        int jct3 = jret + N1 + 3;
 //=======
 //        ct3->numofstructures++;
 //        ct3->checknumberofstructures();        
@@ -367,9 +539,10 @@ void bimol(structure *ct1, structure *ct2, structure *ct3, int maxloop, int maxt
 
 		
         
-        //perform traceback
-        bimoltracebackV(iret, jret, jct3, ct3->GetNumberofStructures(), N1, N2, maxloop, V, ct3, data);
-        bimoltracebackVp(iret, jret, jct3, ct3->GetNumberofStructures(), N1, N2, maxloop, Vp, ct3, data);
+        //copy the traceback
+        for (k1 = 1; k1 <= maxseq; k1++) {
+          if (k1 < batchpairs[next][k1]) ct3->SetPair(k1, batchpairs[next][k1], ct3->GetNumberofStructures());
+        }
       
         ct3->SetEnergy(ct3->GetNumberofStructures(),energy[cntr]);
         
@@ -386,7 +559,7 @@ void bimol(structure *ct1, structure *ct2, structure *ct3, int maxloop, int maxt
           if (k1 < (ct3->GetPair(k1,ct3->GetNumberofStructures()))) {
             mark[k1][ct3->GetPair(k1,ct3->GetNumberofStructures())] = true;
             if (windowsize > 0) {
-              for (k2 = max(1, k1 - windowsize); k2 <= min(maxseq, k1 + windowsize); k2++) {
+              for (k2 = max(1, k1 - windowsize); k2 <= min(N1, k1 + windowsize); k2++) {
                 for (k3 = max(k2, (ct3->GetPair(k1,ct3->GetNumberofStructures()) - windowsize)); k3 <= min(maxseq, (ct3->GetPair(k1,ct3->GetNumberofStructures()) + windowsize)); k3++) {
                       
                       mark[k2][k3] = true;
@@ -411,26 +584,48 @@ void bimol(structure *ct1, structure *ct2, structure *ct3, int maxloop, int maxt
     }
 	if (failedprevious) ct3->RemoveLastStructure();//last structure should not be kept
         
-    de_allocate (mark, maxseq+1);
+    for (b = 0; b < batchsize; b++) delete[] batchpairs[b];
+    delete[] batchpairs;
+    delete[] batch;
+    de_allocate (mark, N1+1);
     delete[] energy;
     delete[] heapi;
     delete[] heapj;
     
   //}
     
-    for (int l = 0; l <= N1; l++) {
-      delete[] V[l];
-      delete[] Vp[l];
-    }
-    
+    delete[] V[0];
+    delete[] Vp[0];
     delete[] V;
     delete[] Vp;
     
 }
 
+//bimolbatch folds the target, ct1, with each of the queries in ct2, keeping the target and the parameters for all of them.
+//With SMP, the queries are folded in parallel, each on one thread, because the parallel fill in bimol is for one long duplex.
+void bimolbatch(structure *ct1, structure **ct2, structure **ct3, int queries, int maxloop, int maxtracebacks, int percent, int windowsize,
+           datatable *data) {
+
+  int N1 = ct1->GetSequenceLength();
+
+#ifdef SMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+  for (int q = 0; q < queries; q++) {
+    bimol(ct1, ct2[q], ct3[q], maxloop, maxtracebacks, percent, windowsize, data);
+
+    //record that the duplex is intermolecular, as HybridRNA::FoldDuplex does
+    ct3[q]->intermolecular = true;
+    ct3[q]->inter[0] = N1+1;
+    ct3[q]->inter[1] = N1+2;
+    ct3[q]->inter[2] = N1+3;
+  }
+
+}
+
 
 
-void bimoltracebackV(int i, int j, int jct3, int k, int N1, int N2, int maxloop, short **V, structure *ct3, datatable *data) {
+void bimoltracebackV(int i, int j, int jct3, int *pairs, int N1, int N2, int maxloop, short **V, structure *ct3, datatable *data) {
   
   bool done, found;
   int jpct3, ip, jp;
@@ -442,7 +637,8 @@ void bimoltracebackV(int i, int j, int jct3, int k, int N1, int N2, int maxloop,
   while (!done) {
 
     //register the current base pair and find the next, if there are any
-     ct3->SetPair(i,jct3,k);
+     pairs[i] = jct3;
+     pairs[jct3] = i;
      
       
 	 
@@ -524,7 +720,7 @@ void bimoltracebackV(int i, int j, int jct3, int k, int N1, int N2, int maxloop,
 	}//end while !done
 }
       
-void bimoltracebackVp(int i, int j, int jct3, int k, int N1, int N2, int maxloop, short **Vp, structure *ct3, datatable *data) { 
+void bimoltracebackVp(int i, int j, int jct3, int *pairs, int N1, int N2, int maxloop, short **Vp, structure *ct3, datatable *data) { 
   
   bool done, found;
   int jpct3, ip, jp;
@@ -536,7 +732,8 @@ void bimoltracebackVp(int i, int j, int jct3, int k, int N1, int N2, int maxloop
   while (!done) {
     
     //record the current base pair and then go look for the next
-    ct3->SetPair(i,jct3,k);
+    pairs[i] = jct3;
+    pairs[jct3] = i;
     
 	if (i!=1&&j!=N2) {
 		if(Vp[i][j] == data->tstack[ct3->numseq[jct3]][ct3->numseq[i]][ct3->numseq[jct3+1]][ct3->numseq[i-1]] + penalty(jct3, i, ct3, data)) {
@@ -625,7 +822,7 @@ void accessfold(structure *ct1, structure *ct2, structure *ct3, int maxloop, int
   int a, b, k, k1, k2, k3;
   int num, numbp, error;
   int q, up, ir, c, cur;
-  int iret, jret, sort;
+  int sort;
   int *heapi, *heapj; 
   double vmin, crit, *energy;
 
@@ -670,16 +867,19 @@ void accessfold(structure *ct1, structure *ct2, structure *ct3, int maxloop, int
         
   //dynamic allocation of memory for V[i][j], the mfe from 1 to i in sequence 1 and j to N2 in sequence 2, where i is paired to j.
   double **V;
+  //The rows are in one block, so that the fill walks contiguous memory.  All N1 rows are kept, as in bimol().
   V = new double *[N1+1];
-  for (int k=0; k<=N1; k++) {
-    V[k] = new double [N2+1];
+  V[0] = new double [(N1+1)*(N2+1)];
+  for (int k=1; k<=N1; k++) {
+    V[k] = V[0]+k*(N2+1);
   }
    
   //dynamic allocation of memory for Vp[i][j], the mfe from i to N1 in sequence 1 and 1 to j in sequence 2, where i is paired to j.
   double **Vp;
   Vp = new double *[N1+1];
-  for (int k = 0; k <= N1; k++) {
-    Vp[k] = new double[N2+1];
+  Vp[0] = new double [(N1+1)*(N2+1)];
+  for (int k = 1; k <= N1; k++) {
+    Vp[k] = Vp[0]+k*(N2+1);
   }
 
 //RNA class constructor - use RNA(filename, type, IsRNA) - type = 2 for .seq, type = 3 for .pfs 6/11
@@ -810,120 +1010,21 @@ void accessfold(structure *ct1, structure *ct2, structure *ct3, int maxloop, int
 	}		
 
   
-  //main loops over i and j to fill the V array - pseudo-G term incorporated 6/11
-  for (i=N1; i >= 1; i--) {
-    for (j=1, jct3 = N1+4; j <= N2; j++, jct3++) {
-
-      //initialize V[i][j]
-      V[i][j] = INFINITE_ENERGY;
-      
-	  //first, check if this is a valid pair
-      if (inc[ct3->numseq[i]][ct3->numseq[jct3]]) {
-        
-        //check case for a terminal mismatch on a starting pair
-        if (i < N1 && j > 1) {
-          V[i][j] = min(V[i][j], data->tstack[ct3->numseq[i]][ct3->numseq[jct3]][ct3->numseq[i+1]][ct3->numseq[jct3-1]] +   
-                        penalty(i, jct3, ct3, data) - Gp[i] - Gp[jct3]);
-        } 
-        //i+1 dangles if nothing can stack on j
-        else if (i < N1 && j == 1) {
-          V[i][j] = min(V[i][j], erg4(i, jct3, i+1, 1, ct3, data, false) + penalty(i, jct3, ct3, data) - Gp[i] - Gp[jct3]);
-        }  
-        //j-1 dangles if nothing can stack on i
-        else if (i == N1 && j > 1) {
-          V[i][j] = min(V[i][j], erg4(i, jct3, jct3-1, 2, ct3, data, false) + penalty(i, jct3, ct3, data) - Gp[i] - Gp[jct3]);
-        }
-		//here nothing can stack because this pair involves terminal nucleotides
-        else (V[i][j] = penalty(i, jct3, ct3, data) - Gp[i] - Gp[jct3]);
-        
-		//now loop over all possible closing pairs at the far end of a base pair stack, bulge loop, or interior loop
-        biggest = N1-i+j-3; 
-        biggest = min(biggest, maxloop);
-        
-        for (int a = 0; a <= biggest; a++) {
-          end = i+a+1;
-          big = min(end, N1);
-          for (ip = max(i+1, i-j+a+3); ip <= big; ip++) {
-            jp = j+ip-i-a-2;
-            jpct3 = jp+N1+3;
-             
-			//make sure this pair at the far end is valid
-            if (inc[ct3->numseq[ip]][ct3->numseq[jpct3]]) {
-              
-              //base pair stack
-			  if (a==0){//ip == i+1 && jp == j-1) {
-                V[i][j] = min(V[i][j], erg1(i, jct3, ip, jpct3, ct3, data)+V[ip][jp] - Gp[i] - Gp[jct3]);
-              }
-              
-              //either internal loop or bulge
-              else V[i][j] = min(V[i][j], erg2(i, jct3, ip, jpct3, ct3, data, 0, 0)+V[ip][jp] - Gp[i] -Gp[jct3]);
-              
-              
-            }
-          }//end loop over ip
-        
-        }//end loop over a
-      }//end check on valid pair
-    }//end loop over j
-  }//end loop over i
-    
-  
-  //main loops over i and j for Vp, V calculations in reverse direction 
-  for (i=1; i <= N1; i++) {
-    for (j = N2, jct3 = maxseq; j >= 1; j--, jct3--) {
-
-	  //initialize Vp
-      Vp[i][j] = INFINITE_ENERGY; 
-      
-	  //Make sure this is a valid pair
-      if (inc[ct3->numseq[i]][ct3->numseq[jct3]]) {
-    
-        //consider a terminal mm
-        if (i > 1 && j < N2) {
-          Vp[i][j] = min(Vp[i][j], data->tstack[ct3->numseq[jct3]][ct3->numseq[i]][ct3->numseq[jct3+1]][ct3->numseq[i-1]] + 
-                         penalty(jct3, i, ct3, data) - Gp[i] - Gp[jct3]);
-        }   
-        //i-1 dangles if nothing can stack on j
-        else if (i > 1 && j == N2) {
-          Vp[i][j] = min(Vp[i][j], erg4(jct3, i, i-1, 2, ct3, data, false) + penalty(jct3, i, ct3, data) - Gp[i] - Gp[jct3]);
-        }
-        //j+1 dangles if nothing can stack on i
-        else if (i == 1 && j < N2) {
-          Vp[i][j] = min(Vp[i][j], erg4(jct3, i, jct3+1, 1, ct3, data, false) + penalty(jct3, i, ct3, data) - Gp[i] - Gp[jct3]);
-        }     
-        //terminal bp, so no stacks are allowed
-        else (Vp[i][j] = min(Vp[i][j], penalty(jct3, i, ct3, data) - Gp[i] - Gp[jct3]));
-        
-
-		//Consider an internal loop, bulge loop, or helical stack closed at the far end by another pair
-        biggest = N2-j+i-3;
-        biggest = min(biggest, maxloop);
-     
-        for (int a = 0; a <= biggest; a++) {
-          end = j+a+1;
-          big = min(end, N2); 
-          for (jp = max(j+1, j-i+a+3), jpct3 = jp+N1+3; jp <= big; jp++, jpct3++) {
-            ip = i+jp-j-a-2;
-            
-			//check that the pair at the far end is valid
-            if (inc[ct3->numseq[ip]][ct3->numseq[jpct3]]) {
-            
-              //bp stack
-			  if (a==0){//ip == i-1 && jp == j+1) {
-                Vp[i][j] = min(Vp[i][j], erg1(jct3, i, jpct3, ip, ct3, data)+Vp[ip][jp] - Gp[i] - Gp[jct3]);
-              }
-              
-              //internal loop or bulge
-              else Vp[i][j] = erg2(jct3, i, jpct3, ip, ct3, data, 0, 0)+Vp[ip][jp] - Gp[i] - Gp[jct3];
-            }//end valid pair at far end
-        
-          }//end loop over ip
-        }//end loop over a
-      }//end valid pair
-      
-    }//end loop over j
-      
-  }//end loop over i
+  //main loops to fill the V and Vp arrays - pseudo-G term incorporated 6/11
+  //V[i][j] needs the rows of V after i, and Vp[i][j] needs the rows of Vp before i, so each pass fills a row of V, from i = N1 down,
+  //and a row of Vp, from i = 1 up.  With SMP, the 2*N2 cells of a pass are filled in parallel, in one parallel region for all of the passes.
+#ifdef SMP
+#pragma omp parallel
+#endif
+  for (int pass = 0; pass < N1; pass++) {
+#ifdef SMP
+#pragma omp for schedule(dynamic,16)
+#endif
+    for (int cell = 1; cell <= 2*N2; cell++) {
+      if (cell <= N2) accessfoldfillV(N1-pass, cell, N1, N2, maxloop, V, Gp, ct3, data);
+      else accessfoldfillVp(pass+1, 2*N2+1-cell, N1, N2, maxloop, Vp, Gp, ct3, data);
+    }
+  }
 
    
   //begin traceback
@@ -944,14 +1045,15 @@ void accessfold(structure *ct1, structure *ct2, structure *ct3, int maxloop, int
     }
     
     //mark will keep track of bps that have been seen before
+    //Every pair is from i in sequence 1 to j in sequence 2, so mark only needs the rows for sequence 1.
     bool **mark;
-    mark = new bool *[maxseq+1];
-    for (i = 0; i <= maxseq; i++) {
+    mark = new bool *[N1+1];
+    for (i = 0; i <= N1; i++) {
       mark[i] = new bool [maxseq+1]; 
     }
     
     //initialize mark
-    for (int count = 1; count <= maxseq; count++) {
+    for (int count = 1; count <= N1; count++) {
       for (int count2 = 1; count2 <= maxseq; count2++) {
         mark[count][count2] = false;
       }
@@ -1040,6 +1142,26 @@ void accessfold(structure *ct1, structure *ct2, structure *ct3, int maxloop, int
       }
     }
     
+    //The traceback from a start depends only on the arrays, but whether a start is traced depends on the pairs
+    //	marked by the structures before it.  So, as in trace() in MaxExpect.cpp, the next unmarked starts on the
+    //	heap are traced together, in parallel in the SMP version, and then used in order.  A start that the
+    //	structures before it have marked since is skipped, as it would have been if the starts were traced one
+    //	at a time, so the structures do not depend on the number of threads.
+    int batchsize, batchcount, next;
+    int *batch;
+    int **batchpairs;
+
+#ifdef SMP
+    batchsize = 4*omp_get_max_threads();
+#else
+    batchsize = 1;
+#endif
+    batch = new int [batchsize];
+    batchpairs = new int *[batchsize];
+    for (b = 0; b < batchsize; b++) batchpairs[b] = new int [maxseq+1];
+    batchcount = 0;
+    next = 0;
+
 	//ct3->numofstructures = 0; //initialize the number of structures
 
     //for max number of structures input by user
@@ -1048,15 +1170,36 @@ void accessfold(structure *ct1, structure *ct2, structure *ct3, int maxloop, int
       //find next unmarked bp
       if (!mark[heapi[cntr]][N1+3+heapj[cntr]]) {
         
-        iret = heapi[cntr];
-        jret = heapj[cntr];
+        //find the traceback for this start in the batch, tracing the next batch if it is not there
+        //the starts in the batch that come before this one have been marked since the batch was traced
+        while (next < batchcount && batch[next] > cntr) next++;
+        if (next == batchcount) {
+          batchcount = 0;
+          for (c = cntr; c > 0 && batchcount < batchsize; c--) {
+            if (!mark[heapi[c]][N1+3+heapj[c]]) batch[batchcount++] = c;
+          }
+
+#ifdef SMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+          for (b = 0; b < batchcount; b++) {
+            int *pairs = batchpairs[b];
+            int ib = heapi[batch[b]];
+            int jb = heapj[batch[b]];
+
+            for (int n = 0; n <= maxseq; n++) pairs[n] = 0;
+            accessfoldtracebackV(ib, jb, jb+N1+3, pairs, N1, N2, maxloop, V, Gp, ct3, data);
+            accessfoldtracebackVp(ib, jb, jb+N1+3, pairs, N1, N2, maxloop, Vp, Gp, ct3, data);
+          }
+          next = 0;
+        }
+
         ct3->AddStructure();
 		//if (ct3->GetNumberofStructures()==1) {
 		//	ct3->SetCtLabel(ct3->GetSequenceLabel(),1);
 		//}
 		//ct3->numofstructures++;
         //ct3->checknumberofstructures();        
-        jct3 = jret + N1 + 3;
 
 		//reset all pairs in the current structure to zero
         //for (i = 0; i <= maxseq; i++) {
@@ -1064,9 +1207,10 @@ void accessfold(structure *ct1, structure *ct2, structure *ct3, int maxloop, int
         //}
 		ct3->CleanStructure(ct3->GetNumberofStructures());
         
-        //perform traceback
-        accessfoldtracebackV(iret, jret, jct3, ct3->GetNumberofStructures(), N1, N2, maxloop, V, Gp, ct3, data);
-        accessfoldtracebackVp(iret, jret, jct3, ct3->GetNumberofStructures(), N1, N2, maxloop, Vp, Gp, ct3, data);
+        //copy the traceback
+        for (k1 = 1; k1 <= maxseq; k1++) {
+          if (k1 < batchpairs[next][k1]) ct3->SetPair(k1, batchpairs[next][k1], ct3->GetNumberofStructures());
+        }
       
         //ct3->energy[ct3->numofstructures] = (int) energy[cntr];
 		ct3->SetEnergy(ct3->GetNumberofStructures(),(int) energy[cntr]);
@@ -1084,7 +1228,7 @@ void accessfold(structure *ct1, structure *ct2, structure *ct3, int maxloop, int
           if (k1 < (ct3->GetPair(k1,ct3->GetNumberofStructures()))) {
             mark[k1][ct3->GetPair(k1,ct3->GetNumberofStructures())] = true;
             if (windowsize > 0) {
-              for (k2 = max(1, k1 - windowsize); k2 <= min(maxseq, k1 + windowsize); k2++) {
+              for (k2 = max(1, k1 - windowsize); k2 <= min(N1, k1 + windowsize); k2++) {
                 for (k3 = max(k2, (ct3->GetPair(k1,ct3->GetNumberofStructures() - windowsize))); k3 <= min(maxseq, (ct3->GetPair(k1,ct3->GetNumberofStructures() + windowsize))); k3++) {
                       
                       mark[k2][k3] = true;
@@ -1106,18 +1250,18 @@ void accessfold(structure *ct1, structure *ct2, structure *ct3, int maxloop, int
       }
     }
         
-    de_allocate (mark, maxseq+1);
+    for (b = 0; b < batchsize; b++) delete[] batchpairs[b];
+    delete[] batchpairs;
+    delete[] batch;
+    de_allocate (mark, N1+1);
     delete[] energy;
     delete[] heapi;
     delete[] heapj;
     
   //}
     
-    for (int l = 0; l <= N1; l++) {
-      delete[] V[l];
-      delete[] Vp[l];
-    }
-    
+    delete[] V[0];
+    delete[] Vp[0];
     delete[] V;
     delete[] Vp;
 
@@ -1130,7 +1274,7 @@ void accessfold(structure *ct1, structure *ct2, structure *ct3, int maxloop, int
 
 
 
-void accessfoldtracebackV(int i, int j, int jct3, int k, int N1, int N2, int maxloop, double **V, double *Gp, structure *ct3, datatable *data) {
+void accessfoldtracebackV(int i, int j, int jct3, int *pairs, int N1, int N2, int maxloop, double **V, double *Gp, structure *ct3, datatable *data) {
   
   bool done, found;
   int jpct3, ip, jp;
@@ -1142,9 +1286,8 @@ void accessfoldtracebackV(int i, int j, int jct3, int k, int N1, int N2, int max
   while (!done) {
 
     //register the current base pair and find the next, if there are any
-     //ct3->basepr[k][i] = jct3;
-     //ct3->basepr[k][jct3] = i;
-	 ct3->SetPair(i,jct3,k);
+     pairs[i] = jct3;
+     pairs[jct3] = i;
       
 	 
 	 
@@ -1225,7 +1368,7 @@ void accessfoldtracebackV(int i, int j, int jct3, int k, int N1, int N2, int max
 	}//end while !done
 }
       
-void accessfoldtracebackVp(int i, int j, int jct3, int k, int N1, int N2, int maxloop, double **Vp, double *Gp, structure *ct3, datatable *data) { 
+void accessfoldtracebackVp(int i, int j, int jct3, int *pairs, int N1, int N2, int maxloop, double **Vp, double *Gp, structure *ct3, datatable *data) { 
   
   bool done, found;
   int jpct3, ip, jp;
@@ -1237,9 +1380,8 @@ void accessfoldtracebackVp(int i, int j, int jct3, int k, int N1, int N2, int ma
   while (!done) {
     
     //record the current base pair and then go look for the next
-    //ct3->basepr[k][i] = jct3;
-    //ct3->basepr[k][jct3] = i;
-	ct3->SetPair(i,jct3,k);
+    pairs[i] = jct3;
+    pairs[jct3] = i;
     
 	if (i!=1&&j!=N2) {
 		if(Vp[i][j] == data->tstack[ct3->numseq[jct3]][ct3->numseq[i]][ct3->numseq[jct3+1]][ct3->numseq[i-1]] + penalty(jct3, i, ct3, data) - Gp[i] - Gp[jct3]) {
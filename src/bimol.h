@@ -11,6 +11,11 @@
 void bimol(structure *ct1, structure *ct2, structure *ct3, int maxloop, int maxtracebacks, int percent, int windowsize, 
            datatable *data);
 
+//prototype for bimolbatch, which uses bimol to fold one target sequence, ct1, with each of a number of query sequences, ct2[0] to ct2[queries-1].
+//ct3[q] receives the duplexes of the target with ct2[q].  The target and the parameters are shared by all of the queries.
+void bimolbatch(structure *ct1, structure **ct2, structure **ct3, int queries, int maxloop, int maxtracebacks, int percent, int windowsize,
+           datatable *data);
+
 //prototype for accessfold, bimolecular folding without intramolecular pairs, using a partition function heuristic to model accessibility to binding.
 void accessfold(structure *ct1, structure *ct2, structure *ct3, int maxloop, int maxtracebacks, int percent, int windowsize, 
            datatable *data, double gamma, bool IsRNA, double temperature );
@@ -14,7 +14,12 @@
 inline PFPRECISION boltzman(double i, PFPRECISION temp) {
 
 	if (i==INFINITE_ENERGY) return 0;
+#ifdef LOG_DOUBLE
+	//log_double cannot hold the negative exponent, so the factor is made from its log directly
+	else return log_double::fromlog((-i/((double)conversionfactor))/(RKC*(double) temp));
+#else
 	else return exp((-((PFPRECISION) i)/((PFPRECISION)conversionfactor))/(RKC*temp));
+#endif //LOG_DOUBLE
 
 }
 #endif
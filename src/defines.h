@@ -34,8 +34,15 @@
 #define DUBLE 8 //corruption of DOUBLE because Visual Studio uses DOUBLE
 #define INTER 16
 #define scalingdefinition 0.6 //0.6  //per nuc scale in partition function
-#define PFPRECISION double//This is the precision used by partition functions (extended_double is a second option)
-//#define EXTENDED_DOUBLE //If precision is defined as extended_double, also #define EXTENDED_DOUBLE
+//#define EXTENDED_DOUBLE //Define EXTENDED_DOUBLE to use extended_double as the precision of partition functions,
+//#define LOG_DOUBLE //or LOG_DOUBLE to use log_double.  Either can also be set with -D (see PFPRECISIONFLAG in compiler.h).
+#if defined(EXTENDED_DOUBLE)
+#define PFPRECISION extended_double
+#elif defined(LOG_DOUBLE)
+#define PFPRECISION log_double
+#else
+#define PFPRECISION double//This is the precision used by partition functions (extended_double and log_double are other options)
+#endif
 #define PFMAX 1e300  //maximum size of storage variable in partition function
 #define	PFMIN 1e-300 //minimum size of storage variable
 #define EPSILON 1e-300 //estimate of machine precision
@@ -73,7 +80,7 @@
 //#define "DIGITS" "%.2f"
 
 #define safiversion 3//version is the save file version for single sequences
-#define pfsaveversion 4//this is the version of save file format for partition functions
+#define pfsaveversion 5//this is the version of save file format for partition functions
 #define T37inK 310.15//37 degrees C in Kelvin
 
 
@@ -443,7 +443,7 @@ void dynforcepairg(int x,structure *ct,char **fce) {
 
 void dynalignforce(structure *ct1, structure *ct2/*, short ****fce*/, char **fce1, char **fce2, bool *dbl1,
                    bool *dbl2, bool *mod1, bool *mod2) {
-  int count;
+  int count,five,three;
   //fill the fce array for a dynalign calculation using the following key:
 
   //SINGLE applies to any fce(i,j) s.t. i or j should be single stranded
@@ -516,21 +516,27 @@ void dynalignforce(structure *ct1, structure *ct2/*, short ****fce*/, char **fce
 
   }
 
-  //now handle prohibited base pairs
+  //now handle prohibited base pairs, which can be given in either order
   for (count=0;count<ct1->GetNumberofForbiddenPairs();++count) {
-    fce1[jref(ct1->GetForbiddenPair5(count),ct1->GetForbiddenPair3(count),ct1->GetSequenceLength())][iref(ct1->GetForbiddenPair5(count),ct1->GetForbiddenPair3(count),ct1->GetSequenceLength())]=
-      fce1[jref(ct1->GetForbiddenPair5(count),ct1->GetForbiddenPair3(count),ct1->GetSequenceLength())][iref(ct1->GetForbiddenPair5(count),ct1->GetForbiddenPair3(count),ct1->GetSequenceLength())]|NOPAIR;
+    five = min(ct1->GetForbiddenPair5(count),ct1->GetForbiddenPair3(count));
+    three = max(ct1->GetForbiddenPair5(count),ct1->GetForbiddenPair3(count));
 
-    fce1[jref(ct1->GetForbiddenPair3(count),ct1->GetForbiddenPair5(count)+ct1->GetSequenceLength(),ct1->GetSequenceLength())][iref(ct1->GetForbiddenPair3(count),ct1->GetForbiddenPair5(count)+ct1->GetSequenceLength(),ct1->GetSequenceLength())]=
-      fce1[jref(ct1->GetForbiddenPair3(count),ct1->GetForbiddenPair5(count)+ct1->GetSequenceLength(),ct1->GetSequenceLength())][iref(ct1->GetForbiddenPair3(count),ct1->GetForbiddenPair5(count)+ct1->GetSequenceLength(),ct1->GetSequenceLength())]|NOPAIR;
+    fce1[jref(five,three,ct1->GetSequenceLength())][iref(five,three,ct1->GetSequenceLength())]=
+      fce1[jref(five,three,ct1->GetSequenceLength())][iref(five,three,ct1->GetSequenceLength())]|NOPAIR;
+
+    fce1[jref(three,five+ct1->GetSequenceLength(),ct1->GetSequenceLength())][iref(three,five+ct1->GetSequenceLength(),ct1->GetSequenceLength())]=
+      fce1[jref(three,five+ct1->GetSequenceLength(),ct1->GetSequenceLength())][iref(three,five+ct1->GetSequenceLength(),ct1->GetSequenceLength())]|NOPAIR;
   }
 
   for (count=0;count<ct2->GetNumberofForbiddenPairs();++count) {
-    fce2[jref(ct2->GetForbiddenPair5(count),ct2->GetForbiddenPair3(count),ct2->GetSequenceLength())][iref(ct2->GetForbiddenPair5(count),ct2->GetForbiddenPair3(count),ct2->GetSequenceLength())]=
-      fce1[jref(ct2->GetForbiddenPair5(count),ct2->GetForbiddenPair3(count),ct2->GetSequenceLength())][iref(ct2->GetForbiddenPair5(count),ct2->GetForbiddenPair3(count),ct2->GetSequenceLength())]|NOPAIR;
+    five = min(ct2->GetForbiddenPair5(count),ct2->GetForbiddenPair3(count));
+    three = max(ct2->GetForbiddenPair5(count),ct2->GetForbiddenPair3(count));
+
+    fce2[jref(five,three,ct2->GetSequenceLength())][iref(five,three,ct2->GetSequenceLength())]=
+      fce2[jref(five,three,ct2->GetSequenceLength())][iref(five,three,ct2->GetSequenceLength())]|NOPAIR;
 
-    fce2[jref(ct2->GetForbiddenPair3(count),ct2->GetForbiddenPair5(count)+ct2->GetSequenceLength(),ct2->GetSequenceLength())][iref(ct2->GetForbiddenPair3(count),ct2->GetForbiddenPair5(count)+ct2->GetSequenceLength(),ct2->GetSequenceLength())]=
-      fce1[jref(ct2->GetForbiddenPair3(count),ct2->GetForbiddenPair5(count)+ct2->GetSequenceLength(),ct2->GetSequenceLength())][iref(ct2->GetForbiddenPair3(count),ct2->GetForbiddenPair5(count)+ct2->GetSequenceLength(),ct2->GetSequenceLength())]|NOPAIR;
+    fce2[jref(three,five+ct2->GetSequenceLength(),ct2->GetSequenceLength())][iref(three,five+ct2->GetSequenceLength(),ct2->GetSequenceLength())]=
+      fce2[jref(three,five+ct2->GetSequenceLength(),ct2->GetSequenceLength())][iref(three,five+ct2->GetSequenceLength(),ct2->GetSequenceLength())]|NOPAIR;
   }
 
   //now handle chemical modification
@@ -559,13 +565,13 @@ int dynalign(structure *ct1, structure *ct2, short **alignment,
 	     short int maxseparation, short int islope, short int iintercept, short int gapincrease, datatable *data,
 	     short maxtracebacks, short window, short awindow, short percentsort, short **forcealign,int max_elongation,
 	     bool **allowed_alignments, TProgressDialog *progress, const char *Savefile, bool energyonly,
-	     bool local, bool forced, short int numProcessors)
+	     bool local, bool forced, short int numProcessors, double maxmemory, double *plannedmemory)
 #else
 int dynalign(structure *ct1, structure *ct2, short **alignment,
 	     short int maxseparation, short int gapincrease, datatable *data,
 	     bool singleinsert, short maxtracebacks, short window, short awindow, short percentsort, short **forcealign,
 	     bool **allowed_alignments, TProgressDialog *progress, const char *Savefile, bool energyonly,
-	     bool local, bool forced, short int numProcessors)
+	     bool local, bool forced, short int numProcessors, double maxmemory, double *plannedmemory)
 #endif
 
  {
@@ -653,6 +659,10 @@ int dynalign(structure *ct1, structure *ct2, short **alignment,
   bool alignmentforced;
 
 
+  //the memory planned for the arrays, and whether each 4-d array is put in a spill file
+  double vmemory,wmemory,vmodmemory,planned;
+  bool spillv,spillw,spillvmod;
+
   short crit;
   crit = DYNALIGN_INFINITY;
 
@@ -704,12 +714,41 @@ int dynalign(structure *ct1, structure *ct2, short **alignment,
 
   }
 
+  //Plan the memory for the 2-d and 4-d arrays, in megabytes.
+  //If the arrays need more than maxmemory, put vmod, which is only used for chemically modified nucleotides,
+  //then w, then v in spill files until the rest fit.
+  vmemory = varray::storagesize(N,lowend,highend,ct1->tem,energyonly)*(sizeof(integersize)/1048576.0);
+  wmemory = dynalignarray::storagesize(N,lowend,highend,energyonly)*(sizeof(integersize)/1048576.0);
+  if (forced&&(ct1->GetNumberofModified()>0||ct2->GetNumberofModified()>0))
+    vmodmemory = dynalignarray::storagesize(N,lowend,highend)*(sizeof(integersize)/1048576.0);
+  else vmodmemory = 0;
+  planned = vmemory+wmemory+vmodmemory+2*(N+2)*(N2+4)*(sizeof(integersize)/1048576.0);
+
+  spillv = false;
+  spillw = false;
+  spillvmod = false;
+  if (maxmemory>0) {
+    if (planned>maxmemory&&vmodmemory>0) {
+      spillvmod = true;
+      planned -= vmodmemory;
+    }
+    if (planned>maxmemory) {
+      spillw = true;
+      planned -= wmemory;
+    }
+    if (planned>maxmemory) {
+      spillv = true;
+      planned -= vmemory;
+    }
+  }
+  if (plannedmemory!=NULL) *plannedmemory = planned;
+
   //Allocate the 2-d and 4-d arrays for storing mfe's for subfragments:
   w5 = new wendarray(N,N2,lowend,highend);
   w3 = new wendarray(N,N2,lowend,highend);
 
-  v = new varray(N,N2,lowend,highend,ct1->tem,energyonly);
-  w = new dynalignarray(N,N2,lowend,highend,energyonly);
+  v = new varray(N,N2,lowend,highend,ct1->tem,energyonly,spillv);
+  w = new dynalignarray(N,N2,lowend,highend,energyonly,spillw);
   //report to Dave1
   
   // structure *ct=new structure();
@@ -871,7 +910,7 @@ int dynalign(structure *ct1, structure *ct2, short **alignment,
     if (ct1->GetNumberofModified()>0||ct2->GetNumberofModified()>0) {
       modification = true;
       //For chemical modification, a second v array, vmod is required
-      vmod = new dynalignarray(N,N2,lowend,highend);
+      vmod = new dynalignarray(N,N2,lowend,highend,false,spillvmod);
 
     }
     else {
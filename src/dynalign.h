@@ -127,6 +127,12 @@ void dynalignforce(structure *ct1, structure *ct2,
  *
  * allowed_alignments is a bool array that summarizes the allowed nucleotide alignments between the two sequences.
  *
+ * maxmemory is the most memory, in megabytes, that the fill arrays can use.  If they need more,
+ * vmod, then w, then v are put in temporary spill files, which the operating system pages to disk
+ * as needed, until the rest fit.  The results are the same either way.  0, the default, is no limit.
+ *
+ * plannedmemory, if not NULL, receives the memory in megabytes planned for the arrays kept in memory.
+ *
  *Return an error code that indicates whether an error occured.  (0=no error, 14=traceback error). 
  *
  */
@@ -135,13 +141,15 @@ int dynalign(structure *ct1, structure *ct2, short **alignment,
              short int maxseparation, short int islope, short int iintercept, short int gapincrease, datatable *data, 
               short maxtracebacks, short window, short awindow, short percentsort, short **forcealign, int max_elongation,bool **allowed_alignments=NULL, 
               TProgressDialog *progress=NULL, const char *Savefile=NULL,
-              bool energyonly = false, bool local = false, bool force = false, short numProcessors = 1);
+              bool energyonly = false, bool local = false, bool force = false, short numProcessors = 1,
+              double maxmemory = 0, double *plannedmemory = NULL);
 #else
 int dynalign(structure *ct1, structure *ct2, short **alignment,
               short int maxseparation, short int gapincrease, datatable *data, bool singleinsert, 
               short maxtracebacks, short window, short awindow, short percentsort, short **forcealign, bool **allowed_alignments=NULL, 
               TProgressDialog *progress=NULL, const char *Savefile=NULL,
-              bool energyonly = false, bool local = false, bool force = false, short numProcessors = 1);
+              bool energyonly = false, bool local = false, bool force = false, short numProcessors = 1,
+              double maxmemory = 0, double *plannedmemory = NULL);
 #endif
 //calculate a single point in the v and w arrays -- allowing constraints if force is true
 
@@ -10,6 +10,8 @@
 
 #include "defines.h"
 
+class mappedfile;
+
 // This class encapsulates the large 4-dimensional arrays used
 // by Dynalign
 
@@ -22,12 +24,28 @@ class dynalignarray {
   bool optimalonly;
   short infinite;
 
+  // The whole array is one block of storage.  The (i,j) planes are
+  // laid out one after the other, each holding its k rows of width[j]
+  // entries, so element (i,j,k,l) is plane[i][j][k*width[j]+l].
+  // plane[i] is a row of the planes array, and the plane pointers are
+  // shifted back so that j, k, and l index them directly.
+  integersize *storage;
+  mappedfile *spillfile; // the temporary file that holds storage, or NULL if storage is in memory
+  integersize **planes;
+  integersize ***plane;
+  long *width;
+
 	public:
-		integersize ****array;
-		dynalignarray(short n1, short n2, short *lowlimit, short *highlimit, bool Optimalonly=false);
+		// spill puts the array in a temporary file that the operating
+		// system pages in and out as needed, instead of in memory
+		dynalignarray(short n1, short n2, short *lowlimit, short *highlimit, bool Optimalonly=false, bool spill=false);
 		dynalignarray();
 		~dynalignarray();
-		void allocate(short n1, short n2, short *lowlimit, short *highlimit, bool Optimalonly=false);
+		void allocate(short n1, short n2, short *lowlimit, short *highlimit, bool Optimalonly=false, bool spill=false);
+
+		// Return the number of entries that allocate() stores for these
+		// arguments.
+		static long storagesize(short n1, short *lowlimit, short *highlimit, bool Optimalonly=false);
 		integersize &f(short i, short j,short k, short l);
 };
 
@@ -38,7 +56,7 @@ inline integersize &dynalignarray::f(short i, short j,short k, short l) {
     k -= N2;
     l -= N2;
   }
-  return array[i][j][k][l];
+  return plane[i][j][k*width[j]+l];
 }
 
 #endif
@@ -31,6 +31,10 @@ Removed folding when break local structure is used.
 #include <cstdlib>
 #include <cstring>
 
+#ifdef SMP
+#include <omp.h>
+#endif
+
 //define the parameters for alltrace()
 #define percent 100	//100% of the suboptimal structure windows
 #define delta 6	//only the suboptimal structures having energy less than 2.8kcal/mol higher than optimal one
@@ -50,6 +54,21 @@ int readrd (rddata* data,char* dnarna);
 inline void scancopy(OligoPclass *region, OligoPclass *copyregion);
 inline void scancopyend(OligoPclass *region, OligoPclass *copyregion) ;
 
+//allocate the oligo structures: oligo for the intermolecular and oligo1 for the intramolecular structure
+void allocateoligo(structure *oligo, structure *oligo1, int length);
+//fill table[i][1] and table[i][5], the duplex free energy and Tm of the oligo at position i
+void duplexenergy(bool isdna, structure *ct, int i, int length, double c, int **table,
+		  datatable& data, rddata *hybriddata, thermo* helixstack);
+//fill table[i][0], the overall free energy of binding, from the other energies at position i
+void overallenergy(int i, double c, int **table);
+
+#ifdef SMP
+//scan the target for option 2 with the partition function of the whole target (Usesub 2, foldsize 0) in parallel
+void refillscan(bool isdna, structure *ct, int length, double c, int **table, datatable& data, rddata *hybriddata,
+		  TProgressDialog *update, thermo* helixstack, int start, int stop, siPREFILTER *prefilter, int *TEST, bool WRITE,
+		  OligoPclass *target, pfdatatable *pfdata, pfdatatable *dpfdata, PFPRECISION Q);
+#endif
+
 
 /*=======================================================================
 oligo fills the array table with thermodynamic data for each oligo (2nd dimension)
@@ -91,10 +110,8 @@ void olig(bool isdna, int option, structure *ct, int length,double c, int **tabl
 	int i,j,k;
 	int ip,jp;
 	int foldstart, foldstop;
-	int dh,ds,dgeff;
 	int *energyarray, *ctenergy;//ctenergy is the energy array to store structure energies from alltrace()
 	int numofstructures;
-	long double k1b,k1u;
 	long double fn,sn,sum;
 	char savefile[250],pfsfile[250],pos[250];
 	int energy=INFINITE_ENERGY;//to store the free energy of lowest free energy structure
@@ -104,6 +121,7 @@ void olig(bool isdna, int option, structure *ct, int length,double c, int **tabl
 	PFPRECISION Q,Qc,Qolig,pftemp=310.15;//store partion function without and with constrains
 	PFPRECISION rescaleinrefill;//rescaling facor for Qc relative to Q
 	pfdatatable *pfdata,*dpfdata;  //store the data tables for partionfunction
+	pfdatatable *unscaledpfdata=NULL,*unscaleddpfdata=NULL;//the data tables before the scan, for option 2 with refill
 	OligoPclass *interoligo,*intraoligo;
 	OligoPclass *target,*targetcopy,*targettemp;
 	structure *oligo,*oligo1;//to store the structural info for the oligo
@@ -129,21 +147,9 @@ void olig(bool isdna, int option, structure *ct, int length,double c, int **tabl
 	//oligo1: intramolecular structure   aaguc
 	oligo = new structure();
 	oligo1 = new structure();
-
-	oligo->allocate(2*length+3);
-	oligo1->allocate(length);
+	allocateoligo(oligo,oligo1,length);
 
 	string label;
-	label = "Oligo_inter";
-
-	oligo->SetSequenceLabel(label);
-
-	label = "Oligo_intra";
-
-	oligo1->SetSequenceLabel(label);
-
-	
-	for (j=1;j<=3;j++) {		oligo->inter[j-1] = length + j;	}
 
 	foldsize= foldsize/2*2; // a trick to make foldsize even
 	//----------------------------------------------------------------------------------------------
@@ -437,6 +443,20 @@ void olig(bool isdna, int option, structure *ct, int length,double c, int **tabl
 	//------------------------------------------------------------------------------------------
 	//-------------------------------------------------------------------------------------------
 	//begin to scan the target from start to stop
+	//With refill, the data tables are restored after a position that rescaled them, as refillscan does,
+	//	so that each position starts from the same tables.
+	if (option==2&&Usesub==2&&foldsize==0) {
+		unscaledpfdata = new pfdatatable(*pfdata);
+		if (isdna) unscaleddpfdata = new pfdatatable(*dpfdata);
+	}
+#ifdef SMP
+	//refolding the whole target from the arrays stored by partition4refill is independent at each position,
+	//so these scans are done in parallel
+	if (option==2&&Usesub==2&&foldsize==0)
+		refillscan(isdna,ct,length,c,table,data,hybriddata,update,helixstack,start,stop,prefilter,TEST,WRITE,
+			target,pfdata,isdna?dpfdata:NULL,Q);
+	else
+#endif
 	for (i=start; i<=stop; ++i) {
 
 		
@@ -1134,49 +1154,7 @@ void olig(bool isdna, int option, structure *ct, int length,double c, int **tabl
 		//-----------------------------------------------------------------------------------------------------
 		//-----------------------------------------------------------------------------------------------------
 		//calculate the stability of the hybrid duplex
-		
-		//oligo is DNA:
-		if (isdna) {
-			
-			table[i][1] = hybriddata->init;//initiation
-			for (j=0;j<(length-1);j++) {
-			
-				table[i][1] += 
-					hybriddata->stack[ct->numseq[i+j]][complement(i+j,ct)][ct->numseq[i+j+1]][complement(i+j+1,ct)];
-			}
-		}
-
-		//oligo is RNA:
-		else {
-			table[i][1] = data.init;//initiation
-      		for (j=0;j<(length-1);j++) {
-          		table[i][1] += 
-					data.stack[ct->numseq[i+j]][complement(i+j,ct)][ct->numseq[i+j+1]][complement(i+j+1,ct)];
-			 }
-			//consider AU end effects for RNA/RNA duplexes
-			if (ct->numseq[i]==1||ct->numseq[i]==4) table[i][1]+=data.auend;
-			if (ct->numseq[i+length-1]==1||ct->numseq[i+length-1]==4) table[i][1]+=data.auend;
-
-		}
-
-		//calculate the Tm of the duplex
-		ds = helixstack->dsi;
-		dh = helixstack->dhi;
-		for (j=0;j<(length-1);j++) {
-	  		dh +=helixstack->dh[ct->numseq[i+j]][complement(i+j,ct)][ct->numseq[i+j+1]][complement(i+j+1,ct)];
-			ds +=helixstack->ds[ct->numseq[i+j]][complement(i+j,ct)][ct->numseq[i+j+1]][complement(i+j+1,ct)];
-   		}
-		if (ct->numseq[i]==1||ct->numseq[i]==4) {
-			dh = dh + helixstack->dha;
-			ds = ds + helixstack->dsa;
-		}
-		if (ct->numseq[i+length-1]==1||ct->numseq[i+length-1]==4) {
-			dh = dh + helixstack->dha;
-			ds = ds + helixstack->dsa;
-		}
-	      
-		table[i][5] = (int) ((conversionfactor*((double)dh*1000)/
-								((double)ds+conversionfactor*Rgas*log(c)))-273.15*conversionfactor);
+		duplexenergy(isdna,ct,i,length,c,table,data,hybriddata,helixstack);
 
 
 
@@ -1271,42 +1249,14 @@ void olig(bool isdna, int option, structure *ct, int length,double c, int **tabl
 		//-----------------------------------------------------------------------------------------
 		//-----------------------------------------------------------------------------------------
 		//calculate the overall free energy for the binding
-		k1b = exp(((-1)*(long double)(table[i][4]))/((1.9872)*(3.1)));
-		k1u = exp(((-1)*(long double)(table[i][3]))/((1.9872)*(3.1)));
-
-		//I don't know what's going on here.:)  ---John , Nov.9,2005
-		//if (i==867) {
-		//	table[0][0]=56;
-		//}
+		overallenergy(i,c,table);
 
-		if ((k1u/(c*k1b))<100) {
-
-      		dgeff = (int)(-((1.9872)*(3.1)*log(((4.0*k1b*(long double)(c))/(-1-k1u+sqrt(pow((long double)1.0+k1u,(long double) 2.0)
-							+8.0*k1b*(long double)(c))))-1.0)));
-		}
-		else {
-			dgeff = table[i][3];
-
-		}
-		//this line converts the free energy to the convention explained in
-		//the written version of the algorithm:
-		table[i][2] = -table[i][2];
-
-		if ((table[i][2]<0)&&(dgeff<0)) {
-	   		table[i][0] = table[i][1] + (int)((rt*conversionfactor)*log( (exp(-(long double)(table[i][2])/
-						  (rt*conversionfactor))+1.0)*  (exp(-(long double)(dgeff)/(rt*conversionfactor))+1.0) )+0.5);
-		}
-		else if (table[i][2]<0) {
-			table[i][0] = table[i][1] + (int)((rt*conversionfactor)*log( (exp(-(long double)(table[i][2])/
-						  (rt*conversionfactor))+1.0))+0.5);
-		}
-		else {
-			table[i][0] = table[i][1] + (int)((rt*conversionfactor)*log(  (exp(-(long double)(dgeff)/
-						  (rt*conversionfactor))+1.0) )+0.5);
+		//restore the data tables if they were rescaled
+		if (unscaledpfdata!=NULL) {
+			if (rescaleinrefill!=(PFPRECISION) 1||pfdata->scaling!=unscaledpfdata->scaling) *pfdata = *unscaledpfdata;
+			if (isdna&&dpfdata->scaling!=unscaleddpfdata->scaling) *dpfdata = *unscaleddpfdata;
 		}
 
-		//table[i][0] = table[i][1] + table[i][2] - dgeff;
-
 	}//end of main loop over all oligonucleotides
 	//The scan is finished now
 	//-------------------------------------------------------------------------------------------------------
@@ -1318,6 +1268,9 @@ void olig(bool isdna, int option, structure *ct, int length,double c, int **tabl
 	//clean up the ct file
 	ct->SetEnergy(1,energy) ;
 
+	delete unscaledpfdata;
+	delete unscaleddpfdata;
+
 	//clean up memory use
 	if (option==1) {
 		if (Usesub==3 && foldsize==0) {
@@ -1357,6 +1310,291 @@ void olig(bool isdna, int option, structure *ct, int length,double c, int **tabl
 }
 
 
+//=======================================================================
+//allocate the oligo structures: oligo for the intermolecular and oligo1 for the intramolecular structure
+//oligo:  intermolecular structure   aagucXXXggcaa
+//oligo1: intramolecular structure   aaguc
+void allocateoligo(structure *oligo, structure *oligo1, int length) {
+
+	int j;
+	string label;
+
+	oligo->allocate(2*length+3);
+	oligo1->allocate(length);
+
+	label = "Oligo_inter";
+
+	oligo->SetSequenceLabel(label);
+
+	label = "Oligo_intra";
+
+	oligo1->SetSequenceLabel(label);
+
+	
+	for (j=1;j<=3;j++) {		oligo->inter[j-1] = length + j;	}
+}
+
+
+//=======================================================================
+//fill table[i][1] and table[i][5], the duplex free energy and Tm of the oligo at position i
+void duplexenergy(bool isdna, structure *ct, int i, int length, double c, int **table,
+		  datatable& data, rddata *hybriddata, thermo* helixstack) {
+
+	int j;
+	int dh,ds;
+	
+	//oligo is DNA:
+	if (isdna) {
+		
+		table[i][1] = hybriddata->init;//initiation
+		for (j=0;j<(length-1);j++) {
+		
+			table[i][1] += 
+				hybriddata->stack[ct->numseq[i+j]][complement(i+j,ct)][ct->numseq[i+j+1]][complement(i+j+1,ct)];
+		}
+	}
+
+	//oligo is RNA:
+	else {
+		table[i][1] = data.init;//initiation
+      		for (j=0;j<(length-1);j++) {
+          		table[i][1] += 
+				data.stack[ct->numseq[i+j]][complement(i+j,ct)][ct->numseq[i+j+1]][complement(i+j+1,ct)];
+		 }
+		//consider AU end effects for RNA/RNA duplexes
+		if (ct->numseq[i]==1||ct->numseq[i]==4) table[i][1]+=data.auend;
+		if (ct->numseq[i+length-1]==1||ct->numseq[i+length-1]==4) table[i][1]+=data.auend;
+
+	}
+
+	//calculate the Tm of the duplex
+	ds = helixstack->dsi;
+	dh = helixstack->dhi;
+	for (j=0;j<(length-1);j++) {
+  		dh +=helixstack->dh[ct->numseq[i+j]][complement(i+j,ct)][ct->numseq[i+j+1]][complement(i+j+1,ct)];
+		ds +=helixstack->ds[ct->numseq[i+j]][complement(i+j,ct)][ct->numseq[i+j+1]][complement(i+j+1,ct)];
+   		}
+	if (ct->numseq[i]==1||ct->numseq[i]==4) {
+		dh = dh + helixstack->dha;
+		ds = ds + helixstack->dsa;
+	}
+	if (ct->numseq[i+length-1]==1||ct->numseq[i+length-1]==4) {
+		dh = dh + helixstack->dha;
+		ds = ds + helixstack->dsa;
+	}
+      
+	table[i][5] = (int) ((conversionfactor*((double)dh*1000)/
+							((double)ds+conversionfactor*Rgas*log(c)))-273.15*conversionfactor);
+
+}
+
+
+//=======================================================================
+//fill table[i][0], the overall free energy of binding, from the other energies at position i
+void overallenergy(int i, double c, int **table) {
+
+	int dgeff;
+	long double k1b,k1u;
+
+	k1b = exp(((-1)*(long double)(table[i][4]))/((1.9872)*(3.1)));
+	k1u = exp(((-1)*(long double)(table[i][3]))/((1.9872)*(3.1)));
+
+	//I don't know what's going on here.:)  ---John , Nov.9,2005
+	//if (i==867) {
+	//	table[0][0]=56;
+	//}
+
+	if ((k1u/(c*k1b))<100) {
+
+      		dgeff = (int)(-((1.9872)*(3.1)*log(((4.0*k1b*(long double)(c))/(-1-k1u+sqrt(pow((long double)1.0+k1u,(long double) 2.0)
+						+8.0*k1b*(long double)(c))))-1.0)));
+	}
+	else {
+		dgeff = table[i][3];
+
+	}
+	//this line converts the free energy to the convention explained in
+	//the written version of the algorithm:
+	table[i][2] = -table[i][2];
+
+	if ((table[i][2]<0)&&(dgeff<0)) {
+   		table[i][0] = table[i][1] + (int)((rt*conversionfactor)*log( (exp(-(long double)(table[i][2])/
+					  (rt*conversionfactor))+1.0)*  (exp(-(long double)(dgeff)/(rt*conversionfactor))+1.0) )+0.5);
+	}
+	else if (table[i][2]<0) {
+		table[i][0] = table[i][1] + (int)((rt*conversionfactor)*log( (exp(-(long double)(table[i][2])/
+					  (rt*conversionfactor))+1.0))+0.5);
+	}
+	else {
+		table[i][0] = table[i][1] + (int)((rt*conversionfactor)*log(  (exp(-(long double)(dgeff)/
+					  (rt*conversionfactor))+1.0) )+0.5);
+	}
+
+	//table[i][0] = table[i][1] + table[i][2] - dgeff;
+
+}
+
+
+#ifdef SMP
+//=======================================================================
+/*
+refillscan does the scan of olig() for option 2 with the partition function of the
+whole target (Usesub 2, foldsize 0) in parallel.
+Each refill starts from the arrays that target stored in partition4refill, so the
+positions are independent.  Each thread takes a contiguous range of positions, with
+its own copies of the target sequence and the data tables, its own oligo structures
+and partition function classes, and an OligoPclass that shares the stored arrays of
+target.  A thread writes only the rows of table for its own positions.
+The data tables of a thread are restored from pfdata and dpfdata after a position that
+rescaled them, so that the results do not depend on the number of threads.
+*/
+void refillscan(bool isdna, structure *ct, int length, double c, int **table, datatable& data, rddata *hybriddata,
+		  TProgressDialog *update, thermo* helixstack, int start, int stop, siPREFILTER *prefilter, int *TEST, bool WRITE,
+		  OligoPclass *target, pfdatatable *pfdata, pfdatatable *dpfdata, PFPRECISION Q) {
+
+	#pragma omp parallel
+	{
+		int i,j,first,last;
+		int thread,threads;
+		char pfsfile[250],pos[250];
+		PFPRECISION Qc,Qolig;
+		PFPRECISION rescaleinrefill;
+		pfdatatable *threadpfdata,*threaddpfdata,*oligopfdata;
+		structure *threadct,*oligo,*oligo1;
+		OligoPclass *threadtarget,*intraoligo,*interoligo;
+
+		thread = omp_get_thread_num();
+		threads = omp_get_num_threads();
+		first = start + (stop-start+1)*thread/threads;
+		last = start + (stop-start+1)*(thread+1)/threads - 1;
+
+		//copy the target sequence, which is constrained differently by each thread
+		threadct = new structure();
+		threadct->allocate(ct->GetSequenceLength());
+		threadct->SetSequenceLabel(ct->GetSequenceLabel());
+		for (j=0;j<=2*ct->GetSequenceLength();j++) threadct->numseq[j] = ct->numseq[j];
+		for (j=1;j<=ct->GetSequenceLength();j++) {
+			threadct->hnumber[j] = ct->hnumber[j];
+			threadct->nucs[j] = ct->nucs[j];
+		}
+		if (ct->DistanceLimited()) threadct->SetPairingDistance(ct->GetPairingDistanceLimit());
+		if (ct->shaped) {
+			threadct->shaped = true;
+			threadct->SHAPE = new double [2*ct->GetSequenceLength()+1];
+			threadct->SHAPEss = new double [2*ct->GetSequenceLength()+1];
+			for (j=0;j<=2*ct->GetSequenceLength();j++) {
+				threadct->SHAPE[j] = ct->SHAPE[j];
+				threadct->SHAPEss[j] = ct->SHAPEss[j];
+			}
+		}
+
+		oligo = new structure();
+		oligo1 = new structure();
+		allocateoligo(oligo,oligo1,length);
+
+		//the data tables are rescaled when the partition functions overflow, so each thread needs its own
+		threadpfdata = new pfdatatable(*pfdata);
+		if (isdna) {
+			threaddpfdata = new pfdatatable(*dpfdata);
+			oligopfdata = threaddpfdata;
+		}
+		else oligopfdata = threadpfdata;
+		threadtarget = new OligoPclass(threadct,threadpfdata,target);
+		intraoligo = new OligoPclass(oligo1,oligopfdata);
+		interoligo = new OligoPclass(oligo,oligopfdata);
+
+		for (i=first;i<=last;++i) {
+
+			//communicate progress from the first thread, which has the first range
+			if (update!=NULL&&thread==0) {
+   				update->update(int((double (i-start))*100/(double (last-start+1))));
+			}
+
+			//define the oligo sequence
+			for (j=1;j<=length;j++) {
+				oligo1->numseq[j] = complement(i+length-j,ct);
+				oligo->numseq[j] = complement(i+length-j,ct);
+			}
+			//prefiltering the functional siRNA
+			if (prefilter->useit != 0) {
+				//count() keeps intermediate results in prefilter
+				#pragma omp critical
+				prefilter->count(oligo1,i,TEST[i]);
+				if (prefilter->score[i] < FILTER_PASS) {
+					continue;
+				}
+			}
+
+			//calculate the free energy of breaking target structure by refolding with the binding site single stranded
+			threadct->RemoveConstraints();
+			for (j=0;j<length;j++) {
+				threadct->AddSingle(i+j);
+			}
+			if (WRITE) {
+				strcpy(pfsfile, ct->GetCtLabel(1).c_str());
+				pfsfile[strlen(pfsfile)-1]='\0'; 
+				sprintf(pos,"_%d",i);
+				strcat(pfsfile,pos);
+				strcat(pfsfile,"_s2_0_constrain.pfs");
+				threadtarget->refill(threadct,&Qc,i, i+length-1,rescaleinrefill,pfsfile);
+			}
+			else threadtarget->refill(threadct,&Qc,i, i+length-1,rescaleinrefill);
+
+			table[i][2] = (int)(conversionfactor*rt* 
+				( (long double)(threadct->GetSequenceLength())*log(rescaleinrefill) 
+				+ log((long double)Q/(long double)Qc) ) );
+
+			duplexenergy(isdna,ct,i,length,c,table,data,hybriddata,helixstack);
+
+			//calculate the free energy of intramolecular folding of oligo
+			intraoligo->reset4oligo(oligo1);
+			intraoligo->partition(true,&Qolig);
+			oligo1->SetEnergy(1,(int)( conversionfactor*rt*
+				((long double)length*log( (intraoligo->data)->scaling) - log((long double)Qolig)) ));
+			table[i][3] = oligo1->GetEnergy(1);
+			//if the intra structure is unfavorable , not consider it in the total energy
+			if (table[i][3]>0) {
+				table[i][3]=0;
+			}
+
+			//calculate the free energy of intermolecular folding of oligo
+			oligo->intermolecular = true;
+			for (j=1;j<=length;j++) {
+				oligo->numseq[j+length+3] = oligo->numseq[j];
+			}
+			for (j=1;j<=3;j++) {
+				oligo->numseq[length+j] = 5;
+			}
+			interoligo->reset4oligo(oligo);
+			interoligo->partition(true,&Qolig);
+			oligo->SetEnergy(1,(int)( conversionfactor*rt*
+				( (long double)(oligo->GetSequenceLength())*log((interoligo->data)->scaling)  - log((long double)Qolig) ) )) ;
+			table[i][4] = oligo->GetEnergy(1);
+			//if the intra structure is unfavorable , not consider it in the total energy
+			if (table[i][4]>0) {
+				table[i][4]=0;
+			}
+
+			overallenergy(i,c,table);
+
+			//restore the data tables if they were rescaled
+			if (rescaleinrefill!=(PFPRECISION) 1||threadpfdata->scaling!=pfdata->scaling) *threadpfdata = *pfdata;
+			if (isdna&&threaddpfdata->scaling!=dpfdata->scaling) *threaddpfdata = *dpfdata;
+		}
+
+		delete threadtarget;
+		delete intraoligo;
+		delete interoligo;
+		delete threadpfdata;
+		if (isdna) delete threaddpfdata;
+		delete threadct;
+		delete oligo;
+		delete oligo1;
+	}
+}
+#endif
+
+
 //=======================================================================
 int readrd (rddata* data,char* dnarna) {
 	
@@ -0,0 +1,191 @@
+
+
+//Log double class.  Stores the natural log of a non-negative number, so that the partition function
+//can be calculated for long sequences without overflow or underflow, and without the scaling
+//branches of extended_double on every operation.
+//A product is then the sum of the logs.  A sum uses the log-sum-exp, log(a+b) = max + log(1+exp(min-max)).
+//Zero is stored as -infinity.  Negative numbers cannot be represented; a difference that would be
+//negative (which, in the partition function, can only arise from roundoff) is stored as zero.
+//Define LOG_DOUBLE (see defines.h) to use this class as PFPRECISION.
+//Every sum outside the bifurcation kernels (see bifurcation.h) is a log-sum-exp of its own, with an exp and
+//	a log1p, so the partition function takes about twice as long as with double.
+
+//Add check so that the header is included only once:
+#ifndef LD_H
+#define LD_H
+
+
+#include <fstream>
+#include <iostream>
+#include <cmath>
+
+
+using namespace std;
+
+class log_double {
+
+public:
+
+	double lnvalue;  //the natural log of the value, -HUGE_VAL for zero
+
+
+	//constructors
+	log_double(){
+	}
+	log_double(const log_double& ld) {
+		lnvalue = ld.lnvalue;
+	}
+
+	log_double(const double& d) {
+		lnvalue = logof(d);
+	}
+
+	//Make a log_double directly from its natural log.  boltzman() uses this so that a
+	//	Boltzmann factor is never formed in double precision.
+	static log_double fromlog(const double &ln) {
+		log_double temp;
+		temp.lnvalue = ln;
+		return temp;
+	}
+
+	//the natural log of a double, with zero (or a negative, see above) as -HUGE_VAL
+	static double logof(const double &d) {
+		return (d>0)?log(d):-HUGE_VAL;
+	}
+
+	//log(exp(a)+exp(b))
+	static double logsum(const double &a, const double &b) {
+		double high = (a>b)?a:b;
+		double low = (a>b)?b:a;
+
+		//If the smaller term is zero, this also avoids -HUGE_VAL - -HUGE_VAL when both are zero.
+		if (low==-HUGE_VAL) return high;
+		return high + log1p(exp(low-high));
+	}
+
+	//log(exp(a)-exp(b)), or -HUGE_VAL if b is not less than a
+	static double logdifference(const double &a, const double &b) {
+		if (!(b<a)) return -HUGE_VAL;
+		return a + log1p(-exp(b-a));
+	}
+
+	//operators using various combinations of types of variables
+	log_double& operator=(const log_double &ld2) {
+		lnvalue = ld2.lnvalue;
+		return *this;
+	}
+	log_double& operator=(const double &ld2) {
+		lnvalue = logof(ld2);
+		return *this;
+	}
+	log_double& operator=(const long double &ld2) {
+		lnvalue = logof((double) ld2);
+		return *this;
+	}
+	const log_double& operator+=(const log_double &ld2) {
+		lnvalue = logsum(lnvalue,ld2.lnvalue);
+		return *this;
+	}
+	const log_double& operator+=(const double &ld2) {
+		lnvalue = logsum(lnvalue,logof(ld2));
+		return *this;
+	}
+
+	//type cast ##### this overflows to infinity if the number is too large for a double ####
+	operator double() const {
+		return exp(lnvalue);
+	}
+
+};
+
+
+inline log_double operator+(const log_double &ld1, const log_double &ld2) {
+	return log_double::fromlog(log_double::logsum(ld1.lnvalue,ld2.lnvalue));
+}
+inline log_double operator-(const log_double &ld1, const log_double &ld2) {
+	return log_double::fromlog(log_double::logdifference(ld1.lnvalue,ld2.lnvalue));
+}
+inline log_double operator*(const log_double &ld1, const log_double &ld2) {
+	return log_double::fromlog(ld1.lnvalue+ld2.lnvalue);
+}
+inline log_double operator/(const log_double &ld1, const log_double &ld2) {
+	return log_double::fromlog(ld1.lnvalue-ld2.lnvalue);
+}
+
+inline log_double operator+(const log_double &ld1, const double &ld2) {return ld1+log_double(ld2);}
+inline log_double operator+(const log_double &ld1, const long double &ld2) {return ld1+log_double((double) ld2);}
+inline log_double operator-(const log_double &ld1, const double &ld2) {return ld1-log_double(ld2);}
+inline log_double operator*(const log_double &ld1, const double &ld2) {return ld1*log_double(ld2);}
+inline log_double operator/(const log_double &ld1, const double &ld2) {return ld1/log_double(ld2);}
+inline log_double operator+(const double &ld1, const log_double &ld2) {return log_double(ld1)+ld2;}
+inline log_double operator-(const double &ld1, const log_double &ld2) {return log_double(ld1)-ld2;}
+inline log_double operator*(const double &ld1, const log_double &ld2) {return log_double(ld1)*ld2;}
+inline log_double operator/(const double &ld1, const log_double &ld2) {return log_double(ld1)/ld2;}
+
+//The comparisons are those of the logs, because log is increasing.
+inline bool operator<(const log_double &ld1, const log_double &ld2) {return ld1.lnvalue<ld2.lnvalue;}
+inline bool operator<(const log_double &ld1, const double &ld2) {return ld1<log_double(ld2);}
+inline bool operator<(const double &ld1, const log_double &ld2) {return log_double(ld1)<ld2;}
+
+inline bool operator>(const log_double &ld1, const log_double &ld2) {return ld2<ld1;}
+inline bool operator>(const log_double &ld1, const double &ld2) {return ld2<ld1;}
+inline bool operator>(const double &ld1, const log_double &ld2) {return ld2<ld1;}
+inline bool operator>(const log_double &ld1, const int &ld2) {return ld1>(double) ld2;}
+inline bool operator>(const log_double &ld1, const float &ld2) {return ld1>(double) ld2;}
+
+inline bool operator<=(const log_double &ld1, const log_double &ld2) {return !(ld1>ld2);}
+inline bool operator<=(const log_double &ld1, const double &ld2) {return !(ld1>ld2);}
+inline bool operator<=(const double &ld1, const log_double &ld2) {return !(ld1>ld2);}
+
+inline bool operator>=(const log_double &ld1, const log_double &ld2) {return ld2<=ld1;}
+inline bool operator>=(const log_double &ld1, const double &ld2) {return ld2<=ld1;}
+inline bool operator>=(const double &ld1, const log_double &ld2) {return ld2<=ld1;}
+
+inline bool operator==(const log_double &ld1, const log_double &ld2) {return ld1.lnvalue==ld2.lnvalue;}
+inline bool operator==(const log_double &ld1, const double &ld2) {return ld1==log_double(ld2);}
+inline bool operator==(const double &ld1, const log_double &ld2) {return log_double(ld1)==ld2;}
+
+//lets you cout a log double (ie cout << log_double), as mantissa e exponent
+inline ostream& operator <<(ostream & out, const log_double & ld){
+	if (ld.lnvalue==-HUGE_VAL) out << 0;
+	else {
+		double log10value = ld.lnvalue/log(10.0);
+		double exponent = floor(log10value);
+		out << pow(10.0,log10value-exponent) << "e" << exponent;
+	}
+	return out;
+}
+
+
+//overloaded read and write functions, which store the log
+void write(std::ofstream *out, double *i);
+void read(std::ifstream *out, double *i);
+inline void write(std::ofstream *out, log_double *i) {
+	write(out,&(i->lnvalue));
+}
+inline void read(std::ifstream *out, log_double *i) {
+	read(out,&(i->lnvalue));
+}
+
+//overloaded math functions
+inline log_double pow(const log_double &base, const int &power) {
+	if (power==0) return log_double(1.0);
+	return log_double::fromlog(base.lnvalue*power);
+}
+inline log_double pow(const log_double &base, const double &power) {
+	if (power==0) return log_double(1.0);
+	return log_double::fromlog(base.lnvalue*power);
+}
+inline double log10(const log_double &ld) {
+	return ld.lnvalue/log(10.0);
+}
+inline double log(const log_double &ld) {
+	return ld.lnvalue;
+}
+//exp of a log_double is the log_double whose log is that value
+inline log_double exp(const log_double &ld) {
+	return log_double::fromlog((double) ld);
+}
+
+
+#endif //LD_H
@@ -0,0 +1,149 @@
+#if !defined(MAPPEDFILE_H)
+#define MAPPEDFILE_H
+
+//mappedfile maps a whole file into memory, so that the file is read only as its pages are used.
+//The mapping is read only, or copy on write: then the pages can be written, but the changes are private to the
+//	process and never reach the file.
+//Used for the precompiled thermodynamic parameters and for partition function save files.
+//A mappedfile can also be scratch memory backed by a temporary file, so that the operating system can write
+//	pages that are not in use to the file instead of keeping them in memory.  Dynalign uses this for arrays
+//	beyond its memory limit.
+
+#include <cstddef>
+
+#ifdef _WIN32
+	#include <windows.h>
+#else
+	#include <cstdlib>
+	#include <string>
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+
+class mappedfile {
+	public:
+
+		//Map filename.  writable indicates a copy on write mapping.
+		//Check good() to see if the file was mapped; an empty file is not.
+		mappedfile(const char *filename, bool writable=false);
+
+		//Make size bytes of zeroed scratch memory, backed by a temporary file that is deleted when it is unmapped.
+		//The temporary file is made in the directory named by TMPDIR (TEMP on Windows), or /tmp.
+		//Check good() to see if the memory was made.
+		mappedfile(size_t size);
+
+		~mappedfile();
+
+		//Return whether the file is mapped.
+		bool good() const {return start!=NULL;}
+
+		//The start of the mapping.  Only a writable mapping can be written.
+		char *data() const {return start;}
+
+		//The size of the file in bytes.
+		size_t size() const {return length;}
+
+	private:
+		char *start;
+		size_t length;
+
+};
+
+inline mappedfile::mappedfile(const char *filename, bool writable) {
+	start = NULL;
+	length = 0;
+
+#ifdef _WIN32
+	HANDLE file,mapping;
+	LARGE_INTEGER filesize;
+
+	file = CreateFileA(filename,GENERIC_READ,FILE_SHARE_READ,NULL,OPEN_EXISTING,FILE_ATTRIBUTE_NORMAL,NULL);
+	if (file==INVALID_HANDLE_VALUE) return;
+	if (!GetFileSizeEx(file,&filesize)||filesize.QuadPart==0) {
+		CloseHandle(file);
+		return;
+	}
+	mapping = CreateFileMapping(file,NULL,writable?PAGE_WRITECOPY:PAGE_READONLY,0,0,NULL);
+	CloseHandle(file);
+	if (mapping==NULL) return;
+	start = (char *) MapViewOfFile(mapping,writable?FILE_MAP_COPY:FILE_MAP_READ,0,0,0);
+	CloseHandle(mapping);
+	if (start!=NULL) length = (size_t) filesize.QuadPart;
+#else
+	int file;
+	struct stat status;
+	void *view;
+
+	file = open(filename,O_RDONLY);
+	if (file<0) return;
+	if (fstat(file,&status)!=0||status.st_size==0) {
+		close(file);
+		return;
+	}
+	view = mmap(NULL,(size_t) status.st_size,writable?(PROT_READ|PROT_WRITE):PROT_READ,MAP_PRIVATE,file,0);
+	close(file);
+	if (view==MAP_FAILED) return;
+	start = (char *) view;
+	length = (size_t) status.st_size;
+#endif
+}
+
+inline mappedfile::mappedfile(size_t size) {
+	start = NULL;
+	length = 0;
+	if (size==0) return;
+
+#ifdef _WIN32
+	HANDLE file,mapping;
+	char directory[MAX_PATH+1],filename[MAX_PATH+1];
+
+	if (GetTempPathA(MAX_PATH+1,directory)==0||GetTempFileNameA(directory,"rna",0,filename)==0) return;
+	file = CreateFileA(filename,GENERIC_READ|GENERIC_WRITE,0,NULL,CREATE_ALWAYS,
+		FILE_ATTRIBUTE_TEMPORARY|FILE_FLAG_DELETE_ON_CLOSE,NULL);
+	if (file==INVALID_HANDLE_VALUE) return;
+	mapping = CreateFileMapping(file,NULL,PAGE_READWRITE,(DWORD) (((unsigned long long) size)>>32),(DWORD) size,NULL);
+	//The view keeps the file open, and the file is deleted when the view is unmapped.
+	CloseHandle(file);
+	if (mapping==NULL) return;
+	start = (char *) MapViewOfFile(mapping,FILE_MAP_WRITE,0,0,0);
+	CloseHandle(mapping);
+	if (start!=NULL) length = size;
+#else
+	int file;
+	void *view;
+	std::string filename;
+
+	if (getenv("TMPDIR")!=NULL) filename = getenv("TMPDIR");
+	else filename = "/tmp";
+	filename += "/RNAstructure.XXXXXX";
+
+	file = mkstemp(&filename[0]);
+	if (file<0) return;
+	//The file has no name from here on, and is deleted when the mapping is removed.
+	unlink(filename.c_str());
+	if (ftruncate(file,(off_t) size)!=0) {
+		close(file);
+		return;
+	}
+	view = mmap(NULL,size,PROT_READ|PROT_WRITE,MAP_SHARED,file,0);
+	close(file);
+	if (view==MAP_FAILED) return;
+	start = (char *) view;
+	length = size;
+#endif
+}
+
+inline mappedfile::~mappedfile() {
+	if (start==NULL) return;
+
+#ifdef _WIN32
+	UnmapViewOfFile(start);
+#else
+	munmap(start,length);
+#endif
+}
+
+#endif //MAPPEDFILE_H
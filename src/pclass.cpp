@@ -3580,6 +3580,8 @@ OligoWalk refolding.
 //Using copy* arrays store the informations to be reused in refolding the whole target sequence
 OligoPclass::OligoPclass(structure *CT, pfdatatable *DATA):Pclass(CT,DATA) {
 
+		sharedcopy=false;
+
 		//initiate the copy arrays
 		copyw= new pfunctionclass(number);
 		copyv= new pfunctionclass(number);
@@ -3600,8 +3602,26 @@ OligoPclass::OligoPclass(structure *CT, pfdatatable *DATA):Pclass(CT,DATA) {
 		}
 }
 
+//Share the copy arrays of stored, which must have the same sequence length
+OligoPclass::OligoPclass(structure *CT, pfdatatable *DATA, OligoPclass *stored):Pclass(CT,DATA) {
+
+		sharedcopy=true;
+
+		copyw=stored->copyw;
+		copyv=stored->copyv;
+		copywmb=stored->copywmb;
+		copywl=stored->copywl;
+		copywmbl=stored->copywmbl;
+		copywcoax=stored->copywcoax;
+
+		copyw5=stored->copyw5;
+		copywca=stored->copywca;
+}
+
 OligoPclass::~OligoPclass() {
 
+		if (sharedcopy) return;
+
 		delete copyw;
 		delete copyv;
 		delete copywmb;
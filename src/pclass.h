@@ -119,6 +119,9 @@ public:
 	pfunctionclass *copyw,*copyv,*copywmb,*copywl,*copywmbl,*copywcoax;
 			//These arrays and classes store the informations to be copied in refolding
 	OligoPclass(structure *CT, pfdatatable *DATA);//initiate the copy arrays
+	OligoPclass(structure *CT, pfdatatable *DATA, OligoPclass *stored);
+			//use the copy arrays that stored filled in partition4refill(), which are only read by refill(),
+			//so that several instances can refill from one unconstrained fold (at the same time in OligoWalk-smp)
 	~OligoPclass();
 
 	//----------------------------------------------------------------------------------------------
@@ -136,6 +139,9 @@ public:
 																//refold the region on target with constrain
 	
 	void reset4oligo(structure *CT);//reset the arrays to be refilled again for other sequence
+
+private:
+	bool sharedcopy;//true if the copy arrays belong to another instance
 };
 
 
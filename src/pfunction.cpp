@@ -13,9 +13,11 @@ Contributions by Zhi John Lu, 2006.
 
 
 #include "pfunction.h"
+#include "bifurcation.h"
 #include "boltzmann.h" //for boltzman
 #include <math.h>
 #include <cstdlib>
+#include <cstring>
 
 #ifdef SMP
 	#include <omp.h>
@@ -53,154 +55,25 @@ using namespace std;
 #define maxasym 30  //maximum asymetry in the internal loops
 
 
-void calculatepfunction(structure* ct,pfdatatable* data, TProgressDialog* update, char* save, bool quickQ, PFPRECISION *Q,
+//Calculate v, w, wl, wmb, wmbl, wcoax and wca for the fragment locali to localj.
+//All shorter fragments inside locali to localj must already be filled.
+//wlcolumn and wmblcolumn are the copies of wl and wmbl by column for the bifurcation search,
+//	and this updates their entries for locali to localj.
+//curE and prevE are the O(N^3) internal loop arrays of the serial code (NULL with SMP).
+static void pfunctioncell(int locali, int localj, structure* ct, pfdatatable* data,
 	pfunctionclass *w, pfunctionclass *v, pfunctionclass *wmb, pfunctionclass *wl, pfunctionclass *wmbl,
-	pfunctionclass *wcoax, forceclass *fce,PFPRECISION *w5,PFPRECISION *w3,bool *mod, bool *lfce) {
-
-
-int ip,jp,ii,jj,jpf,jf,bl,ll,dp;
-register int i,j,h,d;
-int k,p;
-register int inc[6][6]={{0,0,0,0,0,0},{0,0,0,0,1,0},{0,0,0,1,0,0},{0,0,1,0,1,0},
-	{0,1,0,1,0,0},{0,0,0,0,0,0}};
-//int before,after;
-//register PFPRECISION e;
-register int number,maxj;
-register PFPRECISION twoscaling,rarray;
-PFPRECISION **curE,**prevE;
-PFPRECISION **tempE,**wca;
-//bool calculatev;
-
-
-#ifdef timer
-	#include <time.h>
-	ofstream timeout;
-	int seconds;
-	char timerstring[100];
-	char timelength[10];
-	strcpy(timerstring,"time_pf_");
-	sprintf(timelength,"%i",ct->GetSequenceLength());
-	strcat(timerstring,timelength);
-	strcat(timerstring,".out");
-
-	timeout.open(timerstring);
-	timeout<<time(NULL)<<"\n";
-	seconds = time(NULL);
-#endif
-
-number = (ct->GetSequenceLength());//place the number of bases in a registered integer
-
-//#ifndef SMP //These (for internal loop calculations) are only used in serial code
-
-#ifndef SMP //These (for internal loop calculations) are only used in serial code
-
-curE= new  PFPRECISION *[number+1];
-prevE= new PFPRECISION *[number+1];
-#else
-curE = NULL;
-prevE = NULL;
-#endif
-wca = new PFPRECISION *[number+1];
-
-
-
-
-for (i=0;i<=number;i++) {
-	#ifndef SMP //These (for internal loop calculations) are only used in serial code
-		curE[i]= new  PFPRECISION [number+1];
-   		prevE[i]= new PFPRECISION [number+1];
-	#endif
-	wca[i]=new PFPRECISION [number+1];
-	for(j=0;j<=number;j++) {
-
-		wca[i][j] = (PFPRECISION) 0;
-		#ifndef SMP //These (for internal loop calculations) are only used in serial code
-			curE[i][j]= (PFPRECISION) 0;
-			prevE[i][j]= (PFPRECISION) 0;
-		#endif
-	}
-
-}
-
-w5[0] = (PFPRECISION) 1;//initialize the random coil contribution to the partition function
-w3[number+1] = (PFPRECISION) 1;
-
-force(ct,fce,lfce);
-
-twoscaling = data->scaling*data->scaling;
-
+	pfunctionclass *wcoax, forceclass *fce, PFPRECISION *w5, PFPRECISION *w3, bool *mod, bool *lfce,
+	PFPRECISION **wca, PFPRECISION **wlcolumn, PFPRECISION **wmblcolumn,
+	PFPRECISION **curE, PFPRECISION **prevE, PFPRECISION twoscaling) {
 
-//This is the fill routine:
-
-if (quickQ) maxj = number;
-else maxj = 2*number-1;
-
-
-for (h=0;h<=( quickQ?(maxj-1):(maxj-1-minloop) );h++){
-
-	d=(h<=(number-1))?h:(h-number+1);
-
-	#ifndef SMP //These (for internal loop calculations) are only used in serial code
-	if (h==number) {
-		for(i=0;i<=number;i++) {
-			for(j=0;j<=number;j++) {
-				curE[i][j]= (PFPRECISION) 0;
-				prevE[i][j]= (PFPRECISION) 0;
-			}
-		}
-	}
-//<<<<<<< pfunction.cpp
-//	#endif
-
-	
-//=======
-	#endif
-//>>>>>>> 1.30
-
-	if (((h%10)==0)&&update) update->update((100*h)/(2*ct->GetSequenceLength()));
+	int ip,jp,ii,jj,jpf,jf,bl,ll,dp;
+	int p;
+	int inc[6][6]={{0,0,0,0,0,0},{0,0,0,0,1,0},{0,0,0,1,0,0},{0,0,1,0,1,0},
+		{0,1,0,1,0,0},{0,0,0,0,0,0}};
+	int number = ct->GetSequenceLength();
+	int d = localj-locali;
 
-//<<<<<<< pfunction.cpp
-//	int start;
-//	int end;
-//	if (h<=(number-1)) {
-//		start = 1;
-//		end = number-h;
-//	}
-//	else {
-//		start = 2*number-h;
-//		end = number;
-//	}
-	
-	
-	//for (int locali=((h<=(number-1))?1:(2*number-h));locali<=((h<=(number-1))?(number-h):number);locali++){
-//	#ifdef SMP
-//		#pragma omp parallel for
-//	#endif
-//	for (int locali=start;locali<=end;locali++){
-//		int localj=locali+d;
-		
-//=======
 
-	int start;
-	int end;
-	if (h<=(number-1)) {
-		start = 1;
-		end = number-h;
-	}
-	else {
-		start = 2*number-h;
-		end = number;
-	}
-	
-	
-	//for (int locali=((h<=(number-1))?1:(2*number-h));locali<=((h<=(number-1))?(number-h):number);locali++){
-	#ifdef SMP
-		#pragma omp parallel for
-	#endif
-	for (int locali=start;locali<=end;locali++){
-		int localj=locali+d;
-		
-//>>>>>>> 1.30
 		//Test to make sure the fragment is large enough to form pairs:
 		if (!(localj<=(number)&&((localj-locali)<=minloop))) {
 
@@ -1572,16 +1445,21 @@ for (h=0;h<=( quickQ?(maxj-1):(maxj-1-minloop) );h++){
 					wcoax->f(locali,localj) = localrarray;
 
 					//search for an open bifurcation:
-					for (int localk=locali+1;localk<localj;localk++) {
-						//e = 0;
-						if (localk!=number) {
-							if (!lfce[locali]&&locali!=number)
-								localrarray+=(wl->f(locali,localk)-wl->f(locali+1,localk)*data->eparam[6]*data->scaling+wcoax->f(locali,localk))*(wl->f(localk+1,localj)+wmbl->f(localk+1,localj));
-
-							else localrarray+=(wl->f(locali,localk)+wcoax->f(locali,localk))*(wl->f(localk+1,localj)+wmbl->f(localk+1,localj));
-
+					//The terms for locali to localk are row locali, and the terms for localk+1 to localj are
+					//	column localj for localk<number, or column localj-number for localk>number.
+					{
+						PFPRECISION *nextrow = (!lfce[locali]&&locali!=number)?wl->dg[locali+1]:NULL;
+						int localk = min(localj,number);//the first localk that is not in column localj
+
+						localrarray = sumbifurcation(localrarray,wl->dg[locali]+locali+1,(nextrow!=NULL)?(nextrow+locali+1):NULL,
+							wcoax->dg[locali]+locali+1,wlcolumn[localj]+locali+2,wmblcolumn[localj]+locali+2,
+							data->eparam[6],data->scaling,localk-locali-1);
+						if (localj>number+1) {
+							localrarray = sumbifurcation(localrarray,wl->dg[locali]+number+1,(nextrow!=NULL)?(nextrow+number+1):NULL,
+								wcoax->dg[locali]+number+1,wlcolumn[localj-number]+2,wmblcolumn[localj-number]+2,
+								data->eparam[6],data->scaling,localj-number-1);
 						}
-         			}
+					}
 
 
 
@@ -1901,21 +1779,321 @@ for (h=0;h<=( quickQ?(maxj-1):(maxj-1-minloop) );h++){
 
 		}
 		
+		wlcolumn[localj][locali] = wl->f(locali,localj);
+		wmblcolumn[localj][locali] = wmbl->f(locali,localj);
 
 		#ifdef pfdebugmode
 		if (twoscaling>PFMAX||twoscaling<PFMIN) {
 			//look for positions that will underflow
 
 
-			ofstream *ufout = new ofstream();
-			ufout->open("c:/underflow_alert.out",ios::app);
-			*ufout<<"locali= "<<locali<<" localj= "<<localj<<" twoscaling= "<<twoscaling<<"\n";
-			ufout->close();
-			delete ufout;
+			ofstream *ufout = new ofstream();
+			ufout->open("c:/underflow_alert.out",ios::app);
+			*ufout<<"locali= "<<locali<<" localj= "<<localj<<" twoscaling= "<<twoscaling<<"\n";
+			ufout->close();
+			delete ufout;
+
+		}
+		#endif//pfdebugmode
+}
+
+//Copy wl and wmbl, for every fragment, to their copies by column, wlcolumn and wmblcolumn.
+//This is needed after the arrays are rescaled.
+static void pfunctioncolumns(int number, pfunctionclass *wl, pfunctionclass *wmbl,
+	PFPRECISION **wlcolumn, PFPRECISION **wmblcolumn) {
+
+	for (int j=0;j<=2*number;j++) {
+		for (int i=max(0,j-number);i<=min(j,number);i++) {
+			wlcolumn[j][i] = wl->f(i,j);
+			wmblcolumn[j][i] = wmbl->f(i,j);
+		}
+	}
+}
+
+#ifdef SMP
+#define PFTILE 16 //edge length, in nucleotides, of the square tiles of fragments filled by one task
+
+//Return true if the fragment i to j is out of bounds and the arrays would need to be rescaled.
+//These are the same tests applied after each diagonal in calculatepfunction.
+inline bool pfunctionoutofbounds(int i, int j, pfunctionclass *w, pfunctionclass *v, pfunctionclass *wmb,
+	pfunctionclass *wl, pfunctionclass *wmbl, pfunctionclass *wcoax) {
+
+	if (v->f(i,j)>PFMAX||w->f(i,j)>PFMAX||wl->f(i,j)>PFMAX||wcoax->f(i,j)>PFMAX||wmb->f(i,j)>PFMAX||wmbl->f(i,j)>PFMAX) return true;
+	if ((v->f(i,j)<PFMIN&&v->f(i,j)>0)||(w->f(i,j)<PFMIN&&w->f(i,j)>0)||(wl->f(i,j)<PFMIN&&wl->f(i,j)>0)) return true;
+	if ((wcoax->f(i,j)<PFMIN&&wcoax->f(i,j)>0)||(wmb->f(i,j)<PFMIN&&wmb->f(i,j)>0)||(wmbl->f(i,j)<PFMIN&&wmbl->f(i,j)>0)) return true;
+	return false;
+}
+
+//Fill diagonals hfirst through hlast, which are either all interior fragments (h<=number-1) or all
+//	exterior fragments, as a wavefront over square tiles of fragments.
+//A tile is one OpenMP task that starts once the tile to its left (smaller j) and the tile below it
+//	(larger i) are finished; inside a tile the fragments are filled from shortest to longest.
+//	This replaces the barrier after each diagonal with a dependence between neighbouring tiles.
+//The arrays can only be rescaled between diagonals, so once a fragment is out of bounds no
+//	fragments on longer diagonals are filled.  The return value is the last diagonal that is
+//	complete; calculatepfunction rescales and then calls this again for the rest.
+static int pfunctiontiledfill(int hfirst, int hlast, structure* ct, pfdatatable* data,
+	pfunctionclass *w, pfunctionclass *v, pfunctionclass *wmb, pfunctionclass *wl, pfunctionclass *wmbl,
+	pfunctionclass *wcoax, forceclass *fce, PFPRECISION *w5, PFPRECISION *w3, bool *mod, bool *lfce,
+	PFPRECISION **wca, PFPRECISION **wlcolumn, PFPRECISION **wmblcolumn, PFPRECISION twoscaling) {
+
+	int number = ct->GetSequenceLength();
+	bool exterior = hfirst>(number-1);
+
+	//Exterior fragments i to j (j>number) are tiled by i and j-number, where j-number<i.
+	int offset = exterior?number:0;
+	int dfirst = exterior?(hfirst-number+1):hfirst;
+	int dlast = exterior?(hlast-number+1):hlast;
+	int tiles = (number+PFTILE-1)/PFTILE;
+	int stop = hlast;
+
+	//One dependence token per tile, plus a last one that stands in for tiles outside the triangle.
+	char *token = new char [tiles*tiles+1];
+	int none = tiles*tiles;
+
+	#pragma omp parallel
+	#pragma omp single
+	{
+		//Create the tasks in order of tile diagonal, so that a tile's neighbours are created before it.
+		for (int tiled=(exterior?1-tiles:0);tiled<=(exterior?0:tiles-1);tiled++) {
+			for (int ti=0;ti<tiles;ti++) {
+				int tj = ti+tiled;
+				if (tj<0||tj>=tiles) continue;
+
+				int left,below;
+				if (exterior) {
+					left = (tj>0)?(ti*tiles+tj-1):none;
+					below = (ti<tiles-1)?((ti+1)*tiles+tj):none;
+				}
+				else {
+					left = (tj>ti)?(ti*tiles+tj-1):none;
+					below = (ti<tj)?((ti+1)*tiles+tj):none;
+				}
+
+				#pragma omp task firstprivate(ti,tj) shared(stop) depend(in:token[left],token[below]) depend(out:token[ti*tiles+tj])
+				{
+					int ilow = ti*PFTILE+1;
+					int ihigh = min(ti*PFTILE+PFTILE,number);
+					int jlow = tj*PFTILE+1+offset;
+					int jhigh = min(tj*PFTILE+PFTILE,exterior?(number-1):number)+offset;
+					int current;
+
+					for (int d=max(dfirst,jlow-ihigh);d<=min(dlast,jhigh-ilow);d++) {
+						int h = exterior?(d+number-1):d;
+
+						#pragma omp atomic read
+						current = stop;
+						if (h>current) break;
+
+						for (int locali=max(ilow,jlow-d);locali<=min(ihigh,jhigh-d);locali++) {
+							pfunctioncell(locali,locali+d,ct,data,w,v,wmb,wl,wmbl,wcoax,fce,w5,w3,mod,lfce,
+								wca,wlcolumn,wmblcolumn,NULL,NULL,twoscaling);
+
+							if (pfunctionoutofbounds(locali,locali+d,w,v,wmb,wl,wmbl,wcoax)) {
+								#pragma omp critical (pfunctiontiledfill)
+								{
+									#pragma omp atomic read
+									current = stop;
+									if (h<current) {
+										#pragma omp atomic write
+										stop = h;
+									}
+								}
+							}
+						}
+					}
+				}
+			}
+		}
+	}
+
+	delete[] token;
+	return stop;
+}
+#endif //SMP
+
+
+void calculatepfunction(structure* ct,pfdatatable* data, TProgressDialog* update, char* save, bool quickQ, PFPRECISION *Q,
+	pfunctionclass *w, pfunctionclass *v, pfunctionclass *wmb, pfunctionclass *wl, pfunctionclass *wmbl,
+	pfunctionclass *wcoax, forceclass *fce,PFPRECISION *w5,PFPRECISION *w3,bool *mod, bool *lfce) {
+
+
+int ip,jp,ii,jj,jpf,jf,bl,ll,dp;
+register int i,j,h,d;
+int k,p;
+register int inc[6][6]={{0,0,0,0,0,0},{0,0,0,0,1,0},{0,0,0,1,0,0},{0,0,1,0,1,0},
+	{0,1,0,1,0,0},{0,0,0,0,0,0}};
+//int before,after;
+//register PFPRECISION e;
+register int number,maxj;
+register PFPRECISION twoscaling,rarray;
+PFPRECISION **curE,**prevE;
+PFPRECISION **tempE,**wca;
+PFPRECISION **wlcolumn,**wmblcolumn;//wl and wmbl by column, for the bifurcation search
+PFPRECISION columntwoscaling;//twoscaling when wlcolumn and wmblcolumn were last copied
+//bool calculatev;
+#ifdef SMP
+int filled;//the last diagonal filled by pfunctiontiledfill
+PFPRECISION filltwoscaling;//twoscaling when those diagonals were filled
+#endif
+
+
+#ifdef timer
+	#include <time.h>
+	ofstream timeout;
+	int seconds;
+	char timerstring[100];
+	char timelength[10];
+	strcpy(timerstring,"time_pf_");
+	sprintf(timelength,"%i",ct->GetSequenceLength());
+	strcat(timerstring,timelength);
+	strcat(timerstring,".out");
+
+	timeout.open(timerstring);
+	timeout<<time(NULL)<<"\n";
+	seconds = time(NULL);
+#endif
+
+number = (ct->GetSequenceLength());//place the number of bases in a registered integer
+
+//#ifndef SMP //These (for internal loop calculations) are only used in serial code
+
+#ifndef SMP //These (for internal loop calculations) are only used in serial code
+
+curE= new  PFPRECISION *[number+1];
+prevE= new PFPRECISION *[number+1];
+#else
+curE = NULL;
+prevE = NULL;
+#endif
+wca = new PFPRECISION *[number+1];
+
+
+
+
+for (i=0;i<=number;i++) {
+	#ifndef SMP //These (for internal loop calculations) are only used in serial code
+		curE[i]= new  PFPRECISION [number+1];
+   		prevE[i]= new PFPRECISION [number+1];
+	#endif
+	wca[i]=new PFPRECISION [number+1];
+	for(j=0;j<=number;j++) {
+
+		wca[i][j] = (PFPRECISION) 0;
+		#ifndef SMP //These (for internal loop calculations) are only used in serial code
+			curE[i][j]= (PFPRECISION) 0;
+			prevE[i][j]= (PFPRECISION) 0;
+		#endif
+	}
+
+}
+
+//wlcolumn[j][i] is a copy of wl->f(i,j), and wmblcolumn[j][i] of wmbl->f(i,j), stored by column so that
+//	the bifurcation search is unit-stride.  Column j holds i from max(0,j-number) to min(j,number).
+wlcolumn = new PFPRECISION *[2*number+1];
+wmblcolumn = new PFPRECISION *[2*number+1];
+for (j=0;j<=2*number;j++) {
+	wlcolumn[j] = new PFPRECISION [min(j,number)-max(0,j-number)+1];
+	wmblcolumn[j] = new PFPRECISION [min(j,number)-max(0,j-number)+1];
+	wlcolumn[j] -= max(0,j-number);
+	wmblcolumn[j] -= max(0,j-number);
+	for (i=max(0,j-number);i<=min(j,number);i++) {
+		wlcolumn[j][i] = (PFPRECISION) 0;
+		wmblcolumn[j][i] = (PFPRECISION) 0;
+	}
+}
+
+w5[0] = (PFPRECISION) 1;//initialize the random coil contribution to the partition function
+w3[number+1] = (PFPRECISION) 1;
+
+force(ct,fce,lfce);
+
+twoscaling = data->scaling*data->scaling;
+columntwoscaling = twoscaling;
+
+
+//This is the fill routine:
+
+if (quickQ) maxj = number;
+else maxj = 2*number-1;
+
+#ifdef SMP
+filled = -1;
+filltwoscaling = twoscaling;
+#endif
+
+
+for (h=0;h<=( quickQ?(maxj-1):(maxj-1-minloop) );h++){
+
+	d=(h<=(number-1))?h:(h-number+1);
+
+	#ifndef SMP //These (for internal loop calculations) are only used in serial code
+	if (h==number) {
+		for(i=0;i<=number;i++) {
+			for(j=0;j<=number;j++) {
+				curE[i][j]= (PFPRECISION) 0;
+				prevE[i][j]= (PFPRECISION) 0;
+			}
+		}
+	}
+//<<<<<<< pfunction.cpp
+//	#endif
+
+	
+//=======
+	#endif
+//>>>>>>> 1.30
+
+	if (((h%10)==0)&&update) update->update((100*h)/(2*ct->GetSequenceLength()));
+
+//<<<<<<< pfunction.cpp
+//	int start;
+//	int end;
+//	if (h<=(number-1)) {
+//		start = 1;
+//		end = number-h;
+//	}
+//	else {
+//		start = 2*number-h;
+//		end = number;
+//	}
+	
+	
+	//for (int locali=((h<=(number-1))?1:(2*number-h));locali<=((h<=(number-1))?(number-h):number);locali++){
+//	#ifdef SMP
+//		#pragma omp parallel for
+//	#endif
+//	for (int locali=start;locali<=end;locali++){
+//		int localj=locali+d;
+		
+//=======
 
+	int start;
+	int end;
+	if (h<=(number-1)) {
+		start = 1;
+		end = number-h;
+	}
+	else {
+		start = 2*number-h;
+		end = number;
+	}
+	
+	
+	#ifdef SMP
+		if (h>filled) {
+			//Fill this and the remaining diagonals of the interior (or exterior) fragments
+			//	with the tiled wavefront.  filled is the last diagonal that is complete.
+			filled = pfunctiontiledfill(h,(h<=(number-1))?(number-1):(maxj-1-minloop),ct,data,
+				w,v,wmb,wl,wmbl,wcoax,fce,w5,w3,mod,lfce,wca,wlcolumn,wmblcolumn,twoscaling);
+			filltwoscaling = twoscaling;
 		}
-		#endif//pfdebugmode
-	}//end for locali
+	#else
+		for (int locali=start;locali<=end;locali++){
+			pfunctioncell(locali,locali+d,ct,data,w,v,wmb,wl,wmbl,wcoax,fce,w5,w3,mod,lfce,
+				wca,wlcolumn,wmblcolumn,curE,prevE,twoscaling);
+		}
+	#endif
 
 
 	for (i=((h<=(number-1))?1:(2*number-h));i<=((h<=(number-1))?(number-h):number);i++){
@@ -1959,7 +2137,7 @@ for (h=0;h<=( quickQ?(maxj-1):(maxj-1-minloop) );h++){
 			twoscaling = twoscaling*SCALEUP*SCALEUP;
 		}
 		else if (wl->f(i,j)<PFMIN&&wl->f(i,j)>0) {
-			rescale(i,j,ct,data,v,w,wl,wcoax,wmb,wmbl,w5,w3,curE,prevE,wca,SCALEUP);
+			rescale(i,j,ct,data,v,w,wl,wcoax,wmb,wmbl,w5,w3,wca,curE,prevE,SCALEUP);
 			twoscaling = twoscaling*SCALEUP*SCALEUP;
 		}
 		else if (wcoax->f(i,j)<PFMIN&&wcoax->f(i,j)>0) {
@@ -2379,6 +2557,18 @@ for (h=0;h<=( quickQ?(maxj-1):(maxj-1-minloop) );h++){
 		}
 	}
 
+	//A rescale changes wl and wmbl, so they are copied by column again.
+	if (twoscaling!=columntwoscaling) {
+		pfunctioncolumns(number,wl,wmbl,wlcolumn,wmblcolumn);
+		columntwoscaling = twoscaling;
+	}
+
+	#ifdef SMP
+		//A rescale on this diagonal leaves the longer fragments that were already filled
+		//	with the old scaling, so they are filled again, starting with the next diagonal.
+		if (twoscaling!=filltwoscaling&&filled>h) filled = h;
+	#endif
+
 	#ifndef SMP
 		//This is O(N^3) internal loop code that is not used with SMP
 		if (d>(j>number?8:11))
@@ -2411,6 +2601,15 @@ for(ii=0;ii<=number;ii++) {
 
 }
 delete[] wca;
+for (j=0;j<=2*number;j++) {
+	//move the pointers back before deleting
+	wlcolumn[j] += max(0,j-number);
+	wmblcolumn[j] += max(0,j-number);
+	delete[] wlcolumn[j];
+	delete[] wmblcolumn[j];
+}
+delete[] wlcolumn;
+delete[] wmblcolumn;
 #ifndef SMP
 delete[] curE;
 delete[] prevE;
@@ -2646,15 +2845,150 @@ return;
 }
 
 
+//The layout of a partition function save file.
+//The file starts with the structure information.  From version 5, this is followed by the kind and size of PFPRECISION,
+//	and then by the arrays, each as one block laid out as in memory and starting at a multiple of PFSAVEALIGN bytes from
+//	the start of the file.  This lets mappfsave() map the file into memory and use v, w, wmb, wmbl, wl, and wcoax in place,
+//	so that only the parts of them that are used are read from disk.  The thermodynamic data come last.
+//Up to version 4, the elements of the arrays were interleaved, and each was written separately.
+#define PFSAVEALIGN 64
+enum {pfsavev,pfsavew,pfsavewmb,pfsavewmbl,pfsavewl,pfsavewcoax,pfsavew5,pfsavew3,pfsavefce,pfsavelfce,pfsavemod,pfsavedata,pfsaveblocks};
+
+//Find the offset of each block, and of the thermodynamic data, for a sequence of length N, where the blocks follow the header at start.
+static void pfsaveoffsets(long start, int N, long offsets[pfsaveblocks]) {
+	long sizes[pfsavedata];
+	int block;
+
+	for (block=pfsavev;block<=pfsavewcoax;++block) sizes[block] = (long) (N+1)*(N+1)*sizeof(PFPRECISION);
+	sizes[pfsavew5] = (N+1)*sizeof(PFPRECISION);
+	sizes[pfsavew3] = (N+2)*sizeof(PFPRECISION);
+	sizes[pfsavefce] = (long) (N+1)*(N+1);
+	sizes[pfsavelfce] = (2*N+1)*sizeof(bool);
+	sizes[pfsavemod] = (2*N+1)*sizeof(bool);
+
+	offsets[pfsavev] = (start+PFSAVEALIGN-1)/PFSAVEALIGN*PFSAVEALIGN;
+	for (block=pfsavev+1;block<pfsaveblocks;++block) {
+		offsets[block] = (offsets[block-1]+sizes[block-1]+PFSAVEALIGN-1)/PFSAVEALIGN*PFSAVEALIGN;
+	}
+}
+
+//Write zeros up to offset.
+static void pfsavepad(ofstream *sav, long offset) {
+	while ((long) sav->tellp()<offset) sav->put(0);
+}
+
+//Identify the kind of PFPRECISION, because the arrays are saved as they are in memory.
+static int pfsaveprecision() {
+#if defined(EXTENDED_DOUBLE)
+	return 1;
+#elif defined(LOG_DOUBLE)
+	return 2;
+#else
+	return 0;
+#endif
+}
+
+//Read the kind and size of PFPRECISION from a save file, and return whether they are those of this build.
+static bool readpfsaveprecision(ifstream *sav) {
+	int precision,precisionsize;
+
+	read(sav,&precision);
+	read(sav,&precisionsize);
+	return !sav->fail()&&precision==pfsaveprecision()&&precisionsize==(int) sizeof(PFPRECISION);
+}
+
+//Write the thermodynamic data at the end of a partition function save file.
+static void writepfdata(ofstream *sav, pfdatatable *data) {
+	int i,j,k,l,m,n,o,p;
+	int inc[6][6]={{0,0,0,0,0,0},{0,0,0,0,1,0},{0,0,0,1,0,0},{0,0,1,0,1,0},
+	{0,1,0,1,0,0},{0,0,0,0,0,0}};
+
+	write(sav,&(data->temp));
+	for (i=0;i<5;i++) write(sav,&(data->poppen[i]));
+	write(sav,&(data->maxpen));
+	for (i=0;i<11;i++) write(sav,&(data->eparam[i]));
+	for (i=0;i<31;i++) {
+		write(sav,&(data->inter[i]));
+		write(sav,&(data->bulge[i]));
+		write(sav,&(data->hairpin[i]));
+
+	}
+	for (i=0;i<6;i++) {
+		for (j=0;j<6;j++) {
+			for (k=0;k<6;k++) {
+				for (l=0;l<3;l++) {
+					write(sav,&(data->dangle[i][j][k][l]));
+				}
+				for (l=0;l<6;l++) {
+					write(sav,&(data->stack[i][j][k][l]));
+					write(sav,&(data->tstkh[i][j][k][l]));
+					write(sav,&(data->tstki[i][j][k][l]));
+					write(sav,&(data->coax[i][j][k][l]));
+					write(sav,&(data->tstackcoax[i][j][k][l]));
+					write(sav,&(data->coaxstack[i][j][k][l]));
+					write(sav,&(data->tstack[i][j][k][l]));
+					write(sav,&(data->tstkm[i][j][k][l]));
+					write(sav,&(data->tstki23[i][j][k][l]));
+					write(sav,&(data->tstki1n[i][j][k][l]));
+					for (m=0;m<6;m++) {
+						for (n=0;n<6;n++) {
+							write(sav,&(data->iloop11[i][j][k][l][m][n]));
+							for (o=0;o<6;o++) {
+								if (inc[i][j]&&inc[n][o]) write(sav,&(data->iloop21[i][j][k][l][m][n][o]));
+								for (p=0;p<6;p++) {
+									if (inc[i][k]&&inc[j][l])
+										write(sav,&(data->iloop22[i][j][k][l][m][n][o][p]));
+								}
+							}
+
+
+						}
+					}
+				}
+			}
+		}
+	}
+	write(sav,&(data->numoftloops));
+	for (i=0;i<=data->numoftloops;i++) {
+		write(sav,&(data->itloop[i]));
+		write(sav,&(data->tloop[i]));
+
+	}
+	write(sav,&(data->numoftriloops));
+	for (i=0;i<=data->numoftriloops;i++) {
+		write(sav,&(data->itriloop[i]));
+		write(sav,&(data->triloop[i]));
+
+	}
+	write(sav,&(data->numofhexaloops));
+	for (i=0;i<=data->numofhexaloops;i++) {
+		write(sav,&(data->ihexaloop[i]));
+		write(sav,&(data->hexaloop[i]));
+
+	}
+	write(sav,&(data->auend));
+	write(sav,&(data->gubonus));
+	write(sav,&(data->cint));
+	write(sav,&(data->cslope));
+	write(sav,&(data->c3));
+	write(sav,&(data->efn2a));
+	write(sav,&(data->efn2b));
+	write(sav,&(data->efn2c));
+	write(sav,&(data->init));
+	write(sav,&(data->mlasym));
+	write(sav,&(data->strain));
+	write(sav,&(data->prelog));
+	write(sav,&(data->singlecbulge));
+	write(sav,&(data->maxintloopsize));
+}
+
 //writepfsave writes a save file with partition function data.
 void writepfsave(char *filename, structure *ct,
 			 PFPRECISION *w5, PFPRECISION *w3,
 			 pfunctionclass *v, pfunctionclass *w, pfunctionclass *wmb, pfunctionclass *wl, pfunctionclass *wmbl, pfunctionclass *wcoax,
 			 forceclass *fce, bool *mod, bool *lfce, pfdatatable *data) {
 
-	int i,j,k,l,m,n,o,p;
-	int inc[6][6]={{0,0,0,0,0,0},{0,0,0,0,1,0},{0,0,0,1,0,0},{0,0,1,0,1,0},
-	{0,1,0,1,0,0},{0,0,0,0,0,0}};
+	int i,j;
 
 	ofstream sav(filename,ios::binary);
 
@@ -2767,147 +3101,37 @@ void writepfsave(char *filename, structure *ct,
 	}
 
 
-	//now write the array class data for v, w, and wmb:
-	for (i=0;i<=ct->GetSequenceLength();i++) {
-		write(&sav,&(w3[i]));
-		write(&sav,&(w5[i]));
-//<<<<<<< pfunction.cpp
-//		for (j=0;j<=ct->GetSequenceLength();j++) {
-//			write(&sav,&(v->dg[i][j]));
-//			write(&sav,&(w->dg[i][j]));
-//			write(&sav,&(wmb->dg[i][j]));
-//			write(&sav,&(wmbl->dg[i][j]));
-//			write(&sav,&(wl->dg[i][j]));
-//			write(&sav,&(wcoax->dg[i][j]));
-//=======
-		for (j=0;j<=ct->GetSequenceLength();j++) {
-			write(&sav,&(v->dg[i][j+i]));
-			write(&sav,&(w->dg[i][j+i]));
-			write(&sav,&(wmb->dg[i][j+i]));
-			write(&sav,&(wmbl->dg[i][j+i]));
-			write(&sav,&(wl->dg[i][j+i]));
-			write(&sav,&(wcoax->dg[i][j+i]));
-//>>>>>>> 1.30
-			writesinglechar(&sav,&(fce->dg[i][j]));
-			//if (ct->intermolecular) {
-			//	write(&sav,&(w2->dg[i][j]));
-			//	write(&sav,&(wmb2->dg[i][j]));
-
-			//}
-
-
-		}
-
-
-	}
-
-
-	// I should replace this with functionality to convert .pfs files to .txt files -- rhiju.
-	// this is inelegant -- quick way to get at base pair probabilities...
-	if ( false ) { //turn this off before CVS checkin!
-	  string bpp_file( "bpp.txt" );
-	  ofstream bpp_out( bpp_file.c_str() );
-	  for (i=1;i<=ct->GetSequenceLength();i++) {
-	    for (j=1;j<=ct->GetSequenceLength();j++) {
-	      bpp_out << ' ' << calculateprobability(i,j,v,w5,ct,data,lfce,mod,data->scaling,fce);
-	    }
-	    bpp_out << endl;
-	  }
-	  bpp_out.close();
-	}
-
-
-	write(&sav,&(w3[ct->GetSequenceLength()+1]));
-	for (i=0;i<=2*ct->GetSequenceLength();i++) {
-		write(&sav,&(lfce[i]));
-		write(&sav,&(mod[i]));
-
-	}
-
-
-
-
+	//Record the precision of the arrays, so that the file is not read by a build with another precision.
+	int precision = pfsaveprecision();
+	int precisionsize = (int) sizeof(PFPRECISION);
+	write(&sav,&precision);
+	write(&sav,&precisionsize);
 
-	//now write the thermodynamic data:
-	write(&sav,&(data->temp));
-	for (i=0;i<5;i++) write(&sav,&(data->poppen[i]));
-	write(&sav,&(data->maxpen));
-	for (i=0;i<11;i++) write(&sav,&(data->eparam[i]));
-	for (i=0;i<31;i++) {
-		write(&sav,&(data->inter[i]));
-		write(&sav,&(data->bulge[i]));
-		write(&sav,&(data->hairpin[i]));
+	//now write the arrays, each as one block (see pfsaveoffsets):
+	long offsets[pfsaveblocks];
+	long arraysize = (long) (ct->GetSequenceLength()+1)*(ct->GetSequenceLength()+1)*sizeof(PFPRECISION);
+	pfunctionclass *arrays[6] = {v,w,wmb,wmbl,wl,wcoax};
 
-	}
+	pfsaveoffsets((long) sav.tellp(),ct->GetSequenceLength(),offsets);
 	for (i=0;i<6;i++) {
-		for (j=0;j<6;j++) {
-			for (k=0;k<6;k++) {
-				for (l=0;l<3;l++) {
-					write(&sav,&(data->dangle[i][j][k][l]));
-				}
-				for (l=0;l<6;l++) {
-					write(&sav,&(data->stack[i][j][k][l]));
-					write(&sav,&(data->tstkh[i][j][k][l]));
-					write(&sav,&(data->tstki[i][j][k][l]));
-					write(&sav,&(data->coax[i][j][k][l]));
-					write(&sav,&(data->tstackcoax[i][j][k][l]));
-					write(&sav,&(data->coaxstack[i][j][k][l]));
-					write(&sav,&(data->tstack[i][j][k][l]));
-					write(&sav,&(data->tstkm[i][j][k][l]));
-					write(&sav,&(data->tstki23[i][j][k][l]));
-					write(&sav,&(data->tstki1n[i][j][k][l]));
-					for (m=0;m<6;m++) {
-						for (n=0;n<6;n++) {
-							write(&sav,&(data->iloop11[i][j][k][l][m][n]));
-							for (o=0;o<6;o++) {
-								if (inc[i][j]&&inc[n][o]) write(&sav,&(data->iloop21[i][j][k][l][m][n][o]));
-								for (p=0;p<6;p++) {
-									if (inc[i][k]&&inc[j][l])
-										write(&sav,&(data->iloop22[i][j][k][l][m][n][o][p]));
-								}
-							}
-
-
-						}
-					}
-				}
-			}
-		}
-	}
-	write(&sav,&(data->numoftloops));
-	for (i=0;i<=data->numoftloops;i++) {
-		write(&sav,&(data->itloop[i]));
-		write(&sav,&(data->tloop[i]));
-
-	}
-	write(&sav,&(data->numoftriloops));
-	for (i=0;i<=data->numoftriloops;i++) {
-		write(&sav,&(data->itriloop[i]));
-		write(&sav,&(data->triloop[i]));
-
+		pfsavepad(&sav,offsets[pfsavev+i]);
+		//dg[0] is the start of the single allocation that holds the array
+		sav.write((char *) arrays[i]->dg[0],arraysize);
 	}
-	write(&sav,&(data->numofhexaloops));
-	for (i=0;i<=data->numofhexaloops;i++) {
-		write(&sav,&(data->ihexaloop[i]));
-		write(&sav,&(data->hexaloop[i]));
-
-	}
-	write(&sav,&(data->auend));
-	write(&sav,&(data->gubonus));
-	write(&sav,&(data->cint));
-	write(&sav,&(data->cslope));
-	write(&sav,&(data->c3));
-	write(&sav,&(data->efn2a));
-	write(&sav,&(data->efn2b));
-	write(&sav,&(data->efn2c));
-	write(&sav,&(data->init));
-	write(&sav,&(data->mlasym));
-	write(&sav,&(data->strain));
-	write(&sav,&(data->prelog));
-	write(&sav,&(data->singlecbulge));
-	write(&sav,&(data->maxintloopsize));
-
+	pfsavepad(&sav,offsets[pfsavew5]);
+	sav.write((char *) w5,(ct->GetSequenceLength()+1)*sizeof(PFPRECISION));
+	pfsavepad(&sav,offsets[pfsavew3]);
+	sav.write((char *) w3,(ct->GetSequenceLength()+2)*sizeof(PFPRECISION));
+	pfsavepad(&sav,offsets[pfsavefce]);
+	for (i=0;i<=ct->GetSequenceLength();i++) sav.write(fce->dg[i],ct->GetSequenceLength()+1);
+	pfsavepad(&sav,offsets[pfsavelfce]);
+	sav.write((char *) lfce,(2*ct->GetSequenceLength()+1)*sizeof(bool));
+	pfsavepad(&sav,offsets[pfsavemod]);
+	sav.write((char *) mod,(2*ct->GetSequenceLength()+1)*sizeof(bool));
 
+	//now write the thermodynamic data:
+	pfsavepad(&sav,offsets[pfsavedata]);
+	writepfdata(&sav,data);
 
 	sav.close();
 
@@ -2930,23 +3154,37 @@ pfunctionclass::pfunctionclass(int size) {
 	infinite = (PFPRECISION) 0;
 
     Size = size;
-    /*register*/ int i,j;
-    dg = new PFPRECISION *[size+1];
+    /*register*/ int i;
+    long entries = (long) (size+1)*(size+1);
+    storage = new PFPRECISION [entries];
+    ownsstorage = true;
+    for (long l=0;l<entries;l++) {
 
-	for (i=0;i<=(size);i++)  {
-   		dg[i] = new PFPRECISION [size+1];
-   	}
-    for (i=0;i<=size;i++) {
-         for (j=0;j<size+1;j++) {
-
-             dg[i][j] = (PFPRECISION) 0;
-         }
+         storage[l] = (PFPRECISION) 0;
     }
 	
 
-	//Move pointers for faster access:
-	for (i=1;i<=size;++i) {
-		dg[i]-=i;
+	//Point each row at its block of storage, moved back by i for faster access:
+    dg = new PFPRECISION *[size+1];
+	for (i=0;i<=size;++i) {
+		dg[i] = storage + (long) i*size;
+
+	}
+
+}
+
+pfunctionclass::pfunctionclass(int size, PFPRECISION *external) {
+
+	infinite = (PFPRECISION) 0;
+
+	Size = size;
+	storage = external;
+	ownsstorage = false;
+
+	//Point each row at its block of storage, moved back by i for faster access:
+	dg = new PFPRECISION *[size+1];
+	for (int i=0;i<=size;++i) {
+		dg[i] = storage + (long) i*size;
 
 	}
 
@@ -2956,13 +3194,7 @@ pfunctionclass::pfunctionclass(int size) {
 pfunctionclass::~pfunctionclass() {
 
 
-	int i;
-
-    for (i=0;i<=Size;i++) {
-		//restore the pointer position before deleting
-		dg[i]+=i;
-        delete[] dg[i];
-    }
+     if (ownsstorage) delete[] storage;
      delete[] dg;
 }
 
@@ -3675,199 +3907,153 @@ PFPRECISION ergcoaxinterbases2(int i, int j, int ip, int jp, structure *ct, pfda
 //#endif
 
 
-void readpfsave(const char *filename, structure *ct,
-			 PFPRECISION *w5, PFPRECISION *w3,
-			 pfunctionclass *v, pfunctionclass *w, pfunctionclass *wmb, pfunctionclass *wl, pfunctionclass *wmbl, pfunctionclass *wcoax,
-			 forceclass *fce, PFPRECISION *scaling, bool *mod, bool *lfce, pfdatatable *data) {
-	 int i,j,k,l,m,n,o,p;
-	ifstream sav(filename,ios::binary);
-	int inc[6][6]={{0,0,0,0,0,0},{0,0,0,0,1,0},{0,0,0,1,0,0},{0,0,1,0,1,0},
-	{0,1,0,1,0,0},{0,0,0,0,0,0}};//a mask array indicating the identity of canonical pairs
-	short vers;
+//Read the structure information at the start of a partition function save file, which is the same in all versions.
+static void readpfsaveheader(ifstream *sav, structure *ct, PFPRECISION *scaling, pfdatatable *data, short *vers) {
+	int i,j;
 
 	//read the save file
 
 	//read the file version first
-	read(&sav,&vers);
+	read(sav,vers);
 
 	//start with structure information
 	int SequenceLength;
-	read(&sav,&(SequenceLength));
+	read(sav,&(SequenceLength));
 	//ct->numofbases = SequenceLength;
-	read(&sav,&(ct->intermolecular));
-	read(&sav,scaling);
+	read(sav,&(ct->intermolecular));
+	read(sav,scaling);
 
 	data->scaling=*scaling;
 
 	int constraint,constraint2,numberofconstraints;
 
 	//Read information about the forced pairs
-	read(&sav,&(numberofconstraints));
+	read(sav,&(numberofconstraints));
 	for (i=0;i<numberofconstraints;i++) {
-		read(&sav,&(constraint));
-		read(&sav,&(constraint2));
+		read(sav,&(constraint));
+		read(sav,&(constraint2));
 
 		ct->AddPair(constraint,constraint2);
 	}
 	for (i=0;i<=ct->GetSequenceLength();i++) {
 
-		read(&sav,&(ct->hnumber[i]));
-		sav.read(&(ct->nucs[i]),1);
+		read(sav,&(ct->hnumber[i]));
+		sav->read(&(ct->nucs[i]),1);
 
 	}
 
-	for (i=0;i<=2*ct->GetSequenceLength();i++) read(&sav,&(ct->numseq[i]));
+	for (i=0;i<=2*ct->GetSequenceLength();i++) read(sav,&(ct->numseq[i]));
 
 
 	//Read information about nucleotides forced to be double stranded.
-	read(&sav,&(numberofconstraints));
+	read(sav,&(numberofconstraints));
 	for (i=0;i<numberofconstraints;i++) {
 		
-		read(&sav,&(constraint));
+		read(sav,&(constraint));
 
 		ct->AddDouble(constraint);
 
 	}
 	if (ct->intermolecular) {
-		for (i=0;i<3;i++) read(&sav,&(ct->inter[i]));
+		for (i=0;i<3;i++) read(sav,&(ct->inter[i]));
 
 	}
 
 	//Read information about nucleotides not allowed to pair
-	read(&sav,&(numberofconstraints));
+	read(sav,&(numberofconstraints));
 	for (i=0;i<numberofconstraints;i++) {
 		
-		read(&sav,&(constraint));
+		read(sav,&(constraint));
 
 		ct->AddSingle(constraint);
 
 	}
 
 	//Read information about nucleotides that are accessible to chemical modification:
-	read(&sav,&(numberofconstraints));
+	read(sav,&(numberofconstraints));
 	for (i=0;i<numberofconstraints;i++) {
 		
-		read(&sav,&(constraint));
+		read(sav,&(constraint));
 
 		ct->AddModified(constraint);
 
 	}
 
 	//Read information about Us in GU pairs:
-	read(&sav,&(numberofconstraints));
+	read(sav,&(numberofconstraints));
 	for (i=0;i<numberofconstraints;i++) {
 		
-		read(&sav,&(constraint));
+		read(sav,&(constraint));
 
 		ct->AddGUPair(constraint);
 
 	}
 
 	string label;
-	read(&sav,&(label));
+	read(sav,&(label));
 	ct->SetSequenceLabel(label);
 
-	read(&sav,&(ct->templated));
+	read(sav,&(ct->templated));
 	if (ct->templated) {
 		ct->allocatetem();
 		for (i=0;i<=ct->GetSequenceLength();i++) {
-			for (j=0;j<=i;j++) read(&sav,&(ct->tem[i][j]));
+			for (j=0;j<=i;j++) read(sav,&(ct->tem[i][j]));
 
 		}
 
 	}
 
-	read(&sav,&(ct->shaped));
+	read(sav,&(ct->shaped));
 	if (ct->shaped) {
 		ct->SHAPE = new double [2*ct->GetSequenceLength()+1];
-		for (i=0;i<=2*ct->GetSequenceLength();i++) read(&sav,&(ct->SHAPE[i]));
+		for (i=0;i<=2*ct->GetSequenceLength();i++) read(sav,&(ct->SHAPE[i]));
 		ct->SHAPEss = new double [2 * ct->GetSequenceLength() + 1];
-		for (i=0;i<=2*ct->GetSequenceLength();i++) read(&sav,&(ct->SHAPEss[i]));
-
-	}
-
-
-	//now read the array class data for v, w, and wmb:
-	for (i=0;i<=ct->GetSequenceLength();i++) {
-		read(&sav,&(w3[i]));
-		read(&sav,&(w5[i]));
-//<<<<<<< pfunction.cpp
-//		for (j=0;j<=ct->GetSequenceLength();j++) {
-//			read(&sav,&(v->dg[i][j]));
-//			read(&sav,&(w->dg[i][j]));
-//			read(&sav,&(wmb->dg[i][j]));
-//			read(&sav,&(wmbl->dg[i][j]));
-//			read(&sav,&(wl->dg[i][j]));
-//			read(&sav,&(wcoax->dg[i][j]));
-//=======
-		for (j=0;j<=ct->GetSequenceLength();j++) {
-			read(&sav,&(v->dg[i][j+i]));
-			read(&sav,&(w->dg[i][j+i]));
-			read(&sav,&(wmb->dg[i][j+i]));
-			read(&sav,&(wmbl->dg[i][j+i]));
-			read(&sav,&(wl->dg[i][j+i]));
-			read(&sav,&(wcoax->dg[i][j+i]));
-//>>>>>>> 1.30
-			readsinglechar(&sav,&(fce->dg[i][j]));
-			//if (ct->intermolecular) {
-			//	read(&sav,&(w2->dg[i][j]));
-			//	read(&sav,&(wmb2->dg[i][j]));
-
-			//}
-
-
-		}
-
-
-	}
-
-	read(&sav,&(w3[ct->GetSequenceLength()+1]));
-	for (i=0;i<=2*ct->GetSequenceLength();i++) {
-		read(&sav,&(lfce[i]));
-		read(&sav,&(mod[i]));
+		for (i=0;i<=2*ct->GetSequenceLength();i++) read(sav,&(ct->SHAPEss[i]));
 
 	}
+}
 
+//Read the thermodynamic data at the end of a partition function save file.
+static void readpfdata(ifstream *sav, pfdatatable *data) {
+	int i,j,k,l,m,n,o,p;
+	int inc[6][6]={{0,0,0,0,0,0},{0,0,0,0,1,0},{0,0,0,1,0,0},{0,0,1,0,1,0},
+	{0,1,0,1,0,0},{0,0,0,0,0,0}};//a mask array indicating the identity of canonical pairs
 
-
-
-
-	//now read the thermodynamic data:
-	read(&sav,&(data->temp));
-	for (i=0;i<5;i++) read(&sav,&(data->poppen[i]));
-	read(&sav,&(data->maxpen));
-	for (i=0;i<11;i++) read(&sav,&(data->eparam[i]));
+	read(sav,&(data->temp));
+	for (i=0;i<5;i++) read(sav,&(data->poppen[i]));
+	read(sav,&(data->maxpen));
+	for (i=0;i<11;i++) read(sav,&(data->eparam[i]));
 	for (i=0;i<31;i++) {
-		read(&sav,&(data->inter[i]));
-		read(&sav,&(data->bulge[i]));
-		read(&sav,&(data->hairpin[i]));
+		read(sav,&(data->inter[i]));
+		read(sav,&(data->bulge[i]));
+		read(sav,&(data->hairpin[i]));
 
 	}
 	for (i=0;i<6;i++) {
 		for (j=0;j<6;j++) {
 			for (k=0;k<6;k++) {
 				for (l=0;l<3;l++) {
-					read(&sav,&(data->dangle[i][j][k][l]));
+					read(sav,&(data->dangle[i][j][k][l]));
 				}
 				for (l=0;l<6;l++) {
-					read(&sav,&(data->stack[i][j][k][l]));
-					read(&sav,&(data->tstkh[i][j][k][l]));
-					read(&sav,&(data->tstki[i][j][k][l]));
-					read(&sav,&(data->coax[i][j][k][l]));
-					read(&sav,&(data->tstackcoax[i][j][k][l]));
-					read(&sav,&(data->coaxstack[i][j][k][l]));
-					read(&sav,&(data->tstack[i][j][k][l]));
-					read(&sav,&(data->tstkm[i][j][k][l]));
-					read(&sav,&(data->tstki23[i][j][k][l]));
-					read(&sav,&(data->tstki1n[i][j][k][l]));
+					read(sav,&(data->stack[i][j][k][l]));
+					read(sav,&(data->tstkh[i][j][k][l]));
+					read(sav,&(data->tstki[i][j][k][l]));
+					read(sav,&(data->coax[i][j][k][l]));
+					read(sav,&(data->tstackcoax[i][j][k][l]));
+					read(sav,&(data->coaxstack[i][j][k][l]));
+					read(sav,&(data->tstack[i][j][k][l]));
+					read(sav,&(data->tstkm[i][j][k][l]));
+					read(sav,&(data->tstki23[i][j][k][l]));
+					read(sav,&(data->tstki1n[i][j][k][l]));
 					for (m=0;m<6;m++) {
 						for (n=0;n<6;n++) {
-							read(&sav,&(data->iloop11[i][j][k][l][m][n]));
+							read(sav,&(data->iloop11[i][j][k][l][m][n]));
 							for (o=0;o<6;o++) {
-								if (inc[i][j]&&inc[n][o]) read(&sav,&(data->iloop21[i][j][k][l][m][n][o]));
+								if (inc[i][j]&&inc[n][o]) read(sav,&(data->iloop21[i][j][k][l][m][n][o]));
 								for (p=0;p<6;p++) {
 									if (inc[i][k]&&inc[j][l])
-										read(&sav,&(data->iloop22[i][j][k][l][m][n][o][p]));
+										read(sav,&(data->iloop22[i][j][k][l][m][n][o][p]));
 								}
 							}
 
@@ -3878,42 +4064,172 @@ void readpfsave(const char *filename, structure *ct,
 			}
 		}
 	}
-	read(&sav,&(data->numoftloops));
+	read(sav,&(data->numoftloops));
 	for (i=0;i<=data->numoftloops;i++) {
-		read(&sav,&(data->itloop[i]));
-		read(&sav,&(data->tloop[i]));
+		read(sav,&(data->itloop[i]));
+		read(sav,&(data->tloop[i]));
 
 	}
-	read(&sav,&(data->numoftriloops));
+	read(sav,&(data->numoftriloops));
 	for (i=0;i<=data->numoftriloops;i++) {
-		read(&sav,&(data->itriloop[i]));
-		read(&sav,&(data->triloop[i]));
+		read(sav,&(data->itriloop[i]));
+		read(sav,&(data->triloop[i]));
 
 	}
-	read(&sav,&(data->numofhexaloops));
+	read(sav,&(data->numofhexaloops));
 	for (i=0;i<=data->numofhexaloops;i++) {
-		read(&sav,&(data->ihexaloop[i]));
-		read(&sav,&(data->hexaloop[i]));
+		read(sav,&(data->ihexaloop[i]));
+		read(sav,&(data->hexaloop[i]));
+
+	}
+	read(sav,&(data->auend));
+	read(sav,&(data->gubonus));
+	read(sav,&(data->cint));
+	read(sav,&(data->cslope));
+	read(sav,&(data->c3));
+	read(sav,&(data->efn2a));
+	read(sav,&(data->efn2b));
+	read(sav,&(data->efn2c));
+	read(sav,&(data->init));
+	read(sav,&(data->mlasym));
+	read(sav,&(data->strain));
+	read(sav,&(data->prelog));
+	read(sav,&(data->singlecbulge));
+	read(sav,&(data->maxintloopsize));
+}
+
+//readpfsave reads a save file with partition function data.
+bool readpfsave(const char *filename, structure *ct,
+			 PFPRECISION *w5, PFPRECISION *w3,
+			 pfunctionclass *v, pfunctionclass *w, pfunctionclass *wmb, pfunctionclass *wl, pfunctionclass *wmbl, pfunctionclass *wcoax,
+			 forceclass *fce, PFPRECISION *scaling, bool *mod, bool *lfce, pfdatatable *data) {
+	int i,j;
+	ifstream sav(filename,ios::binary);
+	short vers;
+
+	readpfsaveheader(&sav,ct,scaling,data,&vers);
 
+	if (vers<5) {
+		//The elements of the arrays are interleaved.
+		for (i=0;i<=ct->GetSequenceLength();i++) {
+			read(&sav,&(w3[i]));
+			read(&sav,&(w5[i]));
+			for (j=0;j<=ct->GetSequenceLength();j++) {
+				read(&sav,&(v->dg[i][j+i]));
+				read(&sav,&(w->dg[i][j+i]));
+				read(&sav,&(wmb->dg[i][j+i]));
+				read(&sav,&(wmbl->dg[i][j+i]));
+				read(&sav,&(wl->dg[i][j+i]));
+				read(&sav,&(wcoax->dg[i][j+i]));
+				readsinglechar(&sav,&(fce->dg[i][j]));
+			}
+		}
+
+		read(&sav,&(w3[ct->GetSequenceLength()+1]));
+		for (i=0;i<=2*ct->GetSequenceLength();i++) {
+			read(&sav,&(lfce[i]));
+			read(&sav,&(mod[i]));
+
+		}
+
+		//now read the thermodynamic data:
+		readpfdata(&sav,data);
+		sav.close();
+		return true;
+	}
+
+	if (!readpfsaveprecision(&sav)) {
+		sav.close();
+		return false;
+	}
+
+	//now read the arrays, each as one block:
+	long offsets[pfsaveblocks];
+	long arraysize = (long) (ct->GetSequenceLength()+1)*(ct->GetSequenceLength()+1)*sizeof(PFPRECISION);
+	pfunctionclass *arrays[6] = {v,w,wmb,wmbl,wl,wcoax};
+
+	pfsaveoffsets((long) sav.tellg(),ct->GetSequenceLength(),offsets);
+	for (i=0;i<6;i++) {
+		sav.seekg(offsets[pfsavev+i]);
+		//dg[0] is the start of the single allocation that holds the array
+		sav.read((char *) arrays[i]->dg[0],arraysize);
 	}
-	read(&sav,&(data->auend));
-	read(&sav,&(data->gubonus));
-	read(&sav,&(data->cint));
-	read(&sav,&(data->cslope));
-	read(&sav,&(data->c3));
-	read(&sav,&(data->efn2a));
-	read(&sav,&(data->efn2b));
-	read(&sav,&(data->efn2c));
-	read(&sav,&(data->init));
-	read(&sav,&(data->mlasym));
-	read(&sav,&(data->strain));
-	read(&sav,&(data->prelog));
-	read(&sav,&(data->singlecbulge));
-	read(&sav,&(data->maxintloopsize));
+	sav.seekg(offsets[pfsavew5]);
+	sav.read((char *) w5,(ct->GetSequenceLength()+1)*sizeof(PFPRECISION));
+	sav.seekg(offsets[pfsavew3]);
+	sav.read((char *) w3,(ct->GetSequenceLength()+2)*sizeof(PFPRECISION));
+	sav.seekg(offsets[pfsavefce]);
+	for (i=0;i<=ct->GetSequenceLength();i++) sav.read(fce->dg[i],ct->GetSequenceLength()+1);
+	sav.seekg(offsets[pfsavelfce]);
+	sav.read((char *) lfce,(2*ct->GetSequenceLength()+1)*sizeof(bool));
+	sav.seekg(offsets[pfsavemod]);
+	sav.read((char *) mod,(2*ct->GetSequenceLength()+1)*sizeof(bool));
+
+	//now read the thermodynamic data:
+	sav.seekg(offsets[pfsavedata]);
+	readpfdata(&sav,data);
+
+	bool good = !sav.fail();
+	sav.close();
+	return good;
+}
+
+//mappfsave reads a save file of the current version, mapping it into memory so that v, w, wmb, wl, wmbl, and wcoax are used in place.
+mappedfile *mappfsave(const char *filename, structure *ct,
+			 PFPRECISION *w5, PFPRECISION *w3,
+			 pfunctionclass **v, pfunctionclass **w, pfunctionclass **wmb, pfunctionclass **wl, pfunctionclass **wmbl, pfunctionclass **wcoax,
+			 forceclass *fce, PFPRECISION *scaling, bool *mod, bool *lfce, pfdatatable *data) {
+	int i;
+	ifstream sav(filename,ios::binary);
+	short vers;
+	long offsets[pfsaveblocks];
+	mappedfile *mapping;
 
+	readpfsaveheader(&sav,ct,scaling,data,&vers);
+	if (vers!=pfsaveversion||!readpfsaveprecision(&sav)) {
+		sav.close();
+		return NULL;
+	}
+	pfsaveoffsets((long) sav.tellg(),ct->GetSequenceLength(),offsets);
+
+	//The mapping is copy on write, so the arrays can be changed like arrays read into memory.
+	mapping = new mappedfile(filename,true);
+	if (!mapping->good()||mapping->size()<(size_t) offsets[pfsavedata]) {
+		delete mapping;
+		sav.close();
+		return NULL;
+	}
+	*v = new pfunctionclass(ct->GetSequenceLength(),(PFPRECISION *) (mapping->data()+offsets[pfsavev]));
+	*w = new pfunctionclass(ct->GetSequenceLength(),(PFPRECISION *) (mapping->data()+offsets[pfsavew]));
+	*wmb = new pfunctionclass(ct->GetSequenceLength(),(PFPRECISION *) (mapping->data()+offsets[pfsavewmb]));
+	*wmbl = new pfunctionclass(ct->GetSequenceLength(),(PFPRECISION *) (mapping->data()+offsets[pfsavewmbl]));
+	*wl = new pfunctionclass(ct->GetSequenceLength(),(PFPRECISION *) (mapping->data()+offsets[pfsavewl]));
+	*wcoax = new pfunctionclass(ct->GetSequenceLength(),(PFPRECISION *) (mapping->data()+offsets[pfsavewcoax]));
+
+	//The other arrays are small, so they are copied.
+	memcpy(w5,mapping->data()+offsets[pfsavew5],(ct->GetSequenceLength()+1)*sizeof(PFPRECISION));
+	memcpy(w3,mapping->data()+offsets[pfsavew3],(ct->GetSequenceLength()+2)*sizeof(PFPRECISION));
+	for (i=0;i<=ct->GetSequenceLength();i++) memcpy(fce->dg[i],mapping->data()+offsets[pfsavefce]+(long) i*(ct->GetSequenceLength()+1),ct->GetSequenceLength()+1);
+	memcpy(lfce,mapping->data()+offsets[pfsavelfce],(2*ct->GetSequenceLength()+1)*sizeof(bool));
+	memcpy(mod,mapping->data()+offsets[pfsavemod],(2*ct->GetSequenceLength()+1)*sizeof(bool));
 
+	//now read the thermodynamic data:
+	sav.seekg(offsets[pfsavedata]);
+	readpfdata(&sav,data);
+	if (sav.fail()) {
+		delete *v;
+		delete *w;
+		delete *wmb;
+		delete *wmbl;
+		delete *wl;
+		delete *wcoax;
+		delete mapping;
+		sav.close();
+		return NULL;
+	}
 
 	sav.close();
+	return mapping;
 }
 
 //return the pairing probability of the i=j pair, where i<j.
@@ -4263,7 +4579,7 @@ void pfdatatable::rescaledatatable(PFPRECISION rescalefactor) {
 
 //thresh-structure builds a structure containing all base pairs above the probability thresh (expressed as a fraction from 0 to 1).
 //Note that thresh must be 0.5 or larger for the resulting structure to be a valid secondary structure.
-void thresh_structure(structure *ct, char *pfsfile, double thresh) {
+int thresh_structure(structure *ct, char *pfsfile, double thresh) {
 
 
 	int i,j;
@@ -4279,8 +4595,7 @@ void thresh_structure(structure *ct, char *pfsfile, double thresh) {
 
 
 	read(&sav,&(vers));//read the version of the save file
-		//right now there is no infrastructure to indicate the wrong version is being read.
-		//This should be changed in the future...
+		//a save file of the wrong version is detected by readpfsave
 
 	int SequenceLength;
 	read(&sav,&(SequenceLength));
@@ -4319,29 +4634,32 @@ void thresh_structure(structure *ct, char *pfsfile, double thresh) {
 	data = new pfdatatable();
 
 	//load all the data from the pfsavefile:
-	readpfsave(pfsfile, ct, w5, w3,v, w, wmb,wl, wmbl, wcoax, fce,&scaling,mod,lfce,data);
+	int error = 0;
+	if (readpfsave(pfsfile, ct, w5, w3,v, w, wmb,wl, wmbl, wcoax, fce,&scaling,mod,lfce,data)) {
 
-	//reset the base pairing info:
-	//for (i=1;i<=ct->GetSequenceLength();i++) ct->basepr[1][i]=0;
+		//reset the base pairing info:
+		//for (i=1;i<=ct->GetSequenceLength();i++) ct->basepr[1][i]=0;
 
-	ct->AddStructure();
-	//fill array with the values for the plot:
-	for (i=1;i<ct->GetSequenceLength();i++) {
-		for (j=i+1;j<=ct->GetSequenceLength();j++) {
+		ct->AddStructure();
+		//fill array with the values for the plot:
+		for (i=1;i<ct->GetSequenceLength();i++) {
+			for (j=i+1;j<=ct->GetSequenceLength();j++) {
 
 
 
-			if(calculateprobability(i,j,v,w5,ct,data,lfce,mod,scaling,fce)>thresh) {
+				if(calculateprobability(i,j,v,w5,ct,data,lfce,mod,scaling,fce)>thresh) {
 
-				ct->SetPair(i,j);
+					ct->SetPair(i,j);
 
 
-			}
+				}
 
 
 
+			}
 		}
 	}
+	else error = 16;
 
 	//now build the structure
 
@@ -4364,5 +4682,6 @@ void thresh_structure(structure *ct, char *pfsfile, double thresh) {
 	delete wl;
 	delete wcoax;
 
+	return error;
 
 }
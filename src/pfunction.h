@@ -7,6 +7,9 @@
 #ifdef EXTENDED_DOUBLE
 	#include "extended_double.h" //inlcude code for extended double if needed
 #endif//defined EXTENDED_DOUBLE
+#ifdef LOG_DOUBLE
+	#include "log_double.h" //include code for log double if needed
+#endif//defined LOG_DOUBLE
 
 
 #ifdef _WINDOWS_GUI
@@ -14,6 +17,7 @@
 #endif //_WINDOWS
 #include "structure.h"
 #include "algorithm.h"
+#include "mappedfile.h"
 
 
 ////////////////////////////////////////////////////////////////////////
@@ -22,16 +26,27 @@
 class pfunctionclass {
    int Size;
 
+   //All of the array is a single allocation; row i holds the Size+1 fragments
+   //	i to i..i+Size, so fragment i,j is at storage[i*Size+j]
+   PFPRECISION *storage;
+
+   //Whether storage was allocated by the constructor, rather than provided
+   bool ownsstorage;
+
    public:
    	
       int k;
-      PFPRECISION **dg;
+      PFPRECISION **dg;//dg[i] points into storage so that dg[i][j] is fragment i,j
       PFPRECISION infinite;
       
 
       //the constructor allocates the space needed by the arrays
    	pfunctionclass(int size);
 
+      //this constructor uses external, which holds (size+1)*(size+1) values laid out as in storage, in place of allocating;
+      //	external must outlast the class, which does not delete it
+   	pfunctionclass(int size, PFPRECISION *external);
+
       //the destructor deallocates the space used
       ~pfunctionclass();
 
@@ -41,8 +56,14 @@ class pfunctionclass {
 		   if (i>j) {
 				return infinite;
 			}
-		   else if (i>Size) return f(i-Size,j-Size);
-		   else return dg[i][j];
+
+		   //Fragments with i>Size are stored as i-Size to j-Size
+		   //The two tests are kept as branches: the recursions almost always predict them, and selecting
+		   //	with masks instead measured slower
+		   int shift = (i>Size)?Size:0;
+		   i-=shift;
+		   j-=shift;
+		   return storage[(long) i*Size+j];
 	  }
 };
 
@@ -115,11 +136,23 @@ void writepfsave(char *filename, structure *ct,
 			 pfunctionclass *v, pfunctionclass *w, pfunctionclass *wmb, pfunctionclass *wl, pfunctionclass *wmbl, pfunctionclass *wcoax,
 			 forceclass *fce, bool *mod, bool *lfce, pfdatatable *data);
 
-//readpfsave reads a save file with partition function data.
-void readpfsave(const char *filename, structure *ct, 
+//readpfsave reads a save file with partition function data into arrays allocated by the caller.
+//It reads the current version of the file and version 4.  It returns false if the file was written with another
+//	PFPRECISION, or is incomplete.
+bool readpfsave(const char *filename, structure *ct, 
 			 PFPRECISION *w5, PFPRECISION *w3, 
 			 pfunctionclass *v, pfunctionclass *w, pfunctionclass *wmb, pfunctionclass *wl, pfunctionclass *wmbl, pfunctionclass *wcoax,
 			 forceclass *fce, PFPRECISION *scaling, bool *mod, bool *lfce, pfdatatable *data);
+
+//mappfsave reads a save file of the current version (pfsaveversion) by mapping it into memory.
+//v, w, wmb, wl, wmbl, and wcoax receive new arrays that use the file in place, so that only the parts of them that are
+//	used are read from disk; the other arrays are allocated by the caller, as for readpfsave.
+//It returns the mapping, which must be deleted after the arrays, or NULL if the file is another version, was written with
+//	another PFPRECISION, or is incomplete.
+mappedfile *mappfsave(const char *filename, structure *ct,
+			 PFPRECISION *w5, PFPRECISION *w3,
+			 pfunctionclass **v, pfunctionclass **w, pfunctionclass **wmb, pfunctionclass **wl, pfunctionclass **wmbl, pfunctionclass **wcoax,
+			 forceclass *fce, PFPRECISION *scaling, bool *mod, bool *lfce, pfdatatable *data);
 PFPRECISION calculateprobability(int i, int j, pfunctionclass *v, PFPRECISION *w5, structure *ct, pfdatatable *data, bool *lfce, bool *mod, PFPRECISION scaling, forceclass *fce);
 void rescale(int i, int j,structure *ct, pfdatatable *data, pfunctionclass *v, pfunctionclass *w, pfunctionclass *wl, pfunctionclass *wcoax,
 			 pfunctionclass *wmb,pfunctionclass *wmbl, PFPRECISION *w5, PFPRECISION *w3, PFPRECISION **wca, PFPRECISION **curE, PFPRECISION **prevE, PFPRECISION rescalefactor); //function to rescale all arrays when partition function calculation is headed out
@@ -130,7 +163,7 @@ void rescale(int i, int j,structure *ct, pfdatatable *data, pfunctionclass *v, p
 //void rescaleatw5(int jj,structure *ct, pfdatatable *data, pfunctionclass *v, pfunctionclass *w, pfunctionclass *wl, pfunctionclass *wcoax,
 //			 pfunctionclass *wmb,pfunctionclass *wmbl, PFPRECISION *w5, PFPRECISION *w3, double rescalefactor); //function to rescale all arrays when partition function calculation is headed out
 															//of bounds when claculating w5
-void thresh_structure(structure *ct, char *pfsfile, double thresh); //determine a structure of probable base pairs (greater than thresh) and deposit it in ct.
+int thresh_structure(structure *ct, char *pfsfile, double thresh); //determine a structure of probable base pairs (greater than thresh) and deposit it in ct; returns 16 if the save file cannot be read, otherwise 0.
 
 //calculate a the partition function, given that the arrays have been allocated
 void calculatepfunction(structure* ct,pfdatatable* data, TProgressDialog* update, char* save, bool quickQ, PFPRECISION *Q,
@@ -96,6 +96,7 @@ t_phmm_aln::t_phmm_aln(t_structure* _seq1, t_structure* _seq2)
 	this->aln_coinc_priors = NULL;
 	this->seq1_alignment_constraints = NULL;
 	this->seq2_alignment_constraints = NULL;
+	this->workspace = NULL;
 
 	this->check_set_seqs();
 }
@@ -111,6 +112,7 @@ t_phmm_aln::t_phmm_aln(char* seq1_fp, char* seq2_fp)
 	this->aln_coinc_priors = NULL;
 	this->seq1_alignment_constraints = NULL;
 	this->seq2_alignment_constraints = NULL;
+	this->workspace = NULL;
 
 	this->check_set_seqs();
 }
@@ -141,6 +143,11 @@ void t_phmm_aln::set_phmm_band_size(int _phmm_band_size)
 	this->phmm_band_constraint_size = _phmm_band_size;
 }
 
+void t_phmm_aln::set_workspace(t_phmm_workspace* _workspace)
+{
+	this->workspace = _workspace;
+}
+
 void t_phmm_aln::set_aln_constraints(int* _aligned_positions)
 {
 	this->seq1_alignment_constraints = (int*)malloc(sizeof(int) * (this->seq1->numofbases + 3));
@@ -18,6 +18,7 @@ class t_structure;
 class t_phmm;
 class t_p_alignment;
 class t_phmm_array;
+struct t_phmm_workspace;
 class t_matrix;
 
 struct t_pp_result
@@ -68,6 +69,11 @@ public:
 	void set_phmm_band_size(int _phmm_band_size);
 	void set_aln_constraints(int* _aligned_positions);
 
+	// Use the buffers in _workspace for the arrays of the ML and posterior probability computations,
+	// instead of allocating them for each computation. The caller keeps the workspace, which can be
+	// used for one alignment after another; NULL goes back to allocating the arrays.
+	void set_workspace(t_phmm_workspace* _workspace);
+
 	void check_set_seqs();
 
 	// The priors.
@@ -87,6 +93,9 @@ public:
 	// Applies to all computations done via this phmm_aln object.
 	int phmm_band_constraint_size;
 
+	// The caller's buffers for the arrays, or NULL.
+	t_phmm_workspace* workspace;
+
 	// This is the alignment constraint: Constraint on aligned positions.
 	int* seq1_alignment_constraints;
 	int* seq2_alignment_constraints;
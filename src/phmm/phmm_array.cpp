@@ -7,7 +7,34 @@
 
 bool _DUMP_PHMM_ARRAY_MESSAGES_ = false;
 
-t_phmm_array::t_phmm_array(int _n1, int _n2, int _phmm_band_constraint_size, bool mallocate)
+t_phmm_array_buffer::t_phmm_array_buffer()
+{
+	this->block = NULL;
+	this->n_bytes_alloced = 0;
+}
+
+t_phmm_array_buffer::~t_phmm_array_buffer()
+{
+	free(this->block);
+}
+
+void* t_phmm_array_buffer::get_block(size_t n_bytes)
+{
+	// Only grow the block; the contents do not need to be kept.
+	if(n_bytes > this->n_bytes_alloced)
+	{
+		free(this->block);
+		this->block = malloc(n_bytes);
+		this->n_bytes_alloced = n_bytes;
+
+if(_DUMP_PHMM_ARRAY_MESSAGES_)
+		printf("Grew phmm array buffer to %lf bytes.\n", (double)n_bytes);
+	}
+
+	return(this->block);
+}
+
+t_phmm_array::t_phmm_array(int _n1, int _n2, int _phmm_band_constraint_size, bool mallocate, t_phmm_array_buffer* buffer)
 {
 	n1 = _n1;
 	n2 = _n2;
@@ -15,72 +42,72 @@ t_phmm_array::t_phmm_array(int _n1, int _n2, int _phmm_band_constraint_size, boo
 if(_DUMP_PHMM_ARRAY_MESSAGES_)
 	printf("Allocing phmm array..\n");
 
-	this->n_bytes_alloced = 0.0f;
+	this->phmm_band_constraint_size = _phmm_band_constraint_size;
 
-	if(mallocate)
+	// Count the cells in the band, to size the block.
+	size_t n_cells = 0;
+	for(int i = 0; i <= n1 + 1; i++)
+	{
+		n_cells += t_phmm_array::high_phmm_limit(i, n1, n2, this->phmm_band_constraint_size) - t_phmm_array::low_phmm_limit(i, n1, n2, this->phmm_band_constraint_size) + 1;
+	} // i loop
+
+	// The block holds the values, then the pointers to the cells, then the pointers to the rows, then the band limits.
+	size_t n_value_bytes = sizeof(double) * N_STATES * n_cells;
+	size_t n_cell_pointer_bytes = sizeof(double*) * n_cells;
+	size_t n_row_pointer_bytes = sizeof(double**) * (n1 + 2);
+	size_t n_limit_bytes = sizeof(int) * 2 * (n1 + 2);
+
+	this->n_bytes_alloced = (double)(n_value_bytes + n_cell_pointer_bytes + n_row_pointer_bytes + n_limit_bytes);
+
+	// Without mallocate, only the band limits are needed.
+	size_t n_array_bytes = mallocate?(n_value_bytes + n_cell_pointer_bytes + n_row_pointer_bytes):0;
+
+	char* array_block = NULL;
+	if(buffer != NULL)
 	{
-		this->array = (double***)malloc(sizeof(double**) * (n1 + 2));
+		this->block = NULL;
+		array_block = (char*)buffer->get_block(n_array_bytes + n_limit_bytes);
 	}
 	else
 	{
-		this->array = NULL;
+		this->block = malloc(n_array_bytes + n_limit_bytes);
+		array_block = (char*)this->block;
 	}
 
-	this->phmm_band_constraint_size = _phmm_band_constraint_size;
+	this->low_phmm_array_limits = (int*)(array_block + n_array_bytes);
+	this->high_phmm_array_limits = this->low_phmm_array_limits + (n1 + 2);
 	this->set_hmm_array_banded_limits();
 
-	n_bytes_alloced += (sizeof(double**) * (n1 + 2));
-
-	//for(int i = 0; i <= n1 + 1; i++)
-	//{
-	//	//printf("%d -> %d, %d\n", i, this->low_phmm_array_limits[i], this->high_phmm_array_limits[i]);
-	//}
-	//
-
-	for(int i = 0; i <= n1 + 1; i++)
+	if(!mallocate)
 	{
-		int low_k = this->low_phmm_array_limits[i];
-		int high_k = this->high_phmm_array_limits[i];
-		//printf("%d -> %d, %d\n", i, low_k, high_k);
-		//int low_k = 0;
-		//int high_k = n2+1;
-
-		if(mallocate)
-		{
-			this->array[i] = (double**)malloc(sizeof(double*) * (n2 + 2));
-			this->array[i] -= low_k;
-		}
-
-		this->n_bytes_alloced += (sizeof(double*) * (high_k - low_k + 1));		
-
-if(_DUMP_PHMM_ARRAY_MESSAGES_)
-		printf("At %lf bytes for phmm array.\r", n_bytes_alloced);
+		this->array = NULL;
+	}
+	else
+	{
+		double* values = (double*)array_block;
+		double** cells = (double**)(array_block + n_value_bytes);
+		this->array = (double***)(array_block + n_value_bytes + n_cell_pointer_bytes);
 
-		for(int k = low_k; k <= high_k; k++)
+		for(int i = 0; i <= n1 + 1; i++)
 		{
-			if(mallocate)
-			{
-				this->array[i][k] = (double*)malloc(sizeof(double) * (N_STATES + 5));
-				//printf("%d, %d -> %d\n", i, k, this->array[i][k]);
-			}
+			int low_k = this->low_phmm_array_limits[i];
+			int high_k = this->high_phmm_array_limits[i];
 
-			this->n_bytes_alloced += (sizeof(double) * N_STATES);
+			this->array[i] = cells - low_k;
+			cells += high_k - low_k + 1;
 
-			for(int i_state = STATE_INS1; mallocate && i_state <= STATE_ALN; i_state++)
+			for(int k = low_k; k <= high_k; k++)
 			{
-				this->array[i][k][i_state] = xlog(0.0f);
-			}
-		} // k loop
-	} // i loop
-
-	//this->array[2][6][0] = 1221233214.0f;
-	//if(this->array[2][8][0] == 1221233214.0f)
-	//{
-	//	printf("WTF1! (%d, %d) \n", (int)this->array[2][6] , (int)this->array[2][8]);
-	//	exit(0);
-	//}
-
-	//getc(stdin);
+				this->array[i][k] = values;
+				values += N_STATES;
+
+				for(int i_state = STATE_INS1; i_state <= STATE_ALN; i_state++)
+				{
+					this->array[i][k][i_state] = xlog(0.0f);
+				}
+			} // k loop
+		} // i loop
+	}
 
 if(_DUMP_PHMM_ARRAY_MESSAGES_)
 	printf("%lf bytes allocated for phmm_array\n", this->n_bytes_alloced);
@@ -88,30 +115,8 @@ if(_DUMP_PHMM_ARRAY_MESSAGES_)
 
 t_phmm_array::~t_phmm_array()
 {
-	if(this->array != NULL)
-	{
-		//this->array = (double***)malloc(sizeof(double**) * (n1 + 4));
-		for(int i = 0; i <= n1 + 1; i++)
-		{
-			//this->array[k] = (double**)malloc(sizeof(double*) * (n2 + 4));
-			int low_k = this->low_phmm_array_limits[i];
-			int high_k = this->high_phmm_array_limits[i];
-
-			for(int k = low_k; k <= high_k; k++)
-			{
-				//this->array[k][k] = (double**)malloc(sizeof(double) * N_STATES);
-				free(this->array[i][k]);
-			}
-
-			this->array[i] += low_k;
-			free(this->array[i]);
-		}
-
-		free(this->array);
-	}
-
-	free(this->low_phmm_array_limits);
-	free(this->high_phmm_array_limits);
+	// Everything is in the block; an array in a buffer leaves the memory to the buffer.
+	free(this->block);
 }
 
 bool t_phmm_array::check_phmm_boundary(int i, int k)
@@ -160,9 +165,6 @@ bool t_phmm_array::check_phmm_boundary(int i, int k, int n1, int n2, int phmm_ba
 
 void t_phmm_array::set_hmm_array_banded_limits()
 {
-	this->low_phmm_array_limits = (int*)malloc(sizeof(int) * (this->n1 + 2));
-	this->high_phmm_array_limits = (int*)malloc(sizeof(int) * (this->n1 + 2));
-
 	for(int i = 0; i <= this->n1+1; i++)
 	{
 		this->low_phmm_array_limits[i] = t_phmm_array::low_phmm_limit(i, n1, n2, this->phmm_band_constraint_size);
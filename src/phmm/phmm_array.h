@@ -1,15 +1,50 @@
 #ifndef _PHMM_ARRAY_
 #define _PHMM_ARRAY_
 
+#include <stddef.h>
+
 /*
-t_phmm_array is a 3D array that contains state and index information, for storing 
+t_phmm_array_buffer is one block of memory that is reused by one t_phmm_array at a time.
+It keeps the largest block it was asked for, so the arrays for a series of alignments
+allocate memory only when a pair is larger than all of the pairs before it.
+*/
+class t_phmm_array_buffer
+{
+public:
+	t_phmm_array_buffer();
+	~t_phmm_array_buffer();
+
+	// Returns a block of at least n_bytes bytes, which is valid until the next call.
+	void* get_block(size_t n_bytes);
+
+	size_t n_bytes_alloced;
+
+private:
+	void* block;
+};
+
+/*
+t_phmm_workspace holds the buffers for the arrays of posterior probability computations.
+The ML array is freed before the forward array is allocated, so the two share a buffer.
+A workspace can be used by one computation at a time.
+*/
+struct t_phmm_workspace
+{
+	t_phmm_array_buffer fore_buffer; // The ML array, then the forward array.
+	t_phmm_array_buffer back_buffer; // The backward array.
+};
+
+/*
+t_phmm_array is a 3D array that contains state and index information, for storing
 forward/backward/ML array computation results.
+The band limits, the index pointers and the values are in one block of memory, which
+is taken from buffer if one is given, or is allocated and freed with the array otherwise.
 */
 
 class t_phmm_array
 {
 public:
-	t_phmm_array(int _n1, int _n2, int _phmm_band_constraint_size, bool mallocate);
+	t_phmm_array(int _n1, int _n2, int _phmm_band_constraint_size, bool mallocate, t_phmm_array_buffer* buffer = NULL);
 	~t_phmm_array();
 
 	int n1;
@@ -22,6 +57,7 @@ public:
 	static bool check_phmm_boundary(int i, int k, int n1, int n2, int phmm_band_constraint_size);
 	bool check_phmm_boundary(int i, int k);
 
+	// Fills in the band limits, which the constructor places in the block.
 	void set_hmm_array_banded_limits();
 
 	int* low_phmm_array_limits;
@@ -33,8 +69,11 @@ public:
 	double*** array;
 
 	double& x(int i, int k, int state);
+
+private:
+	// The block that holds the array, if the array allocated it, otherwise NULL.
+	void* block;
 };
 
 #endif // _PHMM_ARRAY_
 
-
@@ -66,8 +66,8 @@ t_phmm_array* t_phmm_aln::compute_ML_array(t_ML_result* ml_res)
 	// Replicate the constraints for fast processing of constraints.
 	//int* seq2_aln_const = this->get_seq2_aln_const(seq1_aln_const);
 
-	// ML array.
-	t_phmm_array* ml_array = new t_phmm_array(l1(), l2(), this->phmm_band_constraint_size, true);
+	// ML array. It is freed before the forward array is allocated, so it can use the same buffer.
+	t_phmm_array* ml_array = new t_phmm_array(l1(), l2(), this->phmm_band_constraint_size, true, (this->workspace != NULL)?&this->workspace->fore_buffer:NULL);
 
 if(_DUMP_PHMM_ML_LOOPS_MESSAGES_)
 	printf("Allocated %lf bytes for ML array\n", ml_array->n_bytes_alloced);
@@ -40,12 +40,12 @@ if(_DUMP_PHMM_PP_LOOPS_MESSAGES_)
 
 	//double n_fore_array_bytes_alloced = 0.0f;
 	//double n_back_array_bytes_alloced = 0.0f;
-	t_phmm_array* fore_array = new t_phmm_array(l1(), l2(), this->phmm_band_constraint_size, true);
+	t_phmm_array* fore_array = new t_phmm_array(l1(), l2(), this->phmm_band_constraint_size, true, (this->workspace != NULL)?&this->workspace->fore_buffer:NULL);
 
 if(_DUMP_PHMM_PP_LOOPS_MESSAGES_)
 	printf("Allocated %lf bytes for forward array\n", fore_array->n_bytes_alloced);
 
-	t_phmm_array* back_array = new t_phmm_array(l1(), l2(), this->phmm_band_constraint_size, true);
+	t_phmm_array* back_array = new t_phmm_array(l1(), l2(), this->phmm_band_constraint_size, true, (this->workspace != NULL)?&this->workspace->back_buffer:NULL);
 
 if(_DUMP_PHMM_PP_LOOPS_MESSAGES_)
 	printf("Allocated %lf bytes for backward array\n", back_array->n_bytes_alloced);
@@ -79,7 +79,7 @@ if(_DUMP_PHMM_PP_LOOPS_MESSAGES_)
 
 
 	//printf("Output probability of sequences is %.5f\n", output_prob);
-	if(!xlog_comp(fore_output_prob, back_output_prob))
+	if(!xlog_comp(fore_output_prob, back_output_prob, l1() + l2()))
 	{
 		//printf("Output probabilities from forward and backward computations are not same: %.25f\n", xexp(xlog_div(xlog_sub(fore_output_prob, back_output_prob), fore_output_prob)));
 		printf("Output probabilities from forward and backward computations are not same: %.25f\n", fore_output_prob, back_output_prob);
@@ -157,7 +157,7 @@ if(_DUMP_PHMM_PP_LOOPS_MESSAGES_)
 		}
 
 		// All these above should sum up to 1.
-		if(!xlog_comp(xlog_sum(total_ins1, total_aln), xlog(1.0f)))
+		if(!xlog_comp(xlog_sum(total_ins1, total_aln), xlog(1.0f), 2 * (l1() + l2())))
 		{
 			printf("Forward-backward computation failed for nucleotide %d of 1st sequence: %.25f <-> %.25f\n", i, xlog_sum(total_ins1, total_aln), xlog(1.0f));
 			//exit(0);
@@ -190,7 +190,7 @@ if(_DUMP_PHMM_PP_LOOPS_MESSAGES_)
 		}
 
 		// All these above should sum up to 1.
-		if(!xlog_comp(xlog_sum(total_ins2, total_aln), xlog(1.0)))
+		if(!xlog_comp(xlog_sum(total_ins2, total_aln), xlog(1.0), 2 * (l1() + l2())))
 		{
 			printf("Forward backward computation failed for nucleotide %d of 2nd sequence: %.5f <-> %.5f\n", k, xlog_sum(total_ins2, total_aln), back_output_prob);
 			//exit(0);
@@ -308,60 +308,44 @@ void t_phmm_aln::compute_forward_array(t_phmm_array* fore_array)
 if(_DUMP_PHMM_PP_LOOPS_MESSAGES_)
 			printf("fore(%d, x)\r", i);
 
+			// The cell at (0, 0) is set by init_forward_array.
+			if(i == 0 && k == 0)
+			{
+				continue;
+			}
+
+			double coinc_prior = this->get_coinc_prior(i,k);
+
 			// This loop is for iterating over possible states in this alignment pair.
 			for(int current_state = 0; current_state < N_STATES; current_state++)
 			{
-				if(i != 0 || k != 0)
+				// The cell before this one on the path: STATE_ALN emits i and k, STATE_INS1 emits i and STATE_INS2 emits k.
+				int prev_i = (current_state == STATE_INS2)?(i):(i-1);
+				int prev_k = (current_state == STATE_INS1)?(k):(k-1);
+
+				bool forbid_current_state = (current_state == STATE_ALN && forbid_STATE_ALN) ||
+											(current_state == STATE_INS1 && forbid_STATE_INS1) ||
+											(current_state == STATE_INS2 && forbid_STATE_INS2);
+
+				// The terms of the sum over the previous state, which are added at once.
+				double terms[N_STATES];
+				int n_terms = 0;
+
+				if(!forbid_current_state &&
+					prev_i >= 0 &&
+					prev_k >= 0 &&
+					fore_array->check_phmm_boundary(prev_i, prev_k))
 				{
-					fore_array->x(i, k, current_state) = xlog(0);
-				}
-
-				// This loop is for marginalizing over previous state.
-				for(int prev_state = 0; prev_state < N_STATES; prev_state++)
-				{
-					if(!forbid_STATE_ALN && 
-						current_state == STATE_ALN && 
-						i > 0 && 
-						k > 0 &&
-						fore_array->check_phmm_boundary(i-1, k-1))
+					// This loop is for marginalizing over previous state.
+					for(int prev_state = 0; prev_state < N_STATES; prev_state++)
 					{
-						//printf("prev_state = %s\n", state_names[prev_state]);
-						//printf("%s -> %s\n", state_names[prev_state), state_names[current_state]);
-						double trans_emit_prob = xlog_mul(get_trans_emit_prob(prev_state, current_state, i, k), this->get_coinc_prior(i,k));
+						double trans_emit_prob = xlog_mul(get_trans_emit_prob(prev_state, current_state, i, k), coinc_prior);
 
-						fore_array->x(i,k,current_state) = xlog_sum(fore_array->x(i,k,current_state), xlog_mul(fore_array->x(i-1,k-1,prev_state), trans_emit_prob));							
+						terms[n_terms++] = xlog_mul(fore_array->x(prev_i, prev_k, prev_state), trans_emit_prob);
 					}
-					
-					if(!forbid_STATE_INS1 && 
-						current_state == STATE_INS1 && 
-						i > 0 &&
-						fore_array->check_phmm_boundary(i-1, k))
-					{
-						//printf("prev_state = %s\n", state_names[prev_state]);
-						//printf("%s -> %s\n", state_names[prev_state), state_names[current_state]);
-						double trans_emit_prob = xlog_mul(get_trans_emit_prob(prev_state, current_state, i, k), this->get_coinc_prior(i,k));
-
-						fore_array->x(i,k,current_state) = xlog_sum(fore_array->x(i,k,current_state), xlog_mul(fore_array->x(i-1,k,prev_state), trans_emit_prob));
-					}
-					
-					if(!forbid_STATE_INS2 &&
-						current_state == STATE_INS2 && 
-						k > 0 &&
-						fore_array->check_phmm_boundary(i, k-1))
-					{
-						//printf("prev_state = %s\n", state_names[prev_state]);
-						//printf("%s -> %s\n", state_names[prev_state), state_names[current_state]);
-						double trans_emit_prob = xlog_mul(get_trans_emit_prob(prev_state, current_state, i, k), this->get_coinc_prior(i,k));
-
-						fore_array->x(i,k,current_state) = xlog_sum(fore_array->x(i,k,current_state), xlog_mul(fore_array->x(i,k-1,prev_state), trans_emit_prob));
-					}
-					//else
-					//{
-					//	printf("Problem while computing forward variable, code has seen the thing that should not be @ %s(%d)\n", __FILE__, __LINE__);
-					//	printf("%d, %d\n", i, k);
-					//	//exit(0); // This is a fatal error.
-					//}
 				}
+
+				fore_array->x(i, k, current_state) = xlog_sum(terms, n_terms);
 			} // State loop.
 		} // k loop.
 	} // i loop.
@@ -399,9 +383,6 @@ if(_DUMP_PHMM_PP_LOOPS_MESSAGES_)
 			// This loop is for iterating over possible states in this alignment pair.
 			for(int current_state = 0; current_state < N_STATES; current_state++)
 			{
-				//printf("------------------------------------\n");
-				back_array->x(i, k, current_state) = xlog(0);
-
 				bool forbid_current_state_comp = false;
 				if((current_state == STATE_INS1 && forbid_STATE_INS1) ||
 					(current_state == STATE_INS2 && forbid_STATE_INS2) ||
@@ -410,73 +391,27 @@ if(_DUMP_PHMM_PP_LOOPS_MESSAGES_)
 					forbid_current_state_comp = true;
 				}
 
+				// The terms of the sum over the next state, which are added at once.
+				double terms[N_STATES];
+				int n_terms = 0;
+
 				// This loop is for marginalizing over next state.
 				for(int next_state = 0; !forbid_current_state_comp && next_state < N_STATES; next_state++)
 				{
+					// The cell after this one on the path: STATE_ALN emits i+1 and k+1, STATE_INS1 emits i+1 and STATE_INS2 emits k+1.
+					int next_i = (next_state == STATE_INS2)?(i):(i+1);
+					int next_k = (next_state == STATE_INS1)?(k):(k+1);
+
 					// Transition to next state and emission of next pair of symbols.
-					if(next_state == STATE_ALN && 
-						i <= l1() && 
-						k <= l2() &&
-						back_array->check_phmm_boundary(i+1, k+1))
-					{
-						// Next state is emitting starting with i + 1 and k + 1.
-						//printf("next_state = %s (prob = %f)\n", state_names[next_state,  back_array->x(i+1, k+1, next_state]);
-						//printf("%s -> %s\n", state_names[current_state,  state_names[next_state]);
-						//printf("%s(%d)\n", __FILE__, __LINE__);
-						double trans_emit_prob = xlog_mul(this->get_coinc_prior(i+1, k+1), get_trans_emit_prob(current_state, next_state, i+1, k+1));
-/*
-						if(i == hmm_array->n_length1)
-						{
-							printf("Trans-emit probability with i = l1, k = %d(%d) for transition and emission is %.5f\n", k, hmm_array->n_length2, trans_emit_prob);
-							cin.get();
-						}*/
-
-						//printf("Recursing on (%d, %d) with prob. %f.\n", i+1, k+1, back_array->x(i+1, k+1, next_state]);
-						back_array->x(i, k, current_state) = xlog_sum(back_array->x(i, k, current_state),  xlog_mul(back_array->x(i+1, k+1, next_state),  trans_emit_prob));
-					}
-					
-					if(next_state == STATE_INS1 &&
-						i <= l1() && 
-						back_array->check_phmm_boundary(i+1, k))
+					if(back_array->check_phmm_boundary(next_i, next_k))
 					{
-						// Next state is emitting starting with i + 1 and k.
-						//printf("next_state = %s (prob = %f)\n", state_names[`next_state,  back_array->x(i+1, k, next_state]);
-						//printf("%s -> %s\n", state_names[current_state,  state_names[next_state]);
-						//printf("%s(%d)\n", __FILE__, __LINE__);
-						double trans_emit_prob = xlog_mul(this->get_coinc_prior(i+1, k), get_trans_emit_prob(current_state, next_state, i+1, k));
-
-						//printf("Recursing on (%d, %d) with prob. %f.\n", i+1, k, back_array->x(i+1, k, next_state]);
-						back_array->x(i, k, current_state) = xlog_sum(back_array->x(i, k, current_state),  xlog_mul(back_array->x(i+1, k, next_state),  trans_emit_prob));
-
-						/*if(i == hmm_array->n_length1)
-						{
-							printf("Trans-emit probability with i = l1, k = %d for transition and emission is %.5f\n", k, trans_emit_prob);
-							cin.get();
-						}*/
+						double trans_emit_prob = xlog_mul(this->get_coinc_prior(next_i, next_k), get_trans_emit_prob(current_state, next_state, next_i, next_k));
+
+						terms[n_terms++] = xlog_mul(back_array->x(next_i, next_k, next_state), trans_emit_prob);
 					}
-					
-					if(next_state == STATE_INS2 &&
-						k <= l2() && 
-						back_array->check_phmm_boundary(i, k+1))
-					{
-						// Next state is emitting starting with i and k + 1.
-						//printf("next_state = %s (prob = %f)\n\n", state_names[next_state,  back_array->x(i, k+1, next_state]);
-						//printf("%s -> %s\n", state_names[current_state,  state_names[next_state]);
-						//printf("%s(%d)\n", __FILE__, __LINE__);
-						double trans_emit_prob = xlog_mul(this->get_coinc_prior(i, k+1), get_trans_emit_prob(current_state, next_state, i, k+1));
-
-						/*if(i == 0 && k == hmm_array->n_length2)
-						{
-							printf("Trans-emit probability for transition and emission is %.5f\n", trans_emit_prob);
-							cin.get();
-						}*/
-
-						//printf("Recursing on (%d, %d) with prob. %f.\n", i, k+1, back_array->x(i+1, k+1, next_state]);
-						back_array->x(i, k, current_state) = xlog_sum(back_array->x(i, k, current_state),  xlog_mul(back_array->x(i, k+1, next_state),  trans_emit_prob));
-					}	
 				} // next_state loop.
 
-				//printf("%d, %d, current state: %s, prob = %f (%f)\n", i, k, state_names[current_state,  back_array->x(i, k, current_state,  xexp(back_array->x(i, k, current_state]) );
+				back_array->x(i, k, current_state) = xlog_sum(terms, n_terms);
 			} // current_state loop.
 		} // i index loop.
 	} // k index loop.
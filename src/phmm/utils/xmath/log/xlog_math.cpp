@@ -8,66 +8,6 @@
 //extern double n_divs;
 //extern double n_subs;
 
-// Convert probabilities into log space, with defaults base e.
-double xlog(double value)
-{
-	if(value == 0.0)
-	{
-		return(LOG_OF_ZERO);
-	}
-	else if (value > 0.0)
-	{
-		return(log(value));
-	}
-	else
-	{
-		printf("log of a negative number @ %s(%d): %.6f", __FILE__, __LINE__, value);
-		int* p = NULL;
-		*p = 0;
-		exit(0);
-	}
-}
-
-double xexp(double log_value)
-{
-	if(log_value == xlog(0.0))
-	{
-		return(0);
-	}
-	else
-	{
-		return(exp(log_value));
-	}
-}
-
-double xlog_sum(double log1, double log2)
-{
-	//n_sums++;
-	//return(log1 + log2);
-
-	if(log1 == xlog(0.0))
-	{
-		return(log2);
-	}
-	else if(log2 == xlog(0.0))
-	{
-		return(log1);
-	}
-	else
-	{
-		if(log1 > log2)
-		{
-			return( log1 + xlog(1 + xexp(log2-log1)) );
-		}
-		else
-		{
-			return( log2 + xlog(1 + xexp(log1-log2)) );
-		}
-
-		//return(xlog((log1) + (log2)));
-	}
-}
-
 // Subtract two logs, return xlog((log1) - (log2)), exit if result is negative, that is, log1 < log2.
 double xlog_sub(double log1, double log2)
 {
@@ -114,46 +54,6 @@ double xlog_sub(double log1, double log2)
 	}
 }
 
-double xlog_mul(double log1, double log2)
-{
-	//n_muls++;
-	//return(log1 * log2);
-
-	if(log1 == xlog(0.0) || log2 == xlog(0.0))
-	{
-		return(xlog(0.0));
-	}
-	else
-	{
-		return(log1 + log2);
-	}
-}
-
-// Returns 0 if log1 is 0 no matter what log2 is.
-double xlog_div(double log1, double log2)
-{
-	//n_divs++;
-	//return(log1 / log2);
-
-	if(log1 == xlog(0.0))
-	{
-		return(xlog(0.0));
-	}
-
-	if(log2 == xlog(0.0))
-	{
-		double* p = NULL;
-		*p = 0;
-		printf("Division by zero error at %s(%d)\n", __FILE__, __LINE__);
-		exit(0);
-	}
-	else
-	{
-		//return(xlog_mul(log1, -1.0 * log2));
-		return(log1 - log2);
-	}
-}
-
 double xlog_pow(double log_value, double pow)
 {
 	if(log_value == xlog(0.0))
@@ -345,5 +245,3 @@ double get_xlog_comp_prec()
 	return(log_prec);
 }
 
-
-
@@ -2,11 +2,14 @@
 #define _XLOG_MATH_
 
 #include "math.h"
+#include <stdio.h>
+#include <stdlib.h>
 
 //#define EPS (0.00001f)
 
 // Extended logarithmic/exponential functions from Mann 2006's work, numerically stable hidden markov model.
 // Includes a log value for log of 0, implements PPF_SUMmation, product for implementation of forward-backward algorithm.
+// The functions used in the inner loops of the forward-backward algorithm are inline, below.
 
 #define LOG_OF_ZERO (-1.0 * pow(2.0, 30)) // Log of zero: -2^(30), can be represented exactly.
 
@@ -17,14 +20,10 @@
 #define MAX(x, y) ((x)>(y)?(x):(y))
 #define MIN(x, y) ((x)>(y)?(y):(x))
 
-// Convert probabilities into log space, with defaults base e.
-double xlog(double prob);
-
-double xlog_sum(double log1, double log2);
-
-double xlog_mul(double log1, double log2);
-
-double xlog_div(double log1, double log2);
+// Define XLOG_FAST_SUM to add logs with a table of log(1 + exp(-d)) instead of calling exp and log.
+// This is faster, but each sum is only correct to about XLOG_FAST_SUM_TOLERANCE in log space, so the results differ slightly.
+//#define XLOG_FAST_SUM
+#define XLOG_FAST_SUM_TOLERANCE (1e-5)
 
 double xlog_sub(double log1, double log2);
 
@@ -34,8 +33,6 @@ double xlog_pow(double log_value, int power);
 
 double xlog_max(double log_val1, double log_val2);
 
-double xexp(double log_value);
-
 // returns log1 > log2
 bool is_bigger(double log1, double log2);
 
@@ -50,6 +47,201 @@ bool xlog_gt(double log1, double log2);
 
 double get_xlog_comp_prec();
 
-#endif // _XLOG_MATH_
+// Compare the results of two calculations that each take up to n_sums sums in sequence.
+// This is xlog_comp, except with XLOG_FAST_SUM, where the error of each sum can add up.
+inline bool xlog_comp(double log1, double log2, int n_sums)
+{
+#ifdef XLOG_FAST_SUM
+	return(fabs(log1 - log2) <= n_sums * XLOG_FAST_SUM_TOLERANCE);
+#else
+	return(xlog_comp(log1, log2));
+#endif // XLOG_FAST_SUM
+}
+
+// Convert probabilities into log space, with defaults base e.
+inline double xlog(double value)
+{
+	if(value == 0.0)
+	{
+		return(LOG_OF_ZERO);
+	}
+	else if (value > 0.0)
+	{
+		return(log(value));
+	}
+	else
+	{
+		printf("log of a negative number @ %s(%d): %.6f", __FILE__, __LINE__, value);
+		int* p = NULL;
+		*p = 0;
+		exit(0);
+	}
+}
+
+inline double xexp(double log_value)
+{
+	if(log_value == LOG_OF_ZERO)
+	{
+		return(0);
+	}
+	else
+	{
+		return(exp(log_value));
+	}
+}
+
+#ifdef XLOG_FAST_SUM
+// log(1 + exp(-d)), tabulated at XLOG_FAST_SUM_STEPS points per unit of d for d up to XLOG_FAST_SUM_RANGE.
+// Beyond the range, log(1 + exp(-d)) is below 1e-16 and is taken as 0.
+// Linear interpolation between the points is within XLOG_FAST_SUM_TOLERANCE, since the second derivative is at most 1/4.
+#define XLOG_FAST_SUM_STEPS (64)
+#define XLOG_FAST_SUM_RANGE (37)
+
+struct t_xlog_sum_table
+{
+	double values[XLOG_FAST_SUM_STEPS * XLOG_FAST_SUM_RANGE + 2];
+
+	t_xlog_sum_table()
+	{
+		for(int i = 0; i < XLOG_FAST_SUM_STEPS * XLOG_FAST_SUM_RANGE + 2; i++)
+		{
+			values[i] = log1p(exp(-((double)i / XLOG_FAST_SUM_STEPS)));
+		}
+	}
+};
+
+inline double xlog_log1p_exp(double d)
+{
+	static const t_xlog_sum_table table;
+
+	if(d >= XLOG_FAST_SUM_RANGE)
+	{
+		return(0.0);
+	}
+
+	double position = d * XLOG_FAST_SUM_STEPS;
+	int i = (int)position;
+	double fraction = position - i;
+
+	return(table.values[i] + fraction * (table.values[i+1] - table.values[i]));
+}
+#endif // XLOG_FAST_SUM
+
+inline double xlog_sum(double log1, double log2)
+{
+	if(log1 == LOG_OF_ZERO)
+	{
+		return(log2);
+	}
+	else if(log2 == LOG_OF_ZERO)
+	{
+		return(log1);
+	}
+	else
+	{
+#ifdef XLOG_FAST_SUM
+		if(log1 > log2)
+		{
+			return(log1 + xlog_log1p_exp(log1 - log2));
+		}
+		else
+		{
+			return(log2 + xlog_log1p_exp(log2 - log1));
+		}
+#else
+		if(log1 > log2)
+		{
+			return( log1 + log(1 + exp(log2-log1)) );
+		}
+		else
+		{
+			return( log2 + log(1 + exp(log1-log2)) );
+		}
+#endif // XLOG_FAST_SUM
+	}
+}
+
+// Sum the n values in logs, which are in log space.
+// This is the same as adding the values one at a time with xlog_sum, but the terms are
+// scaled by the largest one, so that the sum takes one exp per term and only one log.
+inline double xlog_sum(const double* logs, int n)
+{
+	if(n == 0)
+	{
+		return(LOG_OF_ZERO);
+	}
+
+	int i_largest = 0;
+	for(int t = 1; t < n; t++)
+	{
+		if(logs[t] > logs[i_largest])
+		{
+			i_largest = t;
+		}
+	} // t loop
+
+	double largest = logs[i_largest];
+	if(largest == LOG_OF_ZERO)
+	{
+		return(LOG_OF_ZERO);
+	}
+
+#ifdef XLOG_FAST_SUM
+	double sum = largest;
+	for(int t = 0; t < n; t++)
+	{
+		if(t != i_largest && logs[t] != LOG_OF_ZERO)
+		{
+			sum += xlog_log1p_exp(sum - logs[t]);
+		}
+	} // t loop
+
+	return(sum);
+#else
+	// The sum of the terms other than the largest, relative to the largest.
+	double rest = 0.0;
+	for(int t = 0; t < n; t++)
+	{
+		if(t != i_largest && logs[t] != LOG_OF_ZERO)
+		{
+			rest += exp(logs[t] - largest);
+		}
+	} // t loop
+
+	return(largest + log1p(rest));
+#endif // XLOG_FAST_SUM
+}
+
+inline double xlog_mul(double log1, double log2)
+{
+	if(log1 == LOG_OF_ZERO || log2 == LOG_OF_ZERO)
+	{
+		return(LOG_OF_ZERO);
+	}
+	else
+	{
+		return(log1 + log2);
+	}
+}
+
+// Returns 0 if log1 is 0 no matter what log2 is.
+inline double xlog_div(double log1, double log2)
+{
+	if(log1 == LOG_OF_ZERO)
+	{
+		return(LOG_OF_ZERO);
+	}
+
+	if(log2 == LOG_OF_ZERO)
+	{
+		double* p = NULL;
+		*p = 0;
+		printf("Division by zero error at %s(%d)\n", __FILE__, __LINE__);
+		exit(0);
+	}
+
+	return(log1 - log2);
+}
 
+#endif // _XLOG_MATH_
 
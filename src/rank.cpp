@@ -14,11 +14,23 @@
 #include "workslice.h"
 #include "workunit.h"
 
-#define MIN_WORKSLICE_SIZE 64UL
-#define WORKSLICES_PER_RANK 256UL
+// The most workunits a consumer takes from its own range at once.
+#define WORKSLICE_SIZE 16ULL
+
+static unsigned long long packrange(unsigned long long begin, unsigned long long end) {
+  return (begin << 32) | end;
+}
 
 Rank::Rank()
-  : allWorkunitsAdded(false) {
+  : ranges(NULL),
+    numRanges(0),
+    allWorkunitsAdded(false),
+    remaining(0),
+    departed(0) {
+}
+
+Rank::~Rank() {
+  delete[] ranges;
 }
 
 void Rank::addWorkunit(workunit wu) {
@@ -26,19 +38,89 @@ void Rank::addWorkunit(workunit wu) {
   workunits.push_back(wu);
 }
 
-workslice Rank::getWorkslice() {
-  if (!allWorkunitsAdded) {
-    assigned = workunits.begin();
-    allWorkunitsAdded = true;
-    worksliceSize = std::max(MIN_WORKSLICE_SIZE,
-                             workunits.size() / WORKSLICES_PER_RANK);
+void Rank::split(int numConsumers) {
+  assert(!allWorkunitsAdded);
+  allWorkunitsAdded = true;
+
+  // Each consumer starts with a contiguous part of the rank, which
+  // keeps neighbouring workunits (and the array rows they use)
+  // together.
+  unsigned long long n = workunits.size();
+  numRanges = numConsumers;
+  ranges = new workrange[numRanges];
+  for (int c = 0; c < numRanges; c++) {
+    ranges[c].bounds = packrange(n * c / numRanges, n * (c + 1) / numRanges);
   }
+  remaining = (int) n;
+}
+
+bool Rank::takeFront(int consumer, workslice &slice) {
+  unsigned long long *bounds = &ranges[consumer].bounds;
+  unsigned long long old = __atomic_load_n(bounds, __ATOMIC_ACQUIRE);
+
+  while (true) {
+    unsigned long long begin = old >> 32;
+    unsigned long long end = old & 0xffffffffULL;
+    if (begin >= end) return false;
+
+    unsigned long long taken = std::min(end - begin, WORKSLICE_SIZE);
+    if (__atomic_compare_exchange_n(bounds, &old, packrange(begin + taken, end),
+                                    false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+      slice.begin = workunits.begin() + begin;
+      slice.end = workunits.begin() + (begin + taken);
+      return true;
+    }
+    // Another consumer stole from the range; old now holds its new
+    // bounds.
+  }
+}
+
+bool Rank::stealBack(int consumer, int victim) {
+  unsigned long long *bounds = &ranges[victim].bounds;
+  unsigned long long old = __atomic_load_n(bounds, __ATOMIC_ACQUIRE);
 
-  workslice slice;
+  while (true) {
+    unsigned long long begin = old >> 32;
+    unsigned long long end = old & 0xffffffffULL;
+    if (begin >= end) return false;
+
+    unsigned long long stolen = (end - begin + 1) / 2;
+    if (__atomic_compare_exchange_n(bounds, &old, packrange(begin, end - stolen),
+                                    false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+      // The consumer's own range is empty, and no one else changes an
+      // empty range, so the stolen workunits can simply be stored as
+      // its new range.
+      __atomic_store_n(&ranges[consumer].bounds, packrange(end - stolen, end), __ATOMIC_RELEASE);
+      return true;
+    }
+  }
+}
+
+bool Rank::getWorkslice(int consumer, workslice &slice) {
+  assert(allWorkunitsAdded);
+
+  while (!takeFront(consumer, slice)) {
+    // Steal from the other consumers in turn, starting with the next.
+    // The stolen workunits can be stolen again before they are taken,
+    // so try again until nothing is left anywhere.
+    bool stolen = false;
+    for (int offset = 1; offset < numRanges && !stolen; offset++) {
+      stolen = stealBack(consumer, (consumer + offset) % numRanges);
+    }
+    if (!stolen) return false;
+  }
+
+  return true;
+}
+
+bool Rank::complete(int count) {
+  return __atomic_sub_fetch(&remaining, count, __ATOMIC_ACQ_REL) == 0;
+}
+
+bool Rank::isComplete() {
+  return __atomic_load_n(&remaining, __ATOMIC_ACQUIRE) == 0;
+}
 
-  slice.begin = assigned;
-  slice.end = std::min(assigned + worksliceSize, workunits.end());
-  assigned = slice.end;
-  
-  return slice;
+bool Rank::depart() {
+  return __atomic_add_fetch(&departed, 1, __ATOMIC_ACQ_REL) == numRanges;
 }
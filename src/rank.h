@@ -13,19 +13,62 @@
 #include "workslice.h"
 #include "workunit.h"
 
+// The workunits of a rank not yet taken by one consumer: [begin,end)
+// as indices into the workunits, packed as begin<<32|end so that both
+// ends change with one compare and swap.  Padded to a cache line so
+// that consumers taking from their own ranges do not share lines.
+typedef struct {
+  unsigned long long bounds;
+  char padding[64 - sizeof(unsigned long long)];
+} workrange;
+
+// The workunits of one rank, which can be done in any order.  Once
+// all are added, split() divides them among the consumers, each of
+// which takes slices from the front of its own range and, when that
+// is empty, steals half of the range of another consumer from the
+// back.  No locks are taken.
 class Rank {
 private:
   std::vector<workunit> workunits;
-  std::vector<workunit>::iterator assigned;
+  workrange *ranges;
+  int numRanges;
   bool allWorkunitsAdded;
-  int worksliceSize;
-  
+
+  // The number of workunits not yet completed.
+  int remaining;
+
+  // The number of consumers that have finished with the rank.
+  int departed;
+
+  bool takeFront(int consumer, workslice &slice);
+  bool stealBack(int consumer, int victim);
+
 public:
   Rank();
-  
+  ~Rank();
+
   void addWorkunit(workunit wu);
 
-  workslice getWorkslice();
+  // Divide the workunits among numConsumers consumers.  No workunits
+  // can be added after this.
+  void split(int numConsumers);
+
+  // Take a slice of work for consumer, stealing from another
+  // consumer if its own range is empty.  Return false if no
+  // workunits remain to be taken.
+  bool getWorkslice(int consumer, workslice &slice);
+
+  // Record that count workunits taken earlier are done.  Return true
+  // if these were the last workunits of the rank.
+  bool complete(int count);
+
+  // Return true if every workunit of the rank is done, so the results
+  // are visible to the calling thread.
+  bool isComplete();
+
+  // Record that a consumer has finished with the rank.  Return true
+  // for the last consumer, which can then delete the rank.
+  bool depart();
 };
 
 #endif
@@ -59,8 +59,10 @@ void *rankconsumer(void *arg) {
   int N = ct1->GetSequenceLength();
   int N2 = ct2->GetSequenceLength();
   
+  int consumer = manager->registerConsumer();
+
   workslice slice;
-  while (slice = manager->getWorkslice(), slice.begin != slice.end) {
+  while (slice = manager->getWorkslice(consumer), slice.begin != slice.end) {
     while (slice.begin != slice.end) {
 #ifdef DYNALIGN_II
         dynalignstep(ct1, ct2, data,
@@ -8,34 +8,56 @@
 #ifndef RANKMANAGER_H
 #define RANKMANAGER_H
 
-#include <queue>
-#include <pthread.h>
-
 #include "observable.h"
 #include "rank.h"
 #include "TProgressDialog.h"
 #include "workslice.h"
 
+// The position of one consumer in the ranks: the rank it is working
+// on and the size of the slice it was last given, which is done when
+// it asks for the next.  Padded to a cache line.
+typedef struct {
+  int rank;
+  int pending;
+  char padding[64 - 2 * sizeof(int)];
+} consumerstate;
+
+// Hands out the ranks made by a producer thread to the consumer
+// threads.  Each consumer works through the ranks in order, taking and
+// stealing slices of the current rank (see Rank).  Each rank is still
+// a barrier: a workunit reads cells of the rank just before it from
+// anywhere inside its own span, so a consumer moves to the next rank
+// only when every workunit of the current one is done.  It does not also wait for the other consumers
+// to check in.  The producer and the consumers synchronize through
+// atomic counters; a thread with nothing to do yields the processor.
 class RankManager : public Observable {
 private:
-  std::queue<Rank*> ranks;
+  // The ranks, indexed by number.  A rank is deleted, and its entry
+  // set to NULL, when every consumer has moved past it.
+  Rank **ranks;
   int numRanks;
-  int ranksCompleted;
   int ranksGenerated;
-  pthread_mutex_t lock;
-  pthread_cond_t rankavailable;
-  pthread_cond_t rankcomplete;
-  pthread_cond_t producer_toggle;
-  
-  int checkInCounter;
+  int ranksDeleted;
+
+  consumerstate *consumers;
   int numConsumers;
-  
+  int consumersRegistered;
+
 public:
   RankManager(int _numRanks, int _numConsumers);
   ~RankManager();
 
+  // Called by the producer, which waits here while too many ranks
+  // are outstanding.
   void addRank(Rank *r);
-  workslice getWorkslice();
+
+  // Called once by each consumer thread to get its consumer number.
+  int registerConsumer();
+
+  // Called by a consumer to get its next slice of work, which also
+  // records that its previous slice is done.  An empty slice means
+  // that all ranks are done.
+  workslice getWorkslice(int consumer);
 };
 
 #endif
@@ -7,25 +7,96 @@
 #include <iostream>
 #include <cstdlib>
 #include <cstring>
+#include <algorithm>
 using namespace std;
 
+#ifdef SMP
+#include <omp.h>
+#endif
+
 
 //Define 1 for the purposes of taking an inverse
 static PFPRECISION ONE=1; //include code for extended double if needed
 
 
  
-//register a base pair between two nucleotides
-inline void regbp(structure *ct, int structurenumber, short i, short j) {
-	ct->SetPair(i,j,structurenumber);
+//register a base pair between two nucleotides in the list of pairs of a sampled structure
+inline void regbp(vector<short> &pairs, short i, short j) {
+	pairs.push_back(i);
+	pairs.push_back(j);
+
+}
+
+//stochasticsamples holds the structures sampled by one thread, in the order it sampled them.
+//	The pairs of all the structures are in one list; structure numbers[s] has the pairs from starts[s] up to starts[s+1].
+struct stochasticsamples {
+	vector<int> numbers;
+	vector<size_t> starts;
+	vector<short> pairs;
+
+	//the traceback error of the last structure with one, and the number of that structure
+	int error,errornumber;
+
+	stochasticsamples() {
+		starts.push_back(0);
+		error = 0;
+		errornumber = 0;
+	}
+};
+
+
+
+stochasticcounts::stochasticcounts(int sequencelength) {
+	length = sequencelength;
+	samples = 0;
+	paircounts.assign(((size_t) length*(length-1))/2,0);
+	unpairedcounts.assign(length+1,0);
+}
+
+void stochasticcounts::add(const vector<short> &pairs) {
+	int i,j;
+
+	samples++;
+	for (i=1;i<=length;++i) unpairedcounts[i]++;
+	for (int p=0;p<(int) pairs.size();p+=2) {
+		i = min(pairs[p],pairs[p+1]);
+		j = max(pairs[p],pairs[p+1]);
+		paircounts[pairindex(i,j)]++;
+		unpairedcounts[i]--;
+		unpairedcounts[j]--;
+	}
+}
+
+void stochasticcounts::add(const stochasticcounts &other) {
+	samples += other.samples;
+	for (size_t p=0;p<paircounts.size();++p) paircounts[p] += other.paircounts[p];
+	for (int i=1;i<=length;++i) unpairedcounts[i] += other.unpairedcounts[i];
+}
+
+int stochasticcounts::GetSamples() const {
+	return samples;
+}
+
+int stochasticcounts::GetPairCount(int i, int j) const {
+	if (i>j) swap(i,j);
+	if (i<1||j>length||i==j) return 0;
+	return paircounts[pairindex(i,j)];
+}
 
+int stochasticcounts::GetUnpairedCount(int i) const {
+	if (i<1||i>length) return 0;
+	return unpairedcounts[i];
 }
 
+size_t stochasticcounts::pairindex(int i, int j) const {
+	//Row i holds j from i+1 to length, and follows the rows before it.
+	return ((size_t) (i-1)*(2*length-i))/2+(j-i-1);
+}
 
 
 int stochastictraceback(pfunctionclass *w,pfunctionclass *wmb,pfunctionclass *wmbl,pfunctionclass *wcoax,pfunctionclass *wl,pfunctionclass *v,
 	forceclass *fce, PFPRECISION *w3,PFPRECISION *w5,PFPRECISION scaling, bool *lfce, bool *mod, pfdatatable *data, int numberofstructures, 
-	structure *ct, int randomseed, TProgressDialog *progress) {
+	structure *ct, int randomseed, TProgressDialog *progress, stochasticcounts *counts) {
 	
 	double scalinginv,twoscaling;
 	int number;
@@ -45,13 +116,29 @@ int stochastictraceback(pfunctionclass *w,pfunctionclass *wmb,pfunctionclass *wm
 
 	int tracebackerror=0;
 
+	//Each thread records its structures in its own buffer, or its own counts, so the threads share nothing
+	//	while sampling.  The buffers are merged in the order of the structure numbers after the loop.
+	int threads = 1;
+	#ifdef SMP
+	threads = omp_get_max_threads();
+	#endif
+	vector<stochasticsamples> samples(threads);
+	vector<stochasticcounts*> threadcounts(threads,(stochasticcounts*) NULL);
+	if (counts!=NULL) threadcounts[0] = counts;
+	int completed = 0;
+
 	//ct->numofstructures=numberofstructures;
 	//ct->checknumberofstructures();
 	//Big loop:
 	#ifdef SMP
-	#pragma omp parallel for
+	#pragma omp parallel for schedule(dynamic)
 	#endif
 	for (number = 1; number <= numberofstructures; number++) {
+		int thread = 0;
+		#ifdef SMP
+		thread = omp_get_thread_num();
+		#endif
+
 		randomnumber rand;
 		rand.seed(randomseed+number);
 
@@ -65,22 +152,9 @@ int stochastictraceback(pfunctionclass *w,pfunctionclass *wmb,pfunctionclass *wm
 	
 		short switchcase,i,j,k,ip,jp,d;
 
-		if (progress!=NULL) {
-
-			progress->update((int) (((float) 100*number)/((float) numberofstructures)));
-
-		}
-//<<<<<<< stochastic.cpp
-		
-		ct->AddStructure();
-		
-//=======
-		
-		//initialize the base pairs
-//		for (i=1;i<=ct->numofbases;i++) ct->basepr[number][i]=0;
-//>>>>>>> 1.10
-
-		ct->SetCtLabel(ct->GetSequenceLabel(),number);
+		//the base pairs of this structure, and any traceback error
+		vector<short> pairs;
+		int sampleerror=0;
 		
 		//start by putting the whole fragment on the stack:
 		stack.push(1,ct->GetSequenceLength(),0,0,0);
@@ -122,7 +196,7 @@ int stochastictraceback(pfunctionclass *w,pfunctionclass *wmb,pfunctionclass *wm
 							if (cumulative>roll&&!found) {
 								stack.push(1,k,0,0,0);
 								stack.push(k+2,j-2,1,0,0);
-								regbp(ct,number,k+1,j-1);
+								regbp(pairs,k+1,j-1);
 								found=true;
 								
 							}
@@ -140,7 +214,7 @@ int stochastictraceback(pfunctionclass *w,pfunctionclass *wmb,pfunctionclass *wm
 							if (cumulative > roll) {
 								stack.push(1,k,0,0,0);
 								stack.push(k+2,j-1,1,0,0);
-								regbp(ct,number,k+1,j);
+								regbp(pairs,k+1,j);
 								found=true;
 							}
 						}
@@ -158,7 +232,7 @@ int stochastictraceback(pfunctionclass *w,pfunctionclass *wmb,pfunctionclass *wm
 							if (cumulative>roll) {
 								stack.push(1,k,0,0,0);
 								stack.push(k+2,j,1,0,0);
-								regbp(ct,number,k+3,j-1);
+								regbp(pairs,k+3,j-1);
 								found=true;
 
 							}
@@ -179,7 +253,7 @@ int stochastictraceback(pfunctionclass *w,pfunctionclass *wmb,pfunctionclass *wm
 							if (cumulative>roll&&!found) {
 								stack.push(1,k,0,0,0);
 								stack.push(k+2,j-2,1,0,0);
-								regbp(ct,number,k+1,j-1);
+								regbp(pairs,k+1,j-1);
 								found=true;
 								
 							}
@@ -205,7 +279,7 @@ int stochastictraceback(pfunctionclass *w,pfunctionclass *wmb,pfunctionclass *wm
 							if (cumulative>roll&&!found) {
 								stack.push(1,k,0,0,0);
 								stack.push(k+3,j-2,1,0,0);
-								regbp(ct,number,k+2,j-1);
+								regbp(pairs,k+2,j-1);
 								found=true;
 								
 							}
@@ -243,8 +317,8 @@ int stochastictraceback(pfunctionclass *w,pfunctionclass *wmb,pfunctionclass *wm
 										stack.push(i+1,ip-1,1,0,0);
 										stack.push(ip+2,j-1,1,0,0);
 										found=true;
-										regbp(ct,number,i,ip);
-										regbp(ct,number,ip+1,j);
+										regbp(pairs,i,ip);
+										regbp(pairs,ip+1,j);
 										stack.push(1,k,0,0,0);
 									}
 
@@ -261,7 +335,7 @@ int stochastictraceback(pfunctionclass *w,pfunctionclass *wmb,pfunctionclass *wm
 										stack.push(i+1,ip-1,1,0,0);
 										stack.push(ip+1,j,1,0,0);
 										found=true;
-										regbp(ct,number,i,ip);
+										regbp(pairs,i,ip);
 										stack.push(1,k,0,0,0);
 
 									}
@@ -280,7 +354,7 @@ int stochastictraceback(pfunctionclass *w,pfunctionclass *wmb,pfunctionclass *wm
 										stack.push(i,ip,1,0,0);
 										stack.push(ip+2,j-1,1,0,0);
 										found=true;
-										regbp(ct,number,ip+1,j);
+										regbp(pairs,ip+1,j);
 										stack.push(1,k,0,0,0);
 			
 									}
@@ -315,8 +389,8 @@ int stochastictraceback(pfunctionclass *w,pfunctionclass *wmb,pfunctionclass *wm
 										 if (!found&&cumulative>roll) {
 											stack.push(i+1,ip-1,1,0,0);
 											stack.push(ip+3,j-2,1,0,0);
-											regbp(ct,number,i,ip);
-											regbp(ct,number,ip+2,j-1);
+											regbp(pairs,i,ip);
+											regbp(pairs,ip+2,j-1);
 											found=true;
 											stack.push(1,k,0,0,0);
 
@@ -334,7 +408,7 @@ int stochastictraceback(pfunctionclass *w,pfunctionclass *wmb,pfunctionclass *wm
 										if(!found&&cumulative>roll) {
 											stack.push(i+1,ip-1,1,0,0);
 											stack.push(ip+2,j-1,1,0,0);
-											regbp(ct,number,i,ip);
+											regbp(pairs,i,ip);
 											found=true;
 											stack.push(1,k,0,0,0);
 
@@ -353,7 +427,7 @@ int stochastictraceback(pfunctionclass *w,pfunctionclass *wmb,pfunctionclass *wm
 										if (!found&&cumulative>roll) {
 											stack.push(i,ip,1,0,0);
 											stack.push(ip+3,j-2,1,0,0);
-											regbp(ct,number,ip+2,j-1);
+											regbp(pairs,ip+2,j-1);
 											found=true;
 											stack.push(1,k,0,0,0);
 
@@ -388,8 +462,8 @@ int stochastictraceback(pfunctionclass *w,pfunctionclass *wmb,pfunctionclass *wm
 										if (!found&&cumulative>roll) {
 											stack.push(i+2,ip-1,1,0,0);
 											stack.push(ip+3,j-1,1,0,0);
-											regbp(ct,number,i+1,ip);
-											regbp(ct,number,ip+2,j);
+											regbp(pairs,i+1,ip);
+											regbp(pairs,ip+2,j);
 											found=true;
 											stack.push(1,k,0,0,0);
 
@@ -406,7 +480,7 @@ int stochastictraceback(pfunctionclass *w,pfunctionclass *wmb,pfunctionclass *wm
 										if (!found&&cumulative>roll) {
 											stack.push(i+2,ip-1,1,0,0);
 											stack.push(ip+2,j,1,0,0);
-											regbp(ct,number,i+1,ip);
+											regbp(pairs,i+1,ip);
 											stack.push(1,k,0,0,0);
 										
 											found=true;
@@ -428,7 +502,7 @@ int stochastictraceback(pfunctionclass *w,pfunctionclass *wmb,pfunctionclass *wm
 											stack.push(ip+3,j-1,1,0,0);
 											stack.push(1,k,0,0,0);
 										
-											regbp(ct,number,ip+2,j);
+											regbp(pairs,ip+2,j);
 											found=true;
 
 										}
@@ -447,14 +521,14 @@ int stochastictraceback(pfunctionclass *w,pfunctionclass *wmb,pfunctionclass *wm
 
 					if (!found) {
 						cout << "Traceback error at w5\n";
-						tracebackerror=14;
+						sampleerror=14;
 
 					}
          
       		
 					break;
 				case 1: //switchcase=1, dealing with a v fragment
-					regbp(ct,number,i,j);
+					regbp(pairs,i,j);
 
 					//check to see if constant is used.  
 					//If it is, then v->f(i,j) was multiplied by ct->constant[j][i] and
@@ -536,7 +610,7 @@ int stochastictraceback(pfunctionclass *w,pfunctionclass *wmb,pfunctionclass *wm
                   							v->f(ip+1,jp-1)*erg1(ip,jp,ip+1,jp-1,ct,data)/denominator;
 										if (cumulative>roll) {
 
-											regbp(ct,number,ip,jp);
+											regbp(pairs,ip,jp);
 											stack.push(ip+1,jp-1,1,0,0);
 											found=true;
 										}
@@ -642,7 +716,7 @@ int stochastictraceback(pfunctionclass *w,pfunctionclass *wmb,pfunctionclass *wm
 								if (!found&&cumulative>roll) {
 									stack.push(ip+1,j-1,4,0,0);
 									stack.push(i+2,ip-1,1,0,0);
-									regbp(ct,number,i+1,ip);
+									regbp(pairs,i+1,ip);
 									found=true;
 			
 								}
@@ -657,7 +731,7 @@ int stochastictraceback(pfunctionclass *w,pfunctionclass *wmb,pfunctionclass *wm
 								if (!found&&cumulative>roll) {
 									stack.push(ip+1,j-1,3,0,0);
 									stack.push(i+2,ip-1,1,0,0);
-									regbp(ct,number,i+1,ip);
+									regbp(pairs,i+1,ip);
 									found=true;
 			
 								}
@@ -712,7 +786,7 @@ int stochastictraceback(pfunctionclass *w,pfunctionclass *wmb,pfunctionclass *wm
 								if (!found&&cumulative>roll) {
 									stack.push(ip+2,j-1,4,0,0);
 									stack.push(i+3,ip-1,1,0,0);
-									regbp(ct,number,i+2,ip);
+									regbp(pairs,i+2,ip);
 									
 									found=true;
 			
@@ -729,7 +803,7 @@ int stochastictraceback(pfunctionclass *w,pfunctionclass *wmb,pfunctionclass *wm
 								if (!found&&cumulative>roll) {
 									stack.push(ip+2,j-1,3,0,0);
 									stack.push(i+3,ip-1,1,0,0);
-									regbp(ct,number,i+2,ip);
+									regbp(pairs,i+2,ip);
 									
 									found=true;
 			
@@ -783,7 +857,7 @@ int stochastictraceback(pfunctionclass *w,pfunctionclass *wmb,pfunctionclass *wm
 									if (!found&&cumulative>roll) {
 										stack.push(ip+1,j-2,4,0,0);
 										stack.push(i+3,ip-1,1,0,0);
-										regbp(ct,number,i+2,ip);
+										regbp(pairs,i+2,ip);
 										found=true;
 			
 									}
@@ -797,7 +871,7 @@ int stochastictraceback(pfunctionclass *w,pfunctionclass *wmb,pfunctionclass *wm
 									if (!found&&cumulative>roll) {
 										stack.push(ip+1,j-2,3,0,0);
 										stack.push(i+3,ip-1,1,0,0);
-										regbp(ct,number,i+2,ip);
+										regbp(pairs,i+2,ip);
 										found=true;
 			
 									}
@@ -844,7 +918,7 @@ int stochastictraceback(pfunctionclass *w,pfunctionclass *wmb,pfunctionclass *wm
 								if (!found&&cumulative>roll) {
 									stack.push(ip+1,j-2,1,0,0);
 									stack.push(i+1,ip-1,4,0,0);
-									regbp(ct,number,ip,j-1);
+									regbp(pairs,ip,j-1);
 									found=true;
 								}
 
@@ -857,7 +931,7 @@ int stochastictraceback(pfunctionclass *w,pfunctionclass *wmb,pfunctionclass *wm
 								if (!found&&cumulative>roll) {
 									stack.push(ip+1,j-2,1,0,0);
 									stack.push(i+1,ip-1,3,0,0);
-									regbp(ct,number,ip,j-1);
+									regbp(pairs,ip,j-1);
 									found=true;
 								}
 
@@ -902,7 +976,7 @@ int stochastictraceback(pfunctionclass *w,pfunctionclass *wmb,pfunctionclass *wm
 									if (!found&&cumulative>roll) {
 										stack.push(ip+1,j-3,1,0,0);
 										stack.push(i+1,ip-2,4,0,0);
-										regbp(ct,number,ip,j-2);
+										regbp(pairs,ip,j-2);
 										found=true;
 									}
 
@@ -917,7 +991,7 @@ int stochastictraceback(pfunctionclass *w,pfunctionclass *wmb,pfunctionclass *wm
 									if (!found&&cumulative>roll) {
 										stack.push(ip+1,j-3,1,0,0);
 										stack.push(i+1,ip-2,3,0,0);
-										regbp(ct,number,ip,j-2);
+										regbp(pairs,ip,j-2);
 										found=true;
 									}
 
@@ -965,7 +1039,7 @@ int stochastictraceback(pfunctionclass *w,pfunctionclass *wmb,pfunctionclass *wm
 									if (!found&&cumulative>roll) {
 										stack.push(ip+1,j-3,1,0,0);
 										stack.push(i+2,ip-1,4,0,0);
-										regbp(ct,number,ip,j-2);
+										regbp(pairs,ip,j-2);
 										found=true;
 
 									}
@@ -981,7 +1055,7 @@ int stochastictraceback(pfunctionclass *w,pfunctionclass *wmb,pfunctionclass *wm
 									if (!found&&cumulative>roll) {
 										stack.push(ip+1,j-3,1,0,0);
 										stack.push(i+2,ip-1,3,0,0);
-										regbp(ct,number,ip,j-2);
+										regbp(pairs,ip,j-2);
 										found=true;
 
 									}
@@ -1000,7 +1074,7 @@ int stochastictraceback(pfunctionclass *w,pfunctionclass *wmb,pfunctionclass *wm
 					
 					if (!found) {
 						cout << "Traceback error in v!\n";
-						tracebackerror=14;
+						sampleerror=14;
 					}
 		
 					
@@ -1038,8 +1112,8 @@ int stochastictraceback(pfunctionclass *w,pfunctionclass *wmb,pfunctionclass *wm
 									stack.push(i+1,ip-1,1,0,0);
 									stack.push(ip+2,j-1,1,0,0);
 									found=true;
-									regbp(ct,number,i,ip);
-									regbp(ct,number,ip+1,j);
+									regbp(pairs,i,ip);
+									regbp(pairs,ip+1,j);
 								}
 
 
@@ -1055,7 +1129,7 @@ int stochastictraceback(pfunctionclass *w,pfunctionclass *wmb,pfunctionclass *wm
 									stack.push(i+1,ip-1,1,0,0);
 									stack.push(ip+1,j,1,0,0);
 									found=true;
-									regbp(ct,number,i,ip);
+									regbp(pairs,i,ip);
 
 								}
 
@@ -1073,7 +1147,7 @@ int stochastictraceback(pfunctionclass *w,pfunctionclass *wmb,pfunctionclass *wm
 									stack.push(i,ip,1,0,0);
 									stack.push(ip+2,j-1,1,0,0);
 									found=true;
-									regbp(ct,number,ip+1,j);
+									regbp(pairs,ip+1,j);
 			
 								}
 
@@ -1106,8 +1180,8 @@ int stochastictraceback(pfunctionclass *w,pfunctionclass *wmb,pfunctionclass *wm
 									 if (!found&&cumulative>roll) {
 										stack.push(i+1,ip-1,1,0,0);
 										stack.push(ip+3,j-2,1,0,0);
-										regbp(ct,number,i,ip);
-										regbp(ct,number,ip+2,j-1);
+										regbp(pairs,i,ip);
+										regbp(pairs,ip+2,j-1);
 										found=true;
 
 									 }
@@ -1124,7 +1198,7 @@ int stochastictraceback(pfunctionclass *w,pfunctionclass *wmb,pfunctionclass *wm
 									if(!found&&cumulative>roll) {
 										stack.push(i+1,ip-1,1,0,0);
 										stack.push(ip+2,j-1,1,0,0);
-										regbp(ct,number,i,ip);
+										regbp(pairs,i,ip);
 										found=true;
 
 									}
@@ -1142,7 +1216,7 @@ int stochastictraceback(pfunctionclass *w,pfunctionclass *wmb,pfunctionclass *wm
 									if (!found&&cumulative>roll) {
 										stack.push(i,ip,1,0,0);
 										stack.push(ip+3,j-2,1,0,0);
-										regbp(ct,number,ip+2,j-1);
+										regbp(pairs,ip+2,j-1);
 										found=true;
 
 									}
@@ -1176,8 +1250,8 @@ int stochastictraceback(pfunctionclass *w,pfunctionclass *wmb,pfunctionclass *wm
 									if (!found&&cumulative>roll) {
 										stack.push(i+2,ip-1,1,0,0);
 										stack.push(ip+3,j-1,1,0,0);
-										regbp(ct,number,i+1,ip);
-										regbp(ct,number,ip+2,j);
+										regbp(pairs,i+1,ip);
+										regbp(pairs,ip+2,j);
 										found=true;
 
 									}
@@ -1193,7 +1267,7 @@ int stochastictraceback(pfunctionclass *w,pfunctionclass *wmb,pfunctionclass *wm
 									if (!found&&cumulative>roll) {
 										stack.push(i+2,ip-1,1,0,0);
 										stack.push(ip+2,j,1,0,0);
-										regbp(ct,number,i+1,ip);
+										regbp(pairs,i+1,ip);
 										
 										found=true;
 
@@ -1213,7 +1287,7 @@ int stochastictraceback(pfunctionclass *w,pfunctionclass *wmb,pfunctionclass *wm
 										stack.push(i+1,ip,1,0,0);
 										stack.push(ip+3,j-1,1,0,0);
 										
-										regbp(ct,number,ip+2,j);
+										regbp(pairs,ip+2,j);
 										found=true;
 
 									}
@@ -1228,7 +1302,7 @@ int stochastictraceback(pfunctionclass *w,pfunctionclass *wmb,pfunctionclass *wm
 					if (!found) {
 
 						cout << "Traceback error at wcoax/n";
-						tracebackerror=14;
+						sampleerror=14;
 
 					}
 
@@ -1261,7 +1335,7 @@ int stochastictraceback(pfunctionclass *w,pfunctionclass *wmb,pfunctionclass *wm
 
 					if (!found) {
 						cout << "Traceback error at wmb\n";
-						tracebackerror=14;
+						sampleerror=14;
 
 					}
 
@@ -1291,7 +1365,7 @@ int stochastictraceback(pfunctionclass *w,pfunctionclass *wmb,pfunctionclass *wm
 
 					if (!found) {
 						cout << "Traceback error at w\n";
-						tracebackerror=14;
+						sampleerror=14;
 
 					}
 	  
@@ -1403,7 +1477,7 @@ int stochastictraceback(pfunctionclass *w,pfunctionclass *wmb,pfunctionclass *wm
 
 					if (!found) {
 						cout << "Traceback error at wmbl\n";
-						tracebackerror=14;
+						sampleerror=14;
 			
 					}
 
@@ -1440,7 +1514,7 @@ int stochastictraceback(pfunctionclass *w,pfunctionclass *wmb,pfunctionclass *wm
 
 						if (cumulative>roll&&!found) {
 							stack.push(i+1,j-2,1,0,0);
-							regbp(ct,number,i,j-1);
+							regbp(pairs,i,j-1);
 							found=true;
 
 						}
@@ -1474,7 +1548,7 @@ int stochastictraceback(pfunctionclass *w,pfunctionclass *wmb,pfunctionclass *wm
 
 						if (!found&&cumulative>roll) {
 							stack.push(i+1,j-1,1,0,0);
-							regbp(ct,number,i,j);
+							regbp(pairs,i,j);
 							found = true;
 
 						}
@@ -1499,7 +1573,7 @@ int stochastictraceback(pfunctionclass *w,pfunctionclass *wmb,pfunctionclass *wm
 						if (!found&&cumulative>roll) {
 							stack.push(i+2,j-1,1,0,0);
 							found=true;
-							regbp(ct,number,i+1,j);
+							regbp(pairs,i+1,j);
 
 						}
 
@@ -1523,7 +1597,7 @@ int stochastictraceback(pfunctionclass *w,pfunctionclass *wmb,pfunctionclass *wm
 
 						if (cumulative>roll&&!found) {
 							stack.push(i+1,j-2,1,0,0);
-							regbp(ct,number,i,j-1);
+							regbp(pairs,i,j-1);
 							found=true;
 
 						}
@@ -1554,7 +1628,7 @@ int stochastictraceback(pfunctionclass *w,pfunctionclass *wmb,pfunctionclass *wm
 
 								if (cumulative>roll&&!found) {
 									stack.push(i+2,j-2,1,0,0);
-									regbp(ct,number,i+1,j-1);
+									regbp(pairs,i+1,j-1);
 									found=true;
 
 								}
@@ -1565,7 +1639,7 @@ int stochastictraceback(pfunctionclass *w,pfunctionclass *wmb,pfunctionclass *wm
 					#endif  //SIMPLEMBLOOP
 					if (!found) {
 						cout << "Traceback errors at wl\n";
-						tracebackerror=14;
+						sampleerror=14;
 
 					}
 
@@ -1592,7 +1666,7 @@ int stochastictraceback(pfunctionclass *w,pfunctionclass *wmb,pfunctionclass *wm
 
 						if (cumulative>roll&&!found) {
 							stack.push(i+1,j-2,1,0,0);
-							regbp(ct,number,i,j-1);
+							regbp(pairs,i,j-1);
 							found=true;
 
 						}
@@ -1615,7 +1689,7 @@ int stochastictraceback(pfunctionclass *w,pfunctionclass *wmb,pfunctionclass *wm
 
 						if (!found&&cumulative>roll) {
 							stack.push(i+1,j-1,1,0,0);
-							regbp(ct,number,i,j);
+							regbp(pairs,i,j);
 							found = true;
 
 						}
@@ -1640,7 +1714,7 @@ int stochastictraceback(pfunctionclass *w,pfunctionclass *wmb,pfunctionclass *wm
 						if (!found&&cumulative>roll) {
 							stack.push(i+2,j-1,1,0,0);
 							found=true;
-							regbp(ct,number,i+1,j);
+							regbp(pairs,i+1,j);
 
 						}
 
@@ -1664,7 +1738,7 @@ int stochastictraceback(pfunctionclass *w,pfunctionclass *wmb,pfunctionclass *wm
 
 						if (cumulative>roll&&!found) {
 							stack.push(i+1,j-2,1,0,0);
-							regbp(ct,number,i,j-1);
+							regbp(pairs,i,j-1);
 							found=true;
 
 						}
@@ -1695,7 +1769,7 @@ int stochastictraceback(pfunctionclass *w,pfunctionclass *wmb,pfunctionclass *wm
 
 								if (cumulative>roll&&!found) {
 									stack.push(i+2,j-2,1,0,0);
-									regbp(ct,number,i+1,j-1);
+									regbp(pairs,i+1,j-1);
 									found=true;
 
 								}
@@ -1706,7 +1780,7 @@ int stochastictraceback(pfunctionclass *w,pfunctionclass *wmb,pfunctionclass *wm
 					#endif //SIMPLEMBLOOP
 					if (!found) {
 						cout << "Traceback error at wl seed\n";
-						tracebackerror=14;
+						sampleerror=14;
 
 					}
 
@@ -1715,16 +1789,84 @@ int stochastictraceback(pfunctionclass *w,pfunctionclass *wmb,pfunctionclass *wm
 			}
 			if (cumulative>(1.0+1e-5)) {
 				cout << "Over 1 probability error\n";
-				tracebackerror=21;
+				sampleerror=21;
 
 			}
 			if (!found) {
 				cout << "Overall traceback error\n";
-				tracebackerror=14;
+				sampleerror=14;
+
+			}
+		}
+
+		//record the structure in this thread's buffer or counts
+		stochasticsamples &buffer = samples[thread];
+		if (counts!=NULL) {
+			if (threadcounts[thread]==NULL) threadcounts[thread] = new stochasticcounts(ct->GetSequenceLength());
+			threadcounts[thread]->add(pairs);
+		}
+		else {
+			buffer.numbers.push_back(number);
+			buffer.pairs.insert(buffer.pairs.end(),pairs.begin(),pairs.end());
+			buffer.starts.push_back(buffer.pairs.size());
+		}
+
+		if (sampleerror!=0) {
+			buffer.error = sampleerror;
+			buffer.errornumber = number;
+		}
+
+		int done;
+		#ifdef SMP
+		#pragma omp atomic capture
+		#endif
+		done = ++completed;
+
+		//only the first thread reports progress
+		if (progress!=NULL&&thread==0) {
+
+			progress->update((int) (((float) 100*done)/((float) numberofstructures)));
+
+		}
+
+	}
+
+	//the error is that of the last structure with one, as when the structures are sampled in order
+	int errornumber = 0;
+	for (int t=0;t<threads;++t) {
+		if (samples[t].errornumber>errornumber) {
+			errornumber = samples[t].errornumber;
+			tracebackerror = samples[t].error;
+		}
+	}
 
+	if (counts!=NULL) {
+		//pair counts do not depend on the order of the structures
+		for (int t=1;t<threads;++t) {
+			if (threadcounts[t]!=NULL) {
+				counts->add(*threadcounts[t]);
+				delete threadcounts[t];
 			}
 		}
+		return tracebackerror;
+	}
 
+	//Add the structures to ct in the order of their numbers.  A dynamic schedule can hand a thread its
+	//	structures in any order, so first find, for each number, the thread and position that hold it.
+	vector<pair<int,size_t> > where(numberofstructures+1);
+	for (int t=0;t<threads;++t) {
+		for (size_t s=0;s<samples[t].numbers.size();++s) where[samples[t].numbers[s]] = make_pair(t,s);
+	}
+	for (number = 1; number <= numberofstructures; number++) {
+		stochasticsamples &buffer = samples[where[number].first];
+		size_t s = where[number].second;
+
+		ct->AddStructure();
+		int structurenumber = ct->GetNumberofStructures();
+		ct->SetCtLabel(ct->GetSequenceLabel(),structurenumber);
+		for (size_t p=buffer.starts[s];p<buffer.starts[s+1];p+=2) {
+			ct->SetPair(buffer.pairs[p],buffer.pairs[p+1],structurenumber);
+		}
 	}
 
 	return tracebackerror;
@@ -1734,7 +1876,7 @@ int stochastictraceback(pfunctionclass *w,pfunctionclass *wmb,pfunctionclass *wm
 
 //Stochastic() starts stochastic traceback from the point of reading a save file from disk.
 //Stochastic() calls stochastictraceback() to do the actual work of sampling.
-void stochastic(structure *ct, char *savefilename, int numberofstructures, int randomseed, TProgressDialog *progress) {
+int stochastic(structure *ct, char *savefilename, int numberofstructures, int randomseed, TProgressDialog *progress) {
 	
 	
 	short vers;
@@ -1749,8 +1891,7 @@ void stochastic(structure *ct, char *savefilename, int numberofstructures, int r
 	ifstream sav(savefilename,ios::binary);
 
 	read(&sav,&vers);//read the save file version
-		//right now there is no infrastructure to indicate an error in file version
-		//that should be added at some point
+		//a save file of the wrong version is detected by readpfsave
 	
 	int sequencelength;
 	read(&sav,&(sequencelength));
@@ -1780,14 +1921,17 @@ void stochastic(structure *ct, char *savefilename, int numberofstructures, int r
 	
 
 	//load all the data from the pfsavefile:
-	readpfsave(savefilename, ct, w5, w3,v, w, wmb,wl, wmbl, wcoax, fce,&scaling,mod,lfce,data);
+	int error = 0;
+	if (readpfsave(savefilename, ct, w5, w3,v, w, wmb,wl, wmbl, wcoax, fce,&scaling,mod,lfce,data)) {
 
-	data->scaling = scaling;
-	
-	//now that partition function data was read from disk, do the sampling:
-	stochastictraceback(w,wmb,wmbl,wcoax,wl,v,
-		fce, w3,w5,scaling, lfce, mod, data, numberofstructures, 
-		ct, randomseed, progress);
+		data->scaling = scaling;
+
+		//now that partition function data was read from disk, do the sampling:
+		error = stochastictraceback(w,wmb,wmbl,wcoax,wl,v,
+			fce, w3,w5,scaling, lfce, mod, data, numberofstructures, 
+			ct, randomseed, progress);
+	}
+	else error = 16;
 
 
 	//delete everything
@@ -1804,5 +1948,6 @@ void stochastic(structure *ct, char *savefilename, int numberofstructures, int r
 	delete[] lfce;
 	delete[] mod;
 
+	return error;
 
 }
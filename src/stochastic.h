@@ -3,6 +3,7 @@
 
 #include "structure.h"
 #include "pfunction.h"
+#include "stochasticcounts.h"
 
 #ifdef _WINDOWS_GUI
 #include "../RNAstructure_windows_interface/TProgressDialog.h"
@@ -24,15 +25,19 @@
 	//numberofstructures is the number of structures to be sampled
 	//randomseed seeds the random number generator
 	//progress is used to track the progress of the calculation
-void stochastic(structure *ct, char *savefilename, int numberofstructures, int randomseed=1000, TProgressDialog *progress=NULL); 
+	//return an int that is zero with no errors, 16 if the save file cannot be read, or an error from stochastictraceback().
+int stochastic(structure *ct, char *savefilename, int numberofstructures, int randomseed=1000, TProgressDialog *progress=NULL); 
 
 //stochastic sampling of structures, enter with partition function data prepared.
+	//The structures are added to ct, in order, or if counts is not NULL, they are added to counts and not stored.
+	//Each structure is sampled with its own seed, randomseed plus its number, so with SMP the structures do not
+	//	depend on the number of threads.
 	//return an int that is zero with no errors and non-zero when errors occur.  These error codes work with the RNA class.
 		//14 = traceback error.
 		//21 = probabilities sum to > 1.
 int stochastictraceback(pfunctionclass *w,pfunctionclass *wmb,pfunctionclass *wmbl,pfunctionclass *wcoax,pfunctionclass *wl,pfunctionclass *v,
 	forceclass *fce, PFPRECISION *w3,PFPRECISION *w5,PFPRECISION scaling, bool *lfce, bool *mod, pfdatatable *data, int numberofstructures, 
-	structure *ct, int randomseed = 1000, TProgressDialog *progress=NULL );
+	structure *ct, int randomseed = 1000, TProgressDialog *progress=NULL, stochasticcounts *counts=NULL );
 
 
 #endif
@@ -0,0 +1,41 @@
+#if !defined(STOCHASTICCOUNTS_H)
+#define STOCHASTICCOUNTS_H
+
+#include <cstddef>
+#include <vector>
+using namespace std;
+
+//stochasticcounts counts how often each base pair, and each unpaired nucleotide, occurs in sampled structures.
+//	This summarizes a sample without storing the structures, so the memory needed does not grow with the number of structures.
+class stochasticcounts {
+	public:
+		//Make counts, all zero, for a sequence of sequencelength nucleotides.
+		stochasticcounts(int sequencelength);
+
+		//Count the structure with the base pairs in pairs, which lists the nucleotides of each pair in turn: i1,j1,i2,j2,...
+		void add(const vector<short> &pairs);
+
+		//Add the structures counted in other, which must be for a sequence of the same length.
+		void add(const stochasticcounts &other);
+
+		//Return the number of structures counted.
+		int GetSamples() const;
+
+		//Return the number of structures with i paired to j.
+		int GetPairCount(int i, int j) const;
+
+		//Return the number of structures with i unpaired.
+		int GetUnpairedCount(int i) const;
+
+	private:
+		int length,samples;
+
+		//The pair counts for i<j, by rows of i.
+		vector<int> paircounts;
+		vector<int> unpairedcounts;
+
+		//The index of pair i,j in paircounts, for i<j.
+		size_t pairindex(int i, int j) const;
+};
+
+#endif //STOCHASTICCOUNTS_H
@@ -474,13 +474,22 @@ void structure::SetPairingDistance(int Maxdistance) {
 //By default, the columns for indicies are only 5 characters wide, so this is a problem for sequences > 9,999 nucs.
 //Now, when sequences are >9,999 nucs, columns are 6 characters wide.  (The code is written yet for sequences > 99,999 nucs.)
 void structure::ctout(const char *ctoutfile, bool append) {
+	ofstream ctfile;
+
+	if (append) ctfile.open(ctoutfile,ios::app);
+	else ctfile.open(ctoutfile);
+
+	ctout(ctfile);
+
+	ctfile.close();
+	return;
+}
+
+//Write a ct file to a stream that stays open.
+void structure::ctout(ostream &ctfile) {
 	int count,i;//length
 	char line[2*ctheaderlength],number[2*numlen];//base[2]
 
-	FILE *ctfile;
-	if (append) ctfile=fopen(ctoutfile,"a");
-	else ctfile=fopen(ctoutfile,"w");
-
 	for (count=1;count<=(GetNumberofStructures());count++) {
 
 		strcpy(line,"");
@@ -507,7 +516,7 @@ void structure::ctout(const char *ctoutfile, bool append) {
 		//make sure that line ends in a newline, if not, add a newline!
 		if(line[strlen(line)-1]!='\n') strcat(line,"\n");
 
-		fputs (line,ctfile);
+		ctfile << line;
 		for (i=1;i<numofbases;i++) {
 			//if (ct->stacking) {
 			//	if (ct->numofbases>9999) sprintf(line,"%6i%2c%8i%6i%6i%6i%6i\n",
@@ -521,7 +530,7 @@ void structure::ctout(const char *ctoutfile, bool append) {
 			else sprintf(line,"%5i%2c%8i%5i%5i%5i\n",
 				i,nucs[i],(i-1),(i+1),GetPair(i,count),hnumber[i]);
 			//}
-			fputs(line,ctfile);
+			ctfile << line;
 		}
 
 
@@ -538,7 +547,7 @@ void structure::ctout(const char *ctoutfile, bool append) {
 			else sprintf(line,"%5i%2c%8i%5i%5i%5i\n",
 				i,nucs[i],(i-1),0,GetPair(i,count),hnumber[i]);
 		//}
-		fputs(line,ctfile);
+		ctfile << line;
 
 //<<<<<<< structure.cpp
 //=======
@@ -547,7 +556,6 @@ void structure::ctout(const char *ctoutfile, bool append) {
 //>>>>>>> 1.51
 	}
 
-	fclose (ctfile);
 	return;
 }
 
@@ -1054,12 +1062,23 @@ int structure::openseq (const char *seqfile) {
 //write a dot-bracket file
 //Note:  This function assumes that there are no pseudoknots, which would make the output un-parsable
 
-void structure::writedotbracket(const char *filename) {
+void structure::writedotbracket(const char *filename, bool append) {
 	ofstream out;
-	int i,j;
 
 
-	out.open(filename);
+	if (append) out.open(filename,ios::app);
+	else out.open(filename);
+
+	writedotbracket(out);
+
+	out.close();
+
+
+}
+
+//Write the structures in dot-bracket format to a stream that stays open.
+void structure::writedotbracket(ostream &out) {
+	int i,j;
 
 
 
@@ -1083,10 +1102,6 @@ void structure::writedotbracket(const char *filename) {
 	}
 
 
-
-	out.close();
-
-
 }
 
 
@@ -7,6 +7,7 @@
 
 #include <vector>
 #include <string>
+#include <ostream>
 using namespace std;
 
 #include "defines.h"
@@ -14,6 +15,9 @@ using namespace std;
 #ifdef EXTENDED_DOUBLE
 	#include "extended_double.h" //inlcude code for extended double if needed
 #endif//defined EXTENDED_DOUBLE
+#ifdef LOG_DOUBLE
+	#include "log_double.h" //include code for log double if needed
+#endif//defined LOG_DOUBLE
 
 //This is a depracted array size that must be removed:
 #define maxforce 3000
@@ -433,6 +437,12 @@ short int SHAPEss_give_value(int index);  //Returns the single stranded SHAPE ps
 		//! \param append is a bool that indicates if these structures should be appended to the end of the file.  The default, falase, is to overwrite any existing file.
 		void ctout (const char *ctoutfile, bool append=false);		
 
+		//! Write a ct file to a stream.
+
+		//!	This lets a caller write many structures through one open file.
+		//! \param out is the stream to which the ct information is written.
+		void ctout (ostream &out);
+
 
 		//! Open a CT File.
 
@@ -455,7 +465,14 @@ short int SHAPEss_give_value(int index);  //Returns the single stranded SHAPE ps
 
 		//! The file will be decipherable only if there are no pseudoknots in the structure.  There is no error checking on this.
 		//! \param filename is a const char pointer to a Null-terminated cstring that provides a filename.
-		void writedotbracket(const char *filename);
+		//! \param append is a bool that indicates if these structures should be appended to the end of the file.  The default, false, is to overwrite any existing file.
+		void writedotbracket(const char *filename, bool append=false);
+
+		//! Write the structures in .bracket format (Vienna Format) to a stream.
+
+		//!	This lets a caller write many structures through one open file.
+		//! \param out is the stream to which the structures are written.
+		void writedotbracket(ostream &out);
 
 		//*******************************
 		//Functions that act on whole structures
@@ -7,17 +7,50 @@
 
 #include "varray.h"
 
+#include <cstddef>
+
 #include "defines.h"
 #include "dynalign.h"
+#include "mappedfile.h"
+
+varray::varray() {
+  storage = NULL;
+  spillfile = NULL;
+  planes = NULL;
+  plane = NULL;
+  width = NULL;
+}
+
+varray::varray(short n1, short n2, short *lowlimit, short *highlimit, bool **Tem, bool Optimalonly, bool spill) {
+  allocate(n1,n2, lowlimit, highlimit,Tem,Optimalonly,spill);
+}
 
-varray::varray() {}
+long varray::storagesize(short n1, short *lowlimit, short *highlimit, bool **Tem, bool Optimalonly) {
+  short i,j,I,a,b;
+  long size;
 
-varray::varray(short n1, short n2, short *lowlimit, short *highlimit, bool **Tem, bool Optimalonly) {
-  allocate(n1,n2, lowlimit, highlimit,Tem,Optimalonly);
+  size = 0;
+  for (i=0;i<=n1;++i) {
+    if (Optimalonly) I = n1;
+    else I = i+n1-1;
+    for (j=i;j<=I;j++) {
+      if (j>n1) {
+        b = i;
+        a = j-n1;
+      }
+      else {
+        b = j;
+        a = i;
+      }
+      if (Tem[b][a]) size += (long) (highlimit[i]-lowlimit[i]+1)*(highlimit[j]-lowlimit[j]+1);
+    }
+  }
+  return size;
 }
 
-void varray::allocate(short n1, short n2, short *lowlimit, short *highlimit, bool **Tem, bool Optimalonly) {
-  short i,j,k,l,I,a,b;
+void varray::allocate(short n1, short n2, short *lowlimit, short *highlimit, bool **Tem, bool Optimalonly, bool spill) {
+  short i,j,I,a,b,count;
+  long size;
 
   N = n1;
   N2 = n2;
@@ -25,7 +58,7 @@ void varray::allocate(short n1, short n2, short *lowlimit, short *highlimit, boo
   Ndiff = N-N2;
   tem = Tem;
 
-  //store the allocation limits for deletion purposes
+  //store the allocation limits
   Lowlimit = lowlimit;
   Highlimit = highlimit;
 
@@ -33,71 +66,39 @@ void varray::allocate(short n1, short n2, short *lowlimit, short *highlimit, boo
 
   infinite = DYNALIGN_INFINITY;
 
-  //allocate the array:
-	
-  //First allocate the i dimension:
-  array = new integersize ***[N+1];
-	
-	
-  for (i=0;i<=N;++i) {
-
-    //now allocate the j dimension:
-    if (optimalonly) array[i]=new integersize **[N-i+1];
-    else array[i] = new integersize **[N+1];
-
-    //now shift the j dimension pointers so that the array positions are indexed in the way they are needed
-    //for all i and j, j>i
-    array[i]=array[i]-i;
-
-		
-    //now allocate the k dimension:
-    if (optimalonly) I = N;
-    else I = i+N-1;
-    for (j=i;j<=I;j++) {
-      if (j>N) {
-        b = i;
-        a = j-N;
-      }
-      else {
-        b = j;
-        a = i;
-      }
-      if (tem[b][a]) {
-        //allocate the k dimension:
-        array[i][j] = new integersize *[highlimit[i]-lowlimit[i]+1/*2*M+2*/];
-
-        //now shift the k dimension pointers so that the array positions are indexed in the way that they are needed
-        // |i*N2/N - k | <= M
-        array[i][j]=array[i][j]-lowlimit[i]/*(i,M,N,N2)*/;
-
-        for (k=lowlimit[i]/*(i,M,N,N2)*/;k<=highlimit[i]/*(i,M,N,N2)*/;k++) {
-          //allocate the l dimension:
-          array[i][j][k]=new integersize [highlimit[j]-lowlimit[j]+1/*2*M+2*/];
-
-          //now shift the l dimension pointers so that the array positions are indexed in the way that they are needed
-          // |j*N2/N - l | <= M
-          array[i][j][k]=array[i][j][k]-lowlimit[j]/*(j,M,N,N2)*/;
-
-          for (l=lowlimit[j]/*(j,M,N,N2)*/;l<=highlimit[j]/*(j,M,N,N2)*/;l++) {
-
-            //make the initial assignment:
-            array[i][j][k][l]=DYNALIGN_INFINITY;
-
-          }
-        }
-      }
+  //The l dimension of a plane (i,j) spans the allowed alignments of j:
+  if (optimalonly) I = N;
+  else I = 2*N-1;
+  width = new long [I+1];
+  for (j=0;j<=I;++j) width[j] = highlimit[j]-lowlimit[j]+1/*2*M+2*/;
+
+  //j runs from i to N, or to i+N-1, in each i row of planes
+  if (optimalonly) count = N+1;
+  else count = N;
+  planes = new integersize *[(long) (N+1)*count];
+  plane = new integersize **[N+1];
+  for (i=0;i<=N;++i) plane[i] = planes + (long) i*count - i;
+
+  //allocate the array in one block, in memory or in a spill file, and make the initial assignment:
+  size = storagesize(N,lowlimit,highlimit,tem,optimalonly);
+  storage = NULL;
+  spillfile = NULL;
+  if (spill) {
+    spillfile = new mappedfile(size*sizeof(integersize));
+    if (spillfile->good()) storage = (integersize *) spillfile->data();
+    else {
+      //The spill file could not be made, so use memory after all.
+      delete spillfile;
+      spillfile = NULL;
     }
   }
-}
-		
-varray::~varray() {
-  short i,j,k,I,a,b;
+  if (storage==NULL) storage = new integersize [size];
+  for (long e=0;e<size;++e) storage[e] = DYNALIGN_INFINITY;
 
-  //delete the array
-	
+  //now point each plane into the storage, shifted so that the positions are indexed in the way that they are needed:
+  // |i*N2/N - k | <= M and |j*N2/N - l | <= M
+  size = 0;
   for (i=0;i<=N;++i) {
-
-    //now delete the k dimension:
     if (optimalonly) I = N;
     else I = i+N-1;
     for (j=i;j<=I;j++) {
@@ -110,29 +111,19 @@ varray::~varray() {
         a = i;
       }
       if (tem[b][a]) {
-
-        for (k=Lowlimit[i]/*(i,M,N,N2)*/;k<=Highlimit[i]/*(i,M,N,N2)*/;k++) {
-          //now shift the l dimension pointers back
-          array[i][j][k]=array[i][j][k]+Lowlimit[j]/*(j,M,N,N2)*/;
-				
-          //delete the l dimension:
-          delete[] array[i][j][k];
-        }
-        //now shift the k dimension pointers back
-        array[i][j]=array[i][j]+Lowlimit[i]/*(i,M,N,N2)*/;
-
-        //delete the k dimension:
-        delete[] array[i][j];
+        plane[i][j] = storage + size - (long) lowlimit[i]*width[j] - lowlimit[j];
+        size += (long) (highlimit[i]-lowlimit[i]+1)*width[j];
       }
+      //Planes that are not stored are never used, because f() checks tem first.
+      else plane[i][j] = NULL;
     }
-
-    //now shift the j pointers back
-    array[i]=array[i]+i;
-
-    //now delete the j dimension:
-    delete[] array[i];
   }
-
-  //delete the i dimension:
-  delete[] array;
+}
+		
+varray::~varray() {
+  if (spillfile!=NULL) delete spillfile;
+  else delete[] storage;
+  delete[] planes;
+  delete[] plane;
+  delete[] width;
 }
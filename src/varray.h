@@ -10,6 +10,8 @@
 
 #include "defines.h"
 
+class mappedfile;
+
 
 //Varray encapsulates the v array. i.e. the lowest free energy for fragments from i to j in seq1,
 //k to l in seq 2, with i paired to j, k paired to l, i aligned to k, and j aligned to l.
@@ -26,14 +28,27 @@ class varray {
 		bool **tem;
 		short *Lowlimit, *Highlimit;
 
+		//The whole array is one block of storage.  The (i,j) planes are laid out one after the other,
+		//	each holding its k rows of width[j] entries, so element (i,j,k,l) is plane[i][j][k*width[j]+l].
+		//plane[i] is a row of the planes array, and the plane pointers are shifted back so that j, k, and l
+		//	index them directly.  Planes with tem[][] false are not stored.
+		integersize *storage;
+		mappedfile *spillfile;//the temporary file that holds storage, or NULL if storage is in memory
+		integersize **planes;
+		integersize ***plane;
+		long *width;
+
 	public:
-		integersize ****array;
 
 		//constructor: n1 is the length of sequence 1, n2 is the length of sequence 2, 
-		varray(short n1, short n2, short *lowlimit, short *highlimit, bool **Tem, bool Optimalonly=false);
+		//spill puts the array in a temporary file that the operating system pages in and out as needed, instead of in memory
+		varray(short n1, short n2, short *lowlimit, short *highlimit, bool **Tem, bool Optimalonly=false, bool spill=false);
 		varray();
 		~varray();
-		void allocate(short n1, short n2, short *lowlimit, short *highlimit, bool **Tem, bool Optimalonly=false);
+		void allocate(short n1, short n2, short *lowlimit, short *highlimit, bool **Tem, bool Optimalonly=false, bool spill=false);
+
+		//Return the number of entries that allocate() stores for these arguments.
+		static long storagesize(short n1, short *lowlimit, short *highlimit, bool **Tem, bool Optimalonly=false);
 		integersize &f(short i, short j,short k, short l);
 };
 
@@ -47,12 +62,12 @@ inline integersize &varray::f(short i, short j,short k, short l) {
   
   if (j > N) {
     if (tem[i][j-N]) {
-      return array[i][j][k][l];
+      return plane[i][j][k*width[j]+l];
     } else {
       return infinite;
     }
   } else if (tem[j][i]) {
-    return array[i][j][k][l];
+    return plane[i][j][k*width[j]+l];
   } else {
     return infinite;
   }
@@ -9,11 +9,14 @@
 
 #include "wendarray.h"
 
+#include <cstddef>
+
 #include "defines.h"
 
 
 wendarray::wendarray() {
 	
+	storage = NULL;
 
 }
 
@@ -32,45 +35,25 @@ void wendarray::allocate(short n1, short n2, short *lowlimit, short *highlimit)
 
   short Low,High;
 
-  array = new integersize *[n1+2];
-  for (int i = 0; i <= n1 + 1; ++i) {
-    
-    
-	//Changed by DHM 11/11/2010
-	//No longer limit the bounds with w3 and w5.
-	//This is required because w3 and w5 don't require the ends to align.
-	//if (i<=N1) {
-	//	Low=lowlimit[i];
-	//	High=highlimit[i];
-	//}
-	
-	//else {
-		Low=0;
-		High=N2+2;
-	//}
-	array[i] = new integersize[High-Low+2/*2*m+2*/];
-	for (int j = 0; j <= High-Low; ++j) {
-      array[i][j]=DYNALIGN_INFINITY;
-    }
-
-	//No shift is needed now.
-	//array[i]=array[i]-Low;//shift pointer for access
-  
+  //Changed by DHM 11/11/2010
+  //No longer limit the bounds with w3 and w5.
+  //This is required because w3 and w5 don't require the ends to align.
+  Low=0;
+  High=N2+2;
+
+  //All rows have the same width, so they are allocated as one block:
+  Width = High-Low+2/*2*m+2*/;
+  storage = new integersize[(long) (n1+2)*Width];
+  for (long e = 0; e < (long) (n1+2)*Width; ++e) {
+    storage[e]=DYNALIGN_INFINITY;
   }
 
   
 }
 
 wendarray::~wendarray() {
-  int i;
 	
-  for (i=0;i<=N1+1;++i) {
-	  //restore pointer:
-	  //if(i<=N1) array[i]=array[i]+Lowlimit[i];
-	  //else array[i]=array[i];
-	  delete[] array[i];
-  }
-  delete[] array;
+  delete[] storage;
   
 
-}
+}
\ No newline at end of file
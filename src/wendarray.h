@@ -29,8 +29,11 @@ private:
 	short *Highlimit;
 #endif
 
+	//The array is one block of N1+2 rows of Width entries.
+	integersize *storage;
+	long Width;
+
 	public:
-		integersize **array;
 		wendarray();
 		wendarray(short n1, short n2, short *lowlimit, short *highlimit);
 		void allocate(short n1, short n2, short *lowlimit, short *highlimit);
@@ -40,7 +43,7 @@ private:
 
 inline integersize &wendarray::f(short i, short j) {
 
-  return array[i][j/*-itN2dN1[i] + M*/];
+  return storage[i*Width+j/*-itN2dN1[i] + M*/];
 }
 
 #endif
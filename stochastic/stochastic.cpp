@@ -7,6 +7,9 @@
  */
 
 #include "stochastic.h"
+#include "../src/stochasticcounts.h"
+#include <cmath>
+#include <fstream>
 
 ///////////////////////////////////////////////////////////////////////////////
 // Constructor.
@@ -27,6 +30,9 @@ stochastic::stochastic() {
 
 	// Initialize the random seed.
 	seed = 1234;
+
+	// Initialize the counts flag to false.
+	isCounts = false;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -37,7 +43,14 @@ bool stochastic::parse( int argc, char** argv ) {
 	// Create the command line parser and build in its required parameters.
 	ParseCommandLine* parser = new ParseCommandLine( "stochastic" );
 	parser->addParameterDescription( "input file", "The name of the input file. Depending on the options selected, this may be one of the following file types. 1) Partition function save file (holds probability data). 2) Sequence file (holds raw sequence: .seq or .fasta). Note that in order to use a sequence file, the \"--sequence\" flag must be specified." );
-	parser->addParameterDescription( "ct file", "The name of a CT file to which output will be written." );
+	parser->addParameterDescription( "ct file", "The name of a CT file to which output will be written. With the \"--counts\" flag, this is instead the name of a dot plot text file." );
+
+	// Add the counts option.
+	vector<string> countsOptions;
+	countsOptions.push_back( "-c" );
+	countsOptions.push_back( "-C" );
+	countsOptions.push_back( "--counts" );
+	parser->addOptionFlagsNoParameters( countsOptions, "Count the base pairs in the sampled structures, instead of writing the structures. The output file is a dot plot text file that gives -log10 of the fraction of structures with each sampled pair, which can be read by ProbabilityPlot with its \"--log10\" flag. The structures are not stored, so this needs much less memory for a large ensemble." );
 
 	// Add the DNA option.
 	vector<string> dnaOptions;
@@ -77,6 +90,9 @@ bool stochastic::parse( int argc, char** argv ) {
 	// Get the sequence flag.
 	isSequence = parser->contains( sequenceOptions );
 
+	// Get the counts flag.
+	isCounts = parser->contains( countsOptions );
+
 	// Get the DNA option.
 	// Only do this if the sequence flag was specified.
 	if( isSequence ) { isRNA = !parser->contains( dnaOptions ); }
@@ -149,8 +165,29 @@ void stochastic::run() {
 		cout << "Analyzing stochastic samples..." << flush;
 
 		// Do the main calculation and check for errors.
-		int mainCalcError = strand->Stochastic( ensemble, seed );
-		error = checker->isErrorStatus( mainCalcError );
+		// If pairs are counted, the structures are not kept.
+		int mainCalcError;
+		if( isCounts ) {
+			stochasticcounts counts( strand->GetSequenceLength() );
+			mainCalcError = strand->Stochastic( ensemble, seed, &counts );
+			error = checker->isErrorStatus( mainCalcError );
+
+			// If no error occurred, write the fraction of structures with each pair in the dot plot text format.
+			if( error == 0 ) {
+				ofstream out( ctFile.c_str() );
+				out << strand->GetSequenceLength() << endl << "i\tj\t-log10(Probability)" << endl;
+				for( int i = 1; i <= strand->GetSequenceLength(); i++ ) {
+					for( int j = i + 1; j <= strand->GetSequenceLength(); j++ ) {
+						int count = counts.GetPairCount( i, j );
+						if( count > 0 ) { out << i << "\t" << j << "\t" << -log10( ( (double)count ) / counts.GetSamples() ) << endl; }
+					}
+				}
+				out.close();
+			}
+		} else {
+			mainCalcError = strand->Stochastic( ensemble, seed );
+			error = checker->isErrorStatus( mainCalcError );
+		}
 
 		// If no error occurred, print message that main calculation is done.
 		if( error == 0 ) { cout << "done." << endl; }
@@ -160,7 +197,7 @@ void stochastic::run() {
 	 * Write a CT output file using the WriteCt method.
 	 * After writing is complete, use the error checker's isErrorStatus method to check for errors.
 	 */
-	if( error == 0 ) {
+	if( error == 0 && !isCounts ) {
 
 		// Show a message saying that the CT file is being written.
 		cout << "Writing output ct file..." << flush;
@@ -61,6 +61,9 @@ class stochastic {
 
 	// The random seed.
 	int seed;
+
+	// Flag signifying if the pairs in the sample are counted, instead of the structures being written (true) or not (false).
+	bool isCounts;
 };
 
 #endif /* STOCHASTIC_H */